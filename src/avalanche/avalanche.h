@@ -36,6 +36,12 @@ static constexpr bool AVALANCHE_DEFAULT_ENABLED = false;
  */
 static constexpr size_t AVALANCHE_DEFAULT_COOLDOWN = 100;
 
+/**
+ * Whether the avalanche proofs are saved on shutdown and loaded on startup by
+ * default.
+ */
+static constexpr bool AVALANCHE_DEFAULT_PERSIST_PROOFS = true;
+
 /**
  * Global avalanche instance.
  */
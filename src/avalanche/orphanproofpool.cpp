@@ -58,6 +58,11 @@ std::shared_ptr<Proof> OrphanProofPool::getProof(const ProofId &proofId) const {
     return it == proofs_by_proofid.end() ? nullptr : *it;
 }
 
+std::vector<std::shared_ptr<Proof>> OrphanProofPool::getProofs() const {
+    auto &proofs_by_sequence = proofs.get<by_sequence>();
+    return {proofs_by_sequence.begin(), proofs_by_sequence.end()};
+}
+
 void OrphanProofPool::rescan(PeerManager &peerManager) {
     ProofContainer last_gen_proofs = std::move(proofs);
     proofs.clear();
@@ -23,6 +23,7 @@
 #include <boost/multi_index_container.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace avalanche {
 
@@ -86,6 +87,9 @@ public:
      */
     std::shared_ptr<Proof> getProof(const ProofId &proofId) const;
 
+    /** Get all the proofs, oldest first. */
+    std::vector<std::shared_ptr<Proof>> getProofs() const;
+
     /**
      * Rescan the pool to remove previously orphaned proofs that have become
      * good or permanently bad.
@@ -91,6 +91,7 @@ bool PeerManager::addNodeToPeer(const PeerSet::iterator &it) {
         const uint32_t score = p.getScore();
         const uint64_t start = slotCount;
         slots.emplace_back(start, score, it->peerid);
+        sampler.push_back(score);
         slotCount = start + score;
     });
 }
@@ -135,10 +136,12 @@ bool PeerManager::removeNodeFromPeer(const PeerSet::iterator &it,
     assert(i < slots.size());
     if (i + 1 == slots.size()) {
         slots.pop_back();
+        sampler.pop_back();
         slotCount = slots.empty() ? 0 : slots.back().getStop();
     } else {
         fragmentation += slots[i].getScore();
         slots[i] = slots[i].withPeerId(NO_PEER);
+        sampler.update(i, 0);
     }
 
     return true;
@@ -163,11 +166,9 @@ NodeId PeerManager::selectNode() {
     for (int retry = 0; retry < SELECT_NODE_MAX_RETRY; retry++) {
         const PeerId p = selectPeer();
 
-        // If we cannot find a peer, it may be due to the fact that it is
-        // unlikely due to high fragmentation, so compact and retry.
+        // There is no peer with a node to poll.
         if (p == NO_PEER) {
-            compact();
-            continue;
+            return NO_NODE;
         }
 
         // See if that peer has an available node.
@@ -210,6 +211,11 @@ void PeerManager::updatedBlockTip() {
     for (const auto &pid : invalidPeers) {
         removePeer(pid);
     }
+
+    // Reclaim the space of the removed peers once it gets significant.
+    if (2 * fragmentation > slotCount) {
+        compact();
+    }
 }
 
 PeerId PeerManager::getPeerId(const std::shared_ptr<Proof> &proof) {
@@ -240,16 +246,18 @@ PeerManager::fetchOrCreatePeer(const std::shared_ptr<Proof> &proof) {
         }
     }
 
-    // Check the proof's validity.
+    // Check the proof's validity. The stakes are looked up under cs_main
+    // first, the signatures are checked without holding it.
     ProofValidationState state;
-    bool valid = [&](ProofValidationState &state) {
-        LOCK(cs_main);
-        const CCoinsViewCache &coins = ::ChainstateActive().CoinsTip();
-        return proof->verify(state, coins);
-    }(state);
-
-    if (!valid) {
-        if (isOrphanState(state)) {
+    const bool validStakes = WITH_LOCK(
+        cs_main, return proof->verifyStakes(
+                     state, ::ChainstateActive().CoinsTip()));
+
+    if (!validStakes) {
+        // Orphans are kept until their stakes show up, as long as they are
+        // properly signed. Their signatures are not cached yet.
+        ProofValidationState sigState;
+        if (isOrphanState(state) && proof->verifySignatures(sigState, false)) {
             orphanProofs.addProof(proof);
         }
 
@@ -257,6 +265,11 @@ PeerManager::fetchOrCreatePeer(const std::shared_ptr<Proof> &proof) {
         return peers.end();
     }
 
+    if (!proof->verifySignatures(state, true)) {
+        // Reject invalid proof.
+        return peers.end();
+    }
+
     orphanProofs.removeProof(proof->getId());
 
     // New peer means new peerid!
@@ -324,19 +337,15 @@ bool PeerManager::removePeer(const PeerId peerid) {
 }
 
 PeerId PeerManager::selectPeer() const {
-    if (slots.empty() || slotCount == 0) {
+    const uint64_t total = sampler.getTotalWeight();
+    if (total == 0) {
         return NO_PEER;
     }
 
-    const uint64_t max = slotCount;
-    for (int retry = 0; retry < SELECT_PEER_MAX_RETRY; retry++) {
-        size_t i = selectPeerImpl(slots, GetRand(max), max);
-        if (i != NO_PEER) {
-            return i;
-        }
-    }
-
-    return NO_PEER;
+    // Dead slots have no weight, so this always lands on a live one.
+    const PeerId peerid = slots[sampler.select(GetRand(total))].getPeerId();
+    assert(peerid != NO_PEER);
+    return peerid;
 }
 
 uint64_t PeerManager::compact() {
@@ -347,6 +356,7 @@ uint64_t PeerManager::compact() {
 
     std::vector<Slot> newslots;
     newslots.reserve(peers.size());
+    sampler.clear();
 
     uint64_t prevStop = 0;
     uint32_t i = 0;
@@ -356,7 +366,8 @@ uint64_t PeerManager::compact() {
         }
 
         newslots.emplace_back(prevStop, it->getScore(), it->peerid);
-        prevStop = slots[i].getStop();
+        sampler.push_back(it->getScore());
+        prevStop = newslots.back().getStop();
         if (!peers.modify(it, [&](Peer &p) { p.index = i++; })) {
             return 0;
         }
@@ -372,7 +383,12 @@ uint64_t PeerManager::compact() {
 }
 
 bool PeerManager::verify() const {
+    if (sampler.size() != slots.size()) {
+        return false;
+    }
+
     uint64_t prevStop = 0;
+    uint64_t liveScore = 0;
     for (size_t i = 0; i < slots.size(); i++) {
         const Slot &s = slots[i];
 
@@ -385,9 +401,24 @@ bool PeerManager::verify() const {
 
         // If this is a dead slot, then nothing more needs to be checked.
         if (s.getPeerId() == NO_PEER) {
+            if (sampler.getWeight(i) != 0) {
+                return false;
+            }
             continue;
         }
 
+        // The sampler must pick live slots according to their score.
+        if (sampler.getWeight(i) != s.getScore()) {
+            return false;
+        }
+        if (s.getScore() > 0 &&
+            (sampler.select(liveScore) != i ||
+             selectPeerImpl(slots, s.getStart(), slotCount) !=
+                 s.getPeerId())) {
+            return false;
+        }
+        liveScore += s.getScore();
+
         // We have a live slot, verify index.
         auto it = peers.find(s.getPeerId());
         if (it == peers.end() || it->index != i) {
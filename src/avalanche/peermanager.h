@@ -20,6 +20,7 @@
 #include <avalanche/node.h>
 #include <avalanche/orphanproofpool.h>
 #include <avalanche/proof.h>
+#include <avalanche/stakesampler.h>
 #include <coins.h>
 #include <net.h>
 #include <pubkey.h>
@@ -110,6 +111,12 @@ class PeerManager {
     uint64_t slotCount = 0;
     uint64_t fragmentation = 0;
 
+    /**
+     * Score of the peer owning each slot, 0 for the dead ones, so peers can
+     * be picked without ever landing on a dead slot.
+     */
+    StakeSampler sampler;
+
     OrphanProofPool orphanProofs{AVALANCHE_ORPHANPROOFPOOL_SIZE};
 
     /**
@@ -153,7 +160,6 @@ class PeerManager {
 
     NodeSet nodes;
 
-    static constexpr int SELECT_PEER_MAX_RETRY = 3;
     static constexpr int SELECT_NODE_MAX_RETRY = 3;
 
 public:
@@ -191,13 +197,15 @@ public:
     bool removePeer(const PeerId peerid);
 
     /**
-     * Randomly select a peer to poll.
+     * Randomly select a peer to poll, weighted by score. This only fails if
+     * there is no peer with a node to poll.
      */
     PeerId selectPeer() const;
 
     /**
      * Trigger maintenance of internal data structures.
      * Returns how much slot space was saved after compaction.
+     * Selection does not depend on it, this only reclaims memory.
      */
     uint64_t compact();
 
@@ -218,6 +226,9 @@ public:
 
     bool isOrphan(const ProofId &id) const;
     std::shared_ptr<Proof> getOrphan(const ProofId &id) const;
+    std::vector<std::shared_ptr<Proof>> getOrphans() const {
+        return orphanProofs.getProofs();
+    }
 
     void addUnbroadcastProof(const ProofId &proofid);
     void removeUnbroadcastProof(const ProofId &proofid);
@@ -20,16 +20,26 @@
 #include <avalanche/peermanager.h>
 #include <avalanche/validation.h>
 #include <chain.h>
+#include <clientversion.h>
+#include <fs.h>
 #include <key_io.h>         // For DecodeSecret
 #include <net_processing.h> // For ::PeerManager
 #include <netmessagemaker.h>
-#include <reverse_iterator.h>
 #include <scheduler.h>
-#include <util/bitmanip.h>
+#include <shutdown.h>
+#include <streams.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <system_error>
+#include <thread>
 #include <tuple>
 
 /**
@@ -37,102 +47,20 @@
  */
 static constexpr std::chrono::milliseconds AVALANCHE_TIME_STEP{10};
 
+static const uint64_t AVALANCHE_PROOFS_DUMP_VERSION = 1;
+
+/**
+ * Maximum number of threads checking the signatures of the proofs loaded from
+ * disk, including the loading thread.
+ */
+static constexpr int MAX_PROOF_LOAD_THREADS = 4;
+
 // Unfortunately, the bitcoind codebase is full of global and we are kinda
 // forced into it here.
 std::unique_ptr<avalanche::Processor> g_avalanche;
 
 namespace avalanche {
 
-bool VoteRecord::registerVote(NodeId nodeid, uint32_t error) {
-    // We just got a new vote, so there is one less inflight request.
-    clearInflightRequest();
-
-    // We want to avoid having the same node voting twice in a quorum.
-    if (!addNodeToQuorum(nodeid)) {
-        return false;
-    }
-
-    /**
-     * The result of the vote is determined from the error code. If the error
-     * code is 0, there is no error and therefore the vote is yes. If there is
-     * an error, we check the most significant bit to decide if the vote is a no
-     * (for instance, the block is invalid) or is the vote inconclusive (for
-     * instance, the queried node does not have the block yet).
-     */
-    votes = (votes << 1) | (error == 0);
-    consider = (consider << 1) | (int32_t(error) >= 0);
-
-    /**
-     * We compute the number of yes and/or no votes as follow:
-     *
-     * votes:     1010
-     * consider:  1100
-     *
-     * yes votes: 1000 using votes & consider
-     * no votes:  0100 using ~votes & consider
-     */
-    bool yes = countBits(votes & consider & 0xff) > 6;
-    if (!yes) {
-        bool no = countBits(~votes & consider & 0xff) > 6;
-        if (!no) {
-            // The round is inconclusive.
-            return false;
-        }
-    }
-
-    // If the round is in agreement with previous rounds, increase confidence.
-    if (isAccepted() == yes) {
-        confidence += 2;
-        return getConfidence() == AVALANCHE_FINALIZATION_SCORE;
-    }
-
-    // The round changed our state. We reset the confidence.
-    confidence = yes;
-    return true;
-}
-
-bool VoteRecord::addNodeToQuorum(NodeId nodeid) {
-    if (nodeid == NO_NODE) {
-        // Helpful for testing.
-        return true;
-    }
-
-    // MMIX Linear Congruent Generator.
-    const uint64_t r1 =
-        6364136223846793005 * uint64_t(nodeid) + 1442695040888963407;
-    // Fibonacci hashing.
-    const uint64_t r2 = 11400714819323198485ull * (nodeid ^ seed);
-    // Combine and extract hash.
-    const uint16_t h = (r1 + r2) >> 48;
-
-    /**
-     * Check if the node is in the filter.
-     */
-    for (size_t i = 1; i < nodeFilter.size(); i++) {
-        if (nodeFilter[(successfulVotes + i) % nodeFilter.size()] == h) {
-            return false;
-        }
-    }
-
-    /**
-     * Add the node which just voted to the filter.
-     */
-    nodeFilter[successfulVotes % nodeFilter.size()] = h;
-    successfulVotes++;
-    return true;
-}
-
-bool VoteRecord::registerPoll() const {
-    uint8_t count = inflight.load();
-    while (count < AVALANCHE_MAX_INFLIGHT_POLL) {
-        if (inflight.compare_exchange_weak(count, count + 1)) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 static bool IsWorthPolling(const CBlockIndex *pindex) {
     AssertLockHeld(cs_main);
 
@@ -232,9 +160,10 @@ public:
 };
 
 Processor::Processor(interfaces::Chain &chain, CConnman *connmanIn,
-                     NodePeerManager *nodePeerManagerIn,
+                     NodePeerManager *nodePeerManagerIn, CTxMemPool &mempoolIn,
                      std::unique_ptr<PeerData> peerDataIn, CKey sessionKeyIn)
     : connman(connmanIn), nodePeerManager(nodePeerManagerIn),
+      mempool(mempoolIn),
       queryTimeoutDuration(AVALANCHE_DEFAULT_QUERY_TIMEOUT), round(0),
       peerManager(std::make_unique<PeerManager>()),
       peerData(std::move(peerDataIn)), sessionKey(std::move(sessionKeyIn)),
@@ -254,7 +183,7 @@ Processor::~Processor() {
 std::unique_ptr<Processor>
 Processor::MakeProcessor(const ArgsManager &argsman, interfaces::Chain &chain,
                          CConnman *connman, NodePeerManager *nodePeerManager,
-                         bilingual_str &error) {
+                         CTxMemPool &mempool, bilingual_str &error) {
     std::unique_ptr<PeerData> peerData;
     CKey masterKey;
     CKey sessionKey;
@@ -347,8 +276,8 @@ Processor::MakeProcessor(const ArgsManager &argsman, interfaces::Chain &chain,
 
     // We can't use std::make_unique with a private constructor
     return std::unique_ptr<Processor>(
-        new Processor(chain, connman, nodePeerManager, std::move(peerData),
-                      std::move(sessionKey)));
+        new Processor(chain, connman, nodePeerManager, mempool,
+                      std::move(peerData), std::move(sessionKey)));
 }
 
 bool Processor::addBlockToReconcile(const CBlockIndex *pindex) {
@@ -364,29 +293,118 @@ bool Processor::addBlockToReconcile(const CBlockIndex *pindex) {
         isAccepted = ::ChainActive().Contains(pindex);
     }
 
-    return vote_records.getWriteView()
-        ->insert(std::make_pair(pindex, VoteRecord(isAccepted)))
-        .second;
+    return vote_records.getWriteView()->insert(pindex, VoteRecord(isAccepted));
 }
 
 bool Processor::isAccepted(const CBlockIndex *pindex) const {
     auto r = vote_records.getReadView();
-    auto it = r->find(pindex);
-    if (it == r.end()) {
+    const VoteRecord *vr = r->find(pindex);
+    return vr && vr->isAccepted();
+}
+
+int Processor::getConfidence(const CBlockIndex *pindex) const {
+    auto r = vote_records.getReadView();
+    const VoteRecord *vr = r->find(pindex);
+    return vr ? vr->getConfidence() : -1;
+}
+
+bool Processor::addTxToReconcile(const CTransactionRef &tx, bool accepted,
+                                 NodeId nodeid) {
+    const TxId &txid = tx->GetId();
+
+    auto w = txVoteRecords.getWriteView();
+    LOCK(cs_conflictingTxs);
+    if (accepted) {
+        // We are voting on too many transactions already. The conflicting
+        // ones don't count, they have their own budget.
+        if (w->size() >=
+            AVALANCHE_MAX_TX_VOTE_RECORDS + conflictingTxs.size()) {
+            return false;
+        }
+
+        return w->insert(txid, VoteRecord(true));
+    }
+
+    const size_t txSize = tx->GetTotalSize();
+    auto peerIt = conflictingTxsPerPeer.find(nodeid);
+    if (conflictingTxs.size() >= AVALANCHE_MAX_CONFLICTING_TXS ||
+        conflictingTxsSize + txSize > AVALANCHE_MAX_CONFLICTING_TXS_SIZE ||
+        (peerIt != conflictingTxsPerPeer.end() &&
+         peerIt->second >= AVALANCHE_MAX_CONFLICTING_TXS_PER_PEER)) {
+        return false;
+    }
+
+    if (!w->insert(txid, VoteRecord(false))) {
         return false;
     }
 
-    return it->second.isAccepted();
+    // Keep the transaction around so it can be added to the mempool if it
+    // ends up winning the vote.
+    conflictingTxs.emplace(
+        txid, ConflictingTx{tx, nodeid,
+                            GetTime<std::chrono::seconds>() +
+                                AVALANCHE_CONFLICTING_TX_EXPIRY});
+    conflictingTxsSize += txSize;
+    conflictingTxsPerPeer[nodeid]++;
+    return true;
 }
 
-int Processor::getConfidence(const CBlockIndex *pindex) const {
-    auto r = vote_records.getReadView();
-    auto it = r->find(pindex);
-    if (it == r.end()) {
-        return -1;
+Processor::ConflictingTxMap::iterator
+Processor::eraseConflictingTx(ConflictingTxMap::iterator it) {
+    AssertLockHeld(cs_conflictingTxs);
+    conflictingTxsSize -= it->second.tx->GetTotalSize();
+    auto peerIt = conflictingTxsPerPeer.find(it->second.nodeid);
+    if (--peerIt->second == 0) {
+        conflictingTxsPerPeer.erase(peerIt);
     }
+    return conflictingTxs.erase(it);
+}
+
+bool Processor::isAccepted(const TxId &txid) const {
+    auto r = txVoteRecords.getReadView();
+    const VoteRecord *vr = r->find(txid);
+    return vr && vr->isAccepted();
+}
+
+int Processor::getConfidence(const TxId &txid) const {
+    auto r = txVoteRecords.getReadView();
+    const VoteRecord *vr = r->find(txid);
+    return vr ? vr->getConfidence() : -1;
+}
 
-    return it->second.getConfidence();
+CTransactionRef Processor::getConflictingTx(const TxId &txid) const {
+    LOCK(cs_conflictingTxs);
+    auto it = conflictingTxs.find(txid);
+    return it == conflictingTxs.end() ? nullptr : it->second.tx;
+}
+
+bool Processor::addProofToReconcile(const std::shared_ptr<Proof> &proof) {
+    bool isAccepted;
+
+    {
+        LOCK(cs_peerManager);
+        isAccepted = !!peerManager->getProof(proof->getId());
+    }
+
+    auto w = proofVoteRecords.getWriteView();
+    if (w->size() >= AVALANCHE_MAX_PROOF_VOTE_RECORDS) {
+        // We are voting on too many proofs already.
+        return false;
+    }
+
+    return w->insert(proof->getId(), VoteRecord(isAccepted));
+}
+
+bool Processor::isAccepted(const ProofId &proofid) const {
+    auto r = proofVoteRecords.getReadView();
+    const VoteRecord *vr = r->find(proofid);
+    return vr && vr->isAccepted();
+}
+
+int Processor::getConfidence(const ProofId &proofid) const {
+    auto r = proofVoteRecords.getReadView();
+    const VoteRecord *vr = r->find(proofid);
+    return vr ? vr->getConfidence() : -1;
 }
 
 namespace {
@@ -425,8 +443,20 @@ void Processor::sendResponse(CNode *pfrom, Response response) const {
                          TCPResponse(std::move(response), sessionKey)));
 }
 
+static BlockUpdate::Status GetUpdateStatus(const VoteRecord &vr) {
+    if (!vr.hasFinalized()) {
+        return vr.isAccepted() ? BlockUpdate::Status::Accepted
+                               : BlockUpdate::Status::Rejected;
+    }
+
+    return vr.isAccepted() ? BlockUpdate::Status::Finalized
+                           : BlockUpdate::Status::Invalid;
+}
+
 bool Processor::registerVotes(NodeId nodeid, const Response &response,
-                              std::vector<BlockUpdate> &updates) {
+                              std::vector<BlockUpdate> &updates,
+                              std::vector<TxUpdate> &txUpdates,
+                              std::vector<ProofUpdate> &proofUpdates) {
     {
         // Save the time at which we can query again.
         LOCK(cs_peerManager);
@@ -440,6 +470,7 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
     }
 
     std::vector<CInv> invs;
+    std::vector<VoteRecordRef> refs;
 
     {
         // Check that the query exists.
@@ -451,6 +482,7 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
         }
 
         invs = std::move(it->invs);
+        refs = std::move(it->refs);
         w->erase(it);
     }
 
@@ -470,12 +502,29 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
         }
     }
 
-    std::map<CBlockIndex *, Vote> responseIndex;
+    std::vector<BlockVoteMap::Vote> batch;
+    std::vector<TxVoteMap::Vote> txBatch;
+    std::vector<ProofVoteMap::Vote> proofBatch;
+    batch.reserve(size);
+
+    for (size_t i = 0; i < size; i++) {
+        const VoteRecordRef ref = i < refs.size() ? refs[i] : VoteRecordRef();
+        if (invs[i].type == MSG_TX) {
+            txBatch.push_back({ref, TxId(invs[i].hash), votes[i].GetError()});
+        } else if (invs[i].type == MSG_AVA_PROOF) {
+            proofBatch.push_back(
+                {ref, ProofId(invs[i].hash), votes[i].GetError()});
+        }
+    }
 
     {
         LOCK(cs_main);
-        for (const auto &v : votes) {
-            auto pindex = LookupBlockIndex(BlockHash(v.GetHash()));
+        for (size_t i = 0; i < size; i++) {
+            if (invs[i].type != MSG_BLOCK) {
+                continue;
+            }
+
+            auto pindex = LookupBlockIndex(BlockHash(votes[i].GetHash()));
             if (!pindex) {
                 // This should not happen, but just in case...
                 continue;
@@ -486,44 +535,73 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
                 continue;
             }
 
-            responseIndex.insert(std::make_pair(pindex, v));
+            batch.push_back({i < refs.size() ? refs[i] : VoteRecordRef(),
+                             pindex, votes[i].GetError()});
         }
     }
 
-    {
-        // Register votes.
-        auto w = vote_records.getWriteView();
-        for (const auto &p : responseIndex) {
-            CBlockIndex *pindex = p.first;
-            const Vote &v = p.second;
-
-            auto it = w->find(pindex);
-            if (it == w.end()) {
-                // We are not voting on that item anymore.
-                continue;
-            }
+    // Register all the votes at once.
+    vote_records.getWriteView()->registerVotes(
+        nodeid, batch,
+        [&](const CBlockIndex *pindex, const VoteRecord &vr) {
+            // The store only hands out const pointers, but these block indexes
+            // were all looked up from the block index above.
+            updates.emplace_back(const_cast<CBlockIndex *>(pindex),
+                                 GetUpdateStatus(vr));
+        });
 
-            auto &vr = it->second;
-            if (!vr.registerVote(nodeid, v.GetError())) {
-                // This vote did not provide any extra information, move on.
-                continue;
+    if (!proofBatch.empty()) {
+        std::vector<std::pair<ProofId, BlockUpdate::Status>> proofStatuses;
+        proofVoteRecords.getWriteView()->registerVotes(
+            nodeid, proofBatch,
+            [&](const ProofId &proofid, const VoteRecord &vr) {
+                proofStatuses.emplace_back(proofid, GetUpdateStatus(vr));
+            });
+
+        LOCK(cs_peerManager);
+        for (const auto &p : proofStatuses) {
+            auto proof = peerManager->getProof(p.first);
+            if (!proof) {
+                proof = peerManager->getOrphan(p.first);
+            }
+            if (proof) {
+                proofUpdates.emplace_back(std::move(proof), p.second);
             }
+        }
+    }
 
-            if (!vr.hasFinalized()) {
-                // This item has note been finalized, so we have nothing more to
-                // do.
-                updates.emplace_back(
-                    pindex, vr.isAccepted() ? BlockUpdate::Status::Accepted
-                                            : BlockUpdate::Status::Rejected);
-                continue;
+    if (!txBatch.empty()) {
+        std::vector<std::pair<TxId, BlockUpdate::Status>> txStatuses;
+        txVoteRecords.getWriteView()->registerVotes(
+            nodeid, txBatch, [&](const TxId &txid, const VoteRecord &vr) {
+                txStatuses.emplace_back(txid, GetUpdateStatus(vr));
+            });
+
+        for (const auto &p : txStatuses) {
+            const bool finalized =
+                p.second == BlockUpdate::Status::Finalized ||
+                p.second == BlockUpdate::Status::Invalid;
+
+            CTransactionRef tx;
+            {
+                LOCK(cs_conflictingTxs);
+                auto it = conflictingTxs.find(p.first);
+                if (it != conflictingTxs.end()) {
+                    tx = it->second.tx;
+                    if (finalized) {
+                        // The vote is over, the caller gets the last
+                        // reference to that transaction.
+                        eraseConflictingTx(it);
+                    }
+                }
             }
 
-            // We just finalized a vote. If it is valid, then let the caller
-            // know. Either way, remove the item from the map.
-            updates.emplace_back(pindex, vr.isAccepted()
-                                             ? BlockUpdate::Status::Finalized
-                                             : BlockUpdate::Status::Invalid);
-            w->erase(it);
+            if (!tx) {
+                tx = mempool.get(p.first);
+            }
+            if (tx) {
+                txUpdates.emplace_back(std::move(tx), p.second);
+            }
         }
     }
 
@@ -615,42 +693,136 @@ bool Processor::stopEventLoop() {
     return eventLoop.stopEventLoop();
 }
 
-std::vector<CInv> Processor::getInvsForNextPoll(bool forPoll) {
-    std::vector<CInv> invs;
+/**
+ * Return the items from a vote record store which can be polled, starting at
+ * the given offset so every item gets its turn. The offset of each candidate
+ * is returned alongside so the caller can move its cursor past the polled
+ * ones.
+ */
+template <typename Store, typename View>
+static std::vector<std::pair<size_t, const typename Store::Entry *>>
+GetPollCandidates(const View &view, size_t start) {
+    std::vector<std::pair<size_t, const typename Store::Entry *>> candidates;
 
-    // First remove all blocks that are not worth polling.
-    {
-        LOCK(cs_main);
-        auto w = vote_records.getWriteView();
-        for (auto it = w->begin(); it != w->end();) {
-            const CBlockIndex *pindex = it->first;
-            if (!IsWorthPolling(pindex)) {
-                w->erase(it++);
-            } else {
-                ++it;
-            }
+    const size_t size = view->size();
+    candidates.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        const size_t offset = (start + i) % size;
+        const auto &e = *(view->begin() + offset);
+        if (e.record.shouldPoll()) {
+            candidates.emplace_back(offset, &e);
         }
     }
 
+    return candidates;
+}
+
+std::vector<CInv>
+Processor::getInvsForNextPoll(bool forPoll, std::vector<VoteRecordRef> *refs) {
+    std::vector<CInv> invs;
+
     auto r = vote_records.getReadView();
-    for (const std::pair<const CBlockIndex *const, VoteRecord> &p :
-         reverse_iterate(r)) {
+    auto rProofs = proofVoteRecords.getReadView();
+    auto rTxs = txVoteRecords.getReadView();
+
+    // Poll the blocks with the most work first.
+    std::vector<const BlockVoteMap::Entry *> candidates;
+    candidates.reserve(r->size());
+    for (const BlockVoteMap::Entry &e : r) {
+        if (e.record.shouldPoll()) {
+            candidates.push_back(&e);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const BlockVoteMap::Entry *a, const BlockVoteMap::Entry *b) {
+                  return CBlockIndexWorkComparator()(b->item, a->item);
+              });
+
+    // Proofs and transactions are polled in turn.
+    const size_t proofStart = proofPollCursor.load();
+    const size_t txStart = txPollCursor.load();
+    const auto proofCandidates =
+        GetPollCandidates<ProofVoteMap>(rProofs, proofStart);
+    const auto txCandidates = GetPollCandidates<TxVoteMap>(rTxs, txStart);
+
+    // Each type gets its share of the poll, and what is left over goes to the
+    // others, blocks first.
+    size_t blockBudget =
+        std::min(candidates.size(), AVALANCHE_BLOCK_POLL_BUDGET);
+    size_t proofBudget =
+        std::min(proofCandidates.size(), AVALANCHE_PROOF_POLL_BUDGET);
+    size_t txBudget = std::min(txCandidates.size(), AVALANCHE_TX_POLL_BUDGET);
+    size_t spare =
+        AVALANCHE_MAX_ELEMENT_POLL - blockBudget - proofBudget - txBudget;
+    for (auto p : {std::make_pair(&blockBudget, candidates.size()),
+                   std::make_pair(&proofBudget, proofCandidates.size()),
+                   std::make_pair(&txBudget, txCandidates.size())}) {
+        const size_t extra = std::min(spare, p.second - *p.first);
+        *p.first += extra;
+        spare -= extra;
+    }
+
+    size_t polled = 0;
+    for (const BlockVoteMap::Entry *e : candidates) {
+        if (polled >= blockBudget) {
+            break;
+        }
+
         // Check if we can run poll.
-        const bool shouldPoll =
-            forPoll ? p.second.registerPoll() : p.second.shouldPoll();
-        if (!shouldPoll) {
+        if (forPoll && !e->record.registerPoll()) {
             continue;
         }
 
         // We don't have a decision, we need more votes.
-        invs.emplace_back(MSG_BLOCK, p.first->GetBlockHash());
-        if (invs.size() >= AVALANCHE_MAX_ELEMENT_POLL) {
-            // Make sure we do not produce more invs than specified by the
-            // protocol.
-            return invs;
+        invs.emplace_back(MSG_BLOCK, e->item->GetBlockHash());
+        if (refs) {
+            refs->push_back(r->getRef(*e));
+        }
+        polled++;
+    }
+
+    polled = 0;
+    for (const auto &p : proofCandidates) {
+        if (polled >= proofBudget) {
+            break;
+        }
+
+        if (forPoll && !p.second->record.registerPoll()) {
+            continue;
+        }
+
+        invs.emplace_back(MSG_AVA_PROOF, p.second->item);
+        if (refs) {
+            refs->push_back(rProofs->getRef(*p.second));
+        }
+        if (forPoll) {
+            proofPollCursor = p.first + 1;
+        }
+        polled++;
+    }
+
+    polled = 0;
+    for (const auto &p : txCandidates) {
+        if (polled >= txBudget) {
+            break;
+        }
+
+        if (forPoll && !p.second->record.registerPoll()) {
+            continue;
+        }
+
+        invs.emplace_back(MSG_TX, p.second->item);
+        if (refs) {
+            refs->push_back(rTxs->getRef(*p.second));
+        }
+        if (forPoll) {
+            txPollCursor = p.first + 1;
         }
+        polled++;
     }
 
+    // Make sure we do not produce more invs than specified by the protocol.
+    assert(invs.size() <= AVALANCHE_MAX_ELEMENT_POLL);
     return invs;
 }
 
@@ -661,15 +833,18 @@ NodeId Processor::getSuitableNodeToQuery() {
 
 void Processor::clearTimedoutRequests() {
     auto now = std::chrono::steady_clock::now();
-    std::map<CInv, uint8_t> timedout_items{};
+    std::vector<std::pair<CInv, VoteRecordRef>> timedout_items;
 
     {
         // Clear expired requests.
         auto w = queries.getWriteView();
         auto it = w->get<query_timeout>().begin();
         while (it != w->get<query_timeout>().end() && it->timeout < now) {
-            for (const auto &i : it->invs) {
-                timedout_items[i]++;
+            for (size_t i = 0; i < it->invs.size(); i++) {
+                timedout_items.emplace_back(it->invs[i],
+                                            i < it->refs.size()
+                                                ? it->refs[i]
+                                                : VoteRecordRef());
             }
 
             w->get<query_timeout>().erase(it++);
@@ -681,27 +856,74 @@ void Processor::clearTimedoutRequests() {
     }
 
     // In flight request accounting.
-    for (const auto &p : timedout_items) {
-        const CInv &inv = p.first;
-        assert(inv.type == MSG_BLOCK);
+    std::vector<BlockVoteMap::Vote> timedout;
+    std::vector<TxVoteMap::Vote> timedoutTxs;
+    std::vector<ProofVoteMap::Vote> timedoutProofs;
+    timedout.reserve(timedout_items.size());
 
-        CBlockIndex *pindex;
+    {
+        LOCK(cs_main);
+        for (const auto &p : timedout_items) {
+            const CInv &inv = p.first;
+            if (inv.type == MSG_TX) {
+                timedoutTxs.push_back({p.second, TxId(inv.hash), 0});
+                continue;
+            }
 
-        {
-            LOCK(cs_main);
-            pindex = LookupBlockIndex(BlockHash(inv.hash));
-            if (!pindex) {
+            if (inv.type == MSG_AVA_PROOF) {
+                timedoutProofs.push_back({p.second, ProofId(inv.hash), 0});
                 continue;
             }
-        }
 
-        auto w = vote_records.getWriteView();
-        auto it = w->find(pindex);
-        if (it == w.end()) {
-            continue;
+            assert(inv.type == MSG_BLOCK);
+            CBlockIndex *pindex = LookupBlockIndex(BlockHash(inv.hash));
+            if (pindex) {
+                timedout.push_back({p.second, pindex, 0});
+            }
         }
+    }
+
+    vote_records.getWriteView()->clearInflightRequests(timedout);
+    if (!timedoutProofs.empty()) {
+        proofVoteRecords.getWriteView()->clearInflightRequests(timedoutProofs);
+    }
+    if (!timedoutTxs.empty()) {
+        txVoteRecords.getWriteView()->clearInflightRequests(timedoutTxs);
+    }
+}
+
+void Processor::pruneBlockVoteRecords() {
+    LOCK(cs_main);
+    vote_records.getWriteView()->eraseIf(
+        [](const CBlockIndex *pindex, const VoteRecord &) {
+            return !IsWorthPolling(pindex);
+        });
+}
+
+void Processor::pruneVoteRecords() {
+    {
+        LOCK(cs_peerManager);
+        proofVoteRecords.getWriteView()->eraseIf(
+            [&](const ProofId &proofid, const VoteRecord &) {
+                return !peerManager->getProof(proofid) &&
+                       !peerManager->getOrphan(proofid);
+            });
+    }
 
-        it->second.clearInflightRequest(p.second);
+    {
+        auto w = txVoteRecords.getWriteView();
+        LOCK(cs_conflictingTxs);
+        const auto now = GetTime<std::chrono::seconds>();
+        for (auto it = conflictingTxs.begin(); it != conflictingTxs.end();) {
+            it = it->second.expiry <= now ? eraseConflictingTx(it)
+                                          : std::next(it);
+        }
+        // Hold the mempool lock for the whole sweep rather than once per
+        // record.
+        LOCK(mempool.cs);
+        w->eraseIf([&](const TxId &txid, const VoteRecord &) {
+            return !conflictingTxs.count(txid) && !mempool.exists(txid);
+        });
     }
 }
 
@@ -715,13 +937,21 @@ void Processor::runEventLoop() {
     // them.
     clearTimedoutRequests();
 
+    pruneBlockVoteRecords();
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= nextVoteRecordsPrune) {
+        pruneVoteRecords();
+        nextVoteRecordsPrune = now + AVALANCHE_VOTE_RECORDS_PRUNE_INTERVAL;
+    }
+
     // Make sure there is at least one suitable node to query before gathering
     // invs.
     NodeId nodeid = getSuitableNodeToQuery();
     if (nodeid == NO_NODE) {
         return;
     }
-    std::vector<CInv> invs = getInvsForNextPoll();
+    std::vector<VoteRecordRef> refs;
+    std::vector<CInv> invs = getInvsForNextPoll(true, &refs);
     if (invs.empty()) {
         return;
     }
@@ -732,7 +962,8 @@ void Processor::runEventLoop() {
          * never add the request to queries, which ensures bad nodes get cleaned
          * up over time.
          */
-        bool hasSent = connman->ForNode(nodeid, [this, &invs](CNode *pnode) {
+        bool hasSent = connman->ForNode(nodeid, [this, &invs,
+                                                 &refs](CNode *pnode) {
             uint64_t current_round = round++;
 
             {
@@ -741,7 +972,7 @@ void Processor::runEventLoop() {
                     std::chrono::steady_clock::now() + queryTimeoutDuration;
                 // Register the query.
                 queries.getWriteView()->insert(
-                    {pnode->GetId(), current_round, timeout, invs});
+                    {pnode->GetId(), current_round, timeout, invs, refs});
                 // Set the timeout.
                 LOCK(cs_peerManager);
                 peerManager->updateNextRequestTime(pnode->GetId(), timeout);
@@ -796,4 +1027,164 @@ void Processor::broadcastProofs() {
     peerManager->broadcastProofs(*connman);
 }
 
+bool Processor::dumpProofs() const {
+    int64_t start = GetTimeMicros();
+
+    std::vector<std::shared_ptr<Proof>> proofs;
+    {
+        LOCK(cs_peerManager);
+        for (const Peer &peer : peerManager->getPeers()) {
+            proofs.push_back(peer.proof);
+        }
+
+        std::vector<std::shared_ptr<Proof>> orphans =
+            peerManager->getOrphans();
+        proofs.insert(proofs.end(), orphans.begin(), orphans.end());
+    }
+
+    int64_t mid = GetTimeMicros();
+
+    try {
+        FILE *filestr =
+            fsbridge::fopen(GetDataDir() / "avaproofs.dat.new", "wb");
+        if (!filestr) {
+            return false;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+        uint64_t version = AVALANCHE_PROOFS_DUMP_VERSION;
+        file << version;
+
+        file << uint64_t(proofs.size());
+        for (const auto &proof : proofs) {
+            file << *proof;
+        }
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        RenameOver(GetDataDir() / "avaproofs.dat.new",
+                   GetDataDir() / "avaproofs.dat");
+        int64_t last = GetTimeMicros();
+        LogPrintf("Dumped %u avalanche proofs: %dms to copy, %dms to dump\n",
+                  proofs.size(), (mid - start) / 1000, (last - mid) / 1000);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to dump avalanche proofs: %s. Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check the stake signatures of the proofs on several threads. This only fills
+ * the signature cache: the proofs are fully verified when they are added, but
+ * that mostly hits the cache. Only the valid proofs get their signatures
+ * cached, so their stakes are looked up first.
+ */
+static void WarmStakeSignatureCache(
+    const std::vector<std::shared_ptr<Proof>> &proofs) {
+    std::atomic<size_t> next{0};
+    const auto worker = [&]() {
+        for (size_t i = next++; i < proofs.size(); i = next++) {
+            ProofValidationState state;
+            if (WITH_LOCK(cs_main,
+                          return proofs[i]->verifyStakes(
+                              state, ::ChainstateActive().CoinsTip()))) {
+                proofs[i]->verifySignatures(state, true);
+            }
+        }
+    };
+
+    const size_t numThreads = std::min<size_t>(
+        std::clamp(GetNumCores(), 1, MAX_PROOF_LOAD_THREADS), proofs.size());
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) {
+        try {
+            threads.emplace_back(&TraceThread<std::function<void()>>,
+                                 "avaproofs", std::function<void()>(worker));
+        } catch (const std::system_error &e) {
+            // The loading thread does the remaining work.
+            LogPrintf("Unable to start an avalanche proof loading thread: "
+                      "%s\n",
+                      e.what());
+            break;
+        }
+    }
+
+    const auto joinAll = [&]() {
+        for (std::thread &t : threads) {
+            t.join();
+        }
+    };
+    try {
+        worker();
+    } catch (...) {
+        // Let the other workers finish before the vector they read goes away.
+        joinAll();
+        throw;
+    }
+    joinAll();
+}
+
+bool Processor::loadProofs() {
+    int64_t start = GetTimeMicros();
+
+    FILE *filestr = fsbridge::fopen(GetDataDir() / "avaproofs.dat", "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        LogPrintf("Failed to open avalanche proofs file from disk. Continuing "
+                  "anyway.\n");
+        return false;
+    }
+
+    std::vector<std::shared_ptr<Proof>> proofs;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != AVALANCHE_PROOFS_DUMP_VERSION) {
+            return false;
+        }
+
+        uint64_t num;
+        file >> num;
+        while (num--) {
+            auto proof = std::make_shared<Proof>();
+            file >> *proof;
+            proofs.push_back(std::move(proof));
+        }
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to deserialize avalanche proofs file from disk: %s. "
+                  "Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+
+    WarmStakeSignatureCache(proofs);
+
+    size_t count = 0;
+    size_t orphans = 0;
+    for (const auto &proof : proofs) {
+        if (ShutdownRequested()) {
+            return false;
+        }
+
+        LOCK(cs_peerManager);
+        if (peerManager->getPeerId(proof) != NO_PEER) {
+            ++count;
+        } else if (peerManager->isOrphan(proof->getId())) {
+            ++orphans;
+        }
+    }
+
+    LogPrintf("Imported %u avalanche proofs from disk in %dms: %u peers, %u "
+              "orphans, %u failed\n",
+              proofs.size(), (GetTimeMicros() - start) / 1000, count, orphans,
+              proofs.size() - count - orphans);
+    return true;
+}
+
 } // namespace avalanche
@@ -19,13 +19,17 @@
 
 #include <avalanche/node.h>
 #include <avalanche/peermanager.h>
+#include <avalanche/proofid.h>
 #include <avalanche/protocol.h>
+#include <avalanche/voterecord.h>
 #include <blockindexworkcomparator.h>
 #include <eventloop.h>
 #include <interfaces/chain.h>
 #include <interfaces/handler.h>
 #include <key.h>
+#include <primitives/transaction.h>
 #include <rwcollection.h>
+#include <salteduint256hasher.h>
 
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -37,122 +41,71 @@
 #include <chrono>
 #include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 class ArgsManager;
 class Config;
 class CBlockIndex;
 class CScheduler;
+class CTxMemPool;
 class PeerManager;
 struct bilingual_str;
 
 using NodePeerManager = PeerManager;
 
-/**
- * Finalization score.
- */
-static constexpr int AVALANCHE_FINALIZATION_SCORE = 128;
-
 /**
  * Maximum item that can be polled at once.
  */
 static constexpr size_t AVALANCHE_MAX_ELEMENT_POLL = 16;
 
 /**
- * How long before we consider that a query timed out.
+ * Share of each poll reserved for every item type. What is not used by a type
+ * is given to the others, blocks first, then proofs and transactions.
  */
-static constexpr std::chrono::milliseconds AVALANCHE_DEFAULT_QUERY_TIMEOUT{
-    10000};
+static constexpr size_t AVALANCHE_BLOCK_POLL_BUDGET = 8;
+static constexpr size_t AVALANCHE_PROOF_POLL_BUDGET = 4;
+static constexpr size_t AVALANCHE_TX_POLL_BUDGET = 4;
+static_assert(AVALANCHE_BLOCK_POLL_BUDGET + AVALANCHE_PROOF_POLL_BUDGET +
+                      AVALANCHE_TX_POLL_BUDGET ==
+                  AVALANCHE_MAX_ELEMENT_POLL,
+              "The poll budgets must add up to the poll size");
 
 /**
- * How many inflight requests can exist for one item.
+ * Maximum number of transactions and proofs being voted on at once. Items
+ * beyond that are not polled, which bounds the memory used by the votes.
  */
-static constexpr int AVALANCHE_MAX_INFLIGHT_POLL = 10;
-
-namespace avalanche {
-
-class Delegation;
-class PeerManager;
-class Proof;
+static constexpr size_t AVALANCHE_MAX_TX_VOTE_RECORDS = 10000;
+static constexpr size_t AVALANCHE_MAX_PROOF_VOTE_RECORDS = 4096;
 
 /**
- * Vote history.
+ * Transactions conflicting with our mempool are kept aside while they are
+ * voted on. They have their own budget, bounded in count, in size and per
+ * peer, and are dropped if they did not finalize in time, so a peer relaying
+ * conflicts can't fill the transaction vote records.
  */
-struct VoteRecord {
-private:
-    // confidence's LSB bit is the result. Higher bits are actual confidence
-    // score.
-    uint16_t confidence = 0;
-
-    // Historical record of votes.
-    uint8_t votes = 0;
-    // Each bit indicate if the vote is to be considered.
-    uint8_t consider = 0;
-    // How many in flight requests exists for this element.
-    mutable std::atomic<uint8_t> inflight{0};
-
-    // Seed for pseudorandom operations.
-    const uint32_t seed = 0;
-
-    // Track how many successful votes occured.
-    uint32_t successfulVotes = 0;
-
-    // Track the nodes which are part of the quorum.
-    std::array<uint16_t, 8> nodeFilter{{0, 0, 0, 0, 0, 0, 0, 0}};
-
-public:
-    explicit VoteRecord(bool accepted) : confidence(accepted) {}
-
-    /**
-     * Copy semantic
-     */
-    VoteRecord(const VoteRecord &other)
-        : confidence(other.confidence), votes(other.votes),
-          consider(other.consider), inflight(other.inflight.load()),
-          successfulVotes(other.successfulVotes), nodeFilter(other.nodeFilter) {
-    }
-
-    /**
-     * Vote accounting facilities.
-     */
-    bool isAccepted() const { return confidence & 0x01; }
-
-    uint16_t getConfidence() const { return confidence >> 1; }
-    bool hasFinalized() const {
-        return getConfidence() >= AVALANCHE_FINALIZATION_SCORE;
-    }
+static constexpr size_t AVALANCHE_MAX_CONFLICTING_TXS = 1000;
+static constexpr size_t AVALANCHE_MAX_CONFLICTING_TXS_SIZE = 4 * 1000 * 1000;
+static constexpr size_t AVALANCHE_MAX_CONFLICTING_TXS_PER_PEER = 100;
+static constexpr std::chrono::minutes AVALANCHE_CONFLICTING_TX_EXPIRY{10};
 
-    /**
-     * Register a new vote for an item and update confidence accordingly.
-     * Returns true if the acceptance or finalization state changed.
-     */
-    bool registerVote(NodeId nodeid, uint32_t error);
-
-    /**
-     * Register that a request is being made regarding that item.
-     * The method is made const so that it can be accessed via a read only view
-     * of vote_records. It's not a problem as it is made thread safe.
-     */
-    bool registerPoll() const;
+/**
+ * How often the proofs and transactions which are no longer worth polling are
+ * removed from the vote records. This is too costly to be done on every poll.
+ */
+static constexpr std::chrono::seconds AVALANCHE_VOTE_RECORDS_PRUNE_INTERVAL{1};
 
-    /**
-     * Return if this item is in condition to be polled at the moment.
-     */
-    bool shouldPoll() const { return inflight < AVALANCHE_MAX_INFLIGHT_POLL; }
+/**
+ * How long before we consider that a query timed out.
+ */
+static constexpr std::chrono::milliseconds AVALANCHE_DEFAULT_QUERY_TIMEOUT{
+    10000};
 
-    /**
-     * Clear `count` inflight requests.
-     */
-    void clearInflightRequest(uint8_t count = 1) { inflight -= count; }
+namespace avalanche {
 
-private:
-    /**
-     * Add the node to the quorum.
-     * Returns true if the node was added, false if the node already was in the
-     * quorum.
-     */
-    bool addNodeToQuorum(NodeId nodeid);
-};
+class Delegation;
+class PeerManager;
+class Proof;
 
 class BlockUpdate {
     union {
@@ -190,8 +143,27 @@ public:
     }
 };
 
-using BlockVoteMap =
-    std::map<const CBlockIndex *, VoteRecord, CBlockIndexWorkComparator>;
+/**
+ * Outcome of the votes for a transaction or a proof.
+ */
+template <typename Item> class ItemUpdate {
+    Item item;
+    BlockUpdate::Status status;
+
+public:
+    ItemUpdate(Item itemIn, BlockUpdate::Status statusIn)
+        : item(std::move(itemIn)), status(statusIn) {}
+
+    BlockUpdate::Status getStatus() const { return status; }
+    const Item &getItem() const { return item; }
+};
+
+using TxUpdate = ItemUpdate<CTransactionRef>;
+using ProofUpdate = ItemUpdate<std::shared_ptr<Proof>>;
+
+using BlockVoteMap = VoteRecordStore<const CBlockIndex *>;
+using TxVoteMap = VoteRecordStore<TxId, SaltedUint256Hasher>;
+using ProofVoteMap = VoteRecordStore<ProofId, SaltedProofIdHasher>;
 
 struct query_timeout {};
 
@@ -202,12 +174,53 @@ namespace {
 class Processor {
     CConnman *connman;
     NodePeerManager *nodePeerManager;
+    CTxMemPool &mempool;
     std::chrono::milliseconds queryTimeoutDuration;
 
     /**
-     * Blocks to run avalanche on.
+     * Items to run avalanche on, one store per inventory type. When several
+     * are needed, they are locked in this order.
      */
     RWCollection<BlockVoteMap> vote_records;
+    RWCollection<ProofVoteMap> proofVoteRecords;
+    RWCollection<TxVoteMap> txVoteRecords;
+
+    /**
+     * Transactions being voted on which are not in our mempool because they
+     * conflict with one that is. They are kept so they can replace it if
+     * they get finalized.
+     */
+    struct ConflictingTx {
+        CTransactionRef tx;
+        /** The peer which relayed it. */
+        NodeId nodeid;
+        std::chrono::seconds expiry;
+    };
+    using ConflictingTxMap =
+        std::unordered_map<TxId, ConflictingTx, SaltedUint256Hasher>;
+
+    mutable Mutex cs_conflictingTxs;
+    ConflictingTxMap conflictingTxs GUARDED_BY(cs_conflictingTxs);
+    /** Total serialized size of the conflicting transactions. */
+    size_t conflictingTxsSize GUARDED_BY(cs_conflictingTxs) = 0;
+    std::unordered_map<NodeId, size_t>
+        conflictingTxsPerPeer GUARDED_BY(cs_conflictingTxs);
+
+    ConflictingTxMap::iterator
+    eraseConflictingTx(ConflictingTxMap::iterator it)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_conflictingTxs);
+
+    /**
+     * Where to resume polling transactions and proofs, so all the items get
+     * their turn.
+     */
+    std::atomic<size_t> proofPollCursor{0};
+    std::atomic<size_t> txPollCursor{0};
+
+    std::atomic<bool> proofsLoaded{false};
+
+    /** When the vote records are pruned next, see pruneVoteRecords(). */
+    TimePoint nextVoteRecordsPrune;
 
     /**
      * Keep track of peers and queries sent.
@@ -232,6 +245,8 @@ class Processor {
          * /!\ Do not use any mutable field as index.
          */
         mutable std::vector<CInv> invs;
+        /** Where the records of the polled items were, see VoteRecordRef. */
+        mutable std::vector<VoteRecordRef> refs;
     };
 
     using QuerySet = boost::multi_index_container<
@@ -269,7 +284,7 @@ class Processor {
     bool mustRegisterProof = false;
 
     Processor(interfaces::Chain &chain, CConnman *connmanIn,
-              NodePeerManager *nodePeerManagerIn,
+              NodePeerManager *nodePeerManagerIn, CTxMemPool &mempoolIn,
               std::unique_ptr<PeerData> peerDataIn, CKey sessionKeyIn);
 
 public:
@@ -278,7 +293,7 @@ public:
     static std::unique_ptr<Processor>
     MakeProcessor(const ArgsManager &argsman, interfaces::Chain &chain,
                   CConnman *connman, NodePeerManager *nodePeerManager,
-                  bilingual_str &error);
+                  CTxMemPool &mempool, bilingual_str &error);
 
     void setQueryTimeoutDuration(std::chrono::milliseconds d) {
         queryTimeoutDuration = d;
@@ -288,10 +303,36 @@ public:
     bool isAccepted(const CBlockIndex *pindex) const;
     int getConfidence(const CBlockIndex *pindex) const;
 
+    /**
+     * Start voting on a transaction. It is accepted if it is in our mempool,
+     * otherwise it is a conflicting transaction relayed by nodeid which we
+     * keep aside.
+     */
+    bool addTxToReconcile(const CTransactionRef &tx, bool accepted,
+                          NodeId nodeid = NO_NODE);
+    bool isAccepted(const TxId &txid) const;
+    int getConfidence(const TxId &txid) const;
+    /** Return the transaction if it is a conflicting one being voted on. */
+    CTransactionRef getConflictingTx(const TxId &txid) const;
+
+    /** Start voting on a proof, it is accepted if it is a valid one. */
+    bool addProofToReconcile(const std::shared_ptr<Proof> &proof);
+    bool isAccepted(const ProofId &proofid) const;
+    int getConfidence(const ProofId &proofid) const;
+
     // TDOD: Refactor the API to remove the dependency on avalanche/protocol.h
     void sendResponse(CNode *pfrom, Response response) const;
     bool registerVotes(NodeId nodeid, const Response &response,
-                       std::vector<BlockUpdate> &updates);
+                       std::vector<BlockUpdate> &blockUpdates,
+                       std::vector<TxUpdate> &txUpdates,
+                       std::vector<ProofUpdate> &proofUpdates);
+    bool registerVotes(NodeId nodeid, const Response &response,
+                       std::vector<BlockUpdate> &updates) {
+        std::vector<TxUpdate> txUpdates;
+        std::vector<ProofUpdate> proofUpdates;
+        return registerVotes(nodeid, response, updates, txUpdates,
+                             proofUpdates);
+    }
 
     bool addNode(NodeId nodeid, const Delegation &delegation);
     bool forNode(NodeId nodeid, std::function<bool(const Node &n)> func) const;
@@ -320,10 +361,40 @@ public:
     void removeUnbroadcastProof(const ProofId &proofid);
     void broadcastProofs();
 
+    /**
+     * Save the proofs of the peers and the orphan proofs to avaproofs.dat, so
+     * they do not need to be fetched from the network again after a restart.
+     */
+    bool dumpProofs() const;
+    /**
+     * Load the proofs saved by dumpProofs. They are verified again, the
+     * signatures being checked on several threads.
+     */
+    bool loadProofs();
+    /**
+     * Whether the proofs were loaded from avaproofs.dat. Until then,
+     * dumpProofs() would overwrite the file with a partial set.
+     */
+    bool isProofsLoaded() const { return proofsLoaded; }
+    void setProofsLoaded(bool loaded) { proofsLoaded = loaded; }
+
 private:
     void runEventLoop();
     void clearTimedoutRequests();
-    std::vector<CInv> getInvsForNextPoll(bool forPoll = true);
+    /**
+     * Remove the blocks which got invalid or too old. There are few of them,
+     * so this is done before every poll.
+     */
+    void pruneBlockVoteRecords();
+    /**
+     * Remove the other items which are no longer worth polling: proofs which
+     * were dropped, transactions which got mined or evicted and conflicting
+     * transactions which did not finalize in time.
+     */
+    void pruneVoteRecords();
+    std::vector<CInv>
+    getInvsForNextPoll(bool forPoll = true,
+                       std::vector<VoteRecordRef> *refs = nullptr);
     NodeId getSuitableNodeToQuery();
 
     /**
@@ -19,6 +19,7 @@
 #include <avalanche/validation.h>
 #include <coins.h>
 #include <hash.h>
+#include <script/sigcache.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <util/strencodings.h>
@@ -82,7 +83,7 @@ uint32_t Proof::getScore() const {
     return uint32_t((100 * total) / COIN);
 }
 
-bool Proof::verify(ProofValidationState &state) const {
+bool Proof::checkStakes(ProofValidationState &state) const {
     if (stakes.empty()) {
         return state.Invalid(ProofValidationResult::NO_STAKE, "no-stake");
     }
@@ -107,19 +108,52 @@ bool Proof::verify(ProofValidationState &state) const {
             return state.Invalid(ProofValidationResult::DUPLICATE_STAKE,
                                  "duplicated-stake");
         }
+    }
+
+    return true;
+}
 
-        if (!ss.verify(proofid)) {
+bool Proof::verifySignatures(ProofValidationState &state,
+                             bool cacheSignatures) const {
+    // Proofs are checked again on every new tip, so the signatures of the
+    // valid ones are remembered.
+    std::vector<uint256> hashes;
+    hashes.reserve(stakes.size());
+    for (const SignedStake &ss : stakes) {
+        const Stake &s = ss.getStake();
+        hashes.push_back(s.getHash(proofid));
+        if (!IsSchnorrSignatureCached(s.getPubkey(), hashes.back(),
+                                      ss.getSignature()) &&
+            !s.getPubkey().VerifySchnorr(hashes.back(), ss.getSignature())) {
             return state.Invalid(ProofValidationResult::INVALID_SIGNATURE,
                                  "invalid-signature");
         }
     }
 
+    if (cacheSignatures) {
+        for (size_t i = 0; i < stakes.size(); i++) {
+            AddSchnorrSignatureToCache(stakes[i].getStake().getPubkey(),
+                                       hashes[i], stakes[i].getSignature());
+        }
+    }
+
     return true;
 }
 
+bool Proof::verify(ProofValidationState &state) const {
+    // state is set by the checks.
+    return checkStakes(state) && verifySignatures(state, false);
+}
+
 bool Proof::verify(ProofValidationState &state, const CCoinsView &view) const {
-    if (!verify(state)) {
-        // state is set by verify.
+    // state is set by the checks.
+    return verifyStakes(state, view) && verifySignatures(state, true);
+}
+
+bool Proof::verifyStakes(ProofValidationState &state,
+                         const CCoinsView &view) const {
+    if (!checkStakes(state)) {
+        // state is set by checkStakes.
         return false;
     }
 
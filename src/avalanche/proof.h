@@ -124,7 +124,25 @@ public:
     uint32_t getScore() const;
 
     bool verify(ProofValidationState &state) const;
+    /**
+     * Check the proof against the UTXO set. The stakes are looked up before
+     * the signatures are checked, and the signatures are only cached once the
+     * whole proof is known to be valid.
+     */
     bool verify(ProofValidationState &state, const CCoinsView &view) const;
+
+    /**
+     * The two halves of verify(state, view), so the UTXO set lookups can be
+     * done under a lock which the signature checks don't need.
+     */
+    bool verifyStakes(ProofValidationState &state,
+                      const CCoinsView &view) const;
+    bool verifySignatures(ProofValidationState &state,
+                          bool cacheSignatures) const;
+
+private:
+    /** Checks which need neither the signatures nor the UTXO set. */
+    bool checkStakes(ProofValidationState &state) const;
 };
 
 } // namespace avalanche
@@ -0,0 +1,123 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_AVALANCHE_STAKESAMPLER_H
+#define BITCOIN_AVALANCHE_STAKESAMPLER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace avalanche {
+
+/**
+ * Pick an index at random, with a probability proportional to its weight.
+ *
+ * The weights are kept in a Fenwick tree, so both updating a weight and
+ * picking an index take O(log n). An index with a weight of 0 is never
+ * picked, which means removing an item does not require to rebuild anything.
+ */
+class StakeSampler {
+    /**
+     * tree[i] holds the sum of the weights in the range (i - lsb(i), i], with
+     * a 1-based indexing. tree[0] is unused.
+     */
+    std::vector<uint64_t> tree{0};
+    std::vector<uint32_t> weights;
+    uint64_t total = 0;
+
+    static size_t lsb(size_t i) { return i & (~i + 1); }
+
+    /** Sum of the weights of the first n items. */
+    uint64_t prefixSum(size_t n) const {
+        uint64_t sum = 0;
+        for (; n > 0; n -= lsb(n)) {
+            sum += tree[n];
+        }
+        return sum;
+    }
+
+public:
+    size_t size() const { return weights.size(); }
+    bool empty() const { return weights.empty(); }
+    uint64_t getTotalWeight() const { return total; }
+    uint32_t getWeight(size_t i) const { return weights[i]; }
+
+    void clear() {
+        tree.assign(1, 0);
+        weights.clear();
+        total = 0;
+    }
+
+    void push_back(uint32_t weight) {
+        // The new node covers (n - lsb(n), n], so it sums the weights of the
+        // items it covers in addition to its own.
+        const size_t n = weights.size() + 1;
+        tree.push_back(weight + prefixSum(n - 1) - prefixSum(n - lsb(n)));
+        weights.push_back(weight);
+        total += weight;
+    }
+
+    /** The nodes of the other items do not cover the last one. */
+    void pop_back() {
+        assert(!weights.empty());
+        total -= weights.back();
+        weights.pop_back();
+        tree.pop_back();
+    }
+
+    void update(size_t i, uint32_t weight) {
+        assert(i < weights.size());
+        const uint64_t old = weights[i];
+        weights[i] = weight;
+        total = total - old + weight;
+        for (size_t n = i + 1; n < tree.size(); n += lsb(n)) {
+            tree[n] = tree[n] - old + weight;
+        }
+    }
+
+    /**
+     * Return the index of the item covering the given point, with the items
+     * laid out one after the other according to their weight. point must be
+     * lower than the total weight.
+     */
+    size_t select(uint64_t point) const {
+        assert(point < total);
+
+        size_t step = 1;
+        while (2 * step < tree.size()) {
+            step *= 2;
+        }
+
+        // Find the largest n such as prefixSum(n) <= point. The item at this
+        // (0-based) index is the one we are looking for.
+        size_t n = 0;
+        for (; step > 0; step /= 2) {
+            if (n + step < tree.size() && tree[n + step] <= point) {
+                n += step;
+                point -= tree[n];
+            }
+        }
+
+        assert(n < weights.size());
+        return n;
+    }
+};
+
+} // namespace avalanche
+
+#endif // BITCOIN_AVALANCHE_STAKESAMPLER_H
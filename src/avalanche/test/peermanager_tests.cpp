@@ -25,6 +25,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <map>
+
 using namespace avalanche;
 
 BOOST_FIXTURE_TEST_SUITE(peermanager_tests, TestingSetup)
@@ -322,6 +324,117 @@ BOOST_AUTO_TEST_CASE(compact_slots) {
     BOOST_CHECK_EQUAL(pm.getFragmentation(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(stake_sampler) {
+    StakeSampler sampler;
+    std::vector<uint32_t> weights;
+
+    const auto checkSelect = [&]() {
+        BOOST_CHECK_EQUAL(sampler.size(), weights.size());
+        uint64_t total = 0;
+        for (size_t i = 0; i < weights.size(); i++) {
+            BOOST_CHECK_EQUAL(sampler.getWeight(i), weights[i]);
+            total += weights[i];
+        }
+        BOOST_CHECK_EQUAL(sampler.getTotalWeight(), total);
+
+        for (int k = 0; k < 100 && total > 0; k++) {
+            const uint64_t point = InsecureRandRange(total);
+
+            // Linear search for the expected index.
+            size_t expected = 0;
+            for (uint64_t stop = weights[0]; stop <= point;
+                 stop += weights[++expected]) {
+            }
+
+            const size_t i = sampler.select(point);
+            BOOST_CHECK_EQUAL(i, expected);
+            BOOST_CHECK_GT(weights[i], 0);
+        }
+    };
+
+    for (int c = 0; c < 1000; c++) {
+        switch (InsecureRandBits(2)) {
+            case 0:
+            case 1: {
+                const uint32_t w =
+                    InsecureRandBits(1) ? InsecureRandBits(8) : 0;
+                sampler.push_back(w);
+                weights.push_back(w);
+            } break;
+            case 2:
+                if (!weights.empty()) {
+                    const size_t i = InsecureRandRange(weights.size());
+                    const uint32_t w = InsecureRandBits(8);
+                    sampler.update(i, w);
+                    weights[i] = w;
+                }
+                break;
+            case 3:
+                if (!weights.empty()) {
+                    sampler.pop_back();
+                    weights.pop_back();
+                }
+                break;
+        }
+
+        checkSelect();
+    }
+
+    sampler.clear();
+    weights.clear();
+    checkSelect();
+    BOOST_CHECK(sampler.empty());
+}
+
+BOOST_AUTO_TEST_CASE(select_peer_distribution) {
+    avalanche::PeerManager pm;
+
+    constexpr int numPeers = 64;
+    std::vector<PeerId> peerids;
+    std::vector<uint32_t> scores;
+    for (int i = 0; i < numPeers; i++) {
+        const uint32_t score = (1 + InsecureRandRange(8)) * 100;
+        auto p = getRandomProofPtr(score);
+        peerids.push_back(pm.getPeerId(p));
+        scores.push_back(score);
+        BOOST_CHECK(pm.addNode(i, DelegationBuilder(*p).build()));
+    }
+
+    // Remove a quarter of the peers, but do not compact.
+    std::map<PeerId, uint32_t> expected;
+    uint64_t totalScore = 0;
+    for (int i = 0; i < numPeers; i++) {
+        if (i % 4 == 1) {
+            BOOST_CHECK(pm.removePeer(peerids[i]));
+            continue;
+        }
+
+        expected[peerids[i]] = scores[i];
+        totalScore += scores[i];
+    }
+    BOOST_CHECK_GT(pm.getFragmentation(), 0);
+    BOOST_CHECK(pm.verify());
+
+    constexpr int numDraws = 100000;
+    std::map<PeerId, int> draws;
+    for (int i = 0; i < numDraws; i++) {
+        const PeerId p = pm.selectPeer();
+        // The removed peers are never selected and we never fail.
+        BOOST_CHECK(expected.count(p));
+        draws[p]++;
+    }
+
+    // Pearson's chi-squared test. With 47 degrees of freedom, the critical
+    // value for p = 0.0001 is about 91.
+    double chi2 = 0;
+    for (const auto &e : expected) {
+        const double mean = double(numDraws) * e.second / totalScore;
+        const double diff = draws[e.first] - mean;
+        chi2 += diff * diff / mean;
+    }
+    BOOST_CHECK_LT(chi2, 91);
+}
+
 BOOST_AUTO_TEST_CASE(node_crud) {
     avalanche::PeerManager pm;
 
@@ -21,7 +21,10 @@
 #include <avalanche/proofbuilder.h>
 #include <chain.h>
 #include <config.h>
+#include <fs.h>
 #include <net_processing.h> // For ::PeerManager
+#include <txmempool.h>
+#include <util/system.h>
 #include <util/time.h>
 #include <util/translation.h> // For bilingual_str
 // D6970 moved LookupBlockIndex from chain.h to validation.h TODO: remove this
@@ -32,6 +35,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <map>
+
 using namespace avalanche;
 
 namespace avalanche {
@@ -40,6 +45,11 @@ namespace {
         static void runEventLoop(avalanche::Processor &p) { p.runEventLoop(); }
 
         static std::vector<CInv> getInvsForNextPoll(Processor &p) {
+            // The event loop prunes the proofs and transactions on a timer.
+            // Prune everything every time here so the tests don't depend on
+            // it.
+            p.pruneBlockVoteRecords();
+            p.pruneVoteRecords();
             return p.getInvsForNextPoll(false);
         }
 
@@ -95,9 +105,9 @@ struct AvalancheTestingSetup : public TestChain100Setup {
 
         // Get the processor ready.
         bilingual_str error;
-        m_processor = Processor::MakeProcessor(*m_node.args, *m_node.chain,
-                                               m_node.connman.get(),
-                                               m_node.peerman.get(), error);
+        m_processor = Processor::MakeProcessor(
+            *m_node.args, *m_node.chain, m_node.connman.get(),
+            m_node.peerman.get(), *m_node.mempool, error);
         BOOST_CHECK(m_processor);
 
         // The master private key we delegate to.
@@ -279,6 +289,77 @@ BOOST_AUTO_TEST_CASE(vote_record) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(vote_record_store) {
+    using Store = VoteRecordStore<int>;
+    Store store;
+
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK(store.insert(i, VoteRecord(true)));
+    }
+    BOOST_CHECK(!store.insert(3, VoteRecord(false)));
+    BOOST_CHECK_EQUAL(store.size(), 10);
+    BOOST_CHECK(store.find(3)->isAccepted());
+    BOOST_CHECK(store.find(10) == nullptr);
+
+    std::map<int, VoteRecordRef> refs;
+    for (const Store::Entry &e : store) {
+        refs[e.item] = store.getRef(e);
+    }
+
+    // Removing an item moves the last record in its place.
+    BOOST_CHECK(store.erase(3));
+    BOOST_CHECK(!store.erase(3));
+    BOOST_CHECK_EQUAL(store.size(), 9);
+    BOOST_CHECK(store.find(3) == nullptr);
+    BOOST_CHECK(store.find(9) != nullptr);
+
+    // Votes are applied through the refs, or by item when the record moved,
+    // and the ones for removed items are ignored.
+    std::vector<int> updated;
+    auto registerVotes = [&](uint32_t error) {
+        std::vector<Store::Vote> votes;
+        for (int i : {9, 3, 0}) {
+            votes.push_back({refs[i], i, error});
+        }
+        store.registerVotes(NO_NODE, votes,
+                            [&](int item, const VoteRecord &) {
+                                updated.push_back(item);
+                            });
+    };
+
+    for (int i = 0; i < 6; i++) {
+        registerVotes(1);
+        BOOST_CHECK(updated.empty());
+    }
+    registerVotes(1);
+    std::sort(updated.begin(), updated.end());
+    BOOST_CHECK(updated == std::vector<int>({0, 9}));
+    BOOST_CHECK(!store.find(0)->isAccepted());
+    BOOST_CHECK(!store.find(9)->isAccepted());
+    BOOST_CHECK(store.find(1)->isAccepted());
+    updated.clear();
+
+    // Finalized records are removed once the batch is applied.
+    for (int i = 1; i < AVALANCHE_FINALIZATION_SCORE; i++) {
+        registerVotes(1);
+        BOOST_CHECK(updated.empty());
+        BOOST_CHECK_EQUAL(store.find(9)->getConfidence(), i);
+    }
+    registerVotes(1);
+    BOOST_CHECK_EQUAL(updated.size(), 2);
+    BOOST_CHECK_EQUAL(store.size(), 7);
+    BOOST_CHECK(store.find(0) == nullptr);
+    BOOST_CHECK(store.find(9) == nullptr);
+
+    // The remaining items are still reachable.
+    store.eraseIf([](int item, const VoteRecord &) { return item % 2; });
+    BOOST_CHECK_EQUAL(store.size(), 4);
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK_EQUAL(store.find(i) != nullptr,
+                          i != 0 && i != 3 && i % 2 == 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(block_update) {
     CBlockIndex index;
     CBlockIndex *pindex = &index;
@@ -1026,4 +1107,304 @@ BOOST_AUTO_TEST_CASE(proof_accessors) {
         !m_processor->addProof(std::make_shared<Proof>(std::move(badProof))));
 }
 
+static CTransactionRef MakeTx(const COutPoint &outpoint, uint32_t locktime) {
+    CMutableTransaction mtx;
+    mtx.nLockTime = locktime;
+    mtx.vin.emplace_back(outpoint);
+    mtx.vout.emplace_back(SATOSHI, CScript() << OP_TRUE);
+    return MakeTransactionRef(std::move(mtx));
+}
+
+BOOST_AUTO_TEST_CASE(tx_and_proof_register) {
+    std::vector<BlockUpdate> updates;
+    std::vector<TxUpdate> txUpdates;
+    std::vector<ProofUpdate> proofUpdates;
+
+    auto avanodes = ConnectNodes();
+
+    // Two transactions spending the same output, only the first one makes it
+    // to the mempool.
+    const COutPoint outpoint(TxId(GetRandHash()), 0);
+    CTransactionRef tx1 = MakeTx(outpoint, 1);
+    CTransactionRef tx2 = MakeTx(outpoint, 2);
+    {
+        LOCK2(cs_main, m_node.mempool->cs);
+        m_node.mempool->addUnchecked(TestMemPoolEntryHelper().FromTx(tx1));
+    }
+
+    BOOST_CHECK(!m_processor->isAccepted(tx1->GetId()));
+    BOOST_CHECK_EQUAL(m_processor->getConfidence(tx1->GetId()), -1);
+
+    BOOST_CHECK(m_processor->addTxToReconcile(tx1, true));
+    BOOST_CHECK(m_processor->addTxToReconcile(tx2, false));
+    BOOST_CHECK(!m_processor->addTxToReconcile(tx1, true));
+    BOOST_CHECK(m_processor->isAccepted(tx1->GetId()));
+    BOOST_CHECK(!m_processor->isAccepted(tx2->GetId()));
+    BOOST_CHECK(!m_processor->getConflictingTx(tx1->GetId()));
+    BOOST_CHECK(m_processor->getConflictingTx(tx2->GetId()) == tx2);
+
+    auto proof = GetProof();
+    const ProofId &proofid = proof->getId();
+    BOOST_CHECK(m_processor->addProof(proof));
+    BOOST_CHECK(m_processor->addProofToReconcile(proof));
+    BOOST_CHECK(!m_processor->addProofToReconcile(proof));
+    BOOST_CHECK(m_processor->isAccepted(proofid));
+
+    // Proofs are polled before transactions.
+    auto invs = getInvsForNextPoll();
+    BOOST_CHECK_EQUAL(invs.size(), 3);
+    BOOST_CHECK_EQUAL(invs[0].type, MSG_AVA_PROOF);
+    BOOST_CHECK(invs[0].hash == proofid);
+    BOOST_CHECK_EQUAL(invs[1].type, MSG_TX);
+    BOOST_CHECK(invs[1].hash == tx1->GetId());
+    BOOST_CHECK_EQUAL(invs[2].type, MSG_TX);
+    BOOST_CHECK(invs[2].hash == tx2->GetId());
+
+    int nextNodeIndex = 0;
+    auto registerNewVote = [&](const Response &resp) {
+        runEventLoop();
+        auto nodeid = avanodes[nextNodeIndex++ % avanodes.size()]->GetId();
+        BOOST_CHECK(m_processor->registerVotes(nodeid, resp, updates,
+                                               txUpdates, proofUpdates));
+    };
+
+    // The network prefers the conflicting transaction.
+    Response resp{getRound(),
+                  0,
+                  {Vote(0, proofid), Vote(1, tx1->GetId()),
+                   Vote(0, tx2->GetId())}};
+    for (int i = 0; i < 6; i++) {
+        registerNewVote(next(resp));
+        BOOST_CHECK(m_processor->isAccepted(tx1->GetId()));
+        BOOST_CHECK(!m_processor->isAccepted(tx2->GetId()));
+        BOOST_CHECK_EQUAL(txUpdates.size(), 0);
+    }
+
+    // Now the state will flip.
+    registerNewVote(next(resp));
+    BOOST_CHECK(!m_processor->isAccepted(tx1->GetId()));
+    BOOST_CHECK(m_processor->isAccepted(tx2->GetId()));
+    BOOST_CHECK_EQUAL(txUpdates.size(), 2);
+    for (const TxUpdate &u : txUpdates) {
+        BOOST_CHECK_EQUAL(u.getStatus(), u.getItem() == tx1
+                                             ? BlockUpdate::Status::Rejected
+                                             : BlockUpdate::Status::Accepted);
+    }
+    txUpdates = {};
+
+    // The proof got more votes and is finalized first.
+    for (int i = 7; i < AVALANCHE_FINALIZATION_SCORE + 5; i++) {
+        registerNewVote(next(resp));
+        BOOST_CHECK_EQUAL(proofUpdates.size(), 0);
+    }
+    registerNewVote(next(resp));
+    BOOST_CHECK_EQUAL(proofUpdates.size(), 1);
+    BOOST_CHECK(proofUpdates[0].getItem() == proof);
+    BOOST_CHECK_EQUAL(proofUpdates[0].getStatus(),
+                      BlockUpdate::Status::Finalized);
+    BOOST_CHECK_EQUAL(m_processor->getConfidence(proofid), -1);
+    BOOST_CHECK_EQUAL(txUpdates.size(), 0);
+
+    // Then the transactions.
+    resp = {getRound(), 0, {Vote(1, tx1->GetId()), Vote(0, tx2->GetId())}};
+    for (int i = 0; i < 6 && txUpdates.empty(); i++) {
+        registerNewVote(next(resp));
+    }
+
+    BOOST_CHECK_EQUAL(updates.size(), 0);
+
+    BOOST_CHECK_EQUAL(txUpdates.size(), 2);
+    for (const TxUpdate &u : txUpdates) {
+        BOOST_CHECK_EQUAL(u.getStatus(), u.getItem() == tx1
+                                             ? BlockUpdate::Status::Invalid
+                                             : BlockUpdate::Status::Finalized);
+    }
+
+    // The winning transaction is handed over and no longer kept aside.
+    BOOST_CHECK(!m_processor->getConflictingTx(tx2->GetId()));
+    BOOST_CHECK_EQUAL(m_processor->getConfidence(tx2->GetId()), -1);
+    BOOST_CHECK_EQUAL(getInvsForNextPoll().size(), 0);
+
+    {
+        LOCK2(cs_main, m_node.mempool->cs);
+        m_node.mempool->clear();
+    }
+
+    // Transactions which are neither in the mempool nor conflicting are not
+    // polled anymore.
+    BOOST_CHECK(m_processor->addTxToReconcile(tx1, true));
+    BOOST_CHECK_EQUAL(getInvsForNextPoll().size(), 0);
+    BOOST_CHECK_EQUAL(m_processor->getConfidence(tx1->GetId()), -1);
+}
+
+BOOST_AUTO_TEST_CASE(poll_budget) {
+    auto proof = GetProof();
+    BOOST_CHECK(m_processor->addProof(proof));
+    BOOST_CHECK(m_processor->addProofToReconcile(proof));
+
+    // Without blocks, the transactions get the rest of the poll.
+    const COutPoint outpoint(TxId(GetRandHash()), 0);
+    std::vector<CTransactionRef> txs;
+    for (uint32_t i = 0; i < 2 * AVALANCHE_MAX_ELEMENT_POLL; i++) {
+        txs.push_back(MakeTx(outpoint, i));
+        BOOST_CHECK(m_processor->addTxToReconcile(txs.back(), false));
+    }
+
+    auto invs = getInvsForNextPoll();
+    BOOST_CHECK_EQUAL(invs.size(), AVALANCHE_MAX_ELEMENT_POLL);
+    BOOST_CHECK_EQUAL(invs[0].type, MSG_AVA_PROOF);
+    for (size_t i = 1; i < invs.size(); i++) {
+        BOOST_CHECK_EQUAL(invs[i].type, MSG_TX);
+    }
+
+    // Blocks can't take the share of the transactions, but get what the
+    // proofs leave over.
+    for (int i = 0; i < 12; i++) {
+        CBlock block = CreateAndProcessBlock({}, CScript());
+        LOCK(cs_main);
+        BOOST_CHECK(m_processor->addBlockToReconcile(
+            LookupBlockIndex(block.GetHash())));
+    }
+
+    invs = getInvsForNextPoll();
+    BOOST_CHECK_EQUAL(invs.size(), AVALANCHE_MAX_ELEMENT_POLL);
+    std::map<int, size_t> counts;
+    for (const CInv &inv : invs) {
+        counts[inv.type]++;
+    }
+    BOOST_CHECK_EQUAL(counts[MSG_BLOCK], AVALANCHE_MAX_ELEMENT_POLL -
+                                             AVALANCHE_TX_POLL_BUDGET - 1);
+    BOOST_CHECK_EQUAL(counts[MSG_AVA_PROOF], 1);
+    BOOST_CHECK_EQUAL(counts[MSG_TX], AVALANCHE_TX_POLL_BUDGET);
+
+    // The number of transactions being voted on is bounded, the conflicting
+    // ones excepted.
+    const uint32_t start = txs.size();
+    for (uint32_t i = start; i < start + AVALANCHE_MAX_TX_VOTE_RECORDS; i++) {
+        BOOST_CHECK(m_processor->addTxToReconcile(MakeTx(outpoint, i), true));
+    }
+    BOOST_CHECK(!m_processor->addTxToReconcile(
+        MakeTx(outpoint, start + AVALANCHE_MAX_TX_VOTE_RECORDS), true));
+}
+
+BOOST_AUTO_TEST_CASE(conflicting_txs_budget) {
+    const int64_t now = GetTime();
+    SetMockTime(now);
+
+    // The total size of the conflicting transactions is bounded.
+    const COutPoint outpoint(TxId(GetRandHash()), 0);
+    auto makeLargeTx = [&](uint32_t locktime) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = locktime;
+        mtx.vin.emplace_back(outpoint);
+        mtx.vout.emplace_back(SATOSHI,
+                              CScript() << std::vector<uint8_t>(100000));
+        return MakeTransactionRef(std::move(mtx));
+    };
+
+    std::vector<CTransactionRef> txs;
+    size_t totalSize = 0;
+    for (NodeId nodeid = 0;; nodeid++) {
+        CTransactionRef tx = makeLargeTx(nodeid);
+        if (!m_processor->addTxToReconcile(tx, false, nodeid)) {
+            BOOST_CHECK_GT(totalSize + tx->GetTotalSize(),
+                           AVALANCHE_MAX_CONFLICTING_TXS_SIZE);
+            break;
+        }
+        totalSize += tx->GetTotalSize();
+        txs.push_back(tx);
+    }
+    BOOST_CHECK_GT(txs.size(), 0);
+    BOOST_CHECK_EQUAL(getInvsForNextPoll().size(),
+                      std::min(txs.size(), AVALANCHE_MAX_ELEMENT_POLL));
+
+    // They are dropped if they don't finalize in time.
+    SetMockTime(now + count_seconds(AVALANCHE_CONFLICTING_TX_EXPIRY) - 1);
+    BOOST_CHECK(m_processor->getConflictingTx(txs[0]->GetId()) == txs[0]);
+    BOOST_CHECK(!getInvsForNextPoll().empty());
+    SetMockTime(now + count_seconds(AVALANCHE_CONFLICTING_TX_EXPIRY));
+    BOOST_CHECK(getInvsForNextPoll().empty());
+    for (const CTransactionRef &tx : txs) {
+        BOOST_CHECK(!m_processor->getConflictingTx(tx->GetId()));
+        BOOST_CHECK_EQUAL(m_processor->getConfidence(tx->GetId()), -1);
+    }
+
+    // Each peer gets a share of the conflicting transactions.
+    uint32_t locktime = 0;
+    for (size_t i = 0; i < AVALANCHE_MAX_CONFLICTING_TXS_PER_PEER; i++) {
+        BOOST_CHECK(m_processor->addTxToReconcile(MakeTx(outpoint, locktime++),
+                                                  false, 0));
+    }
+    BOOST_CHECK(!m_processor->addTxToReconcile(MakeTx(outpoint, locktime++),
+                                               false, 0));
+
+    // Their number is bounded.
+    for (size_t i = AVALANCHE_MAX_CONFLICTING_TXS_PER_PEER;
+         i < AVALANCHE_MAX_CONFLICTING_TXS; i++) {
+        const NodeId nodeid = 1 + i / AVALANCHE_MAX_CONFLICTING_TXS_PER_PEER;
+        BOOST_CHECK(m_processor->addTxToReconcile(MakeTx(outpoint, locktime++),
+                                                  false, nodeid));
+    }
+    BOOST_CHECK(!m_processor->addTxToReconcile(MakeTx(outpoint, locktime++),
+                                               false, 1000));
+
+    // They don't eat into the budget of the mempool transactions.
+    for (size_t i = 0; i < AVALANCHE_MAX_TX_VOTE_RECORDS; i++) {
+        BOOST_CHECK(m_processor->addTxToReconcile(MakeTx(outpoint, locktime++),
+                                                  true));
+    }
+    BOOST_CHECK(
+        !m_processor->addTxToReconcile(MakeTx(outpoint, locktime++), true));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(dump_and_load_proofs) {
+    constexpr int numProofs = 5;
+
+    std::vector<std::shared_ptr<Proof>> proofs;
+    for (int i = 0; i < numProofs; i++) {
+        proofs.push_back(GetProof());
+        BOOST_CHECK(m_processor->addProof(proofs.back()));
+    }
+
+    // A proof with a stake that is not in the UTXO set becomes an orphan.
+    ProofBuilder pb(0, 0, masterpriv.GetPubKey());
+    BOOST_CHECK(pb.addUTXO(COutPoint(TxId(GetRandHash()), 0), 10 * COIN, 1,
+                           false, coinbaseKey));
+    auto orphan = std::make_shared<Proof>(pb.build());
+    BOOST_CHECK(!m_processor->addProof(orphan));
+    BOOST_CHECK(m_processor->getOrphan(orphan->getId()));
+
+    BOOST_CHECK(m_processor->dumpProofs());
+
+    // Start over with an empty processor and reload the proofs from disk.
+    bilingual_str error;
+    m_processor = Processor::MakeProcessor(*m_node.args, *m_node.chain,
+                                           m_node.connman.get(),
+                                           m_node.peerman.get(),
+                                           *m_node.mempool, error);
+    BOOST_CHECK(m_processor);
+    for (const auto &proof : proofs) {
+        BOOST_CHECK(!m_processor->getProof(proof->getId()));
+    }
+
+    BOOST_CHECK(m_processor->loadProofs());
+    for (const auto &proof : proofs) {
+        auto loaded = m_processor->getProof(proof->getId());
+        BOOST_CHECK(loaded != nullptr);
+        BOOST_CHECK(loaded->getId() == proof->getId());
+    }
+    BOOST_CHECK(m_processor->getOrphan(orphan->getId()));
+
+    // A corrupted file is ignored.
+    {
+        FILE *file = fsbridge::fopen(GetDataDir() / "avaproofs.dat", "wb");
+        BOOST_CHECK(file);
+        fputs("garbage", file);
+        fclose(file);
+    }
+    BOOST_CHECK(!m_processor->loadProofs());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
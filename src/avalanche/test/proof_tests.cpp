@@ -20,6 +20,7 @@
 #include <avalanche/test/util.h>
 #include <avalanche/validation.h>
 #include <coins.h>
+#include <script/sigcache.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <util/strencodings.h>
@@ -461,4 +462,58 @@ BOOST_AUTO_TEST_CASE(verify) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(signature_cache) {
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+
+    const Amount value = 12345 * COIN;
+    const uint32_t height = 10;
+
+    COutPoint outpoint(TxId(InsecureRand256()), InsecureRand32());
+    CTxOut output(value, GetScriptForRawPubKey(pubkey));
+    coins.AddCoin(outpoint, Coin(output, height, false), false);
+
+    const auto isCached = [](const Proof &p) {
+        for (const SignedStake &ss : p.getStakes()) {
+            const Stake &s = ss.getStake();
+            if (!IsSchnorrSignatureCached(s.getPubkey(), s.getHash(p.getId()),
+                                          ss.getSignature())) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // The stakes are looked up before the signatures are checked, and an
+    // orphan doesn't get its signatures cached.
+    ProofBuilder pbOrphan(0, 0, pubkey);
+    pbOrphan.addUTXO(COutPoint(TxId(InsecureRand256()), 0), value, height,
+                     false, key);
+    Proof orphan = pbOrphan.build();
+
+    ProofValidationState state;
+    BOOST_CHECK(orphan.verify(state));
+    BOOST_CHECK(!orphan.verify(state, coins));
+    BOOST_CHECK(state.GetResult() == ProofValidationResult::MISSING_UTXO);
+    BOOST_CHECK(!isCached(orphan));
+
+    // Neither does a proof which is not checked against the UTXO set.
+    ProofBuilder pb(0, 0, pubkey);
+    pb.addUTXO(outpoint, value, height, false, key);
+    Proof p = pb.build();
+
+    BOOST_CHECK(p.verify(state));
+    BOOST_CHECK(!isCached(p));
+    BOOST_CHECK(p.verifyStakes(state, coins));
+    BOOST_CHECK(!isCached(p));
+
+    // A valid proof does.
+    BOOST_CHECK(p.verify(state, coins));
+    BOOST_CHECK(isCached(p));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
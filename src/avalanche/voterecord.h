@@ -0,0 +1,297 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_AVALANCHE_VOTERECORD_H
+#define BITCOIN_AVALANCHE_VOTERECORD_H
+
+#include <net.h> // For NodeId
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Finalization score.
+ */
+static constexpr int AVALANCHE_FINALIZATION_SCORE = 128;
+
+/**
+ * How many inflight requests can exist for one item.
+ */
+static constexpr int AVALANCHE_MAX_INFLIGHT_POLL = 10;
+
+namespace avalanche {
+
+/**
+ * Vote history.
+ */
+struct VoteRecord {
+private:
+    // confidence's LSB bit is the result. Higher bits are actual confidence
+    // score.
+    uint16_t confidence = 0;
+
+    // Historical record of votes.
+    uint8_t votes = 0;
+    // Each bit indicate if the vote is to be considered.
+    uint8_t consider = 0;
+    // How many in flight requests exists for this element.
+    mutable std::atomic<uint8_t> inflight{0};
+
+    // Seed for pseudorandom operations.
+    const uint32_t seed = 0;
+
+    // Track how many successful votes occured.
+    uint32_t successfulVotes = 0;
+
+    // Track the nodes which are part of the quorum.
+    std::array<uint16_t, 8> nodeFilter{{0, 0, 0, 0, 0, 0, 0, 0}};
+
+public:
+    explicit VoteRecord(bool accepted) : confidence(accepted) {}
+
+    /**
+     * Copy semantic
+     */
+    VoteRecord(const VoteRecord &other)
+        : confidence(other.confidence), votes(other.votes),
+          consider(other.consider), inflight(other.inflight.load()),
+          successfulVotes(other.successfulVotes), nodeFilter(other.nodeFilter) {
+    }
+
+    VoteRecord &operator=(const VoteRecord &other) {
+        confidence = other.confidence;
+        votes = other.votes;
+        consider = other.consider;
+        inflight = other.inflight.load();
+        successfulVotes = other.successfulVotes;
+        nodeFilter = other.nodeFilter;
+        return *this;
+    }
+
+    /**
+     * Vote accounting facilities.
+     */
+    bool isAccepted() const { return confidence & 0x01; }
+
+    uint16_t getConfidence() const { return confidence >> 1; }
+    bool hasFinalized() const {
+        return getConfidence() >= AVALANCHE_FINALIZATION_SCORE;
+    }
+
+    /**
+     * Register a new vote for an item and update confidence accordingly.
+     * Returns true if the acceptance or finalization state changed.
+     */
+    bool registerVote(NodeId nodeid, uint32_t error);
+
+    /**
+     * Register that a request is being made regarding that item.
+     * The method is made const so that it can be accessed via a read only view
+     * of vote_records. It's not a problem as it is made thread safe.
+     */
+    bool registerPoll() const;
+
+    /**
+     * Return if this item is in condition to be polled at the moment.
+     */
+    bool shouldPoll() const { return inflight < AVALANCHE_MAX_INFLIGHT_POLL; }
+
+    /**
+     * Clear `count` inflight requests.
+     */
+    void clearInflightRequest(uint8_t count = 1) { inflight -= count; }
+
+private:
+    /**
+     * Add the node to the quorum.
+     * Returns true if the node was added, false if the node already was in the
+     * quorum.
+     */
+    bool addNodeToQuorum(NodeId nodeid);
+};
+
+/**
+ * Handle on a record of a VoteRecordStore, taken when the item is polled.
+ * It is only a hint: it is checked against the record it points to, and the
+ * item is looked up again if the record moved in the meantime.
+ */
+struct VoteRecordRef {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint64_t id = 0;
+};
+
+/**
+ * Flat storage for the VoteRecords of the items being polled.
+ *
+ * The records live in a contiguous array, so scanning them for the next poll
+ * is cache friendly, and a response is applied in one pass over the array,
+ * in index order, without looking every item up. Records are removed by
+ * swapping the last one in their place, so the array never needs compacting.
+ */
+template <typename Item, typename Hash = std::hash<Item>>
+class VoteRecordStore {
+public:
+    struct Entry {
+        Item item;
+        VoteRecord record;
+        //! Unique for the lifetime of the store, to detect moved records.
+        uint64_t id;
+    };
+
+    struct Vote {
+        VoteRecordRef ref;
+        Item item;
+        uint32_t error;
+    };
+
+private:
+    std::vector<Entry> entries;
+    std::unordered_map<Item, uint32_t, Hash> indices;
+    uint64_t nextId = 1;
+
+    uint32_t resolve(const VoteRecordRef &ref, const Item &item) const {
+        if (ref.index < entries.size() && entries[ref.index].id == ref.id) {
+            return ref.index;
+        }
+
+        auto it = indices.find(item);
+        return it == indices.end() ? std::numeric_limits<uint32_t>::max()
+                                   : it->second;
+    }
+
+public:
+    using iterator = typename std::vector<Entry>::iterator;
+    using const_iterator = typename std::vector<Entry>::const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    bool insert(const Item &item, const VoteRecord &record) {
+        if (!indices.emplace(item, entries.size()).second) {
+            return false;
+        }
+
+        entries.push_back({item, record, nextId++});
+        return true;
+    }
+
+    const VoteRecord *find(const Item &item) const {
+        auto it = indices.find(item);
+        return it == indices.end() ? nullptr : &entries[it->second].record;
+    }
+
+    VoteRecordRef getRef(const Entry &entry) const {
+        return {uint32_t(&entry - entries.data()), entry.id};
+    }
+
+    bool erase(const Item &item) {
+        auto it = indices.find(item);
+        if (it == indices.end()) {
+            return false;
+        }
+
+        const uint32_t index = it->second;
+        indices.erase(it);
+        if (index + 1 != entries.size()) {
+            entries[index] = std::move(entries.back());
+            indices[entries[index].item] = index;
+        }
+        entries.pop_back();
+        return true;
+    }
+
+    template <typename Predicate> void eraseIf(Predicate &&pred) {
+        std::vector<Item> toErase;
+        for (const Entry &e : entries) {
+            if (pred(e.item, e.record)) {
+                toErase.push_back(e.item);
+            }
+        }
+
+        for (const Item &item : toErase) {
+            erase(item);
+        }
+    }
+
+    /**
+     * Clear the inflight requests of items whose poll timed out.
+     */
+    void clearInflightRequests(const std::vector<Vote> &timedout) {
+        for (const Vote &v : timedout) {
+            const uint32_t index = resolve(v.ref, v.item);
+            if (index < entries.size()) {
+                entries[index].record.clearInflightRequest();
+            }
+        }
+    }
+
+    /**
+     * Apply all the votes of a response. Votes are resolved to a record then
+     * sorted, so the records are walked in memory order, and the finalized
+     * ones are only removed once the whole batch has been applied.
+     * onUpdate(item, record) is called for every vote changing the state of
+     * the record.
+     */
+    template <typename Callback>
+    void registerVotes(NodeId nodeid, std::vector<Vote> &votes,
+                       Callback &&onUpdate) {
+        for (Vote &v : votes) {
+            v.ref.index = resolve(v.ref, v.item);
+        }
+        std::sort(votes.begin(), votes.end(),
+                  [](const Vote &a, const Vote &b) {
+                      return a.ref.index < b.ref.index;
+                  });
+
+        std::vector<Item> finalized;
+        for (const Vote &v : votes) {
+            if (v.ref.index >= entries.size()) {
+                // We are not voting on that item anymore.
+                break;
+            }
+
+            Entry &e = entries[v.ref.index];
+            if (!e.record.registerVote(nodeid, v.error)) {
+                // This vote did not provide any extra information, move on.
+                continue;
+            }
+
+            onUpdate(e.item, e.record);
+            if (e.record.hasFinalized()) {
+                finalized.push_back(e.item);
+            }
+        }
+
+        for (const Item &item : finalized) {
+            erase(item);
+        }
+    }
+};
+
+} // namespace avalanche
+
+#endif // BITCOIN_AVALANCHE_VOTERECORD_H
@@ -0,0 +1,79 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <avalanche/stakesampler.h>
+#include <bench/bench.h>
+#include <random.h>
+
+using namespace avalanche;
+
+/** Number of peers, in the same ballpark as the avalanche network. */
+static constexpr size_t NUM_PEERS = 4096;
+static constexpr size_t SELECTIONS = 1000;
+
+static StakeSampler MakeSampler(FastRandomContext &rng) {
+    StakeSampler sampler;
+    for (size_t i = 0; i < NUM_PEERS; i++) {
+        sampler.push_back(1 + rng.randrange(1000000));
+    }
+    return sampler;
+}
+
+/**
+ * Stake weighted selection, as done for every avalanche poll.
+ */
+static void AvalancheStakeSamplerSelect(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    const StakeSampler sampler = MakeSampler(rng);
+    const uint64_t total = sampler.getTotalWeight();
+
+    size_t sum = 0;
+    bench.batch(SELECTIONS).unit("selection").run([&] {
+        for (size_t i = 0; i < SELECTIONS; i++) {
+            sum += sampler.select(rng.randrange(total));
+        }
+    });
+    assert(sum > 0);
+}
+
+/**
+ * Selection while peers come and go, without ever compacting: a quarter of the
+ * peers get removed and replaced between selections.
+ */
+static void AvalancheStakeSamplerChurn(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    StakeSampler sampler = MakeSampler(rng);
+
+    size_t sum = 0;
+    bench.batch(SELECTIONS).unit("selection").run([&] {
+        for (size_t i = 0; i < SELECTIONS; i++) {
+            if (i % 4 == 0) {
+                sampler.update(rng.randrange(sampler.size()), 0);
+                // Dead slots pile up, only the trailing ones are released.
+                if (sampler.size() < 2 * NUM_PEERS) {
+                    sampler.push_back(1 + rng.randrange(1000000));
+                } else {
+                    sampler.pop_back();
+                }
+            }
+            sum += sampler.select(rng.randrange(sampler.getTotalWeight()));
+        }
+    });
+    assert(sum > 0);
+}
+
+BENCHMARK(AvalancheStakeSamplerSelect);
+BENCHMARK(AvalancheStakeSamplerChurn);
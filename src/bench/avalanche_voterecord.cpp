@@ -0,0 +1,82 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <avalanche/voterecord.h>
+#include <bench/bench.h>
+#include <random.h>
+
+#include <vector>
+
+using namespace avalanche;
+
+/** Items being voted on at once, e.g. blocks, transactions and proofs. */
+static constexpr uint32_t NUM_ITEMS = 4096;
+/** Responses applied per benchmark iteration. */
+static constexpr size_t NUM_RESPONSES = 256;
+static constexpr size_t VOTES_PER_RESPONSE = 16;
+static constexpr NodeId NUM_NODES = 64;
+
+/**
+ * Apply responses to a store of items which never finalize, measuring the
+ * vote processing throughput.
+ */
+static void AvalancheRegisterVotes(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    using Store = VoteRecordStore<uint32_t>;
+
+    Store store;
+    for (uint32_t i = 0; i < NUM_ITEMS; i++) {
+        store.insert(i, VoteRecord(true));
+    }
+
+    // Each poll remembers where the records of its items were, like the
+    // processor does, and votes get a mix of yes, no and neutral votes so
+    // the records keep flipping instead of finalizing.
+    std::vector<std::vector<Store::Vote>> responses(NUM_RESPONSES);
+    std::vector<NodeId> nodeids;
+    for (auto &response : responses) {
+        for (size_t i = 0; i < VOTES_PER_RESPONSE; i++) {
+            const uint32_t item = rng.randrange(NUM_ITEMS);
+            const uint32_t error = rng.randrange(4) == 0 ? -1 : rng.randbool();
+            response.push_back({VoteRecordRef(), item, error});
+        }
+        nodeids.push_back(rng.randrange(NUM_NODES));
+    }
+    for (auto &response : responses) {
+        for (Store::Vote &v : response) {
+            for (const Store::Entry &e : store) {
+                if (e.item == v.item) {
+                    v.ref = store.getRef(e);
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t updates = 0;
+    bench.batch(NUM_RESPONSES * VOTES_PER_RESPONSE).unit("vote").run([&] {
+        for (size_t i = 0; i < NUM_RESPONSES; i++) {
+            std::vector<Store::Vote> votes = responses[i];
+            store.registerVotes(nodeids[i], votes,
+                                [&](uint32_t, const VoteRecord &) {
+                                    updates++;
+                                });
+        }
+    });
+    ankerl::nanobench::doNotOptimizeAway(updates);
+}
+
+BENCHMARK(AvalancheRegisterVotes);
@@ -18,6 +18,7 @@
 #include <chainparams.h>
 #include <interfaces/chain.h>
 #include <node/context.h>
+#include <random.h>
 #include <wallet/coinselection.h>
 #include <wallet/wallet.h>
 
@@ -145,5 +146,66 @@ static void BnBExhaustion(benchmark::Bench &bench) {
     });
 }
 
+// Coin selection in a wallet holding a large number of small, randomly sized
+// outputs, as seen on high-volume wallets (exchanges, payment processors).
+static void CoinSelectionLargePool(benchmark::Bench &bench, size_t num_utxos,
+                                   bool use_bnb) {
+    SelectParams(CBaseChainParams::REGTEST);
+
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node, Params());
+    CWallet wallet(chain.get(), WalletLocation(), CreateDummyWalletDatabase());
+    wallet.SetupLegacyScriptPubKeyMan();
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    FastRandomContext rng(true);
+    for (size_t i = 0; i < num_utxos; ++i) {
+        const Amount value =
+            COIN / 1000 + int64_t(rng.randrange(COIN / SATOSHI)) * SATOSHI;
+        addCoin(value, wallet, wtxs);
+    }
+
+    std::vector<OutputGroup> groups;
+    for (const auto &wtx : wtxs) {
+        COutput output(wtx.get(), 0 /* iIn */, 6 * 24 /* nDepthIn */,
+                       true /* spendable */, true /* solvable */,
+                       true /* safe */);
+        groups.emplace_back(output.GetInputCoin(), 6, false, 0, 0);
+    }
+
+    const CoinEligibilityFilter filter_standard(1, 6, 0);
+    const CoinSelectionParams coin_selection_params(
+        use_bnb, 34, 148, CFeeRate(Amount::zero()), 0);
+    bench.run([&] {
+        std::set<CInputCoin> setCoinsRet;
+        Amount nValueRet;
+        bool bnb_used;
+        // BnB may legitimately find no changeless solution, so only the
+        // knapsack solver is required to succeed.
+        bool success = wallet.SelectCoinsMinConf(
+            50 * COIN, filter_standard, groups, setCoinsRet, nValueRet,
+            coin_selection_params, bnb_used);
+        assert(success || use_bnb);
+    });
+}
+
+static void CoinSelectionBnB10k(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, 10000, true);
+}
+static void CoinSelectionBnB100k(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, 100000, true);
+}
+static void CoinSelectionKnapsack10k(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, 10000, false);
+}
+static void CoinSelectionKnapsack100k(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, 100000, false);
+}
+
 BENCHMARK(CoinSelection);
 BENCHMARK(BnBExhaustion);
+BENCHMARK(CoinSelectionBnB10k);
+BENCHMARK(CoinSelectionBnB100k);
+BENCHMARK(CoinSelectionKnapsack10k);
+BENCHMARK(CoinSelectionKnapsack100k);
@@ -70,6 +70,27 @@ static void SHA256D64_1024(benchmark::Bench &bench) {
         [&] { SHA256D64(in.data(), in.data(), 1024); });
 }
 
+static void BIP32Hash_1024(benchmark::Bench &bench) {
+    SHA512AutoDetect();
+    const ChainCode chaincode;
+    const uint8_t data[32] = {};
+    std::vector<uint8_t> out(64 * 1024);
+    bench.batch(1024).unit("child").run([&] {
+        for (uint32_t i = 0; i < 1024; ++i) {
+            BIP32Hash(chaincode, i, 0, data, out.data() + 64 * i);
+        }
+    });
+}
+
+static void BIP32HashBatch_1024(benchmark::Bench &bench) {
+    SHA512AutoDetect();
+    const ChainCode chaincode;
+    const uint8_t data[32] = {};
+    std::vector<uint8_t> out(64 * 1024);
+    bench.batch(1024).unit("child").run(
+        [&] { BIP32HashBatch(chaincode, 0, 1024, 0, data, out.data()); });
+}
+
 static void SHA512(benchmark::Bench &bench) {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
     std::vector<uint8_t> in(BUFFER_SIZE, 0);
@@ -105,5 +126,7 @@ BENCHMARK(SHA3_256_1M);
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
 BENCHMARK(SHA256D64_1024);
+BENCHMARK(BIP32Hash_1024);
+BENCHMARK(BIP32HashBatch_1024);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
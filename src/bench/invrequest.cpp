@@ -0,0 +1,86 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <invrequest.h>
+#include <primitives/txid.h>
+#include <random.h>
+
+#include <chrono>
+#include <vector>
+
+static constexpr NodeId NUM_PEERS = 100;
+static constexpr size_t NUM_INVS = 1000;
+static constexpr size_t ANNOUNCEMENTS_PER_INV = 8;
+
+/**
+ * Simulate a busy relay round: many peers announce the same inventories, the
+ * best candidates get requested and answered, and the rest time out.
+ */
+static void InvRequestTrackerAnnounceRequest(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+
+    std::vector<TxId> txids;
+    txids.reserve(NUM_INVS);
+    for (size_t i = 0; i < NUM_INVS; ++i) {
+        txids.emplace_back(rng.rand256());
+    }
+
+    std::vector<NodeId> announcers;
+    announcers.reserve(NUM_INVS * ANNOUNCEMENTS_PER_INV);
+    for (size_t i = 0; i < NUM_INVS * ANNOUNCEMENTS_PER_INV; ++i) {
+        announcers.push_back(rng.randrange(NUM_PEERS));
+    }
+
+    bench.run([&] {
+        InvRequestTracker<TxId> tracker(true);
+        std::chrono::microseconds now{1};
+
+        for (size_t i = 0; i < NUM_INVS; ++i) {
+            for (size_t j = 0; j < ANNOUNCEMENTS_PER_INV; ++j) {
+                const NodeId peer = announcers[i * ANNOUNCEMENTS_PER_INV + j];
+                tracker.ReceivedInv(peer, txids[i], peer % 4 == 0,
+                                    now + std::chrono::microseconds{j});
+            }
+        }
+
+        std::vector<std::pair<NodeId, TxId>> expired;
+        now += std::chrono::seconds{1};
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+            for (const TxId &txid :
+                 tracker.GetRequestable(peer, now, &expired)) {
+                tracker.RequestedData(peer, txid,
+                                      now + std::chrono::seconds{60});
+                // Half of the requests are answered, the others expire.
+                if (txid.GetUint64(0) & 1) {
+                    tracker.ReceivedResponse(peer, txid);
+                }
+            }
+        }
+
+        now += std::chrono::seconds{120};
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+            tracker.GetRequestable(peer, now, &expired);
+        }
+
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+            tracker.DisconnectedPeer(peer);
+        }
+        assert(tracker.Size() == 0);
+    });
+}
+
+BENCHMARK(InvRequestTrackerAnnounceRequest);
@@ -0,0 +1,135 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <protocol.h>
+#include <random.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <txreconciliation.h>
+#include <version.h>
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static constexpr NodeId INITIATOR_PEER = 0;
+static constexpr NodeId RESPONDER_PEER = 1;
+/** Transactions both peers want to announce to each other. */
+static constexpr size_t NUM_COMMON_TXS = 400;
+/** Transactions only known by one of the peers. */
+static constexpr size_t NUM_DIFFERENT_TXS = 20;
+/** Size of an inv entry on the wire: 4 bytes type and 32 bytes hash. */
+static constexpr size_t INV_ENTRY_SIZE = 36;
+
+/**
+ * Run a reconciliation round between two peers, including the messages
+ * serialization, and return the number of bytes exchanged.
+ */
+static size_t ReconcileOnce(TxReconciliationTracker &initiator,
+                            TxReconciliationTracker &responder,
+                            const std::vector<TxId> &common,
+                            const std::vector<TxId> &different,
+                            std::chrono::microseconds now) {
+    for (const TxId &txid : common) {
+        initiator.AddToSet(RESPONDER_PEER, txid);
+        responder.AddToSet(INITIATOR_PEER, txid);
+    }
+    for (size_t i = 0; i < different.size(); ++i) {
+        if (i % 2) {
+            initiator.AddToSet(RESPONDER_PEER, different[i]);
+        } else {
+            responder.AddToSet(INITIATOR_PEER, different[i]);
+        }
+    }
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    size_t bytes = 0;
+
+    auto request = initiator.MaybeRequestReconciliation(RESPONDER_PEER, now);
+    assert(request);
+    ss << request->set_size << request->round;
+    bytes += ss.size();
+    uint16_t peer_set_size;
+    uint32_t round;
+    ss >> peer_set_size >> round;
+
+    ReconciliationSketch sketch;
+    std::vector<TxId> announced;
+    responder.HandleReconciliationRequest(INITIATOR_PEER, peer_set_size,
+                                          sketch, announced);
+    ss << round << sketch;
+    bytes += ss.size();
+    ss >> round >> sketch;
+
+    bool success = false;
+    std::vector<uint32_t> shortids;
+    initiator.HandleSketch(RESPONDER_PEER, round, sketch, success, announced,
+                           shortids);
+    assert(success);
+    bytes += INV_ENTRY_SIZE * announced.size();
+    ss << success << shortids;
+    bytes += ss.size();
+    ss >> success >> shortids;
+
+    responder.HandleReconciliationDifference(INITIATOR_PEER, success,
+                                             shortids, announced);
+    bytes += INV_ENTRY_SIZE * announced.size();
+    return bytes;
+}
+
+/**
+ * CPU cost of a reconciliation round with one peer. The bytes exchanged with
+ * the peer are printed after the timings, along with what flooding the same
+ * transactions in both directions would cost.
+ */
+static void TxReconciliationRound(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    std::vector<TxId> common, different;
+    for (size_t i = 0; i < NUM_COMMON_TXS; ++i) {
+        common.emplace_back(rng.rand256());
+    }
+    for (size_t i = 0; i < NUM_DIFFERENT_TXS; ++i) {
+        different.emplace_back(rng.rand256());
+    }
+
+    TxReconciliationTracker initiator;
+    TxReconciliationTracker responder;
+    const uint64_t initiator_salt = initiator.PreRegisterPeer(RESPONDER_PEER);
+    const uint64_t responder_salt = responder.PreRegisterPeer(INITIATOR_PEER);
+    initiator.RegisterPeer(RESPONDER_PEER, true, TXRECONCILIATION_VERSION,
+                           responder_salt);
+    responder.RegisterPeer(INITIATOR_PEER, false, TXRECONCILIATION_VERSION,
+                           initiator_salt);
+
+    std::chrono::microseconds now{0};
+    size_t bytes = 0;
+    uint64_t rounds = 0;
+    bench.unit("round").run([&] {
+        now += RECON_REQUEST_INTERVAL;
+        bytes += ReconcileOnce(initiator, responder, common, different, now);
+        ++rounds;
+    });
+
+    // The benchmark only reports timings, the bandwidth is printed apart.
+    const size_t flooding =
+        INV_ENTRY_SIZE * (2 * NUM_COMMON_TXS + NUM_DIFFERENT_TXS);
+    std::cout << strprintf(
+        "TxReconciliationRound: %u bytes/peer, flooding %u bytes/peer\n",
+        bytes / rounds, flooding);
+}
+
+BENCHMARK(TxReconciliationRound);
@@ -51,3 +51,32 @@ static void VerifyNestedIfScript(benchmark::Bench &bench) {
 }
 
 BENCHMARK(VerifyNestedIfScript);
+
+// Verify a spend whose scripts mostly move data around on the stack, so that
+// element allocation rather than signature checking dominates.
+static void VerifyStackOpsScript(benchmark::Bench &bench) {
+    CScript scriptSig;
+    for (uint8_t i = 0; i < 20; ++i) {
+        scriptSig << std::vector<uint8_t>(32, i);
+    }
+
+    CScript scriptPubKey;
+    for (int i = 0; i < 20; ++i) {
+        scriptPubKey << OP_2DUP << OP_CAT << OP_16 << OP_SPLIT << OP_SHA256
+                     << OP_EQUAL << OP_DROP << OP_OVER << OP_HASH160
+                     << OP_DROP;
+    }
+    scriptPubKey << OP_1;
+
+    const uint32_t flags =
+        SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC |
+        SCRIPT_VERIFY_MINIMALDATA | SCRIPT_ENABLE_SIGHASH_FORKID;
+    bench.run([&] {
+        ScriptError error;
+        bool ret = VerifyScript(scriptSig, scriptPubKey, flags,
+                                BaseSignatureChecker(), &error);
+        assert(ret);
+    });
+}
+
+BENCHMARK(VerifyStackOpsScript);
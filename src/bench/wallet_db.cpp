@@ -0,0 +1,171 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <fs.h>
+#include <util/system.h>
+#include <wallet/db.h>
+#include <wallet/walletdb.h>
+
+#include <test/util/setup_common.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+static constexpr uint32_t NUM_RECORDS = 1000;
+
+// Roughly the size of a serialized wallet key record
+static const std::vector<uint8_t> RECORD_VALUE(200, 0x42);
+
+static std::unique_ptr<WalletDatabase>
+CreateBenchDatabase(const std::string &name, DatabaseFormat format) {
+    std::unique_ptr<WalletDatabase> database =
+        CreateWalletDatabase(GetDataDir() / name, format);
+    // Create the database file
+    database->MakeBatch("cr+");
+    return database;
+}
+
+/** Write records one by one, each in its own transaction, like the wallet. */
+static void WalletDatabaseWrite(benchmark::Bench &bench,
+                                DatabaseFormat format) {
+    BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    std::unique_ptr<WalletDatabase> database =
+        CreateBenchDatabase("bench_write", format);
+
+    uint32_t key = 0;
+    bench.batch(NUM_RECORDS).unit("record").run([&] {
+        std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+        for (uint32_t i = 0; i < NUM_RECORDS; ++i) {
+            bool success =
+                batch->Write(std::make_pair(std::string("bench"), key++),
+                             RECORD_VALUE);
+            assert(success);
+        }
+    });
+    database->Flush(true);
+}
+
+/**
+ * Write the records in one transaction, like the imports and the rescans do.
+ */
+static void WalletDatabaseWriteBatched(benchmark::Bench &bench,
+                                       DatabaseFormat format) {
+    BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    std::unique_ptr<WalletDatabase> database =
+        CreateBenchDatabase("bench_write_batched", format);
+
+    uint32_t key = 0;
+    bench.batch(NUM_RECORDS).unit("record").run([&] {
+        std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+        bool success = batch->TxnBegin();
+        for (uint32_t i = 0; i < NUM_RECORDS; ++i) {
+            success &= batch->Write(std::make_pair(std::string("bench"), key++),
+                                    RECORD_VALUE);
+        }
+        success &= batch->TxnCommit();
+        assert(success);
+    });
+    database->Flush(true);
+}
+
+/** Read all the records through a cursor, like the wallet does on load. */
+static void WalletDatabaseLoad(benchmark::Bench &bench, DatabaseFormat format) {
+    BasicTestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    std::unique_ptr<WalletDatabase> database =
+        CreateBenchDatabase("bench_load", format);
+    {
+        std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+        bool success = batch->TxnBegin();
+        for (uint32_t i = 0; i < NUM_RECORDS; ++i) {
+            success &= batch->Write(std::make_pair(std::string("bench"), i),
+                                    RECORD_VALUE);
+        }
+        success &= batch->TxnCommit();
+        assert(success);
+    }
+
+    bench.batch(NUM_RECORDS).unit("record").run([&] {
+        std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+        bool success = batch->StartCursor();
+        uint32_t records = 0;
+        while (success) {
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+            bool complete;
+            success = batch->ReadAtCursor(ssKey, ssValue, complete);
+            if (complete) {
+                break;
+            }
+            ++records;
+        }
+        batch->CloseCursor();
+        assert(success && records >= NUM_RECORDS);
+    });
+    database->Flush(true);
+}
+
+static void WalletDatabaseWriteBDB(benchmark::Bench &bench) {
+    WalletDatabaseWrite(bench, DatabaseFormat::BERKELEY);
+}
+static void WalletDatabaseWriteBatchedBDB(benchmark::Bench &bench) {
+    WalletDatabaseWriteBatched(bench, DatabaseFormat::BERKELEY);
+}
+static void WalletDatabaseLoadBDB(benchmark::Bench &bench) {
+    WalletDatabaseLoad(bench, DatabaseFormat::BERKELEY);
+}
+
+BENCHMARK(WalletDatabaseWriteBDB);
+BENCHMARK(WalletDatabaseWriteBatchedBDB);
+BENCHMARK(WalletDatabaseLoadBDB);
+
+#ifdef USE_SQLITE
+static void WalletDatabaseWriteSQLite(benchmark::Bench &bench) {
+    WalletDatabaseWrite(bench, DatabaseFormat::SQLITE);
+}
+static void WalletDatabaseWriteBatchedSQLite(benchmark::Bench &bench) {
+    WalletDatabaseWriteBatched(bench, DatabaseFormat::SQLITE);
+}
+static void WalletDatabaseLoadSQLite(benchmark::Bench &bench) {
+    WalletDatabaseLoad(bench, DatabaseFormat::SQLITE);
+}
+
+BENCHMARK(WalletDatabaseWriteSQLite);
+BENCHMARK(WalletDatabaseWriteBatchedSQLite);
+BENCHMARK(WalletDatabaseLoadSQLite);
+#endif
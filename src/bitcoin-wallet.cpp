@@ -48,6 +48,10 @@ static void SetupWalletToolArgs(ArgsManager &argsman) {
         "Send trace/debug info to console (default: 1 when no -debug "
         "is true, 0 otherwise).",
         ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-format=<format>",
+                   "The database format of the wallet created by the create "
+                   "command, bdb or sqlite (default: bdb)",
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
     argsman.AddArg("info", "Get wallet info", ArgsManager::ALLOW_ANY,
                    OptionsCategory::COMMANDS);
@@ -56,6 +60,10 @@ static void SetupWalletToolArgs(ArgsManager &argsman) {
     argsman.AddArg("salvage",
                    "Attempt to recover private keys from a corrupt wallet",
                    ArgsManager::ALLOW_ANY, OptionsCategory::COMMANDS);
+    argsman.AddArg("migrate",
+                   "Convert a Berkeley DB wallet file to SQLite, keeping the "
+                   "original file with a .bdb.bak suffix",
+                   ArgsManager::ALLOW_ANY, OptionsCategory::COMMANDS);
 }
 
 static bool WalletAppInit(int argc, char *argv[]) {
@@ -16,6 +16,7 @@
 
 #include <crypto/hmac_sha512.h>
 
+#include <algorithm>
 #include <cstring>
 
 CHMAC_SHA512::CHMAC_SHA512(const uint8_t *key, size_t keylen) {
@@ -44,3 +45,18 @@ void CHMAC_SHA512::Finalize(uint8_t hash[OUTPUT_SIZE]) {
     inner.Finalize(temp);
     outer.Write(temp, 64).Finalize(hash);
 }
+
+void CHMAC_SHA512::FinalizeBatch(uint8_t *output, const uint8_t *input,
+                                 size_t len, size_t count) const {
+    // Work in chunks so that the inner hashes stay on the stack.
+    static constexpr size_t CHUNK_SIZE = 64;
+    uint8_t temp[CHUNK_SIZE * OUTPUT_SIZE];
+    while (count) {
+        const size_t n = std::min(count, CHUNK_SIZE);
+        inner.FinalizeBatch(temp, input, len, n);
+        outer.FinalizeBatch(output, temp, OUTPUT_SIZE, n);
+        output += n * OUTPUT_SIZE;
+        input += n * len;
+        count -= n;
+    }
+}
@@ -37,6 +37,15 @@ public:
         return *this;
     }
     void Finalize(uint8_t hash[OUTPUT_SIZE]);
+
+    /**
+     * Compute the HMAC's of count equally sized messages, each prefixed by
+     * the data already written. The object is not modified.
+     * output:  pointer to a count*64 byte output buffer
+     * input:   pointer to a count*len byte input buffer
+     */
+    void FinalizeBatch(uint8_t *output, const uint8_t *input, size_t len,
+                       size_t count) const;
 };
 
 #endif // BITCOIN_CRYPTO_HMAC_SHA512_H
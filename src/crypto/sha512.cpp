@@ -16,10 +16,20 @@
 
 #include <crypto/sha512.h>
 
+#include <compat/cpuid.h>
 #include <crypto/common.h>
 
+#include <cassert>
 #include <cstring>
 
+namespace sha512_avx2 {
+void Transform_4way(uint8_t *out, const uint64_t *midstate, const uint8_t *in);
+}
+
+namespace sha512_avx512 {
+void Transform_8way(uint8_t *out, const uint64_t *midstate, const uint8_t *in);
+}
+
 // Internal implementation code.
 namespace {
 /// Internal SHA-512 implementation.
@@ -249,8 +259,158 @@ namespace sha512 {
 
 } // namespace sha512
 
+typedef void (*TransformMultiType)(uint8_t *, const uint64_t *,
+                                   const uint8_t *);
+
+TransformMultiType Transform_4way = nullptr;
+TransformMultiType Transform_8way = nullptr;
+
+/**
+ * Check a multi-way transform against the 1-way Transform over the given
+ * blocks, starting from the state after the first block.
+ */
+bool SelfTestMulti(TransformMultiType tr, const uint8_t *blocks,
+                   size_t ways) {
+    uint64_t midstate[8];
+    sha512::Initialize(midstate);
+    sha512::Transform(midstate, blocks);
+
+    uint8_t out[8 * 64];
+    tr(out, midstate, blocks + 128);
+    for (size_t i = 0; i < ways; ++i) {
+        uint64_t s[8];
+        memcpy(s, midstate, sizeof(s));
+        sha512::Transform(s, blocks + 128 * (i + 1));
+        for (int j = 0; j < 8; ++j) {
+            if (ReadBE64(out + 64 * i + 8 * j) != s[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SelfTest() {
+    // Some random input data to test with
+    static const uint8_t data[] =
+        "-" // Intentionally not aligned
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+        "eiusmod tempor incididunt ut labore et dolore magna aliqua. Et m"
+        "olestie ac feugiat sed lectus vestibulum mattis ullamcorper. Mor"
+        "bi blandit cursus risus at ultrices mi tempus imperdiet nulla. N"
+        "unc congue nisi vita suscipit tellus mauris. Imperdiet proin fer"
+        "mentum leo vel orci. Massa tempor nec feugiat nisl pretium fusce"
+        " id velit. Telus in metus vulputate eu scelerisque felis. Mi tem"
+        "pus imperdiet nulla malesuada pellentesque. Tristique magna sit."
+        "Sed viverra tellus in hac habitasse platea dictumst vestibulum r"
+        "honcus. Ac turpis egestas maecenas pharetra convallis posuere mo"
+        "rbi leo urna. Consequat interdum varius sit amet mattis vulputat"
+        "e enim nulla aliquet. Quis hendrerit dolor magna eget est lorem "
+        "ipsum dolor. Purus in mollis nunc sed id semper risus in hendrer"
+        "it. Pellentesque habitant morbi tristique senectus et netus et m"
+        "alesuada fames ac. Nibh venenatis cras sed felis eget velit aliq"
+        "uet sagittis id. Nunc faucibus a pellentesque sit amet porttitor"
+        " eget dolor. Viverra nam libero justo laoreet sit amet cursus si"
+        "t amet. Amet porttitor eget dolor morbi non arcu risus quis vari"
+        "us. Aliquam ultrices sagittis orci a scelerisque purus semper eg"
+        "et duis. Feugiat in ante metus dictum at tempor commodo ullamcor"
+        "per. Lectus urna duis convallis convallis tellus id interdum vel"
+        "it. Tempus quam pellentesque nec nam aliquam sem et tortor conse"
+        "quat. Sit amet risus nullam eget felis eget nunc lobortis mattis"
+        ". Mi in nulla posuere sollicitudin aliquam ultrices sagittis orc"
+        "i a. Est ante in nibh mauris cursus mattis molestie. Amet est pl"
+        "acerat in egestas erat imperdiet sed euismod nisi. Egestas pretium"
+        " aenean pharetra magna ac placerat vestibulum lectus mauris. Odi"
+        "o ut sem nulla pharetra diam. Ac tortor dignissim convallis aene"
+        "an et tortor at risus. Tincidunt augue interdum velit euismod in"
+        " pellentesque massa placerat duis. Aliquet enim tortor at auctor"
+        " urna nunc id cursus metus. Amet nisl suscipit adipiscing bibend"
+        "um est ultricies integer. Magna etiam tempor orci eu lobortis el"
+        "ementum nibh tellus molestie. Egestas pretium aenean pharetra ma"
+        "gna ac placerat vestibulum. Ullamcorper malesuada proin libero n"
+        "unc consequat interdum varius sit amet.";
+
+    // Test Transform_4way, if available.
+    if (Transform_4way && !SelfTestMulti(Transform_4way, data + 1, 4)) {
+        return false;
+    }
+
+    // Test Transform_8way, if available.
+    if (Transform_8way && !SelfTestMulti(Transform_8way, data + 1, 8)) {
+        return false;
+    }
+
+    return true;
+}
+
+#if defined(USE_ASM) &&                                                        \
+    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled() {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+
+/** Check whether the OS has enabled the AVX-512 opmask and ZMM registers. */
+bool AVX512Enabled() {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 0xe6) == 0xe6;
+}
+#endif
 } // namespace
 
+std::string SHA512AutoDetect() {
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    bool have_xsave = false;
+    bool have_avx = false;
+    bool have_avx2 = false;
+    bool have_avx512 = false;
+    bool enabled_avx = false;
+    bool enabled_avx512 = false;
+
+    (void)AVXEnabled;
+    (void)AVX512Enabled;
+    (void)have_avx;
+    (void)have_xsave;
+    (void)have_avx2;
+    (void)have_avx512;
+    (void)enabled_avx;
+    (void)enabled_avx512;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    have_xsave = (ecx >> 27) & 1;
+    have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+        enabled_avx512 = AVX512Enabled();
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+        have_avx512 = (ebx >> 16) & 1;
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && have_avx && enabled_avx) {
+        Transform_4way = sha512_avx2::Transform_4way;
+        ret += ",avx2(4way)";
+    }
+#endif
+
+#if defined(ENABLE_AVX512) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx512 && enabled_avx512) {
+        Transform_8way = sha512_avx512::Transform_8way;
+        ret += ",avx512(8way)";
+    }
+#endif
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
+
 ////// SHA-512
 
 CSHA512::CSHA512() : bytes(0) {
@@ -303,3 +463,49 @@ CSHA512 &CSHA512::Reset() {
     sha512::Initialize(s);
     return *this;
 }
+
+void CSHA512::FinalizeBatch(uint8_t *output, const uint8_t *input, size_t len,
+                            size_t count) const {
+    const size_t bufsize = bytes % 128;
+    // The padding takes at least 17 bytes.
+    if (bufsize + len <= 111 && (Transform_8way || Transform_4way)) {
+        // The buffered prefix and the padding are the same for every message,
+        // so they are written once and each round only copies the messages
+        // in.
+        uint8_t blocks[8 * 128] = {};
+        for (size_t i = 0; i < 8; ++i) {
+            memcpy(blocks + 128 * i, buf, bufsize);
+            blocks[128 * i + bufsize + len] = 0x80;
+            WriteBE64(blocks + 128 * i + 120, (bytes + len) << 3);
+        }
+
+        if (Transform_8way) {
+            while (count >= 8) {
+                for (size_t i = 0; i < 8; ++i) {
+                    memcpy(blocks + 128 * i + bufsize, input + len * i, len);
+                }
+                Transform_8way(output, s, blocks);
+                output += 8 * OUTPUT_SIZE;
+                input += 8 * len;
+                count -= 8;
+            }
+        }
+        if (Transform_4way) {
+            while (count >= 4) {
+                for (size_t i = 0; i < 4; ++i) {
+                    memcpy(blocks + 128 * i + bufsize, input + len * i, len);
+                }
+                Transform_4way(output, s, blocks);
+                output += 4 * OUTPUT_SIZE;
+                input += 4 * len;
+                count -= 4;
+            }
+        }
+    }
+    while (count) {
+        CSHA512(*this).Write(input, len).Finalize(output);
+        output += OUTPUT_SIZE;
+        input += len;
+        --count;
+    }
+}
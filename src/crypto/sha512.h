@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <string>
 
 /** A hasher class for SHA-512. */
 class CSHA512 {
@@ -35,6 +36,25 @@ public:
     void Finalize(uint8_t hash[OUTPUT_SIZE]);
     CSHA512 &Reset();
     uint64_t Size() const { return bytes; }
+
+    /**
+     * Compute the SHA-512's of count equally sized messages, each prefixed by
+     * the data already written to this hasher. The hasher is not modified.
+     * output:  pointer to a count*64 byte output buffer
+     * input:   pointer to a count*len byte input buffer
+     *
+     * When the prefix and a message fit in a single padded block, messages
+     * are hashed several at a time if a multi-way implementation is
+     * available. This is the case for HMAC-SHA512 over short messages.
+     */
+    void FinalizeBatch(uint8_t *output, const uint8_t *input, size_t len,
+                       size_t count) const;
 };
 
+/**
+ * Autodetect the best available SHA-512 implementation.
+ * Returns the name of the implementation.
+ */
+std::string SHA512AutoDetect();
+
 #endif // BITCOIN_CRYPTO_SHA512_H
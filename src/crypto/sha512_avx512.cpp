@@ -0,0 +1,192 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX512
+
+#include <cstdint>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace sha512_avx512 {
+namespace {
+
+    /** SHA-512 round constants. */
+    const uint64_t ROUND_CONSTANTS[80] = {
+        0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full,
+        0xe9b5dba58189dbbcull, 0x3956c25bf348b538ull, 0x59f111f1b605d019ull,
+        0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull, 0xd807aa98a3030242ull,
+        0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+        0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull,
+        0xc19bf174cf692694ull, 0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull,
+        0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull, 0x2de92c6f592b0275ull,
+        0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+        0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full,
+        0xbf597fc7beef0ee4ull, 0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull,
+        0x06ca6351e003826full, 0x142929670a0e6e70ull, 0x27b70a8546d22ffcull,
+        0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+        0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull,
+        0x92722c851482353bull, 0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull,
+        0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull, 0xd192e819d6ef5218ull,
+        0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+        0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull,
+        0x34b0bcb5e19b48a8ull, 0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull,
+        0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull, 0x748f82ee5defb2fcull,
+        0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+        0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull,
+        0xc67178f2e372532bull, 0xca273eceea26619cull, 0xd186b8c721c0c207ull,
+        0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull, 0x06f067aa72176fbaull,
+        0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+        0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull,
+        0x431d67c49c100d4cull, 0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull,
+        0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull,
+    };
+
+    __m512i inline K(uint64_t x) { return _mm512_set1_epi64(x); }
+
+    __m512i inline Add(__m512i x, __m512i y) { return _mm512_add_epi64(x, y); }
+    __m512i inline Add(__m512i x, __m512i y, __m512i z) {
+        return Add(Add(x, y), z);
+    }
+    __m512i inline Add(__m512i x, __m512i y, __m512i z, __m512i w) {
+        return Add(Add(x, y), Add(z, w));
+    }
+    __m512i inline Inc(__m512i &x, __m512i y, __m512i z, __m512i w) {
+        x = Add(x, y, z, w);
+        return x;
+    }
+    // The zero-masking forms are used for shifts and rotations because the
+    // unmasked ones make some GCC versions warn about an uninitialized
+    // variable in their headers. With a full mask they compute the same.
+    template <int n> __m512i inline ShR(__m512i x) {
+        return _mm512_maskz_srli_epi64(0xff, x, n);
+    }
+    template <int n> __m512i inline Ror(__m512i x) {
+        return _mm512_maskz_ror_epi64(0xff, x, n);
+    }
+    __m512i inline Xor(__m512i x, __m512i y, __m512i z) {
+        return _mm512_ternarylogic_epi64(x, y, z, 0x96);
+    }
+
+    __m512i inline Ch(__m512i x, __m512i y, __m512i z) {
+        return _mm512_ternarylogic_epi64(x, y, z, 0xca);
+    }
+    __m512i inline Maj(__m512i x, __m512i y, __m512i z) {
+        return _mm512_ternarylogic_epi64(x, y, z, 0xe8);
+    }
+    __m512i inline Sigma0(__m512i x) {
+        return Xor(Ror<28>(x), Ror<34>(x), Ror<39>(x));
+    }
+    __m512i inline Sigma1(__m512i x) {
+        return Xor(Ror<14>(x), Ror<18>(x), Ror<41>(x));
+    }
+    __m512i inline sigma0(__m512i x) {
+        return Xor(Ror<1>(x), Ror<8>(x), ShR<7>(x));
+    }
+    __m512i inline sigma1(__m512i x) {
+        return Xor(Ror<19>(x), Ror<61>(x), ShR<6>(x));
+    }
+
+    /** One round of SHA-512. */
+    inline void __attribute__((always_inline))
+    Round(__m512i a, __m512i b, __m512i c, __m512i &d, __m512i e, __m512i f,
+          __m512i g, __m512i &h, __m512i k) {
+        __m512i t1 = Add(h, Sigma1(e), Ch(e, f, g), k);
+        __m512i t2 = Add(Sigma0(a), Maj(a, b, c));
+        d = Add(d, t1);
+        h = Add(t1, t2);
+    }
+
+    /**
+     * Return message schedule word i. From round 16 on, it is computed in
+     * place of word i - 16, which is no longer needed.
+     */
+    __m512i inline Schedule(__m512i *w, int i) {
+        if (i >= 16) {
+            Inc(w[i & 15], sigma1(w[(i - 2) & 15]), w[(i - 7) & 15],
+                sigma0(w[(i - 15) & 15]));
+        }
+        return w[i & 15];
+    }
+
+    __m512i inline Read8(const uint8_t *chunk, int offset) {
+        return _mm512_set_epi64(
+            ReadBE64(chunk + 0 + offset), ReadBE64(chunk + 128 + offset),
+            ReadBE64(chunk + 256 + offset), ReadBE64(chunk + 384 + offset),
+            ReadBE64(chunk + 512 + offset), ReadBE64(chunk + 640 + offset),
+            ReadBE64(chunk + 768 + offset), ReadBE64(chunk + 896 + offset));
+    }
+
+    inline void Write8(uint8_t *out, int offset, __m512i v) {
+        alignas(64) uint64_t words[8];
+        _mm512_store_si512((__m512i *)words, v);
+        WriteBE64(out + 0 + offset, words[7]);
+        WriteBE64(out + 64 + offset, words[6]);
+        WriteBE64(out + 128 + offset, words[5]);
+        WriteBE64(out + 192 + offset, words[4]);
+        WriteBE64(out + 256 + offset, words[3]);
+        WriteBE64(out + 320 + offset, words[2]);
+        WriteBE64(out + 384 + offset, words[1]);
+        WriteBE64(out + 448 + offset, words[0]);
+    }
+} // namespace
+
+/**
+ * Process one 128-byte block for each of 8 messages, all starting from the
+ * same midstate, and write the 8 resulting states as big endian 64-byte
+ * digests.
+ */
+void Transform_8way(uint8_t *out, const uint64_t *midstate,
+                    const uint8_t *in) {
+    __m512i a = K(midstate[0]);
+    __m512i b = K(midstate[1]);
+    __m512i c = K(midstate[2]);
+    __m512i d = K(midstate[3]);
+    __m512i e = K(midstate[4]);
+    __m512i f = K(midstate[5]);
+    __m512i g = K(midstate[6]);
+    __m512i h = K(midstate[7]);
+
+    __m512i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = Read8(in, 8 * i);
+    }
+
+    for (int i = 0; i < 80; i += 8) {
+        const uint64_t *k = ROUND_CONSTANTS + i;
+        Round(a, b, c, d, e, f, g, h, Add(K(k[0]), Schedule(w, i + 0)));
+        Round(h, a, b, c, d, e, f, g, Add(K(k[1]), Schedule(w, i + 1)));
+        Round(g, h, a, b, c, d, e, f, Add(K(k[2]), Schedule(w, i + 2)));
+        Round(f, g, h, a, b, c, d, e, Add(K(k[3]), Schedule(w, i + 3)));
+        Round(e, f, g, h, a, b, c, d, Add(K(k[4]), Schedule(w, i + 4)));
+        Round(d, e, f, g, h, a, b, c, Add(K(k[5]), Schedule(w, i + 5)));
+        Round(c, d, e, f, g, h, a, b, Add(K(k[6]), Schedule(w, i + 6)));
+        Round(b, c, d, e, f, g, h, a, Add(K(k[7]), Schedule(w, i + 7)));
+    }
+
+    Write8(out, 0, Add(a, K(midstate[0])));
+    Write8(out, 8, Add(b, K(midstate[1])));
+    Write8(out, 16, Add(c, K(midstate[2])));
+    Write8(out, 24, Add(d, K(midstate[3])));
+    Write8(out, 32, Add(e, K(midstate[4])));
+    Write8(out, 40, Add(f, K(midstate[5])));
+    Write8(out, 48, Add(g, K(midstate[6])));
+    Write8(out, 56, Add(h, K(midstate[7])));
+}
+
+} // namespace sha512_avx512
+
+#endif
@@ -135,6 +135,7 @@ public:
  *  Read Operations:
  *      - contains() for `erase=false`
  *      - get() for `erase=false`
+ *      - for_each()
  *
  *  Read+Erase Operations:
  *      - contains() for `erase=true`
@@ -554,6 +555,20 @@ public:
         return false;
     }
 
+    /**
+     * for_each calls fn on every element which is not marked for garbage
+     * collection, for instance to save the contents of the cache.
+     *
+     * @param fn a callable taking a const Element &
+     */
+    template <typename Fn> void for_each(Fn fn) const {
+        for (uint32_t i = 0; i < size; ++i) {
+            if (!collection_flags.bit_is_set(i)) {
+                fn(table[i]);
+            }
+        }
+    }
+
 private:
     const Element *find(const Key &k, const bool erase) const {
         std::array<uint32_t, 8> locs = compute_hashes(k);
@@ -42,11 +42,12 @@ public:
 
 void DummyWalletInit::AddWalletOptions(ArgsManager &argsman) const {
     std::vector<std::string> opts = {
-        "-avoidpartialspends", "-disablewallet", "-fallbackfee=<amt>",
-        "-keypool=<n>", "-maxapsfee=<n>", "-maxtxfee=<amt>", "-mintxfee=<amt>",
-        "-paytxfee=<amt>", "-rescan", "-salvagewallet", "-spendzeroconfchange",
-        "-upgradewallet", "-wallet=<path>", "-walletbroadcast",
-        "-walletdir=<dir>", "-walletnotify=<cmd>", "-zapwallettxes=<mode>",
+        "-avoidpartialspends", "-consolidatefeerate=<amt>", "-disablewallet",
+        "-fallbackfee=<amt>", "-keypool=<n>", "-maxapsfee=<n>",
+        "-maxtxfee=<amt>", "-mintxfee=<amt>", "-paytxfee=<amt>", "-rescan",
+        "-salvagewallet", "-spendzeroconfchange", "-upgradewallet",
+        "-wallet=<path>", "-walletbroadcast", "-walletdir=<dir>",
+        "-walletnotify=<cmd>", "-zapwallettxes=<mode>",
         // Wallet debug options
         "-dblogsize=<n>", "-flushwallet", "-privdb", "-walletrejectlongchains"};
     argsman.AddHiddenArgs(opts);
@@ -18,6 +18,9 @@
 
 #include <crypto/hmac_sha512.h>
 
+#include <algorithm>
+#include <cstring>
+
 inline uint32_t ROTL32(uint32_t x, int8_t r) {
     return (x << r) | (x >> (32 - r));
 }
@@ -93,3 +96,25 @@ void BIP32Hash(const ChainCode &chainCode, uint32_t nChild, uint8_t header,
         .Write(num, 4)
         .Finalize(output);
 }
+
+void BIP32HashBatch(const ChainCode &chainCode, uint32_t nFirstChild,
+                    size_t count, uint8_t header, const uint8_t data[32],
+                    uint8_t *output) {
+    static constexpr size_t MESSAGE_SIZE = 1 + 32 + 4;
+    static constexpr size_t CHUNK_SIZE = 64;
+    const CHMAC_SHA512 hmac(chainCode.begin(), chainCode.size());
+    uint8_t messages[CHUNK_SIZE * MESSAGE_SIZE];
+    while (count) {
+        const size_t n = std::min(count, CHUNK_SIZE);
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t *message = messages + MESSAGE_SIZE * i;
+            message[0] = header;
+            memcpy(message + 1, data, 32);
+            WriteBE32(message + 33, nFirstChild + i);
+        }
+        hmac.FinalizeBatch(output, messages, MESSAGE_SIZE, n);
+        output += n * CHMAC_SHA512::OUTPUT_SIZE;
+        nFirstChild += n;
+        count -= n;
+    }
+}
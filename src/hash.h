@@ -196,4 +196,12 @@ uint32_t MurmurHash3(uint32_t nHashSeed, Span<const uint8_t> vDataToHash);
 void BIP32Hash(const ChainCode &chainCode, uint32_t nChild, uint8_t header,
                const uint8_t data[32], uint8_t output[64]);
 
+/**
+ * Compute BIP32Hash for count consecutive children starting at nFirstChild,
+ * writing count*64 bytes to output. The children must not wrap around.
+ */
+void BIP32HashBatch(const ChainCode &chainCode, uint32_t nFirstChild,
+                    size_t count, uint8_t header, const uint8_t data[32],
+                    uint8_t *output);
+
 #endif // BITCOIN_HASH_H
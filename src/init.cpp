@@ -35,6 +35,7 @@
 #include <compat/sanity.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <crypto/sha512.h>
 #include <currencyunit.h>
 #include <flatfile.h>
 #include <fs.h>
@@ -70,6 +71,7 @@
 #include <torcontrol.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <txreconciliation.h>
 #include <util/asmap.h>
 #include <util/check.h>
 #include <util/moneystr.h>
@@ -169,6 +171,13 @@ static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
 static boost::thread_group threadGroup;
 
+/**
+ * Whether the signature and script execution caches were set up and loaded.
+ * Until then, Shutdown() must not overwrite their files, e.g. after an early
+ * init failure such as another instance holding the data directory.
+ */
+static bool g_sigcache_loaded = false;
+
 void Interrupt(NodeContext &node) {
     InterruptHTTPServer();
     InterruptHTTPRPC();
@@ -260,6 +269,12 @@ void Shutdown(NodeContext &node) {
     // stopped, destruct and reset all to nullptr.
     node.peerman.reset();
 
+    if (g_avalanche && g_avalanche->isProofsLoaded() &&
+        node.args->GetBoolArg("-persistavaproofs",
+                              AVALANCHE_DEFAULT_PERSIST_PROOFS)) {
+        g_avalanche->dumpProofs();
+    }
+
     // Destroy various global instances
     g_avalanche.reset();
     node.connman.reset();
@@ -270,6 +285,13 @@ void Shutdown(NodeContext &node) {
         DumpMempool(::g_mempool);
     }
 
+    if (g_sigcache_loaded &&
+        node.args->GetBoolArg("-persistsigcache", DEFAULT_PERSIST_SIGCACHE)) {
+        DumpSignatureCache();
+        LOCK(cs_main);
+        DumpScriptExecutionCache();
+    }
+
     // FlushStateToDisk generates a ChainStateFlushed callback, which we should
     // avoid missing
     if (node.chainman) {
@@ -560,6 +582,12 @@ void SetupServerArgs(NodeContext &node) {
                              "on restart (default: %u)",
                              DEFAULT_PERSIST_MEMPOOL),
                    ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-persistsigcache",
+                   strprintf("Whether to save the signature and script "
+                             "caches on shutdown and load them on restart "
+                             "(default: %u)",
+                             DEFAULT_PERSIST_SIGCACHE),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-pid=<file>",
         strprintf("Specify pid file. Relative paths will be prefixed "
@@ -788,6 +816,18 @@ void SetupServerArgs(NodeContext &node) {
                    "Tor control port password (default: empty)",
                    ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE,
                    OptionsCategory::CONNECTION);
+    argsman.AddArg("-txreconciliation",
+                   strprintf("Reconcile transactions with the peers supporting "
+                             "it instead of announcing all of them (default: "
+                             "%d)",
+                             DEFAULT_TXRECONCILIATION_ENABLE),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg(
+        "-txreconciliationfanout=<n>",
+        strprintf("Percentage of the reconciling peers transactions are still "
+                  "announced to, between 0 and 100 (default: %d)",
+                  DEFAULT_TXRECONCILIATION_FANOUT),
+        ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
 #ifdef USE_UPNP
 #if USE_UPNP
     argsman.AddArg("-upnp",
@@ -1265,6 +1305,11 @@ void SetupServerArgs(NodeContext &node) {
                    ArgsManager::ALLOW_ANY, OptionsCategory::AVALANCHE);
     argsman.AddArg("-avasessionkey", "Avalanche session key (default: random)",
                    ArgsManager::ALLOW_ANY, OptionsCategory::AVALANCHE);
+    argsman.AddArg("-persistavaproofs",
+                   strprintf("Whether to save the avalanche proofs on shutdown "
+                             "and load them on restart (default: %u)",
+                             AVALANCHE_DEFAULT_PERSIST_PROOFS),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::AVALANCHE);
 
     // Add the hidden options
     argsman.AddHiddenArgs(hidden_args);
@@ -1473,6 +1518,12 @@ static void ThreadImport(const Config &config, ChainstateManager &chainman,
         LoadMempool(config, ::g_mempool);
     }
     ::g_mempool.SetIsLoaded(!ShutdownRequested());
+
+    if (g_avalanche && args.GetBoolArg("-persistavaproofs",
+                                       AVALANCHE_DEFAULT_PERSIST_PROOFS)) {
+        g_avalanche->loadProofs();
+        g_avalanche->setProofsLoaded(!ShutdownRequested());
+    }
 }
 
 /** Sanity checks
@@ -2096,6 +2147,8 @@ bool AppInitSanityChecks() {
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string sha512_algo = SHA512AutoDetect();
+    LogPrintf("Using the '%s' SHA512 implementation\n", sha512_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -2198,6 +2251,12 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    if (args.GetBoolArg("-persistsigcache", DEFAULT_PERSIST_SIGCACHE)) {
+        LoadSignatureCache();
+        LOCK(cs_main);
+        LoadScriptExecutionCache();
+    }
+    g_sigcache_loaded = true;
 
     int script_threads = args.GetArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -2482,7 +2541,7 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     bilingual_str avalancheError;
     g_avalanche = avalanche::Processor::MakeProcessor(
         args, *node.chain, node.connman.get(), node.peerman.get(),
-        avalancheError);
+        *node.mempool, avalancheError);
     if (!g_avalanche) {
         InitError(avalancheError);
         return false;
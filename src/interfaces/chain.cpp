@@ -19,6 +19,7 @@
 #include <blockdb.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <index/blockfilterindex.h>
 #include <interfaces/handler.h>
 #include <interfaces/wallet.h>
 #include <net.h>
@@ -331,6 +332,28 @@ namespace {
             }
             return false;
         }
+        bool hasBlockFilterIndex(BlockFilterType filter_type) override {
+            return GetBlockFilterIndex(filter_type) != nullptr;
+        }
+        std::optional<bool>
+        blockFilterMatchesAny(BlockFilterType filter_type,
+                              const BlockHash &block_hash,
+                              const GCSFilter::ElementSet &filter_set)
+            override {
+            const BlockFilterIndex *block_filter_index =
+                GetBlockFilterIndex(filter_type);
+            if (!block_filter_index) {
+                return std::nullopt;
+            }
+
+            const CBlockIndex *index =
+                WITH_LOCK(::cs_main, return LookupBlockIndex(block_hash));
+            BlockFilter filter;
+            if (!index || !block_filter_index->LookupFilter(index, filter)) {
+                return std::nullopt;
+            }
+            return filter.GetFilter().MatchAny(filter_set);
+        }
         bool hasDescendantsInMempool(const TxId &txid) override {
             LOCK(::g_mempool.cs);
             auto it = ::g_mempool.GetIter(txid);
@@ -17,6 +17,7 @@
 #ifndef BITCOIN_INTERFACES_CHAIN_H
 #define BITCOIN_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>
 #include <primitives/transaction.h>
 #include <primitives/txid.h>
 
@@ -214,6 +215,17 @@ public:
     virtual bool hasBlocks(const BlockHash &block_hash, int min_height = 0,
                            std::optional<int> max_height = {}) = 0;
 
+    //! Return whether a block filter index of the given type is running.
+    virtual bool hasBlockFilterIndex(BlockFilterType filter_type) = 0;
+
+    //! Return whether any of the elements match the block filter of the
+    //! given type for the block, or std::nullopt if the filter is not
+    //! available (yet) for this block.
+    virtual std::optional<bool>
+    blockFilterMatchesAny(BlockFilterType filter_type,
+                          const BlockHash &block_hash,
+                          const GCSFilter::ElementSet &filter_set) = 0;
+
     //! Check if transaction has descendants in mempool.
     virtual bool hasDescendantsInMempool(const TxId &txid) = 0;
 
@@ -18,16 +18,21 @@
 
 #include <crypto/siphash.h>
 #include <net.h>
+#include <prevector.h>
 #include <random.h>
+#include <salteduint256hasher.h>
 
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index_container.hpp>
-
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace {
 
@@ -35,8 +40,7 @@ namespace {
  * The various states a (invid, peer) pair can be in.
  *
  * Note that CANDIDATE is split up into 3 substates (DELAYED, BEST, READY),
- * allowing more efficient implementation. Also note that the sorting order of
- * ByInvIdView relies on the specific order of values in this enum.
+ * allowing more efficient implementation.
  *
  * Expected behaviour is:
  *   - When first announced by a peer, the state is CANDIDATE_DELAYED until
@@ -74,24 +78,36 @@ enum class State : uint8_t {
 //! Type alias for sequence numbers.
 using SequenceNumber = uint64_t;
 
+//! Type alias for the position of an announcement in the announcement pool.
+using AnnouncementIdx = uint32_t;
+
+//! Marker for a missing announcement.
+constexpr AnnouncementIdx NO_ANNOUNCEMENT =
+    std::numeric_limits<AnnouncementIdx>::max();
+
 /**
  * An announcement. This is the data we track for each invid that is announced
  * to us by each peer.
+ *
+ * Announcements live in a pool and are referred to by their position in that
+ * pool. The slots of deleted announcements are reused.
  */
 struct Announcement {
     /** InvId that was announced. */
-    const uint256 m_invid;
+    uint256 m_invid;
     /**
      * For CANDIDATE_{DELAYED,BEST,READY} the reqtime; for REQUESTED the
      * expiry.
      */
     std::chrono::microseconds m_time;
     /** What peer the request was from. */
-    const NodeId m_peer;
+    NodeId m_peer;
     /** What sequence number this announcement has. */
-    const SequenceNumber m_sequence : 60;
+    SequenceNumber m_sequence : 59;
     /** Whether the request is preferred. */
-    const bool m_preferred : 1;
+    bool m_preferred : 1;
+    /** Whether this slot of the pool holds a live announcement. */
+    bool m_in_use : 1;
 
     /**
      * What state this announcement is in.
@@ -101,6 +117,16 @@ struct Announcement {
      */
     uint8_t m_state : 3;
 
+    /** Position of this announcement in its peer's announcement list. */
+    uint32_t m_peer_pos;
+    /** Position of this announcement in its peer's CANDIDATE_BEST list. */
+    uint32_t m_best_pos;
+    /**
+     * Incremented every time the announcement changes or is deleted, so that
+     * outdated timers can be recognized.
+     */
+    uint32_t m_generation;
+
     /** Convert m_state to a State enum. */
     State GetState() const { return static_cast<State>(m_state); }
 
@@ -136,10 +162,12 @@ struct Announcement {
      * CANDIDATE_DELAYED state.
      */
     Announcement(const uint256 &invid, NodeId peer, bool preferred,
-                 std::chrono::microseconds reqtime, SequenceNumber sequence)
+                 std::chrono::microseconds reqtime, SequenceNumber sequence,
+                 uint32_t generation)
         : m_invid(invid), m_time(reqtime), m_peer(peer), m_sequence(sequence),
-          m_preferred(preferred),
-          m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)) {}
+          m_preferred(preferred), m_in_use(true),
+          m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)),
+          m_peer_pos(0), m_best_pos(0), m_generation(generation) {}
 };
 
 //! Type alias for priorities.
@@ -173,123 +201,44 @@ public:
     }
 };
 
-// Definitions for the 3 indexes used in the main data structure.
-//
-// Each index has a By* type to identify it, a By*View data type to represent
-// the view of announcement it is sorted by, and an By*ViewExtractor type to
-// convert an announcement into the By*View type. See
-// https://www.boost.org/doc/libs/1_58_0/libs/multi_index/doc/reference/key_extraction.html#key_extractors
-// for more information about the key extraction concept.
-
-// The ByPeer index is sorted by (peer, state == CANDIDATE_BEST, invid)
-//
-// Uses:
-// * Looking up existing announcements by peer/invid, by checking both (peer,
-//   false, invid) and (peer, true, invid).
-// * Finding all CANDIDATE_BEST announcements for a given peer in
-//   GetRequestable.
-struct ByPeer {};
-using ByPeerView = std::tuple<NodeId, bool, const uint256 &>;
-struct ByPeerViewExtractor {
-    using result_type = ByPeerView;
-    result_type operator()(const Announcement &ann) const {
-        return ByPeerView{ann.m_peer, ann.GetState() == State::CANDIDATE_BEST,
-                          ann.m_invid};
-    }
-};
-
-// The ByInvId index is sorted by (invid, state, priority).
-//
-// Note: priority == 0 whenever state != CANDIDATE_READY.
-//
-// Uses:
-// * Deleting all announcements with a given invid in ForgetInvId.
-// * Finding the best CANDIDATE_READY to convert to CANDIDATE_BEST, when no
-//   other CANDIDATE_READY or REQUESTED announcement exists for that invid.
-// * Determining when no more non-COMPLETED announcements for a given invid
-//   exist, so the COMPLETED ones can be deleted.
-struct ByInvId {};
-using ByInvIdView = std::tuple<const uint256 &, State, Priority>;
-class ByInvIdViewExtractor {
-    const PriorityComputer &m_computer;
-
-public:
-    ByInvIdViewExtractor(const PriorityComputer &computer)
-        : m_computer(computer) {}
-    using result_type = ByInvIdView;
-    result_type operator()(const Announcement &ann) const {
-        const Priority prio =
-            (ann.GetState() == State::CANDIDATE_READY) ? m_computer(ann) : 0;
-        return ByInvIdView{ann.m_invid, ann.GetState(), prio};
-    }
-};
+/**
+ * The announcements for a given invid. There is usually a handful of them, so
+ * they are stored inline.
+ */
+using InvIdAnnouncements = prevector<4, AnnouncementIdx>;
 
-enum class WaitState {
-    //! Used for announcements that need efficient testing of "is their
-    //! timestamp in the future?".
-    FUTURE_EVENT,
-    //! Used for announcements whose timestamp is not relevant.
-    NO_EVENT,
-    //! Used for announcements that need efficient testing of "is their
-    //! timestamp in the past?".
-    PAST_EVENT,
+/**
+ * A timer for an announcement that is waiting for its reqtime (for
+ * CANDIDATE_DELAYED) or its expiry (for REQUESTED) to pass.
+ *
+ * Timers are never removed when the announcement changes: they are discarded
+ * when they fire if the announcement generation doesn't match anymore.
+ */
+struct Timer {
+    std::chrono::microseconds m_time;
+    SequenceNumber m_sequence;
+    AnnouncementIdx m_idx;
+    uint32_t m_generation;
 };
 
-WaitState GetWaitState(const Announcement &ann) {
-    if (ann.IsWaiting()) {
-        return WaitState::FUTURE_EVENT;
-    }
-    if (ann.IsSelectable()) {
-        return WaitState::PAST_EVENT;
-    }
-    return WaitState::NO_EVENT;
-}
-
-// The ByTime index is sorted by (wait_state, time).
-//
-// All announcements with a timestamp in the future can be found by iterating
-// the index forward from the beginning. All announcements with a timestamp in
-// the past can be found by iterating the index backwards from the end.
-//
-// Uses:
-// * Finding CANDIDATE_DELAYED announcements whose reqtime has passed, and
-//   REQUESTED announcements whose expiry has passed.
-// * Finding CANDIDATE_READY/BEST announcements whose reqtime is in the future
-//   (when the clock time went backwards).
-struct ByTime {};
-using ByTimeView = std::pair<WaitState, std::chrono::microseconds>;
-struct ByTimeViewExtractor {
-    using result_type = ByTimeView;
-    result_type operator()(const Announcement &ann) const {
-        return ByTimeView{GetWaitState(ann), ann.m_time};
+/** Order the timers in a min-heap, earliest first. */
+struct TimerCompare {
+    bool operator()(const Timer &a, const Timer &b) const {
+        return std::tie(a.m_time, a.m_sequence) >
+               std::tie(b.m_time, b.m_sequence);
     }
 };
 
-/**
- * Data type for the main data structure (Announcement objects with
- * ByPeer/ByInvId/ByTime indexes).
- */
-using Index = boost::multi_index_container<
-    Announcement,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<boost::multi_index::tag<ByPeer>,
-                                           ByPeerViewExtractor>,
-        boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByInvId>,
-                                               ByInvIdViewExtractor>,
-        boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTime>,
-                                               ByTimeViewExtractor>>>;
-
-/** Helper type to simplify syntax of iterator types. */
-template <typename Tag> using Iter = typename Index::index<Tag>::type::iterator;
-
-/** Per-peer statistics object. */
+/** Per-peer statistics and announcements. */
 struct PeerInfo {
-    //! Total number of announcements for this peer.
-    size_t m_total = 0;
     //! Number of COMPLETED announcements for this peer.
     size_t m_completed = 0;
     //! Number of REQUESTED announcements for this peer.
     size_t m_requested = 0;
+    //! All the announcements for this peer.
+    std::vector<AnnouncementIdx> m_announcements;
+    //! The CANDIDATE_BEST announcements for this peer.
+    std::vector<AnnouncementIdx> m_best;
 };
 
 /** Per-invid statistics object. Only used for sanity checking. */
@@ -314,31 +263,15 @@ struct InvIdInfo {
     std::vector<NodeId> m_peers;
 };
 
-/** Compare two PeerInfo objects. Only used for sanity checking. */
-bool operator==(const PeerInfo &a, const PeerInfo &b) {
-    return std::tie(a.m_total, a.m_completed, a.m_requested) ==
-           std::tie(b.m_total, b.m_completed, b.m_requested);
-};
-
-/**
- * (Re)compute the PeerInfo map from the index. Only used for sanity checking.
- */
-std::unordered_map<NodeId, PeerInfo> RecomputePeerInfo(const Index &index) {
-    std::unordered_map<NodeId, PeerInfo> ret;
-    for (const Announcement &ann : index) {
-        PeerInfo &info = ret[ann.m_peer];
-        ++info.m_total;
-        info.m_requested += (ann.GetState() == State::REQUESTED);
-        info.m_completed += (ann.GetState() == State::COMPLETED);
-    }
-    return ret;
-}
-
 /** Compute the InvIdInfo map. Only used for sanity checking. */
 std::map<uint256, InvIdInfo>
-ComputeInvIdInfo(const Index &index, const PriorityComputer &computer) {
+ComputeInvIdInfo(const std::vector<Announcement> &announcements,
+                 const PriorityComputer &computer) {
     std::map<uint256, InvIdInfo> ret;
-    for (const Announcement &ann : index) {
+    for (const Announcement &ann : announcements) {
+        if (!ann.m_in_use) {
+            continue;
+        }
         InvIdInfo &info = ret[ann.m_invid];
         // Classify how many announcements of each state we have for this invid.
         info.m_candidate_delayed +=
@@ -364,7 +297,13 @@ ComputeInvIdInfo(const Index &index, const PriorityComputer &computer) {
 
 } // namespace
 
-/** Actual implementation for InvRequestTracker's data structure. */
+/**
+ * Actual implementation for InvRequestTracker's data structure.
+ *
+ * The announcements are stored in a flat pool. They are indexed by invid and
+ * by peer through hash maps of small lists of pool positions, and the ones
+ * waiting for some time to pass are tracked in a min-heap of timers.
+ */
 class InvRequestTrackerImpl : public InvRequestTrackerImplInterface {
     //! The current sequence number. Increases for every announcement. This is
     //! used to sort invid returned by GetRequestable in announcement order.
@@ -373,23 +312,115 @@ class InvRequestTrackerImpl : public InvRequestTrackerImplInterface {
     //! This tracker's priority computer.
     const PriorityComputer m_computer;
 
-    //! This tracker's main data structure. See SanityCheck() for the invariants
-    //! that apply to it.
-    Index m_index;
+    //! The announcement pool. See SanityCheck() for the invariants that apply
+    //! to it.
+    std::vector<Announcement> m_announcements;
+
+    //! The slots of m_announcements that don't hold an announcement.
+    std::vector<AnnouncementIdx> m_free_slots;
+
+    //! Map from invid to its announcements.
+    std::unordered_map<uint256, InvIdAnnouncements, SaltedUint256Hasher>
+        m_invids;
 
     //! Map with this tracker's per-peer statistics.
     std::unordered_map<NodeId, PeerInfo> m_peerinfo;
 
+    //! Min-heap of the timers for the IsWaiting() announcements. It can contain
+    //! outdated timers.
+    std::vector<Timer> m_timers;
+
+    //! Number of IsWaiting() announcements.
+    size_t m_waiting{0};
+
+    //! Upper bound of the time of the IsSelectable() announcements. This is
+    //! used to detect when the clock went backwards.
+    std::chrono::microseconds m_selectable_time_bound{
+        std::chrono::microseconds::min()};
+
 public:
     void SanityCheck() const {
-        // Recompute m_peerdata from m_index. This verifies the data in it as it
-        // should just be caching statistics on m_index. It also verifies the
-        // invariant that no PeerInfo announcements with m_total==0 exist.
-        assert(m_peerinfo == RecomputePeerInfo(m_index));
+        // Recompute the per-peer data from the pool. This verifies the data in
+        // m_peerinfo, which should just be caching it. It also verifies the
+        // invariant that no PeerInfo exists for a peer without announcements.
+        std::unordered_map<NodeId, PeerInfo> peerinfo;
+        size_t waiting = 0;
+        for (AnnouncementIdx idx = 0; idx < m_announcements.size(); ++idx) {
+            const Announcement &ann = m_announcements[idx];
+            if (!ann.m_in_use) {
+                continue;
+            }
+            PeerInfo &info = peerinfo[ann.m_peer];
+            info.m_requested += (ann.GetState() == State::REQUESTED);
+            info.m_completed += (ann.GetState() == State::COMPLETED);
+            info.m_announcements.push_back(idx);
+            if (ann.GetState() == State::CANDIDATE_BEST) {
+                info.m_best.push_back(idx);
+            }
+            waiting += ann.IsWaiting();
+
+            // The announcement must be indexed by its invid.
+            auto invit = m_invids.find(ann.m_invid);
+            assert(invit != m_invids.end());
+            assert(std::count(invit->second.begin(), invit->second.end(),
+                              idx) == 1);
+
+            if (ann.IsSelectable()) {
+                assert(ann.m_time <= m_selectable_time_bound);
+            }
+        }
+        assert(waiting == m_waiting);
+        assert(peerinfo.size() == m_peerinfo.size());
+        for (const auto &item : peerinfo) {
+            auto it = m_peerinfo.find(item.first);
+            assert(it != m_peerinfo.end());
+            const PeerInfo &expected = item.second;
+            const PeerInfo &actual = it->second;
+            assert(expected.m_requested == actual.m_requested);
+            assert(expected.m_completed == actual.m_completed);
+            assert(expected.m_announcements.size() ==
+                   actual.m_announcements.size());
+            assert(expected.m_best.size() == actual.m_best.size());
+            for (size_t i = 0; i < actual.m_announcements.size(); ++i) {
+                const Announcement &ann =
+                    m_announcements[actual.m_announcements[i]];
+                assert(ann.m_in_use && ann.m_peer == item.first);
+                assert(ann.m_peer_pos == i);
+            }
+            for (size_t i = 0; i < actual.m_best.size(); ++i) {
+                const Announcement &ann = m_announcements[actual.m_best[i]];
+                assert(ann.GetState() == State::CANDIDATE_BEST);
+                assert(ann.m_best_pos == i);
+            }
+        }
+
+        // The invid index must not reference any other announcement.
+        size_t indexed = 0;
+        for (const auto &item : m_invids) {
+            assert(!item.second.empty());
+            for (const AnnouncementIdx idx : item.second) {
+                assert(m_announcements[idx].m_in_use);
+                assert(m_announcements[idx].m_invid == item.first);
+            }
+            indexed += item.second.size();
+        }
+        assert(indexed == Size());
 
-        // Calculate per-invid statistics from m_index, and validate
+        // Every waiting announcement must have an up to date timer.
+        std::set<std::pair<AnnouncementIdx, uint32_t>> timers;
+        for (const Timer &timer : m_timers) {
+            timers.emplace(timer.m_idx, timer.m_generation);
+        }
+        for (AnnouncementIdx idx = 0; idx < m_announcements.size(); ++idx) {
+            const Announcement &ann = m_announcements[idx];
+            if (ann.m_in_use && ann.IsWaiting()) {
+                assert(timers.count({idx, ann.m_generation}));
+            }
+        }
+
+        // Calculate per-invid statistics from the pool, and validate
         // invariants.
-        for (auto &item : ComputeInvIdInfo(m_index, m_computer)) {
+        for (auto &item : ComputeInvIdInfo(m_announcements, m_computer)) {
             InvIdInfo &info = item.second;
 
             // Cannot have only COMPLETED peer (invid should have been forgotten
@@ -424,7 +455,10 @@ public:
     }
 
     void PostGetRequestableSanityCheck(std::chrono::microseconds now) const {
-        for (const Announcement &ann : m_index) {
+        for (const Announcement &ann : m_announcements) {
+            if (!ann.m_in_use) {
+                continue;
+            }
             if (ann.IsWaiting()) {
                 // REQUESTED and CANDIDATE_DELAYED must have a time in the
                 // future (they should have been converted to
@@ -441,117 +475,237 @@ public:
     }
 
 private:
-    //! Wrapper around Index::...::erase that keeps m_peerinfo up to date.
-    template <typename Tag> Iter<Tag> Erase(Iter<Tag> it) {
-        auto peerit = m_peerinfo.find(it->m_peer);
-        peerit->second.m_completed -= it->GetState() == State::COMPLETED;
-        peerit->second.m_requested -= it->GetState() == State::REQUESTED;
-        if (--peerit->second.m_total == 0) {
+    //! Find the announcement for a given (peer, invid) combination, or
+    //! NO_ANNOUNCEMENT if there is none.
+    AnnouncementIdx Find(NodeId peer, const uint256 &invid) const {
+        auto it = m_invids.find(invid);
+        if (it == m_invids.end()) {
+            return NO_ANNOUNCEMENT;
+        }
+        for (const AnnouncementIdx idx : it->second) {
+            if (m_announcements[idx].m_peer == peer) {
+                return idx;
+            }
+        }
+        return NO_ANNOUNCEMENT;
+    }
+
+    //! Find the IsSelected() announcement for a given invid, or
+    //! NO_ANNOUNCEMENT if there is none.
+    AnnouncementIdx FindSelected(const uint256 &invid) const {
+        auto it = m_invids.find(invid);
+        if (it == m_invids.end()) {
+            return NO_ANNOUNCEMENT;
+        }
+        for (const AnnouncementIdx idx : it->second) {
+            if (m_announcements[idx].IsSelected()) {
+                return idx;
+            }
+        }
+        return NO_ANNOUNCEMENT;
+    }
+
+    //! Find the highest priority CANDIDATE_READY announcement for a given
+    //! invid, or NO_ANNOUNCEMENT if there is none.
+    AnnouncementIdx FindBestReady(const uint256 &invid) const {
+        auto it = m_invids.find(invid);
+        if (it == m_invids.end()) {
+            return NO_ANNOUNCEMENT;
+        }
+        AnnouncementIdx best = NO_ANNOUNCEMENT;
+        Priority best_priority = 0;
+        for (const AnnouncementIdx idx : it->second) {
+            const Announcement &ann = m_announcements[idx];
+            if (ann.GetState() != State::CANDIDATE_READY) {
+                continue;
+            }
+            const Priority priority = m_computer(ann);
+            if (best == NO_ANNOUNCEMENT || priority > best_priority) {
+                best = idx;
+                best_priority = priority;
+            }
+        }
+        return best;
+    }
+
+    //! Add a timer for an IsWaiting() announcement. The outdated timers are
+    //! purged when they make up more than half of the heap.
+    void AddTimer(AnnouncementIdx idx) {
+        const Announcement &ann = m_announcements[idx];
+        m_timers.push_back(
+            Timer{ann.m_time, ann.m_sequence, idx, ann.m_generation});
+        std::push_heap(m_timers.begin(), m_timers.end(), TimerCompare());
+
+        if (m_timers.size() > 2 * m_waiting + 64) {
+            m_timers.erase(std::remove_if(m_timers.begin(), m_timers.end(),
+                                          [this](const Timer &timer) {
+                                              return IsOutdated(timer);
+                                          }),
+                           m_timers.end());
+            std::make_heap(m_timers.begin(), m_timers.end(), TimerCompare());
+        }
+    }
+
+    //! Whether a timer doesn't match its announcement anymore.
+    bool IsOutdated(const Timer &timer) const {
+        const Announcement &ann = m_announcements[timer.m_idx];
+        return !ann.m_in_use || ann.m_generation != timer.m_generation;
+    }
+
+    //! Remove an announcement from its peer's CANDIDATE_BEST list.
+    void RemoveFromBest(PeerInfo &info, const Announcement &ann) {
+        const AnnouncementIdx last = info.m_best.back();
+        info.m_best[ann.m_best_pos] = last;
+        m_announcements[last].m_best_pos = ann.m_best_pos;
+        info.m_best.pop_back();
+    }
+
+    //! Change the state and time of an announcement, keeping m_peerinfo and
+    //! the timers up to date.
+    void Modify(AnnouncementIdx idx, State new_state,
+                std::chrono::microseconds new_time) {
+        Announcement &ann = m_announcements[idx];
+        PeerInfo &info = m_peerinfo.find(ann.m_peer)->second;
+
+        info.m_completed -= ann.GetState() == State::COMPLETED;
+        info.m_requested -= ann.GetState() == State::REQUESTED;
+        m_waiting -= ann.IsWaiting();
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            RemoveFromBest(info, ann);
+        }
+
+        ann.SetState(new_state);
+        ann.m_time = new_time;
+        ++ann.m_generation;
+
+        info.m_completed += ann.GetState() == State::COMPLETED;
+        info.m_requested += ann.GetState() == State::REQUESTED;
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            ann.m_best_pos = info.m_best.size();
+            info.m_best.push_back(idx);
+        }
+        if (ann.IsWaiting()) {
+            ++m_waiting;
+            AddTimer(idx);
+        }
+        if (ann.IsSelectable()) {
+            m_selectable_time_bound =
+                std::max(m_selectable_time_bound, ann.m_time);
+        }
+    }
+
+    //! Change the state of an announcement, keeping its time.
+    void Modify(AnnouncementIdx idx, State new_state) {
+        Modify(idx, new_state, m_announcements[idx].m_time);
+    }
+
+    //! Delete an announcement from the pool and from its peer's data. The
+    //! caller is responsible for the invid index.
+    void Release(AnnouncementIdx idx) {
+        Announcement &ann = m_announcements[idx];
+        auto peerit = m_peerinfo.find(ann.m_peer);
+        PeerInfo &info = peerit->second;
+
+        info.m_completed -= ann.GetState() == State::COMPLETED;
+        info.m_requested -= ann.GetState() == State::REQUESTED;
+        m_waiting -= ann.IsWaiting();
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            RemoveFromBest(info, ann);
+        }
+
+        const AnnouncementIdx last = info.m_announcements.back();
+        info.m_announcements[ann.m_peer_pos] = last;
+        m_announcements[last].m_peer_pos = ann.m_peer_pos;
+        info.m_announcements.pop_back();
+        if (info.m_announcements.empty()) {
             m_peerinfo.erase(peerit);
         }
-        return m_index.get<Tag>().erase(it);
+
+        ann.m_in_use = false;
+        ++ann.m_generation;
+        m_free_slots.push_back(idx);
     }
 
-    //! Wrapper around Index::...::modify that keeps m_peerinfo up to date.
-    template <typename Tag, typename Modifier>
-    void Modify(Iter<Tag> it, Modifier modifier) {
-        auto peerit = m_peerinfo.find(it->m_peer);
-        peerit->second.m_completed -= it->GetState() == State::COMPLETED;
-        peerit->second.m_requested -= it->GetState() == State::REQUESTED;
-        m_index.get<Tag>().modify(it, std::move(modifier));
-        peerit->second.m_completed += it->GetState() == State::COMPLETED;
-        peerit->second.m_requested += it->GetState() == State::REQUESTED;
+    //! Delete an announcement.
+    void Erase(AnnouncementIdx idx) {
+        auto invit = m_invids.find(m_announcements[idx].m_invid);
+        InvIdAnnouncements &anns = invit->second;
+        anns.erase(std::find(anns.begin(), anns.end(), idx));
+        if (anns.empty()) {
+            m_invids.erase(invit);
+        }
+        Release(idx);
+    }
+
+    //! Delete all the announcements for a given invid.
+    void EraseInvId(const uint256 &invid) {
+        auto invit = m_invids.find(invid);
+        if (invit == m_invids.end()) {
+            return;
+        }
+        const InvIdAnnouncements anns = std::move(invit->second);
+        m_invids.erase(invit);
+        for (const AnnouncementIdx idx : anns) {
+            Release(idx);
+        }
     }
 
     //! Convert a CANDIDATE_DELAYED announcement into a CANDIDATE_READY. If this
     //! makes it the new best CANDIDATE_READY (and no REQUESTED exists) and
     //! better than the CANDIDATE_BEST (if any), it becomes the new
     //! CANDIDATE_BEST.
-    void PromoteCandidateReady(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
-        assert(it->GetState() == State::CANDIDATE_DELAYED);
-        // Convert CANDIDATE_DELAYED to CANDIDATE_READY first.
-        Modify<ByInvId>(it, [](Announcement &ann) {
-            ann.SetState(State::CANDIDATE_READY);
-        });
-        // The following code relies on the fact that the ByInvId is sorted by
-        // invid, and then by state (first _DELAYED, then _READY, then
-        // _BEST/REQUESTED). Within the _READY announcements, the best one
-        // (highest priority) comes last. Thus, if an existing _BEST exists for
-        // the same invid that this announcement may be preferred over, it must
-        // immediately follow the newly created _READY.
-        auto it_next = std::next(it);
-        if (it_next == m_index.get<ByInvId>().end() ||
-            it_next->m_invid != it->m_invid ||
-            it_next->GetState() == State::COMPLETED) {
+    void PromoteCandidateReady(AnnouncementIdx idx) {
+        assert(m_announcements[idx].GetState() == State::CANDIDATE_DELAYED);
+        Modify(idx, State::CANDIDATE_READY);
+
+        const Announcement &ann = m_announcements[idx];
+        const AnnouncementIdx selected = FindSelected(ann.m_invid);
+        if (selected == NO_ANNOUNCEMENT) {
             // This is the new best CANDIDATE_READY, and there is no
             // IsSelected() announcement for this invid already.
-            Modify<ByInvId>(it, [](Announcement &ann) {
-                ann.SetState(State::CANDIDATE_BEST);
-            });
-        } else if (it_next->GetState() == State::CANDIDATE_BEST) {
-            Priority priority_old = m_computer(*it_next);
-            Priority priority_new = m_computer(*it);
-            if (priority_new > priority_old) {
-                // There is a CANDIDATE_BEST announcement already, but this one
-                // is better.
-                Modify<ByInvId>(it_next, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_READY);
-                });
-                Modify<ByInvId>(it, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_BEST);
-                });
-            }
+            Modify(idx, State::CANDIDATE_BEST);
+        } else if (m_announcements[selected].GetState() ==
+                       State::CANDIDATE_BEST &&
+                   m_computer(ann) > m_computer(m_announcements[selected])) {
+            // There is a CANDIDATE_BEST announcement already, but this one is
+            // better.
+            Modify(selected, State::CANDIDATE_READY);
+            Modify(idx, State::CANDIDATE_BEST);
         }
     }
 
     //! Change the state of an announcement to something non-IsSelected(). If it
     //! was IsSelected(), the next best announcement will be marked
     //! CANDIDATE_BEST.
-    void ChangeAndReselect(Iter<ByInvId> it, State new_state) {
+    void ChangeAndReselect(AnnouncementIdx idx, State new_state) {
         assert(new_state == State::COMPLETED ||
                new_state == State::CANDIDATE_DELAYED);
-        assert(it != m_index.get<ByInvId>().end());
-        if (it->IsSelected() && it != m_index.get<ByInvId>().begin()) {
-            auto it_prev = std::prev(it);
-            // The next best CANDIDATE_READY, if any, immediately precedes the
-            // REQUESTED or CANDIDATE_BEST announcement in the ByInvId index.
-            if (it_prev->m_invid == it->m_invid &&
-                it_prev->GetState() == State::CANDIDATE_READY) {
-                // If one such CANDIDATE_READY exists (for this invid), convert
-                // it to CANDIDATE_BEST.
-                Modify<ByInvId>(it_prev, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_BEST);
-                });
+        const bool was_selected = m_announcements[idx].IsSelected();
+        Modify(idx, new_state);
+        if (was_selected) {
+            // If a CANDIDATE_READY exists for this invid, convert the best one
+            // to CANDIDATE_BEST.
+            const AnnouncementIdx best =
+                FindBestReady(m_announcements[idx].m_invid);
+            if (best != NO_ANNOUNCEMENT) {
+                Modify(best, State::CANDIDATE_BEST);
             }
         }
-        Modify<ByInvId>(
-            it, [new_state](Announcement &ann) { ann.SetState(new_state); });
     }
 
-    //! Check if 'it' is the only announcement for a given invid that isn't
+    //! Check if 'idx' is the only announcement for a given invid that isn't
     //! COMPLETED.
-    bool IsOnlyNonCompleted(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
+    bool IsOnlyNonCompleted(AnnouncementIdx idx) const {
+        const Announcement &ann = m_announcements[idx];
         // Not allowed to call this on COMPLETED announcements.
-        assert(it->GetState() != State::COMPLETED);
-
-        // This announcement has a predecessor that belongs to the same invid.
-        // Due to ordering, and the fact that 'it' is not COMPLETED, its
-        // predecessor cannot be COMPLETED here.
-        if (it != m_index.get<ByInvId>().begin() &&
-            std::prev(it)->m_invid == it->m_invid) {
-            return false;
-        }
+        assert(ann.GetState() != State::COMPLETED);
 
-        // This announcement has a successor that belongs to the same invid,
-        // and is not COMPLETED.
-        if (std::next(it) != m_index.get<ByInvId>().end() &&
-            std::next(it)->m_invid == it->m_invid &&
-            std::next(it)->GetState() != State::COMPLETED) {
-            return false;
+        for (const AnnouncementIdx other : m_invids.find(ann.m_invid)->second) {
+            if (other != idx &&
+                m_announcements[other].GetState() != State::COMPLETED) {
+                return false;
+            }
         }
-
         return true;
     }
 
@@ -562,28 +716,23 @@ private:
      * the best one is made CANDIDATE_BEST. Returns whether the announcement
      * still exists.
      */
-    bool MakeCompleted(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
-
+    bool MakeCompleted(AnnouncementIdx idx) {
         // Nothing to be done if it's already COMPLETED.
-        if (it->GetState() == State::COMPLETED) {
+        if (m_announcements[idx].GetState() == State::COMPLETED) {
             return true;
         }
 
-        if (IsOnlyNonCompleted(it)) {
+        if (IsOnlyNonCompleted(idx)) {
             // This is the last non-COMPLETED announcement for this invid.
             // Delete all.
-            uint256 invid = it->m_invid;
-            do {
-                it = Erase<ByInvId>(it);
-            } while (it != m_index.get<ByInvId>().end() &&
-                     it->m_invid == invid);
+            const uint256 invid = m_announcements[idx].m_invid;
+            EraseInvId(invid);
             return false;
         }
 
         // Mark the announcement COMPLETED, and select the next best
-        // announcement (the first CANDIDATE_READY) if needed.
-        ChangeAndReselect(it, State::COMPLETED);
+        // announcement (the best CANDIDATE_READY) if needed.
+        ChangeAndReselect(idx, State::COMPLETED);
 
         return true;
     }
@@ -598,131 +747,124 @@ private:
                       ClearExpiredFun clearExpired,
                       EmplaceExpiredFun emplaceExpired) {
         clearExpired();
-        // Iterate over all CANDIDATE_DELAYED and REQUESTED from old to new, as
-        // long as they're in the past, and convert them to CANDIDATE_READY and
-        // COMPLETED respectively.
-        while (!m_index.empty()) {
-            auto it = m_index.get<ByTime>().begin();
-            if (it->GetState() == State::CANDIDATE_DELAYED &&
-                it->m_time <= now) {
-                PromoteCandidateReady(m_index.project<ByInvId>(it));
-            } else if (it->GetState() == State::REQUESTED &&
-                       it->m_time <= now) {
-                emplaceExpired(it->m_peer, it->m_invid);
-                MakeCompleted(m_index.project<ByInvId>(it));
-            } else {
-                break;
+        // Fire the timers of all CANDIDATE_DELAYED and REQUESTED from old to
+        // new, as long as they're in the past, and convert them to
+        // CANDIDATE_READY and COMPLETED respectively.
+        while (!m_timers.empty() && m_timers.front().m_time <= now) {
+            const Timer timer = m_timers.front();
+            std::pop_heap(m_timers.begin(), m_timers.end(), TimerCompare());
+            m_timers.pop_back();
+
+            if (IsOutdated(timer)) {
+                continue;
+            }
+
+            const Announcement &ann = m_announcements[timer.m_idx];
+            if (ann.GetState() == State::CANDIDATE_DELAYED) {
+                PromoteCandidateReady(timer.m_idx);
+            } else if (ann.GetState() == State::REQUESTED) {
+                emplaceExpired(ann.m_peer, ann.m_invid);
+                MakeCompleted(timer.m_idx);
             }
         }
 
-        while (!m_index.empty()) {
-            // If time went backwards, we may need to demote CANDIDATE_BEST and
-            // CANDIDATE_READY announcements back to CANDIDATE_DELAYED. This is
-            // an unusual edge case, and unlikely to matter in production.
-            // However, it makes it much easier to specify and test
-            // InvRequestTracker::Impl's behaviour.
-            auto it = std::prev(m_index.get<ByTime>().end());
-            if (it->IsSelectable() && it->m_time > now) {
-                ChangeAndReselect(m_index.project<ByInvId>(it),
-                                  State::CANDIDATE_DELAYED);
+        // If time went backwards, we may need to demote CANDIDATE_BEST and
+        // CANDIDATE_READY announcements back to CANDIDATE_DELAYED. This is an
+        // unusual edge case, and unlikely to matter in production. However, it
+        // makes it much easier to specify and test InvRequestTracker::Impl's
+        // behaviour. As it requires a scan of all the announcements, it is
+        // only done when some selectable announcement may be in the future.
+        if (m_selectable_time_bound <= now) {
+            return;
+        }
+
+        std::vector<AnnouncementIdx> to_demote;
+        std::chrono::microseconds bound = std::chrono::microseconds::min();
+        for (AnnouncementIdx idx = 0; idx < m_announcements.size(); ++idx) {
+            const Announcement &ann = m_announcements[idx];
+            if (!ann.m_in_use || !ann.IsSelectable()) {
+                continue;
+            }
+            if (ann.m_time > now) {
+                to_demote.push_back(idx);
             } else {
-                break;
+                bound = std::max(bound, ann.m_time);
             }
         }
+
+        // Reselection can only promote announcements which are either in the
+        // past or part of to_demote, so this is enough to demote them all.
+        for (const AnnouncementIdx idx : to_demote) {
+            ChangeAndReselect(idx, State::CANDIDATE_DELAYED);
+        }
+        m_selectable_time_bound = bound;
     }
 
 public:
-    InvRequestTrackerImpl(bool deterministic)
-        : m_computer(deterministic),
-          // Explicitly initialize m_index as we need to pass a reference to
-          // m_computer to ByInvIdViewExtractor.
-          m_index(boost::make_tuple(
-              boost::make_tuple(ByPeerViewExtractor(), std::less<ByPeerView>()),
-              boost::make_tuple(ByInvIdViewExtractor(m_computer),
-                                std::less<ByInvIdView>()),
-              boost::make_tuple(ByTimeViewExtractor(),
-                                std::less<ByTimeView>()))) {}
-
-    // Disable copying and assigning (a default copy won't work due the stateful
-    // ByInvIdViewExtractor).
+    InvRequestTrackerImpl(bool deterministic) : m_computer(deterministic) {}
+
     InvRequestTrackerImpl(const InvRequestTrackerImpl &) = delete;
     InvRequestTrackerImpl &operator=(const InvRequestTrackerImpl &) = delete;
 
     ~InvRequestTrackerImpl() = default;
 
     void DisconnectedPeer(NodeId peer) {
-        auto &index = m_index.get<ByPeer>();
-        auto it =
-            index.lower_bound(ByPeerView{peer, false, uint256(uint256::ZERO)});
-        while (it != index.end() && it->m_peer == peer) {
-            // Check what to continue with after this iteration. 'it' will be
-            // deleted in what follows, so we need to decide what to continue
-            // with afterwards. There are a number of cases to consider:
-            // - std::next(it) is end() or belongs to a different peer. In that
-            //   case, this is the last iteration of the loop (denote this by
-            //   setting it_next to end()).
-            // - 'it' is not the only non-COMPLETED announcement for its invid.
-            //   This means it will be deleted, but no other Announcement
-            //   objects will be modified. Continue with std::next(it) if it
-            //   belongs to the same peer, but decide this ahead of time (as
-            //   'it' may change position in what follows).
-            // - 'it' is the only non-COMPLETED announcement for its invid. This
-            //   means it will be deleted along with all other announcements for
-            //   the same invid - which may include std::next(it). However,
-            //   other than 'it', no announcements for the same peer can be
-            //   affected (due to (peer, invid) uniqueness). In other words, the
-            //   situation where std::next(it) is deleted can only occur if
-            //   std::next(it) belongs to a different peer but the same invid as
-            //   'it'. This is covered by the first bulletpoint already, and
-            //   we'll have set it_next to end().
-            auto it_next =
-                (std::next(it) == index.end() || std::next(it)->m_peer != peer)
-                    ? index.end()
-                    : std::next(it);
+        auto it = m_peerinfo.find(peer);
+        if (it == m_peerinfo.end()) {
+            return;
+        }
+
+        // Copy the list, as it is modified while we iterate. No announcement
+        // for that peer other than the current one can be deleted while
+        // iterating, due to (peer, invid) uniqueness.
+        const std::vector<AnnouncementIdx> announcements =
+            it->second.m_announcements;
+        for (const AnnouncementIdx idx : announcements) {
             // If the announcement isn't already COMPLETED, first make it
             // COMPLETED (which will mark other CANDIDATEs as CANDIDATE_BEST, or
             // delete all of a invid's announcements if no non-COMPLETED ones
             // are left).
-            if (MakeCompleted(m_index.project<ByInvId>(it))) {
+            if (MakeCompleted(idx)) {
                 // Then actually delete the announcement (unless it was already
                 // deleted by MakeCompleted).
-                Erase<ByPeer>(it);
+                Erase(idx);
             }
-            it = it_next;
         }
     }
 
-    void ForgetInvId(const uint256 &invid) {
-        auto it = m_index.get<ByInvId>().lower_bound(
-            ByInvIdView{invid, State::CANDIDATE_DELAYED, 0});
-        while (it != m_index.get<ByInvId>().end() && it->m_invid == invid) {
-            it = Erase<ByInvId>(it);
-        }
-    }
+    void ForgetInvId(const uint256 &invid) { EraseInvId(invid); }
 
     void ReceivedInv(NodeId peer, const uint256 &invid, bool preferred,
                      std::chrono::microseconds reqtime) {
-        // Bail out if we already have a CANDIDATE_BEST announcement for this
-        // (invid, peer) combination. The case where there is a
-        // non-CANDIDATE_BEST announcement already will be caught by the
-        // uniqueness property of the ByPeer index when we try to emplace the
-        // new object below.
-        if (m_index.get<ByPeer>().count(ByPeerView{peer, true, invid})) {
+        // Bail out if we already have an announcement for this (invid, peer)
+        // combination.
+        if (Find(peer, invid) != NO_ANNOUNCEMENT) {
             return;
         }
 
-        // Try creating the announcement with CANDIDATE_DELAYED state (which
-        // will fail due to the uniqueness of the ByPeer index if a
-        // non-CANDIDATE_BEST announcement already exists with the same invid
-        // and peer). Bail out in that case.
-        auto ret = m_index.get<ByPeer>().emplace(invid, peer, preferred,
-                                                 reqtime, m_current_sequence);
-        if (!ret.second) {
-            return;
+        // Create the announcement with CANDIDATE_DELAYED state, reusing a free
+        // slot if any.
+        AnnouncementIdx idx;
+        if (m_free_slots.empty()) {
+            idx = m_announcements.size();
+            m_announcements.emplace_back(invid, peer, preferred, reqtime,
+                                         m_current_sequence, 0);
+        } else {
+            idx = m_free_slots.back();
+            m_free_slots.pop_back();
+            m_announcements[idx] =
+                Announcement(invid, peer, preferred, reqtime,
+                             m_current_sequence,
+                             m_announcements[idx].m_generation);
         }
 
-        // Update accounting metadata.
-        ++m_peerinfo[peer].m_total;
+        // Update the indexes and accounting metadata.
+        m_invids[invid].push_back(idx);
+        PeerInfo &info = m_peerinfo[peer];
+        m_announcements[idx].m_peer_pos = info.m_announcements.size();
+        info.m_announcements.push_back(idx);
+        ++m_waiting;
+        AddTimer(idx);
         ++m_current_sequence;
     }
 
@@ -734,15 +876,16 @@ public:
         // Move time.
         SetTimePoint(now, clearExpired, emplaceExpired);
 
+        auto it = m_peerinfo.find(peer);
+        if (it == m_peerinfo.end()) {
+            return {};
+        }
+
         // Find all CANDIDATE_BEST announcements for this peer.
         std::vector<const Announcement *> selected;
-        auto it_peer = m_index.get<ByPeer>().lower_bound(
-            ByPeerView{peer, true, uint256(uint256::ZERO)});
-        while (it_peer != m_index.get<ByPeer>().end() &&
-               it_peer->m_peer == peer &&
-               it_peer->GetState() == State::CANDIDATE_BEST) {
-            selected.emplace_back(&*it_peer);
-            ++it_peer;
+        selected.reserve(it->second.m_best.size());
+        for (const AnnouncementIdx idx : it->second.m_best) {
+            selected.emplace_back(&m_announcements[idx]);
         }
 
         // Sort by sequence number.
@@ -762,8 +905,16 @@ public:
 
     void RequestedData(NodeId peer, const uint256 &invid,
                        std::chrono::microseconds expiry) {
-        auto it = m_index.get<ByPeer>().find(ByPeerView{peer, true, invid});
-        if (it == m_index.get<ByPeer>().end()) {
+        const AnnouncementIdx idx = Find(peer, invid);
+        if (idx == NO_ANNOUNCEMENT) {
+            // There is no announcement tracked for this peer, so we have
+            // nothing to do. This invid wasn't tracked at all (and the caller
+            // should have called ReceivedInv).
+            return;
+        }
+
+        const State state = m_announcements[idx].GetState();
+        if (state != State::CANDIDATE_BEST) {
             // There is no CANDIDATE_BEST announcement, look for a _READY or
             // _DELAYED instead. If the caller only ever invokes RequestedData
             // with the values returned by GetRequestable, and no other
@@ -771,16 +922,11 @@ public:
             // between, this branch will never execute (as invids returned by
             // GetRequestable always correspond to CANDIDATE_BEST
             // announcements).
-
-            it = m_index.get<ByPeer>().find(ByPeerView{peer, false, invid});
-            if (it == m_index.get<ByPeer>().end() ||
-                (it->GetState() != State::CANDIDATE_DELAYED &&
-                 it->GetState() != State::CANDIDATE_READY)) {
-                // There is no CANDIDATE announcement tracked for this peer, so
-                // we have nothing to do. Either this invid wasn't tracked at
-                // all (and the caller should have called ReceivedInv), or it
-                // was already requested and/or completed for other reasons and
-                // this is just a superfluous RequestedData call.
+            if (state != State::CANDIDATE_DELAYED &&
+                state != State::CANDIDATE_READY) {
+                // The inventory was already requested and/or completed for
+                // other reasons and this is just a superfluous RequestedData
+                // call.
                 return;
             }
 
@@ -788,11 +934,10 @@ public:
             // invid. We only need to do this if the found announcement had a
             // different state than CANDIDATE_BEST. If it did, invariants
             // guarantee that no other CANDIDATE_BEST or REQUESTED can exist.
-            auto it_old = m_index.get<ByInvId>().lower_bound(
-                ByInvIdView{invid, State::CANDIDATE_BEST, 0});
-            if (it_old != m_index.get<ByInvId>().end() &&
-                it_old->m_invid == invid) {
-                if (it_old->GetState() == State::CANDIDATE_BEST) {
+            const AnnouncementIdx selected = FindSelected(invid);
+            if (selected != NO_ANNOUNCEMENT) {
+                if (m_announcements[selected].GetState() ==
+                    State::CANDIDATE_BEST) {
                     // The data structure's invariants require that there can be
                     // at most one CANDIDATE_BEST or one REQUESTED announcement
                     // per invid (but not both simultaneously), so we have to
@@ -803,35 +948,23 @@ public:
                     // GetRequestable() time. If time only goes forward, it will
                     // always be _READY, so pick that to avoid extra work in
                     // SetTimePoint().
-                    Modify<ByInvId>(it_old, [](Announcement &ann) {
-                        ann.SetState(State::CANDIDATE_READY);
-                    });
-                } else if (it_old->GetState() == State::REQUESTED) {
+                    Modify(selected, State::CANDIDATE_READY);
+                } else {
                     // As we're no longer waiting for a response to the previous
                     // REQUESTED announcement, convert it to COMPLETED. This
                     // also helps guaranteeing progress.
-                    Modify<ByInvId>(it_old, [](Announcement &ann) {
-                        ann.SetState(State::COMPLETED);
-                    });
+                    Modify(selected, State::COMPLETED);
                 }
             }
         }
 
-        Modify<ByPeer>(it, [expiry](Announcement &ann) {
-            ann.SetState(State::REQUESTED);
-            ann.m_time = expiry;
-        });
+        Modify(idx, State::REQUESTED, expiry);
     }
 
     void ReceivedResponse(NodeId peer, const uint256 &invid) {
-        // We need to search the ByPeer index for both (peer, false, invid) and
-        // (peer, true, invid).
-        auto it = m_index.get<ByPeer>().find(ByPeerView{peer, false, invid});
-        if (it == m_index.get<ByPeer>().end()) {
-            it = m_index.get<ByPeer>().find(ByPeerView{peer, true, invid});
-        }
-        if (it != m_index.get<ByPeer>().end()) {
-            MakeCompleted(m_index.project<ByInvId>(it));
+        const AnnouncementIdx idx = Find(peer, invid);
+        if (idx != NO_ANNOUNCEMENT) {
+            MakeCompleted(idx);
         }
     }
 
@@ -846,8 +979,8 @@ public:
     size_t CountCandidates(NodeId peer) const {
         auto it = m_peerinfo.find(peer);
         if (it != m_peerinfo.end()) {
-            return it->second.m_total - it->second.m_requested -
-                   it->second.m_completed;
+            return it->second.m_announcements.size() -
+                   it->second.m_requested - it->second.m_completed;
         }
         return 0;
     }
@@ -855,14 +988,16 @@ public:
     size_t Count(NodeId peer) const {
         auto it = m_peerinfo.find(peer);
         if (it != m_peerinfo.end()) {
-            return it->second.m_total;
+            return it->second.m_announcements.size();
         }
         return 0;
     }
 
     //! Count how many announcements are being tracked in total across all peers
     //! and transactions.
-    size_t Size() const { return m_index.size(); }
+    size_t Size() const {
+        return m_announcements.size() - m_free_slots.size();
+    }
 
     uint64_t ComputePriority(const uint256 &invid, NodeId peer,
                              bool preferred) const {
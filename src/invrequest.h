@@ -124,9 +124,11 @@
  * - Memory usage is proportional to the total number of tracked announcements
  *   (Size()) plus the number of peers with a nonzero number of tracked
  *   announcements.
- * - CPU usage is generally logarithmic in the total number of tracked
- *   announcements, plus the number of announcements affected by an operation
- *   (amortized O(1) per announcement).
+ * - CPU usage is generally constant for lookups by invid or by peer (the few
+ *   announcements for a given invid are scanned linearly), logarithmic in the
+ *   number of announcements waiting for their reqtime or expiry when one of
+ *   them is scheduled, plus the number of announcements affected by an
+ *   operation (amortized O(1) per announcement).
  */
 
 // Avoid littering this header file with implementation details.
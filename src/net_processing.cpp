@@ -46,11 +46,13 @@
 #include <streams.h>
 #include <tinyformat.h>
 #include <txmempool.h>
+#include <txreconciliation.h>
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <memory>
 #include <typeinfo>
 
@@ -1062,6 +1064,68 @@ void PeerManager::AddProofAnnouncement(const CNode &node,
     m_proofrequest.ReceivedInv(node.GetId(), proofid, preferred, reqtime);
 }
 
+void PeerManager::AnnounceReconciledTxs(CNode &peer,
+                                        const std::vector<TxId> &txids) {
+    if (peer.m_tx_relay == nullptr) {
+        return;
+    }
+
+    const CNetMsgMaker msgMaker(peer.GetCommonVersion());
+    std::vector<CInv> vInv;
+
+    LOCK2(cs_main, peer.m_tx_relay->cs_tx_inventory);
+    for (const TxId &txid : txids) {
+        if (peer.m_tx_relay->filterInventoryKnown.contains(txid) ||
+            !m_mempool.exists(txid)) {
+            continue;
+        }
+
+        // Let the peer request it, same as a trickled announcement.
+        peer.m_tx_relay->filterInventoryKnown.insert(txid);
+        State(peer.GetId())->m_recently_announced_invs.insert(txid);
+        vInv.emplace_back(MSG_TX, txid);
+        if (vInv.size() == MAX_INV_SZ) {
+            m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+            vInv.clear();
+        }
+    }
+
+    if (!vInv.empty()) {
+        m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+    }
+}
+
+std::vector<CTransactionRef>
+PeerManager::EvictConflicts(const CTransaction &tx) {
+    LOCK(m_mempool.cs);
+    CTxMemPool::setEntries conflicts;
+    for (const CTxIn &txin : tx.vin) {
+        auto it = m_mempool.mapNextTx.find(txin.prevout);
+        if (it == m_mempool.mapNextTx.end()) {
+            continue;
+        }
+        if (auto conflict = m_mempool.GetIter(it->second->GetId())) {
+            m_mempool.CalculateDescendants(*conflict, conflicts);
+        }
+    }
+
+    // A transaction has more ancestors than any of its parents.
+    std::vector<CTxMemPool::txiter> sorted(conflicts.begin(), conflicts.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](CTxMemPool::txiter a, CTxMemPool::txiter b) {
+                  return a->GetCountWithAncestors() <
+                         b->GetCountWithAncestors();
+              });
+    std::vector<CTransactionRef> evicted;
+    evicted.reserve(sorted.size());
+    for (CTxMemPool::txiter it : sorted) {
+        evicted.push_back(it->GetSharedTx());
+    }
+
+    m_mempool.removeConflicts(tx);
+    return evicted;
+}
+
 // This function is used for testing the stale tip eviction logic, see
 // denialofservice_tests.cpp
 void UpdateLastBlockAnnounceTime(NodeId node, int64_t time_in_seconds) {
@@ -1172,6 +1236,10 @@ void PeerManager::FinalizeNode(const Config &config, NodeId nodeid,
 
     WITH_LOCK(cs_proofrequest, m_proofrequest.DisconnectedPeer(nodeid));
 
+    if (m_txreconciliation) {
+        m_txreconciliation->ForgetPeer(nodeid);
+    }
+
     LogPrint(BCLog::NET, "Cleared nodestate for peer=%d\n", nodeid);
 }
 
@@ -1522,6 +1590,14 @@ PeerManager::PeerManager(const CChainParams &chainparams, CConnman &connman,
     g_recent_confirmed_transactions.reset(
         new CRollingBloomFilter(24000, 0.000001));
 
+    if (gArgs.GetBoolArg("-txreconciliation",
+                         DEFAULT_TXRECONCILIATION_ENABLE)) {
+        m_txreconciliation = std::make_unique<TxReconciliationTracker>(
+            std::clamp<int>(gArgs.GetArg("-txreconciliationfanout",
+                                         DEFAULT_TXRECONCILIATION_FANOUT),
+                            0, 100));
+    }
+
     const Consensus::Params &consensusParams = chainparams.GetConsensus();
     // Stale tip checking and peer eviction are on two different timers, but we
     // don't want them to get out of sync due to drift in the scheduler, so we
@@ -3065,6 +3141,18 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
             }
         }
 
+        if (m_txreconciliation && pfrom.m_tx_relay != nullptr &&
+            WITH_LOCK(pfrom.m_tx_relay->cs_filter,
+                      return pfrom.m_tx_relay->fRelayTxes)) {
+            // Offer to reconcile transactions rather than flooding them.
+            const uint64_t salt =
+                m_txreconciliation->PreRegisterPeer(pfrom.GetId());
+            m_connman.PushMessage(&pfrom,
+                                  msgMaker.Make(NetMsgType::SENDRECON,
+                                                TXRECONCILIATION_VERSION,
+                                                salt));
+        }
+
         pfrom.fSuccessfullyConnected = true;
         return;
     }
@@ -3159,6 +3247,78 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
         return;
     }
 
+    if (msg_type == NetMsgType::SENDRECON) {
+        uint32_t peer_version;
+        uint64_t peer_salt;
+        vRecv >> peer_version >> peer_salt;
+        // Ignore the message if we did not offer to reconcile ourselves.
+        if (m_txreconciliation &&
+            m_txreconciliation->RegisterPeer(pfrom.GetId(),
+                                             !pfrom.IsInboundConn(),
+                                             peer_version, peer_salt)) {
+            LogPrint(BCLog::NET, "Reconciling transactions with peer=%d\n",
+                     pfrom.GetId());
+        }
+        return;
+    }
+
+    if (msg_type == NetMsgType::REQRECON) {
+        uint16_t peer_set_size;
+        uint32_t round;
+        vRecv >> peer_set_size >> round;
+        ReconciliationSketch sketch;
+        std::vector<TxId> txs_to_announce;
+        if (!m_txreconciliation ||
+            !m_txreconciliation->HandleReconciliationRequest(
+                pfrom.GetId(), peer_set_size, sketch, txs_to_announce)) {
+            Misbehaving(pfrom, 10, "unexpected-reqrecon");
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        m_connman.PushMessage(
+            &pfrom, msgMaker.Make(NetMsgType::SKETCH, round, sketch));
+        return;
+    }
+
+    if (msg_type == NetMsgType::SKETCH) {
+        uint32_t round;
+        ReconciliationSketch sketch;
+        vRecv >> round >> sketch;
+        bool success = false;
+        std::vector<TxId> txs_to_announce;
+        std::vector<uint32_t> shortids_to_request;
+        if (!m_txreconciliation ||
+            !m_txreconciliation->HandleSketch(pfrom.GetId(), round, sketch,
+                                              success, txs_to_announce,
+                                              shortids_to_request)) {
+            // Not a misbehavior, the request may have timed out while the
+            // sketch was in flight.
+            LogPrint(BCLog::NET, "Ignoring unexpected sketch from peer=%d\n",
+                     pfrom.GetId());
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        m_connman.PushMessage(&pfrom,
+                              msgMaker.Make(NetMsgType::RECONCILDIFF, success,
+                                            shortids_to_request));
+        return;
+    }
+
+    if (msg_type == NetMsgType::RECONCILDIFF) {
+        bool success;
+        std::vector<uint32_t> shortids;
+        vRecv >> success >> shortids;
+        std::vector<TxId> txs_to_announce;
+        if (!m_txreconciliation ||
+            !m_txreconciliation->HandleReconciliationDifference(
+                pfrom.GetId(), success, shortids, txs_to_announce)) {
+            Misbehaving(pfrom, 10, "unexpected-reconcildiff");
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        return;
+    }
+
     if (msg_type == NetMsgType::SENDCMPCT) {
         bool fAnnounceUsingCMPCTBLOCK = false;
         uint64_t nCMPCTBLOCKVersion = 0;
@@ -3255,6 +3415,10 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
                 logInv(inv, fAlreadyHave);
 
                 pfrom.AddKnownTx(txid);
+                if (m_txreconciliation) {
+                    m_txreconciliation->TryRemovingFromSet(pfrom.GetId(),
+                                                           txid);
+                }
                 if (fBlocksOnly) {
                     LogPrint(BCLog::NET,
                              "transaction (%s) inv sent in violation of "
@@ -3567,6 +3731,9 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
             // about any requests for it.
             m_txrequest.ForgetInvId(tx.GetId());
             RelayTransaction(tx.GetId(), m_connman);
+            if (g_avalanche && isAvalancheEnabled(gArgs)) {
+                g_avalanche->addTxToReconcile(ptx, true);
+            }
             for (size_t i = 0; i < tx.vout.size(); i++) {
                 auto it_by_prev =
                     mapOrphanTransactionsByPrev.find(COutPoint(txid, i));
@@ -3639,6 +3806,13 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
             recentRejects->insert(tx.GetId());
             m_txrequest.ForgetInvId(tx.GetId());
 
+            if (state.GetRejectReason() == "txn-mempool-conflict" &&
+                g_avalanche && isAvalancheEnabled(gArgs)) {
+                // Let the avalanche peers decide which of the conflicting
+                // transactions should be kept.
+                g_avalanche->addTxToReconcile(ptx, false, pfrom.GetId());
+            }
+
             if (RecursiveDynamicUsage(*ptx) < 100000) {
                 AddToCompactExtraTransactions(ptx);
             }
@@ -4211,6 +4385,10 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
         LogPrint(BCLog::NET, "received avalanche poll from peer=%d\n",
                  pfrom.GetId());
 
+        // Proofs are looked up once cs_main is released, as the avalanche
+        // peer manager takes it after its own lock.
+        std::vector<size_t> proofVotes;
+
         {
             LOCK(cs_main);
 
@@ -4222,6 +4400,33 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
                     votes.emplace_back(e, inv.hash);
                 };
 
+                if (inv.type == MSG_AVA_PROOF) {
+                    proofVotes.push_back(votes.size());
+                    insertVote(-1);
+                    continue;
+                }
+
+                if (inv.type == MSG_TX) {
+                    const TxId txid(inv.hash);
+
+                    // Accepted transaction.
+                    if (m_mempool.exists(txid)) {
+                        insertVote(0);
+                        continue;
+                    }
+
+                    // Rejected or conflicting transaction.
+                    if (recentRejects->contains(txid) ||
+                        g_avalanche->getConflictingTx(txid)) {
+                        insertVote(1);
+                        continue;
+                    }
+
+                    // Unknown transaction.
+                    insertVote(-1);
+                    continue;
+                }
+
                 // Not a block.
                 if (inv.type != MSG_BLOCK) {
                     insertVote(-1);
@@ -4278,6 +4483,25 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
             }
         }
 
+        for (size_t i : proofVotes) {
+            const avalanche::ProofId proofid(votes[i].GetHash());
+
+            uint32_t error = -1;
+            if (g_avalanche->getProof(proofid)) {
+                // Valid proof.
+                error = 0;
+            } else if (WITH_LOCK(cs_rejectedProofs,
+                                 return rejectedProofs->contains(proofid))) {
+                // Invalid proof.
+                error = 1;
+            } else if (g_avalanche->getOrphan(proofid)) {
+                // Orphan proof, we can't tell yet.
+                error = -2;
+            }
+
+            votes[i] = avalanche::Vote(error, proofid);
+        }
+
         // Send the query to the node.
         g_avalanche->sendResponse(
             &pfrom, avalanche::Response(round, cooldown, std::move(votes)));
@@ -4302,10 +4526,75 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
         }
 
         std::vector<avalanche::BlockUpdate> updates;
-        if (!g_avalanche->registerVotes(pfrom.GetId(), response, updates)) {
+        std::vector<avalanche::TxUpdate> txUpdates;
+        std::vector<avalanche::ProofUpdate> proofUpdates;
+        if (!g_avalanche->registerVotes(pfrom.GetId(), response, updates,
+                                        txUpdates, proofUpdates)) {
             return;
         }
 
+        for (const avalanche::ProofUpdate &u : proofUpdates) {
+            const avalanche::ProofId &proofid = u.getItem()->getId();
+            if (u.getStatus() == avalanche::BlockUpdate::Status::Invalid) {
+                LogPrintf("Avalanche invalidated proof %s\n",
+                          proofid.ToString());
+                WITH_LOCK(cs_rejectedProofs, rejectedProofs->insert(proofid));
+            }
+        }
+
+        for (const avalanche::TxUpdate &u : txUpdates) {
+            const CTransactionRef &tx = u.getItem();
+            switch (u.getStatus()) {
+                case avalanche::BlockUpdate::Status::Invalid: {
+                    // The network settled on a conflicting transaction.
+                    LogPrintf("Avalanche invalidated tx %s\n",
+                              tx->GetId().ToString());
+                    LOCK2(cs_main, m_mempool.cs);
+                    m_mempool.removeRecursive(*tx,
+                                              MemPoolRemovalReason::CONFLICT);
+                    recentRejects->insert(tx->GetId());
+                } break;
+                case avalanche::BlockUpdate::Status::Finalized: {
+                    LOCK(cs_main);
+                    if (m_mempool.exists(tx->GetId())) {
+                        break;
+                    }
+
+                    // This transaction won against the one in our mempool,
+                    // swap them.
+                    LogPrintf("Avalanche finalized conflicting tx %s\n",
+                              tx->GetId().ToString());
+                    const std::vector<CTransactionRef> evicted =
+                        EvictConflicts(*tx);
+
+                    TxValidationState state;
+                    if (AcceptToMemoryPool(config, m_mempool, state, tx,
+                                           false /* bypass_limits */,
+                                           Amount::zero() /* nAbsurdFee */)) {
+                        RelayTransaction(tx->GetId(), m_connman);
+                        break;
+                    }
+
+                    // The winner can't make it to our mempool, e.g. because
+                    // one of its inputs got spent in a block meanwhile. Don't
+                    // lose the transactions it was meant to replace.
+                    LogPrint(BCLog::MEMPOOL,
+                             "failed to accept finalized tx %s (%s)\n",
+                             tx->GetId().ToString(), state.ToString());
+                    for (const CTransactionRef &evictedTx : evicted) {
+                        TxValidationState dummyState;
+                        AcceptToMemoryPool(config, m_mempool, dummyState,
+                                           evictedTx, true /* bypass_limits */,
+                                           Amount::zero() /* nAbsurdFee */);
+                    }
+                } break;
+                case avalanche::BlockUpdate::Status::Accepted:
+                case avalanche::BlockUpdate::Status::Rejected:
+                    // Nothing to do until the vote is final.
+                    break;
+            }
+        }
+
         if (updates.size()) {
             for (avalanche::BlockUpdate &u : updates) {
                 CBlockIndex *pindex = u.getBlockIndex();
@@ -4366,6 +4655,7 @@ void PeerManager::ProcessMessage(const Config &config, CNode &pfrom,
         if (g_avalanche->addProof(proof)) {
             WITH_LOCK(cs_proofrequest, m_proofrequest.ForgetInvId(proofid));
             RelayProof(proofid, m_connman);
+            g_avalanche->addProofToReconcile(proof);
 
             LogPrint(BCLog::NET, "New avalanche proof: peer=%d, proofid %s\n",
                      nodeid, proofid.ToString());
@@ -5030,18 +5320,38 @@ void PeerManager::CheckForStaleTipAndEvictPeers(
 }
 
 namespace {
-class CompareInvMempoolOrder {
-    CTxMemPool *mp;
+/**
+ * What is needed from the mempool entry of a transaction to announce it,
+ * copied so the mempool doesn't need to stay locked while the inventory is
+ * built.
+ */
+struct TxInvCandidate {
+    std::set<TxId>::iterator it;
+    CTransactionRef tx;
+    Amount fee;
+    size_t size;
+    uint64_t countWithAncestors;
+};
 
+class CompareInvMempoolOrder {
 public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool) { mp = _mempool; }
-
-    bool operator()(std::set<TxId>::iterator a, std::set<TxId>::iterator b) {
+    bool operator()(const TxInvCandidate &a, const TxInvCandidate &b) const {
         /**
          * As std::make_heap produces a max-heap, we want the entries with the
-         * fewest ancestors/highest fee to sort later.
+         * fewest ancestors/highest fee to sort later. This is the same order
+         * as CTxMemPool::CompareDepthAndScore, without looking the entries up
+         * and locking the mempool for every comparison.
          */
-        return mp->CompareDepthAndScore(*b, *a);
+        if (a.countWithAncestors != b.countWithAncestors) {
+            return b.countWithAncestors < a.countWithAncestors;
+        }
+        // Same as CompareTxMemPoolEntryByScore()(b, a)
+        const double f1 = a.size * (b.fee / SATOSHI);
+        const double f2 = b.size * (a.fee / SATOSHI);
+        if (f1 == f2) {
+            return a.tx->GetId() < b.tx->GetId();
+        }
+        return f1 > f2;
     }
 };
 } // namespace
@@ -5493,30 +5803,66 @@ bool PeerManager::SendMessages(const Config &config, CNode *pto,
 
             // Determine transactions to relay
             if (fSendTrickle) {
-                // Produce a vector with all candidates for sending
-                std::vector<std::set<TxId>::iterator> vInvTx;
-                vInvTx.reserve(pto->m_tx_relay->setInventoryTxToSend.size());
-                for (std::set<TxId>::iterator it =
-                         pto->m_tx_relay->setInventoryTxToSend.begin();
-                     it != pto->m_tx_relay->setInventoryTxToSend.end(); it++) {
-                    vInvTx.push_back(it);
-                }
                 CFeeRate filterrate;
                 {
                     LOCK(pto->m_tx_relay->cs_feeFilter);
                     filterrate = CFeeRate(pto->m_tx_relay->minFeeFilter);
                 }
+                // Produce a vector with all candidates for sending. The ones
+                // that would be skipped anyway are dropped now, so they don't
+                // need sorting: the ones the peer already knows about, the
+                // ones which are not in the mempool anymore, and the ones
+                // below the feerate the peer told us not to send. The mempool
+                // is only locked to look the transactions up.
+                std::vector<TxInvCandidate> vInvTx;
+                vInvTx.reserve(pto->m_tx_relay->setInventoryTxToSend.size());
+                {
+                    LOCK(m_mempool.cs);
+                    auto it = pto->m_tx_relay->setInventoryTxToSend.begin();
+                    while (it != pto->m_tx_relay->setInventoryTxToSend.end()) {
+                        if (pto->m_tx_relay->filterInventoryKnown.contains(
+                                *it)) {
+                            it = pto->m_tx_relay->setInventoryTxToSend.erase(
+                                it);
+                            continue;
+                        }
+                        auto entry = m_mempool.GetIter(*it);
+                        if (!entry) {
+                            it = pto->m_tx_relay->setInventoryTxToSend.erase(
+                                it);
+                            continue;
+                        }
+                        vInvTx.push_back({it, (*entry)->GetSharedTx(),
+                                          (*entry)->GetFee(),
+                                          (*entry)->GetTxSize(),
+                                          (*entry)->GetCountWithAncestors()});
+                        ++it;
+                    }
+                }
+                size_t nKept = 0;
+                for (TxInvCandidate &candidate : vInvTx) {
+                    if (candidate.fee < filterrate.GetFee(candidate.size)) {
+                        pto->m_tx_relay->setInventoryTxToSend.erase(
+                            candidate.it);
+                        continue;
+                    }
+                    vInvTx[nKept++] = std::move(candidate);
+                }
+                vInvTx.erase(vInvTx.begin() + nKept, vInvTx.end());
+                LOCK(pto->m_tx_relay->cs_filter);
                 // Topologically and fee-rate sort the inventory we send for
                 // privacy and priority reasons. A heap is used so that not
                 // all items need sorting if only a few are being sent.
-                CompareInvMempoolOrder compareInvMempoolOrder(&m_mempool);
+                CompareInvMempoolOrder compareInvMempoolOrder;
                 std::make_heap(vInvTx.begin(), vInvTx.end(),
                                compareInvMempoolOrder);
                 // No reason to drain out at many times the network's
                 // capacity, especially since we have many peers and some
                 // will draw much shorter delays.
                 unsigned int nRelayedTransactions = 0;
-                LOCK(pto->m_tx_relay->cs_filter);
+                const bool reconciling =
+                    m_txreconciliation &&
+                    m_txreconciliation->IsPeerRegistered(pto->GetId());
                 while (!vInvTx.empty() &&
                        nRelayedTransactions < INVENTORY_BROADCAST_MAX_PER_MB *
                                                   config.GetMaxBlockSize() /
@@ -5524,28 +5870,22 @@ bool PeerManager::SendMessages(const Config &config, CNode *pto,
                     // Fetch the top element from the heap
                     std::pop_heap(vInvTx.begin(), vInvTx.end(),
                                   compareInvMempoolOrder);
-                    std::set<TxId>::iterator it = vInvTx.back();
+                    const TxInvCandidate candidate = vInvTx.back();
                     vInvTx.pop_back();
-                    const TxId txid = *it;
+                    const TxId txid = *candidate.it;
                     // Remove it from the to-be-sent set
-                    pto->m_tx_relay->setInventoryTxToSend.erase(it);
-                    // Check if not in the filter already
-                    if (pto->m_tx_relay->filterInventoryKnown.contains(txid)) {
-                        continue;
-                    }
-                    // Not in the mempool anymore? don't bother sending it.
-                    auto txinfo = m_mempool.info(txid);
-                    if (!txinfo.tx) {
-                        continue;
-                    }
-                    // Peer told you to not send transactions at that
-                    // feerate? Don't bother sending it.
-                    if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
+                    pto->m_tx_relay->setInventoryTxToSend.erase(candidate.it);
+                    CTransactionRef tx = candidate.tx;
+                    if (pto->m_tx_relay->pfilter &&
+                        !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(*tx)) {
                         continue;
                     }
-                    if (pto->m_tx_relay->pfilter &&
-                        !pto->m_tx_relay->pfilter->IsRelevantAndUpdate(
-                            *txinfo.tx)) {
+                    // Leave the transactions out of the fanout to set
+                    // reconciliation, unless the set is full.
+                    if (reconciling &&
+                        !m_txreconciliation->ShouldFloodTo(txid,
+                                                           pto->GetId()) &&
+                        m_txreconciliation->AddToSet(pto->GetId(), txid)) {
                         continue;
                     }
                     // Send
@@ -5562,7 +5902,7 @@ bool PeerManager::SendMessages(const Config &config, CNode *pto,
                         }
 
                         auto ret = mapRelay.insert(
-                            std::make_pair(txid, std::move(txinfo.tx)));
+                            std::make_pair(txid, std::move(tx)));
                         if (ret.second) {
                             vRelayExpiration.push_back(std::make_pair(
                                 count_microseconds(current_time) +
@@ -5582,6 +5922,20 @@ bool PeerManager::SendMessages(const Config &config, CNode *pto,
         m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::INV, vInv));
     }
 
+    if (m_txreconciliation) {
+        std::vector<TxId> txs_to_announce;
+        if (m_txreconciliation->ExpireReconciliationRequest(
+                pto->GetId(), current_time, txs_to_announce)) {
+            AnnounceReconciledTxs(*pto, txs_to_announce);
+        }
+        if (auto request = m_txreconciliation->MaybeRequestReconciliation(
+                pto->GetId(), current_time)) {
+            m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::REQRECON,
+                                                     request->set_size,
+                                                     request->round));
+        }
+    }
+
     {
         LOCK(cs_main);
 
@@ -22,6 +22,7 @@
 #include <invrequest.h>
 #include <net.h>
 #include <sync.h>
+#include <txreconciliation.h>
 #include <validationinterface.h>
 
 extern RecursiveMutex cs_main;
@@ -224,6 +225,21 @@ private:
                          std::chrono::microseconds current_time, bool preferred)
         EXCLUSIVE_LOCKS_REQUIRED(cs_proofrequest);
 
+    /**
+     * Announce the transactions found through reconciliation to a peer, the
+     * ones no longer in the mempool or already known by the peer excepted.
+     */
+    void AnnounceReconciledTxs(CNode &peer, const std::vector<TxId> &txids)
+        LOCKS_EXCLUDED(::cs_main);
+
+    /**
+     * Remove the mempool transactions conflicting with tx and their
+     * descendants. They are returned parents first, so they can be added back
+     * if tx doesn't make it to the mempool.
+     */
+    std::vector<CTransactionRef> EvictConflicts(const CTransaction &tx)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     const CChainParams &m_chainparams;
     CConnman &m_connman;
     /**
@@ -234,6 +250,11 @@ private:
     ChainstateManager &m_chainman;
     CTxMemPool &m_mempool;
     InvRequestTracker<TxId> m_txrequest GUARDED_BY(::cs_main);
+    /**
+     * Transaction reconciliation state with the peers, nullptr if
+     * -txreconciliation is disabled.
+     */
+    std::unique_ptr<TxReconciliationTracker> m_txreconciliation;
 
     Mutex cs_proofrequest;
     InvRequestTracker<avalanche::ProofId>
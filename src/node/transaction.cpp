@@ -109,3 +109,49 @@ TransactionError BroadcastTransaction(NodeContext &node, const Config &config,
 
     return TransactionError::OK;
 }
+
+TransactionError BroadcastPackage(NodeContext &node, const Config &config,
+                                  const std::vector<CTransactionRef> &package,
+                                  TxValidationState &package_state,
+                                  std::vector<TxValidationState> &tx_states,
+                                  const CFeeRate &max_tx_fee_rate, bool relay,
+                                  bool wait_callback) {
+    assert(node.connman);
+    assert(node.mempool);
+    std::promise<void> promise;
+
+    { // cs_main scope
+        LOCK(cs_main);
+        if (!AcceptPackageToMemoryPool(config, *node.mempool, package,
+                                       package_state, tx_states,
+                                       false /* bypass_limits */,
+                                       max_tx_fee_rate) &&
+            !package_state.IsValid()) {
+            return TransactionError::MEMPOOL_REJECTED;
+        }
+
+        if (wait_callback) {
+            // See BroadcastTransaction.
+            CallFunctionInValidationInterfaceQueue(
+                [&promise] { promise.set_value(); });
+        }
+    } // cs_main
+
+    if (wait_callback) {
+        promise.get_future().wait();
+    }
+
+    if (relay) {
+        for (size_t i = 0; i < package.size(); i++) {
+            if (!tx_states[i].IsValid()) {
+                continue;
+            }
+
+            const TxId &txid = package[i]->GetId();
+            node.mempool->AddUnbroadcastTx(txid);
+            RelayTransaction(txid, *node.connman);
+        }
+    }
+
+    return TransactionError::OK;
+}
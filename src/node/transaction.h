@@ -23,6 +23,7 @@
 #include <util/error.h>
 
 class Config;
+class TxValidationState;
 struct NodeContext;
 struct TxId;
 
@@ -60,4 +61,30 @@ NODISCARD TransactionError BroadcastTransaction(
     NodeContext &node, const Config &config, CTransactionRef tx,
     std::string &err_string, Amount max_tx_fee, bool relay, bool wait_callback);
 
+/**
+ * Submit a package of transactions to the mempool and (optionally) relay the
+ * accepted transactions to all P2P peers.
+ *
+ * The package is accepted in a single pass, see AcceptPackageToMemoryPool.
+ * The same constraints as BroadcastTransaction apply to wait_callback.
+ *
+ * @param[in]  node reference to node context
+ * @param[in]  package the topologically sorted transactions to broadcast
+ * @param[out] package_state reason for which the whole package was rejected
+ * @param[out] tx_states validation state of each transaction of the package
+ * @param[in]  max_tx_fee_rate reject txs with a fee rate higher than this (if
+ * 0, accept any fee rate)
+ * @param[in]  relay flag if both mempool insertion and p2p relay are requested
+ * @param[in]  wait_callback wait until callbacks have been processed to avoid
+ * stale result due to a sequentially RPC.
+ * @return error
+ */
+NODISCARD TransactionError
+BroadcastPackage(NodeContext &node, const Config &config,
+                 const std::vector<CTransactionRef> &package,
+                 TxValidationState &package_state,
+                 std::vector<TxValidationState> &tx_states,
+                 const CFeeRate &max_tx_fee_rate, bool relay,
+                 bool wait_callback);
+
 #endif // BITCOIN_NODE_TRANSACTION_H
@@ -20,6 +20,7 @@
 #define BITCOIN_PRIMITIVES_TRANSACTION_H
 
 #include <amount.h>
+#include <crypto/sha256.h>
 #include <feerate.h>
 #include <primitives/txid.h>
 #include <script/script.h>
@@ -340,9 +341,18 @@ static inline CTransactionRef MakeTransactionRef(Tx &&txIn) {
 /** Precompute sighash midstate to avoid quadratic hashing */
 struct PrecomputedTransactionData {
     uint256 hashPrevouts, hashSequence, hashOutputs;
+    /**
+     * SHA256 midstate over the start of the signature hash preimage (nVersion,
+     * hashPrevouts and hashSequence) for sighash types which commit to all of
+     * the inputs, such as SIGHASH_ALL. It is shared by all the inputs, so it
+     * is only computed for transactions with more than one input.
+     */
+    CSHA256 sighashPrefix;
+    bool sighashPrefixReady;
 
     PrecomputedTransactionData()
-        : hashPrevouts(), hashSequence(), hashOutputs() {}
+        : hashPrevouts(), hashSequence(), hashOutputs(),
+          sighashPrefixReady(false) {}
 
     PrecomputedTransactionData(const PrecomputedTransactionData &txdata) =
         default;
@@ -67,6 +67,10 @@ const char *AVAHELLO = "avahello";
 const char *AVAPOLL = "avapoll";
 const char *AVARESPONSE = "avaresponse";
 const char *AVAPROOF = "avaproof";
+const char *SENDRECON = "sendrecon";
+const char *REQRECON = "reqrecon";
+const char *SKETCH = "sketch";
+const char *RECONCILDIFF = "reconcildiff";
 
 bool IsBlockLike(const std::string &strCommand) {
     return strCommand == NetMsgType::BLOCK ||
@@ -91,6 +95,8 @@ static const std::string allNetMessageTypes[] = {
     NetMsgType::CMPCTBLOCK,  NetMsgType::GETBLOCKTXN,  NetMsgType::BLOCKTXN,
     NetMsgType::GETCFILTERS, NetMsgType::CFILTER,      NetMsgType::GETCFHEADERS,
     NetMsgType::CFHEADERS,   NetMsgType::GETCFCHECKPT, NetMsgType::CFCHECKPT,
+    NetMsgType::SENDRECON,   NetMsgType::REQRECON,     NetMsgType::SKETCH,
+    NetMsgType::RECONCILDIFF,
 };
 static const std::vector<std::string>
     allNetMessageTypesVec(allNetMessageTypes,
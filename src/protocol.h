@@ -328,6 +328,30 @@ extern const char *AVARESPONSE;
  * MSG_AVA_PROOF.
  */
 extern const char *AVAPROOF;
+/**
+ * Contains a 4-byte version number and an 8-byte salt.
+ * Indicates that a node is willing to reconcile transactions instead of
+ * flooding them. Sent after "verack" to full relay peers.
+ */
+extern const char *SENDRECON;
+/**
+ * Contains the 2-byte size of the initiator's reconciliation set and a 4-byte
+ * round identifying the request.
+ * Peer should respond with "sketch" message.
+ */
+extern const char *REQRECON;
+/**
+ * Contains the round of the request and a sketch of the responder's
+ * reconciliation set.
+ * Sent in response to a "reqrecon" message.
+ */
+extern const char *SKETCH;
+/**
+ * Contains a success flag and the short ids of the transactions the
+ * initiator is missing. Sent in response to a "sketch" message, peer should
+ * respond with an "inv" for the requested transactions.
+ */
+extern const char *RECONCILDIFF;
 
 /**
  * Indicate if the message is used to transmit the content of a block.
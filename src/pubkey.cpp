@@ -351,6 +351,48 @@ bool CExtPubKey::Derive(CExtPubKey &out, unsigned int _nChild) const {
     return pubkey.Derive(out.pubkey, out.chaincode, _nChild, chaincode);
 }
 
+bool CExtPubKey::DeriveBatch(std::vector<CExtPubKey> &out,
+                             unsigned int nFirstChild, size_t count) const {
+    assert(pubkey.IsValid());
+    assert(count == 0 || ((nFirstChild + (count - 1)) >> 31) == 0);
+    assert(pubkey.size() == CPubKey::COMPRESSED_SIZE);
+    std::vector<uint8_t> vout(64 * count);
+    BIP32HashBatch(chaincode, nFirstChild, count, *pubkey.begin(),
+                   pubkey.begin() + 1, vout.data());
+    assert(secp256k1_context_verify &&
+           "secp256k1_context_verify must be initialized to use CPubKey.");
+    secp256k1_pubkey parent;
+    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &parent,
+                                   pubkey.begin(), pubkey.size())) {
+        return false;
+    }
+    const CKeyID id = pubkey.GetID();
+
+    bool ret = true;
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        CExtPubKey &child = out[i];
+        const uint8_t *hash = vout.data() + 64 * i;
+        child.nDepth = nDepth + 1;
+        memcpy(&child.vchFingerprint[0], &id, 4);
+        child.nChild = nFirstChild + i;
+        memcpy(child.chaincode.begin(), hash + 32, 32);
+        secp256k1_pubkey tweaked = parent;
+        if (!secp256k1_ec_pubkey_tweak_add(secp256k1_context_verify, &tweaked,
+                                           hash)) {
+            child.pubkey = CPubKey();
+            ret = false;
+            continue;
+        }
+        uint8_t pub[CPubKey::COMPRESSED_SIZE];
+        size_t publen = CPubKey::COMPRESSED_SIZE;
+        secp256k1_ec_pubkey_serialize(secp256k1_context_verify, pub, &publen,
+                                      &tweaked, SECP256K1_EC_COMPRESSED);
+        child.pubkey.Set(pub, pub + publen);
+    }
+    return ret;
+}
+
 bool CPubKey::CheckLowS(
     const boost::sliced_range<const std::vector<uint8_t>> &vchSig) {
     secp256k1_ecdsa_signature sig;
@@ -226,6 +226,14 @@ struct CExtPubKey {
     void Encode(uint8_t code[BIP32_EXTKEY_SIZE]) const;
     void Decode(const uint8_t code[BIP32_EXTKEY_SIZE]);
     bool Derive(CExtPubKey &out, unsigned int nChild) const;
+    /**
+     * Derive count consecutive non-hardened children starting at nFirstChild.
+     * This is equivalent to calling Derive for each of them, but only parses
+     * the parent public key once and hashes several children at a time.
+     * Returns false if any child is invalid.
+     */
+    bool DeriveBatch(std::vector<CExtPubKey> &out, unsigned int nFirstChild,
+                     size_t count) const;
 
     CExtPubKey() = default;
 };
@@ -104,6 +104,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"sendrawtransaction", 1, "maxfeerate"},
     {"testmempoolaccept", 0, "rawtxs"},
     {"testmempoolaccept", 1, "maxfeerate"},
+    {"submitpackage", 0, "rawtxs"},
+    {"submitpackage", 1, "maxfeerate"},
     {"combinerawtransaction", 0, "txs"},
     {"fundrawtransaction", 1, "options"},
     {"walletcreatefundedpsbt", 0, "inputs"},
@@ -1156,6 +1156,128 @@ static UniValue testmempoolaccept(const Config &config,
     return result;
 }
 
+static UniValue submitpackage(const Config &config,
+                              const JSONRPCRequest &request) {
+    RPCHelpMan{
+        "submitpackage",
+        "Submits a package of raw transactions (serialized, hex-encoded) to "
+        "local node and network.\n"
+        "\nThe package is validated in a single pass and must be "
+        "topologically sorted: each transaction can only spend the outputs of "
+        "the transactions that appear before it in the array.\n"
+        "\nSee sendrawtransaction call.\n",
+        {
+            {
+                "rawtxs",
+                RPCArg::Type::ARR,
+                RPCArg::Optional::NO,
+                "An array of hex strings of raw transactions.\n"
+                "                             Length must not exceed " +
+                    ToString(MAX_PACKAGE_COUNT) + ".",
+                {
+                    {"rawtx", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED,
+                     ""},
+                },
+            },
+            {"maxfeerate", RPCArg::Type::AMOUNT,
+             /* default */
+             FormatMoney(DEFAULT_MAX_RAW_TX_FEE_RATE.GetFeePerK()),
+             "Reject transactions whose fee rate is higher than the specified "
+             "value, expressed in " +
+                 Currency::get().ticker +
+                 "/kB\nSet to 0 to accept any fee rate.\n"},
+        },
+        RPCResult{RPCResult::Type::ARR,
+                  "",
+                  "The result of the mempool acceptance for each raw "
+                  "transaction in the input array.",
+                  {
+                      {RPCResult::Type::OBJ,
+                       "",
+                       "",
+                       {
+                           {RPCResult::Type::STR_HEX, "txid",
+                            "The transaction hash in hex"},
+                           {RPCResult::Type::BOOL, "allowed",
+                            "If the transaction is in the mempool"},
+                           {RPCResult::Type::STR, "reject-reason",
+                            "Rejection string (only present when 'allowed' is "
+                            "false)"},
+                       }},
+                  }},
+        RPCExamples{
+            "\nSend a parent and its child (signed hex)\n" +
+            HelpExampleCli("submitpackage",
+                           "[\"signedparenthex\",\"signedchildhex\"]") +
+            "\nAs a JSON-RPC call\n" +
+            HelpExampleRpc("submitpackage",
+                           "[\"signedparenthex\", \"signedchildhex\"]")},
+    }
+        .Check(request);
+
+    RPCTypeCheck(request.params,
+                 {
+                     UniValue::VARR,
+                     // VNUM or VSTR, checked inside AmountFromValue()
+                     UniValueType(),
+                 });
+
+    const UniValue &rawtxs = request.params[0].get_array();
+    if (rawtxs.size() == 0 || rawtxs.size() > MAX_PACKAGE_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER,
+                           strprintf("Array must contain between 1 and %u "
+                                     "raw transactions",
+                                     MAX_PACKAGE_COUNT));
+    }
+
+    Package package;
+    package.reserve(rawtxs.size());
+    for (size_t i = 0; i < rawtxs.size(); i++) {
+        CMutableTransaction mtx;
+        if (!DecodeHexTx(mtx, rawtxs[i].get_str())) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR,
+                               strprintf("TX decode failed for transaction %u",
+                                         i));
+        }
+        package.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+
+    const CFeeRate max_raw_tx_fee_rate =
+        request.params[1].isNull()
+            ? DEFAULT_MAX_RAW_TX_FEE_RATE
+            : CFeeRate(AmountFromValue(request.params[1]));
+
+    TxValidationState package_state;
+    std::vector<TxValidationState> tx_states;
+    AssertLockNotHeld(cs_main);
+    NodeContext &node = EnsureNodeContext(request.context);
+    const TransactionError err = BroadcastPackage(
+        node, config, package, package_state, tx_states, max_raw_tx_fee_rate,
+        /*relay*/ true, /*wait_callback*/ true);
+    if (err != TransactionError::OK) {
+        throw JSONRPCTransactionError(err, package_state.ToString());
+    }
+
+    UniValue result(UniValue::VARR);
+    for (size_t i = 0; i < package.size(); i++) {
+        const TxValidationState &state = tx_states[i];
+
+        UniValue result_tx(UniValue::VOBJ);
+        result_tx.pushKV("txid", package[i]->GetId().GetHex());
+        result_tx.pushKV("allowed", state.IsValid());
+        if (!state.IsValid()) {
+            if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS) {
+                result_tx.pushKV("reject-reason", "missing-inputs");
+            } else {
+                result_tx.pushKV("reject-reason", state.GetRejectReason());
+            }
+        }
+        result.push_back(std::move(result_tx));
+    }
+
+    return result;
+}
+
 static std::string WriteHDKeypath(std::vector<uint32_t> &keypath) {
     std::string keypath_str = "m";
     for (uint32_t num : keypath) {
@@ -2172,6 +2294,7 @@ void RegisterRawTransactionRPCCommands(CRPCTable &t) {
         { "rawtransactions",    "combinerawtransaction",     combinerawtransaction,     {"txs"} },
         { "rawtransactions",    "signrawtransactionwithkey", signrawtransactionwithkey, {"hexstring","privkeys","prevtxs","sighashtype"} },
         { "rawtransactions",    "testmempoolaccept",         testmempoolaccept,         {"rawtxs","maxfeerate"} },
+        { "rawtransactions",    "submitpackage",             submitpackage,             {"rawtxs","maxfeerate"} },
         { "rawtransactions",    "decodepsbt",                decodepsbt,                {"psbt"} },
         { "rawtransactions",    "combinepsbt",               combinepsbt,               {"txs"} },
         { "rawtransactions",    "finalizepsbt",               finalizepsbt,               {"psbt", "extract"} },
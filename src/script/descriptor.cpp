@@ -28,6 +28,7 @@
 #include <util/system.h>
 #include <util/vector.h>
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -234,6 +235,13 @@ public:
     /** Derive a private key, if private data is available in arg. */
     virtual bool GetPrivKey(int pos, const SigningProvider &arg,
                             CKey &key) const = 0;
+
+    /**
+     * Derive the extended public keys at count consecutive positions from
+     * the parent in the cache, and add them to the cache.
+     */
+    virtual void CacheDerivedExtPubKeys(int first_pos, int count,
+                                        DescriptorCache &cache) const {}
 };
 
 class OriginPubkeyProvider final : public PubkeyProvider {
@@ -281,6 +289,10 @@ public:
                     CKey &key) const override {
         return m_provider->GetPrivKey(pos, arg, key);
     }
+    void CacheDerivedExtPubKeys(int first_pos, int count,
+                                DescriptorCache &cache) const override {
+        m_provider->CacheDerivedExtPubKeys(first_pos, count, cache);
+    }
 };
 
 /** An object representing a parsed constant public key in a descriptor. */
@@ -421,6 +433,11 @@ public:
                 if (m_derive == DeriveType::UNHARDENED) {
                     der = parent_extkey.Derive(final_extkey, pos);
                 }
+            } else if (m_derive != DeriveType::HARDENED) {
+                // Unhardened keys are only cached along with their parent, by
+                // CacheDerivedExtPubKeys, keep it for m_cached_xpub below.
+                read_cache->GetCachedParentExtPubKey(m_expr_index,
+                                                     parent_extkey);
             }
         } else if (m_cached_xpub.pubkey.IsValid() &&
                    m_derive != DeriveType::HARDENED) {
@@ -476,6 +493,24 @@ public:
 
         return true;
     }
+    void CacheDerivedExtPubKeys(int first_pos, int count,
+                                DescriptorCache &cache) const override {
+        CExtPubKey parent;
+        if (m_derive != DeriveType::UNHARDENED || first_pos < 0 ||
+            count <= 0 || count > std::numeric_limits<int>::max() - first_pos ||
+            !cache.GetCachedParentExtPubKey(m_expr_index, parent)) {
+            return;
+        }
+        std::vector<CExtPubKey> children;
+        parent.DeriveBatch(children, first_pos, count);
+        for (int i = 0; i < count; ++i) {
+            // An invalid child is left for GetPubKey to derive, and fail.
+            if (children[i].pubkey.IsValid()) {
+                cache.CacheDerivedExtPubKey(m_expr_index, first_pos + i,
+                                            children[i]);
+            }
+        }
+    }
     std::string ToString() const override {
         std::string ret =
             EncodeExtPubKey(m_root_extkey) + FormatHDKeypath(m_path);
@@ -698,6 +733,17 @@ public:
                             output_scripts, out, nullptr);
     }
 
+    void CacheDerivedExtPubKeys(int first_pos, int count,
+                                DescriptorCache &cache) const final {
+        for (const auto &p : m_pubkey_args) {
+            p->CacheDerivedExtPubKeys(first_pos, count, cache);
+        }
+        if (m_subdescriptor_arg) {
+            m_subdescriptor_arg->CacheDerivedExtPubKeys(first_pos, count,
+                                                        cache);
+        }
+    }
+
     void ExpandPrivate(int pos, const SigningProvider &provider,
                        FlatSigningProvider &out) const final {
         for (const auto &p : m_pubkey_args) {
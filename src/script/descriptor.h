@@ -159,6 +159,18 @@ struct Descriptor {
                                  std::vector<CScript> &output_scripts,
                                  FlatSigningProvider &out) const = 0;
 
+    /**
+     * Derive the unhardened keys of a range of positions at once, so that
+     * ExpandFromCache does not derive them one position at a time.
+     *
+     * @param[in] first_pos The first position of the range.
+     * @param[in] count The number of positions in the range.
+     * @param[in,out] cache Cached expansion data. The keys are derived from
+     *                      the parent xpubs it contains, and added to it.
+     */
+    virtual void CacheDerivedExtPubKeys(int first_pos, int count,
+                                        DescriptorCache &cache) const = 0;
+
     /**
      * Expand the private key for a descriptor at a specified position, if
      * possible.
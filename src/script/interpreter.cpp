@@ -28,6 +28,8 @@
 #include <uint256.h>
 #include <util/bitmanip.h>
 
+#include <algorithm>
+
 bool CastToBool(const valtype &vch) {
     for (size_t i = 0; i < vch.size(); i++) {
         if (vch[i] != 0) {
@@ -47,13 +49,74 @@ bool CastToBool(const valtype &vch) {
  */
 #define stacktop(i) (stack.at(stack.size() + (i)))
 #define altstacktop(i) (altstack.at(altstack.size() + (i)))
+
+/**
+ * Buffers of stack elements that have been popped.
+ *
+ * Popped elements are recycled rather than freed, so that pushing onto the
+ * stack reuses the capacity of an earlier element instead of allocating. The
+ * pool is per thread and outlives a single evaluation, so a script check
+ * thread keeps reusing the same buffers from one input to the next.
+ */
+class StackElementPool {
+    std::vector<valtype> buffers;
+
+public:
+    valtype Take() {
+        if (buffers.empty()) {
+            return valtype();
+        }
+
+        valtype vch = std::move(buffers.back());
+        buffers.pop_back();
+        return vch;
+    }
+
+    void Release(valtype &&vch) {
+        // Bound the pool to what a single stack can hold.
+        if (vch.capacity() == 0 || vch.capacity() > MAX_SCRIPT_ELEMENT_SIZE ||
+            buffers.size() >= MAX_STACK_SIZE) {
+            return;
+        }
+
+        vch.clear();
+        buffers.push_back(std::move(vch));
+    }
+};
+
+static thread_local StackElementPool g_stack_element_pool;
+
 static inline void popstack(std::vector<valtype> &stack) {
     if (stack.empty()) {
         throw std::runtime_error("popstack(): stack empty");
     }
+    g_stack_element_pool.Release(std::move(stack.back()));
     stack.pop_back();
 }
 
+template <typename I>
+static inline valtype makestackelement(I first, I last) {
+    valtype vch = g_stack_element_pool.Take();
+    vch.assign(first, last);
+    return vch;
+}
+
+static inline valtype makestackelement(const valtype &vch) {
+    return makestackelement(vch.begin(), vch.end());
+}
+
+static inline void pushstack(std::vector<valtype> &stack, const valtype &vch) {
+    // The copy is made before pushing, so vch may be an element of the stack.
+    stack.push_back(makestackelement(vch));
+}
+
+static inline void pushstack(std::vector<valtype> &stack,
+                             const CScriptNum &bn) {
+    valtype vch = g_stack_element_pool.Take();
+    bn.getvch(vch);
+    stack.push_back(std::move(vch));
+}
+
 int FindAndDelete(CScript &script, const CScript &b) {
     int nFound = 0;
     if (b.empty()) {
@@ -263,7 +326,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                     !CheckMinimalPush(vchPushValue, opcode)) {
                     return set_error(serror, ScriptError::MINIMALDATA);
                 }
-                stack.push_back(vchPushValue);
+                pushstack(stack, vchPushValue);
             } else if (fExec || (OP_IF <= opcode && opcode <= OP_ENDIF)) {
                 switch (opcode) {
                     //
@@ -288,7 +351,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                     case OP_16: {
                         // ( -- value)
                         CScriptNum bn((int)opcode - (int)(OP_1 - 1));
-                        stack.push_back(bn.getvch());
+                        pushstack(stack, bn);
                         // The result of these opcodes should always be the
                         // minimal way to push the data they push, so no need
                         // for a CheckMinimalPush here.
@@ -476,7 +539,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        altstack.push_back(stacktop(-1));
+                        altstack.push_back(std::move(stacktop(-1)));
                         popstack(stack);
                     } break;
 
@@ -486,7 +549,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror,
                                 ScriptError::INVALID_ALTSTACK_OPERATION);
                         }
-                        stack.push_back(altstacktop(-1));
+                        stack.push_back(std::move(altstacktop(-1)));
                         popstack(altstack);
                     } break;
 
@@ -506,10 +569,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-2);
-                        valtype vch2 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        pushstack(stack, stacktop(-2));
+                        pushstack(stack, stacktop(-2));
                     } break;
 
                     case OP_3DUP: {
@@ -518,12 +579,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-3);
-                        valtype vch2 = stacktop(-2);
-                        valtype vch3 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
-                        stack.push_back(vch3);
+                        pushstack(stack, stacktop(-3));
+                        pushstack(stack, stacktop(-3));
+                        pushstack(stack, stacktop(-3));
                     } break;
 
                     case OP_2OVER: {
@@ -532,10 +590,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-4);
-                        valtype vch2 = stacktop(-3);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        pushstack(stack, stacktop(-4));
+                        pushstack(stack, stacktop(-4));
                     } break;
 
                     case OP_2ROT: {
@@ -544,11 +600,11 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-6);
-                        valtype vch2 = stacktop(-5);
+                        valtype vch1 = std::move(stacktop(-6));
+                        valtype vch2 = std::move(stacktop(-5));
                         stack.erase(stack.end() - 6, stack.end() - 4);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(std::move(vch1));
+                        stack.push_back(std::move(vch2));
                     } break;
 
                     case OP_2SWAP: {
@@ -567,16 +623,15 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        if (CastToBool(vch)) {
-                            stack.push_back(vch);
+                        if (CastToBool(stacktop(-1))) {
+                            pushstack(stack, stacktop(-1));
                         }
                     } break;
 
                     case OP_DEPTH: {
                         // -- stacksize
                         CScriptNum bn(stack.size());
-                        stack.push_back(bn.getvch());
+                        pushstack(stack, bn);
                     } break;
 
                     case OP_DROP: {
@@ -594,8 +649,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.push_back(vch);
+                        pushstack(stack, stacktop(-1));
                     } break;
 
                     case OP_NIP: {
@@ -613,8 +667,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-2);
-                        stack.push_back(vch);
+                        pushstack(stack, stacktop(-2));
                     } break;
 
                     case OP_PICK:
@@ -632,11 +685,13 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-n - 1);
                         if (opcode == OP_ROLL) {
+                            valtype vch = std::move(stacktop(-n - 1));
                             stack.erase(stack.end() - n - 1);
+                            stack.push_back(std::move(vch));
+                        } else {
+                            pushstack(stack, stacktop(-n - 1));
                         }
-                        stack.push_back(vch);
                     } break;
 
                     case OP_ROT: {
@@ -666,8 +721,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.insert(stack.end() - 2, vch);
+                        stack.insert(stack.end() - 2,
+                                     makestackelement(stacktop(-1)));
                     } break;
 
                     case OP_SIZE: {
@@ -677,7 +732,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         CScriptNum bn(stacktop(-1).size());
-                        stack.push_back(bn.getvch());
+                        pushstack(stack, bn);
                     } break;
 
                     //
@@ -747,7 +802,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             //    fEqual = !fEqual;
                             popstack(stack);
                             popstack(stack);
-                            stack.push_back(fEqual ? vchTrue : vchFalse);
+                            pushstack(stack, fEqual ? vchTrue : vchFalse);
                             if (opcode == OP_EQUALVERIFY) {
                                 if (fEqual) {
                                     popstack(stack);
@@ -800,7 +855,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 break;
                         }
                         popstack(stack);
-                        stack.push_back(bn.getvch());
+                        pushstack(stack, bn);
                     } break;
 
                     case OP_ADD:
@@ -892,7 +947,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         }
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(bn.getvch());
+                        pushstack(stack, bn);
 
                         if (opcode == OP_NUMEQUALVERIFY) {
                             if (CastToBool(stacktop(-1))) {
@@ -917,7 +972,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         popstack(stack);
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fValue ? vchTrue : vchFalse);
+                        pushstack(stack, fValue ? vchTrue : vchFalse);
                     } break;
 
                     //
@@ -934,30 +989,34 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype &vch = stacktop(-1);
-                        valtype vchHash((opcode == OP_RIPEMD160 ||
-                                         opcode == OP_SHA1 ||
-                                         opcode == OP_HASH160)
-                                            ? 20
-                                            : 32);
+                        uint8_t vchHash[CSHA256::OUTPUT_SIZE];
+                        const size_t hashSize = (opcode == OP_RIPEMD160 ||
+                                                 opcode == OP_SHA1 ||
+                                                 opcode == OP_HASH160)
+                                                    ? 20
+                                                    : 32;
                         if (opcode == OP_RIPEMD160) {
                             CRIPEMD160()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(vchHash);
                         } else if (opcode == OP_SHA1) {
                             CSHA1()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(vchHash);
                         } else if (opcode == OP_SHA256) {
                             CSHA256()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(vchHash);
                         } else if (opcode == OP_HASH160) {
-                            CHash160().Write(vch).Finalize(vchHash);
+                            CHash160().Write(vch).Finalize(
+                                Span<uint8_t>(vchHash, hashSize));
                         } else if (opcode == OP_HASH256) {
-                            CHash256().Write(vch).Finalize(vchHash);
+                            CHash256().Write(vch).Finalize(
+                                Span<uint8_t>(vchHash, hashSize));
                         }
                         popstack(stack);
-                        stack.push_back(vchHash);
+                        stack.push_back(
+                            makestackelement(vchHash, vchHash + hashSize));
                     } break;
 
                     case OP_CODESEPARATOR: {
@@ -983,7 +1042,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         }
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushstack(stack, fSuccess ? vchTrue : vchFalse);
                         if (opcode == OP_CHECKSIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1032,7 +1091,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                         popstack(stack);
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushstack(stack, fSuccess ? vchTrue : vchFalse);
                         if (opcode == OP_CHECKDATASIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1266,7 +1325,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             popstack(stack);
                         }
 
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushstack(stack, fSuccess ? vchTrue : vchFalse);
                         if (opcode == OP_CHECKMULTISIGVERIFY) {
                             if (fSuccess) {
                                 popstack(stack);
@@ -1303,7 +1362,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
 
-                        const valtype &data = stacktop(-2);
+                        valtype &data = stacktop(-2);
 
                         // Make sure the split point is appropriate.
                         uint64_t position =
@@ -1313,14 +1372,15 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                              ScriptError::INVALID_SPLIT_RANGE);
                         }
 
-                        // Prepare the results in their own buffer as `data`
-                        // will be invalidated.
-                        valtype n1(data.begin(), data.begin() + position);
-                        valtype n2(data.begin() + position, data.end());
+                        // Move the tail to its own buffer and truncate the
+                        // data in place to get the head.
+                        valtype n2 = makestackelement(data.begin() + position,
+                                                      data.end());
+                        data.erase(data.begin() + position, data.end());
 
-                        // Replace existing stack values by the new values.
-                        stacktop(-2) = std::move(n1);
-                        stacktop(-1) = std::move(n2);
+                        // Replace the position by the tail.
+                        popstack(stack);
+                        stack.push_back(std::move(n2));
                     } break;
 
                     case OP_REVERSEBYTES: {
@@ -1535,6 +1595,42 @@ public:
     }
 };
 
+/**
+ * Writer for signature hash preimages, which can resume from a midstate. The
+ * result is the double SHA256 of everything written, as with CHashWriter.
+ */
+class SigHashWriter {
+private:
+    CSHA256 ctx;
+
+public:
+    SigHashWriter() {}
+    explicit SigHashWriter(const CSHA256 &midstate) : ctx(midstate) {}
+
+    int GetType() const { return SER_GETHASH; }
+    int GetVersion() const { return 0; }
+
+    void write(const char *pch, size_t size) {
+        ctx.Write((const uint8_t *)pch, size);
+    }
+
+    template <typename T> SigHashWriter &operator<<(const T &obj) {
+        ::Serialize(*this, obj);
+        return *this;
+    }
+
+    const CSHA256 &GetMidstate() const { return ctx; }
+
+    // invalidates the object
+    uint256 GetHash() {
+        uint256 result;
+        ctx.Finalize(result.begin());
+        ctx.Reset().Write(result.begin(), CSHA256::OUTPUT_SIZE);
+        ctx.Finalize(result.begin());
+        return result;
+    }
+};
+
 template <class T> uint256 GetPrevoutHash(const T &txTo) {
     CHashWriter ss(SER_GETHASH, 0);
     for (const auto &txin : txTo.vin) {
@@ -1566,6 +1662,15 @@ PrecomputedTransactionData::PrecomputedTransactionData(const T &txTo) {
     hashPrevouts = GetPrevoutHash(txTo);
     hashSequence = GetSequenceHash(txTo);
     hashOutputs = GetOutputsHash(txTo);
+    // The midstate only saves work when it is shared by several inputs.
+    if (txTo.vin.size() > 1) {
+        SigHashWriter ss;
+        ss << txTo.nVersion << hashPrevouts << hashSequence;
+        sighashPrefix = ss.GetMidstate();
+        sighashPrefixReady = true;
+    } else {
+        sighashPrefixReady = false;
+    }
 }
 
 // explicit instantiation
@@ -1590,36 +1695,48 @@ uint256 SignatureHash(const CScript &scriptCode, const T &txTo,
     }
 
     if (sigHashType.hasForkId() && (flags & SCRIPT_ENABLE_SIGHASH_FORKID)) {
-        uint256 hashPrevouts;
-        uint256 hashSequence;
-        uint256 hashOutputs;
+        const bool commitsToAllInputs =
+            !sigHashType.hasAnyoneCanPay() &&
+            (sigHashType.getBaseType() != BaseSigHashType::SINGLE) &&
+            (sigHashType.getBaseType() != BaseSigHashType::NONE);
 
-        if (!sigHashType.hasAnyoneCanPay()) {
-            hashPrevouts = cache ? cache->hashPrevouts : GetPrevoutHash(txTo);
-        }
+        SigHashWriter ss;
+        if (commitsToAllInputs && cache && cache->sighashPrefixReady) {
+            // Version and input prevouts/nSequence are already hashed.
+            ss = SigHashWriter(cache->sighashPrefix);
+        } else {
+            uint256 hashPrevouts;
+            uint256 hashSequence;
 
-        if (!sigHashType.hasAnyoneCanPay() &&
-            (sigHashType.getBaseType() != BaseSigHashType::SINGLE) &&
-            (sigHashType.getBaseType() != BaseSigHashType::NONE)) {
-            hashSequence = cache ? cache->hashSequence : GetSequenceHash(txTo);
+            if (!sigHashType.hasAnyoneCanPay()) {
+                hashPrevouts =
+                    cache ? cache->hashPrevouts : GetPrevoutHash(txTo);
+            }
+
+            if (commitsToAllInputs) {
+                hashSequence =
+                    cache ? cache->hashSequence : GetSequenceHash(txTo);
+            }
+
+            // Version
+            ss << txTo.nVersion;
+            // Input prevouts/nSequence (none/all, depending on flags)
+            ss << hashPrevouts;
+            ss << hashSequence;
         }
 
+        uint256 hashOutputs;
+
         if ((sigHashType.getBaseType() != BaseSigHashType::SINGLE) &&
             (sigHashType.getBaseType() != BaseSigHashType::NONE)) {
             hashOutputs = cache ? cache->hashOutputs : GetOutputsHash(txTo);
         } else if ((sigHashType.getBaseType() == BaseSigHashType::SINGLE) &&
                    (nIn < txTo.vout.size())) {
-            CHashWriter ss(SER_GETHASH, 0);
-            ss << txTo.vout[nIn];
-            hashOutputs = ss.GetHash();
+            CHashWriter ssOutput(SER_GETHASH, 0);
+            ssOutput << txTo.vout[nIn];
+            hashOutputs = ssOutput.GetHash();
         }
 
-        CHashWriter ss(SER_GETHASH, 0);
-        // Version
-        ss << txTo.nVersion;
-        // Input prevouts/nSequence (none/all, depending on flags)
-        ss << hashPrevouts;
-        ss << hashSequence;
         // The input being signed (replacing the scriptSig with scriptCode +
         // amount). The prevout may already be contained in hashPrevout, and the
         // nSequence may already be contain in hashSequence.
@@ -1682,8 +1799,7 @@ bool GenericTransactionSignatureChecker<T>::CheckSig(
     SigHashType sigHashType = GetHashType(vchSig);
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, sigHashType, amount,
-                                    this->txdata, flags);
+    uint256 sighash = GetSignatureHash(scriptCode, sigHashType, flags);
 
     if (!VerifySignature(vchSig, pubkey, sighash)) {
         return false;
@@ -1692,6 +1808,13 @@ bool GenericTransactionSignatureChecker<T>::CheckSig(
     return true;
 }
 
+template <class T>
+uint256 GenericTransactionSignatureChecker<T>::GetSignatureHash(
+    const CScript &scriptCode, SigHashType sigHashType, uint32_t flags) const {
+    return SignatureHash(scriptCode, *txTo, nIn, sigHashType, amount,
+                         this->txdata, flags);
+}
+
 template <class T>
 bool GenericTransactionSignatureChecker<T>::CheckLockTime(
     const CScriptNum &nLockTime) const {
@@ -1786,6 +1909,85 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
+/**
+ * Verify a spend of a pay-to-pubkey-hash output without running the generic
+ * interpreter.
+ *
+ * This only handles the exact template, that is a scriptPubKey of the form
+ * OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG and a scriptSig made
+ * of two direct pushes of at least 2 bytes each, so neither push can ever be
+ * non-minimal. Anything else returns false and must go through EvalScript.
+ *
+ * When true is returned, the result and error are the ones the generic path
+ * would have produced and fSuccess holds the script verification result.
+ * Flags must already have been adjusted by the caller.
+ */
+static bool VerifyPayToPubKeyHash(const CScript &scriptSig,
+                                  const CScript &scriptPubKey, uint32_t flags,
+                                  const BaseSignatureChecker &checker,
+                                  ScriptExecutionMetrics &metricsOut,
+                                  ScriptError *serror, bool &fSuccess) {
+    if (scriptPubKey.size() != 25 || scriptPubKey[0] != OP_DUP ||
+        scriptPubKey[1] != OP_HASH160 || scriptPubKey[2] != 20 ||
+        scriptPubKey[23] != OP_EQUALVERIFY || scriptPubKey[24] != OP_CHECKSIG) {
+        return false;
+    }
+
+    // This combination of flags is rejected by an assertion in the generic
+    // path, leave it there.
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) && !(flags & SCRIPT_VERIFY_P2SH)) {
+        return false;
+    }
+
+    const size_t sigSize = scriptSig.size() > 0 ? scriptSig[0] : 0;
+    if (sigSize < 2 || sigSize >= OP_PUSHDATA1 ||
+        scriptSig.size() < sigSize + 2) {
+        return false;
+    }
+
+    const size_t pubKeySize = scriptSig[sigSize + 1];
+    if (pubKeySize < 2 || pubKeySize >= OP_PUSHDATA1 ||
+        scriptSig.size() != sigSize + pubKeySize + 2) {
+        return false;
+    }
+
+    const valtype vchSig(scriptSig.begin() + 1,
+                         scriptSig.begin() + 1 + sigSize);
+    const valtype vchPubKey(scriptSig.begin() + sigSize + 2, scriptSig.end());
+
+    // OP_DUP OP_HASH160 <hash> OP_EQUALVERIFY
+    uint8_t pubKeyHash[CHash160::OUTPUT_SIZE];
+    CHash160().Write(vchPubKey).Finalize(pubKeyHash);
+    if (!std::equal(std::begin(pubKeyHash), std::end(pubKeyHash),
+                    scriptPubKey.begin() + 3)) {
+        fSuccess = set_error(serror, ScriptError::EQUALVERIFY);
+        return true;
+    }
+
+    // OP_CHECKSIG, the scriptCode is the whole scriptPubKey.
+    ScriptExecutionMetrics metrics = {};
+    bool fCheckSigSuccess = false;
+    if (!EvalChecksig(vchSig, vchPubKey, scriptPubKey.begin(),
+                      scriptPubKey.end(), flags, checker, metrics, serror,
+                      fCheckSigSuccess)) {
+        // serror is set
+        fSuccess = false;
+        return true;
+    }
+
+    if (!fCheckSigSuccess) {
+        fSuccess = set_error(serror, ScriptError::EVAL_FALSE);
+        return true;
+    }
+
+    // The stack now holds a single true element, so CLEANSTACK is satisfied
+    // and a single SigCheck is always within the INPUT_SIGCHECKS density
+    // limit.
+    metricsOut = metrics;
+    fSuccess = set_success(serror);
+    return true;
+}
+
 bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
                   uint32_t flags, const BaseSignatureChecker &checker,
                   ScriptExecutionMetrics &metricsOut, ScriptError *serror) {
@@ -1800,6 +2002,13 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
         return set_error(serror, ScriptError::SIG_PUSHONLY);
     }
 
+    // Most inputs spend pay-to-pubkey-hash outputs, handle them directly.
+    bool fSuccess;
+    if (VerifyPayToPubKeyHash(scriptSig, scriptPubKey, flags, checker,
+                              metricsOut, serror, fSuccess)) {
+        return fSuccess;
+    }
+
     ScriptExecutionMetrics metrics = {};
 
     // scriptSig and scriptPubKey must be evaluated sequentially on the same
@@ -1809,7 +2018,10 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
         // serror is set
         return false;
     }
-    if (flags & SCRIPT_VERIFY_P2SH) {
+    // The copy is only needed to evaluate the redeem script.
+    const bool fP2SH =
+        (flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash();
+    if (fP2SH) {
         stackCopy = stack;
     }
     if (!EvalScript(stack, scriptPubKey, flags, checker, metrics, serror)) {
@@ -1824,7 +2036,7 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
     }
 
     // Additional validation for spend-to-script-hash transactions:
-    if ((flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash()) {
+    if (fP2SH) {
         // scriptSig must be literals-only or validation fails
         if (!scriptSig.IsPushOnly()) {
             return set_error(serror, ScriptError::SIG_PUSHONLY);
@@ -87,6 +87,12 @@ public:
                   uint32_t flags) const final override;
     bool CheckLockTime(const CScriptNum &nLockTime) const final override;
     bool CheckSequence(const CScriptNum &nSequence) const final override;
+
+protected:
+    /** Compute the signature hash of this input. */
+    virtual uint256 GetSignatureHash(const CScript &scriptCode,
+                                     SigHashType sigHashType,
+                                     uint32_t flags) const;
 };
 
 using TransactionSignatureChecker =
@@ -371,12 +371,21 @@ public:
 
     std::vector<uint8_t> getvch() const { return serialize(m_value); }
 
+    /** Serialize into an existing buffer, reusing its capacity. */
+    void getvch(std::vector<uint8_t> &vch) const { serialize(m_value, vch); }
+
     static std::vector<uint8_t> serialize(const int64_t &value) {
+        std::vector<uint8_t> result;
+        serialize(value, result);
+        return result;
+    }
+
+    static void serialize(const int64_t &value, std::vector<uint8_t> &result) {
+        result.clear();
         if (value == 0) {
-            return {};
+            return;
         }
 
-        std::vector<uint8_t> result;
         const bool neg = value < 0;
         uint64_t absvalue = neg ? ~static_cast<uint64_t>(value) + 1
                                 : static_cast<uint64_t>(value);
@@ -399,8 +408,6 @@ public:
         } else if (neg) {
             result.back() |= 0x80;
         }
-
-        return result;
     }
 
 private:
@@ -16,13 +16,17 @@
 
 #include <script/scriptcache.h>
 
+#include <clientversion.h>
 #include <crypto/sha256.h>
 #include <cuckoocache.h>
+#include <fs.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <script/sigcache.h>
+#include <streams.h>
 #include <sync.h>
 #include <util/system.h>
+#include <util/time.h>
 #include <validation.h>
 
 /**
@@ -84,15 +88,23 @@ public:
 static CuckooCache::cache<ScriptCacheElement, ScriptCacheHasher>
     g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
+static uint256 g_scriptExecutionCacheNonce;
 
-void InitScriptExecutionCache() {
-    // Setup the salted hasher
-    uint256 nonce = GetRandHash();
+static const uint64_t SCRIPT_CACHE_DUMP_VERSION = 1;
+
+static void SetScriptExecutionCacheNonce(const uint256 &nonce) {
+    g_scriptExecutionCacheNonce = nonce;
     // We want the nonce to be 64 bytes long to force the hasher to process
     // this chunk, which makes later hash computations more efficient. We
     // just write our 32-byte entropy twice to fill the 64 bytes.
+    g_scriptExecutionCacheHasher = CSHA256();
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
     g_scriptExecutionCacheHasher.Write(nonce.begin(), 32);
+}
+
+void InitScriptExecutionCache() {
+    // Setup the salted hasher
+    SetScriptExecutionCacheNonce(GetRandHash());
     // nMaxCacheSize is unsigned. If -maxscriptcachesize is set to zero,
     // setup_bytes creates the minimum possible cache (2 elements).
     size_t nMaxCacheSize =
@@ -137,3 +149,94 @@ void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks) {
     ScriptCacheElement elem(key, nSigChecks);
     g_scriptExecutionCache.insert(elem);
 }
+
+bool DumpScriptExecutionCache() {
+    AssertLockHeld(cs_main);
+
+    int64_t start = GetTimeMillis();
+
+    std::vector<ScriptCacheElement> elements;
+    g_scriptExecutionCache.for_each(
+        [&](const ScriptCacheElement &elem) { elements.push_back(elem); });
+
+    try {
+        FILE *filestr =
+            fsbridge::fopen(GetDataDir() / "scriptcache.dat.new", "wb");
+        if (!filestr) {
+            return false;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+        file << SCRIPT_CACHE_DUMP_VERSION;
+        file << g_scriptExecutionCacheNonce;
+
+        file << uint64_t(elements.size());
+        for (const ScriptCacheElement &elem : elements) {
+            file << elem.key;
+            file << int32_t(elem.nSigChecks);
+        }
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        RenameOver(GetDataDir() / "scriptcache.dat.new",
+                   GetDataDir() / "scriptcache.dat");
+        LogPrintf("Dumped %u script execution cache entries in %dms\n",
+                  elements.size(), GetTimeMillis() - start);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to dump script execution cache: %s. Continuing "
+                  "anyway.\n",
+                  e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadScriptExecutionCache() {
+    AssertLockHeld(cs_main);
+
+    FILE *filestr = fsbridge::fopen(GetDataDir() / "scriptcache.dat", "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        LogPrintf("Failed to open script execution cache file from disk. "
+                  "Continuing anyway.\n");
+        return false;
+    }
+
+    uint64_t count = 0;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != SCRIPT_CACHE_DUMP_VERSION) {
+            return false;
+        }
+
+        uint256 nonce;
+        file >> nonce;
+
+        uint64_t num;
+        file >> num;
+
+        // The keys are only meaningful under the nonce they were salted with.
+        // Entries computed under the fresh nonce are dropped, but the cache is
+        // expected to be empty at this point anyway.
+        SetScriptExecutionCacheNonce(nonce);
+        for (; count < num; ++count) {
+            ScriptCacheKey key;
+            int32_t nSigChecks;
+            file >> key;
+            file >> nSigChecks;
+            g_scriptExecutionCache.insert(ScriptCacheElement(key, nSigChecks));
+        }
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to deserialize script execution cache data on disk: "
+                  "%s. Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+
+    LogPrintf("Imported %u script execution cache entries\n", count);
+    return true;
+}
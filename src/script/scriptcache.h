@@ -17,6 +17,8 @@
 #ifndef BITCOIN_SCRIPT_SCRIPTCACHE_H
 #define BITCOIN_SCRIPT_SCRIPTCACHE_H
 
+#include <serialize.h>
+
 #include <array>
 #include <cstdint>
 
@@ -43,6 +45,8 @@ public:
         return rhs.data == data;
     }
 
+    SERIALIZE_METHODS(ScriptCacheKey, obj) { READWRITE(obj.data); }
+
     friend class ScriptCacheHasher;
 };
 
@@ -67,4 +71,17 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut);
  */
 void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks);
 
+/**
+ * Dump the script-execution cache, along with the nonce its keys are salted
+ * with, to scriptcache.dat in the data directory.
+ */
+bool DumpScriptExecutionCache();
+
+/**
+ * Load the script-execution cache from scriptcache.dat. The nonce is taken
+ * over from the file so the loaded keys remain valid; this must be called
+ * right after InitScriptExecutionCache(), before the cache is used.
+ */
+bool LoadScriptExecutionCache();
+
 #endif // BITCOIN_SCRIPT_SCRIPTCACHE_H
@@ -17,11 +17,15 @@
 
 #include <script/sigcache.h>
 
+#include <clientversion.h>
 #include <cuckoocache.h>
+#include <fs.h>
 #include <pubkey.h>
 #include <random.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/system.h>
+#include <util/time.h>
 
 #include <boost/thread/shared_mutex.hpp>
 
@@ -36,6 +40,7 @@ class CSignatureCache {
 private:
     //! Entries are SHA256(nonce || signature hash || public key || signature):
     CSHA256 m_salted_hasher;
+    uint256 m_nonce;
     typedef CuckooCache::cache<CuckooCache::KeyOnly<uint256>,
                                SignatureCacheHasher>
         map_type;
@@ -43,11 +48,21 @@ private:
     boost::shared_mutex cs_sigcache;
 
 public:
-    CSignatureCache() {
-        uint256 nonce = GetRandHash();
+    CSignatureCache() { SetNonce(GetRandHash()); }
+
+    const uint256 &GetNonce() const { return m_nonce; }
+
+    /**
+     * Replace the nonce. Entries computed with the previous nonce can no
+     * longer be found, so this is only meant to be called on startup, when
+     * restoring a saved cache.
+     */
+    void SetNonce(const uint256 &nonce) {
+        m_nonce = nonce;
         // We want the nonce to be 64 bytes long to force the hasher to process
         // this chunk, which makes later hash computations more efficient. We
         // just write our 32-byte entropy twice to fill the 64 bytes.
+        m_salted_hasher = CSHA256();
         m_salted_hasher.Write(nonce.begin(), 32);
         m_salted_hasher.Write(nonce.begin(), 32);
     }
@@ -71,6 +86,12 @@ public:
         boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
         setValid.insert(entry);
     }
+
+    template <typename Fn> void ForEach(Fn fn) {
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        setValid.for_each(fn);
+    }
+
     uint32_t setup_bytes(size_t n) { return setValid.setup_bytes(n); }
 };
 
@@ -82,6 +103,7 @@ public:
  * signatureCache could be made local to VerifySignature.
  */
 static CSignatureCache signatureCache;
+static CSignatureCache schnorrSignatureCache;
 } // namespace
 
 // To be called once in AppInitMain/BasicTestingSetup to initialize the
@@ -98,6 +120,85 @@ void InitSignatureCache() {
     LogPrintf("Using %zu MiB out of %zu requested for signature cache, able to "
               "store %zu elements\n",
               (nElems * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nElems);
+
+    schnorrSignatureCache.setup_bytes(size_t(SCHNORR_SIG_CACHE_SIZE) << 20);
+}
+
+static const uint64_t SIGCACHE_DUMP_VERSION = 1;
+
+bool DumpSignatureCache() {
+    int64_t start = GetTimeMillis();
+
+    std::vector<uint256> entries;
+    signatureCache.ForEach(
+        [&](const uint256 &entry) { entries.push_back(entry); });
+
+    try {
+        FILE *filestr =
+            fsbridge::fopen(GetDataDir() / "sigcache.dat.new", "wb");
+        if (!filestr) {
+            return false;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+        file << SIGCACHE_DUMP_VERSION;
+        file << signatureCache.GetNonce();
+        file << entries;
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        RenameOver(GetDataDir() / "sigcache.dat.new",
+                   GetDataDir() / "sigcache.dat");
+        LogPrintf("Dumped %u signature cache entries in %dms\n",
+                  entries.size(), GetTimeMillis() - start);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to dump signature cache: %s. Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadSignatureCache() {
+    FILE *filestr = fsbridge::fopen(GetDataDir() / "sigcache.dat", "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        LogPrintf("Failed to open signature cache file from disk. Continuing "
+                  "anyway.\n");
+        return false;
+    }
+
+    std::vector<uint256> entries;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != SIGCACHE_DUMP_VERSION) {
+            return false;
+        }
+
+        uint256 nonce;
+        file >> nonce;
+        file >> entries;
+
+        // The entries are only meaningful under the nonce they were salted
+        // with, so take it over before inserting them.
+        signatureCache.SetNonce(nonce);
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to deserialize signature cache data on disk: %s. "
+                  "Continuing anyway.\n",
+                  e.what());
+        return false;
+    }
+
+    for (uint256 &entry : entries) {
+        signatureCache.Set(entry);
+    }
+
+    LogPrintf("Imported %u signature cache entries\n", entries.size());
+    return true;
 }
 
 template <typename F>
@@ -117,6 +218,22 @@ bool RunMemoizedCheck(const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
     return true;
 }
 
+bool IsSchnorrSignatureCached(const CPubKey &pubkey, const uint256 &hash,
+                              const SchnorrSig &sig) {
+    uint256 entry;
+    schnorrSignatureCache.ComputeEntry(
+        entry, hash, std::vector<uint8_t>(sig.begin(), sig.end()), pubkey);
+    return schnorrSignatureCache.Get(entry, false);
+}
+
+void AddSchnorrSignatureToCache(const CPubKey &pubkey, const uint256 &hash,
+                                const SchnorrSig &sig) {
+    uint256 entry;
+    schnorrSignatureCache.ComputeEntry(
+        entry, hash, std::vector<uint8_t>(sig.begin(), sig.end()), pubkey);
+    schnorrSignatureCache.Set(entry);
+}
+
 bool CachingTransactionSignatureChecker::IsCached(
     const std::vector<uint8_t> &vchSig, const CPubKey &pubkey,
     const uint256 &sighash) const {
@@ -132,3 +249,39 @@ bool CachingTransactionSignatureChecker::VerifySignature(
                                                             sighash);
     });
 }
+
+bool SignatureHashCache::Get(const CScript &scriptCode,
+                             SigHashType sigHashType, uint32_t flags,
+                             uint256 &sighash) const {
+    for (const Entry &entry : entries) {
+        if (entry.sigHashType == sigHashType && entry.flags == flags &&
+            entry.scriptCode == scriptCode) {
+            sighash = entry.sighash;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SignatureHashCache::Set(const CScript &scriptCode,
+                             SigHashType sigHashType, uint32_t flags,
+                             const uint256 &sighash) {
+    if (entries.size() < MAX_ENTRIES) {
+        entries.push_back({scriptCode, sigHashType, flags, sighash});
+    }
+}
+
+uint256 CachingTransactionSignatureChecker::GetSignatureHash(
+    const CScript &scriptCode, SigHashType sigHashType, uint32_t flags) const {
+    // Only these flags affect the signature hash.
+    const uint32_t sighashFlags =
+        flags &
+        (SCRIPT_ENABLE_SIGHASH_FORKID | SCRIPT_ENABLE_REPLAY_PROTECTION);
+    uint256 sighash;
+    if (!sighashCache.Get(scriptCode, sigHashType, sighashFlags, sighash)) {
+        sighash = TransactionSignatureChecker::GetSignatureHash(
+            scriptCode, sigHashType, flags);
+        sighashCache.Set(scriptCode, sigHashType, sighashFlags, sighash);
+    }
+    return sighash;
+}
@@ -18,6 +18,7 @@
 #ifndef BITCOIN_SCRIPT_SIGCACHE_H
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
+#include <key.h> // For SchnorrSig
 #include <script/interpreter.h>
 
 #include <vector>
@@ -28,6 +29,11 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Default for -persistsigcache
+static const bool DEFAULT_PERSIST_SIGCACHE = true;
+// Size of the cache for the Schnorr signatures which are not part of a script,
+// in MiB
+static const unsigned int SCHNORR_SIG_CACHE_SIZE = 4;
 
 class CPubKey;
 
@@ -51,9 +57,36 @@ public:
     }
 };
 
+/**
+ * Signature hashes already computed for one input. A script which checks
+ * several signatures with the same scriptCode and sighash type, such as a
+ * multisig, then only hashes the transaction once.
+ */
+class SignatureHashCache {
+private:
+    struct Entry {
+        CScript scriptCode;
+        SigHashType sigHashType;
+        uint32_t flags;
+        uint256 sighash;
+    };
+
+    //! Inputs only hash a few distinct combinations, so a short list is
+    //! cheaper than a map. It is bounded because the scriptCodes are copied.
+    static constexpr size_t MAX_ENTRIES = 4;
+    std::vector<Entry> entries;
+
+public:
+    bool Get(const CScript &scriptCode, SigHashType sigHashType,
+             uint32_t flags, uint256 &sighash) const;
+    void Set(const CScript &scriptCode, SigHashType sigHashType,
+             uint32_t flags, const uint256 &sighash);
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker {
 private:
     bool store;
+    mutable SignatureHashCache sighashCache;
 
     bool IsCached(const std::vector<uint8_t> &vchSig, const CPubKey &vchPubKey,
                   const uint256 &sighash) const;
@@ -70,9 +103,38 @@ public:
                          const CPubKey &vchPubKey,
                          const uint256 &sighash) const override;
 
+protected:
+    uint256 GetSignatureHash(const CScript &scriptCode,
+                             SigHashType sigHashType,
+                             uint32_t flags) const override;
+
     friend class TestCachingTransactionSignatureChecker;
 };
 
 void InitSignatureCache();
 
+/**
+ * Dump the signature cache, along with the nonce its entries are salted with,
+ * to sigcache.dat in the data directory.
+ */
+bool DumpSignatureCache();
+
+/**
+ * Load the signature cache from sigcache.dat. The nonce is taken over from the
+ * file so the loaded entries remain valid; this must be called right after
+ * InitSignatureCache(), before the cache is used.
+ */
+bool LoadSignatureCache();
+
+/**
+ * The Schnorr signatures which are not part of a script, such as the avalanche
+ * stake signatures, have their own cache so they don't evict the script
+ * signatures. Verifying a signature doesn't add it: the caller does once what
+ * it signs is known to be valid.
+ */
+bool IsSchnorrSignatureCached(const CPubKey &pubkey, const uint256 &hash,
+                              const SchnorrSig &sig);
+void AddSchnorrSignatureToCache(const CPubKey &pubkey, const uint256 &hash,
+                                const SchnorrSig &sig);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -30,20 +30,61 @@
 
 #define BITCOIN_SEED_NONCE 0x0539a019ca550825ULL
 
-void CSeederNode::Send() {
+bool CSeederNode::Send() {
     if (sock == INVALID_SOCKET) {
-        return;
+        return false;
     }
     if (vSend.empty()) {
-        return;
+        return true;
     }
     int nBytes = send(sock, &vSend[0], vSend.size(), 0);
     if (nBytes > 0) {
         vSend.erase(vSend.begin(), vSend.begin() + nBytes);
-    } else {
-        close(sock);
-        sock = INVALID_SOCKET;
+        return true;
+    }
+
+    // The socket is nonblocking, so the send buffer can be full.
+    int nErr = WSAGetLastError();
+    if (nBytes < 0 && (nErr == WSAEWOULDBLOCK || nErr == WSAEINTR)) {
+        return true;
     }
+
+    CloseSocket(sock);
+    return false;
+}
+
+void CSeederNode::PushVersion() {
+    uint64_t nLocalServices = 0;
+    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
+    CService myService;
+    CAddress me(myService, ServiceFlags(NODE_NETWORK));
+    std::string ver = "/bitcoin-cash-seeder:0.15/";
+    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
+                                nLocalServices, GetTime(), you, me, nLocalNonce,
+                                ver, GetRequireHeight());
+}
+
+bool CSeederNode::Receive() {
+    char pchBuf[0x10000];
+    int nBytes = recv(sock, pchBuf, sizeof(pchBuf), 0);
+    if (nBytes > 0) {
+        int nPos = vRecv.size();
+        vRecv.resize(nPos + nBytes);
+        memcpy(&vRecv[nPos], pchBuf, nBytes);
+        lastReceive = GetTime();
+        return true;
+    }
+
+    if (nBytes == 0) {
+        // tfm::format(std::cout, "%s: BAD (connection closed
+        // prematurely)\n",
+        //        ToString(you));
+        return false;
+    }
+
+    // Spurious wakeup, there is nothing to read yet.
+    int nErr = WSAGetLastError();
+    return nErr == WSAEWOULDBLOCK || nErr == WSAEINTR;
 }
 
 PeerMessagingState CSeederNode::ProcessMessage(std::string strCommand,
@@ -187,13 +228,78 @@ bool CSeederNode::ProcessMessages() {
 CSeederNode::CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn)
     : sock(INVALID_SOCKET), vSend(SER_NETWORK, 0), vRecv(SER_NETWORK, 0),
       nHeaderStart(-1), nMessageStart(-1), nVersion(0), vAddr(vAddrIn), ban(0),
-      doneAfter(0), you(ip, ServiceFlags(NODE_NETWORK)) {
+      doneAfter(0), lastReceive(GetTime()),
+      you(ip, ServiceFlags(NODE_NETWORK)) {
     if (GetTime() > 1329696000) {
         vSend.SetVersion(209);
         vRecv.SetVersion(209);
     }
 }
 
+CSeederNode::~CSeederNode() {
+    Disconnect();
+}
+
+void CSeederNode::Disconnect() {
+    if (sock != INVALID_SOCKET) {
+        CloseSocket(sock);
+    }
+}
+
+bool CSeederNode::Connect() {
+    if (!you.IsValid()) {
+        return false;
+    }
+
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!you.GetSockAddr((struct sockaddr *)&sockaddr, &len)) {
+        return false;
+    }
+
+    // The socket is nonblocking, so this returns before the connection is
+    // established and OnConnected() tells us how it went.
+    sock = CreateSocket(you);
+    if (sock == INVALID_SOCKET) {
+        return false;
+    }
+
+    if (connect(sock, (struct sockaddr *)&sockaddr, len) == SOCKET_ERROR) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINPROGRESS && nErr != WSAEWOULDBLOCK &&
+            nErr != WSAEINVAL) {
+            CloseSocket(sock);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CSeederNode::OnConnected() {
+    int nRet = 0;
+    socklen_t nRetSize = sizeof(nRet);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (sockopt_arg_type)&nRet,
+                   &nRetSize) == SOCKET_ERROR ||
+        nRet != 0) {
+        CloseSocket(sock);
+        return false;
+    }
+
+    lastReceive = GetTime();
+    PushVersion();
+    return Send();
+}
+
+bool CSeederNode::OnReadable() {
+    if (sock == INVALID_SOCKET || !Receive()) {
+        return false;
+    }
+
+    ProcessMessages();
+    return Send();
+}
+
 bool CSeederNode::Run() {
     // FIXME: This logic is duplicated with CConnman::ConnectNode for no
     // good reason.
@@ -230,22 +336,13 @@ bool CSeederNode::Run() {
         return false;
     }
 
-    // Write version message
-    uint64_t nLocalServices = 0;
-    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
-    CService myService;
-    CAddress me(myService, ServiceFlags(NODE_NETWORK));
-    std::string ver = "/bitcoin-cash-seeder:0.15/";
-    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
-                                nLocalServices, GetTime(), you, me, nLocalNonce,
-                                ver, GetRequireHeight());
+    PushVersion();
     Send();
 
     bool res = true;
     int64_t now;
     while (now = GetTime(), ban == 0 && (doneAfter == 0 || doneAfter > now) &&
                                 sock != INVALID_SOCKET) {
-        char pchBuf[0x10000];
         fd_set fdsetRecv;
         fd_set fdsetError;
         FD_ZERO(&fdsetRecv);
@@ -267,20 +364,7 @@ bool CSeederNode::Run() {
             }
             break;
         }
-        int nBytes = recv(sock, pchBuf, sizeof(pchBuf), 0);
-        int nPos = vRecv.size();
-        if (nBytes > 0) {
-            vRecv.resize(nPos + nBytes);
-            memcpy(&vRecv[nPos], pchBuf, nBytes);
-        } else if (nBytes == 0) {
-            // tfm::format(std::cout, "%s: BAD (connection closed
-            // prematurely)\n",
-            //        ToString(you));
-            res = false;
-            break;
-        } else {
-            // tfm::format(std::cout, "%s: BAD (connection error)\n",
-            // ToString(you));
+        if (!Receive()) {
             res = false;
             break;
         }
@@ -290,7 +374,6 @@ bool CSeederNode::Run() {
     if (sock == INVALID_SOCKET) {
         res = false;
     }
-    close(sock);
-    sock = INVALID_SOCKET;
+    Disconnect();
     return (ban == 0) && res;
 }
@@ -56,9 +56,10 @@ private:
     std::vector<CAddress> *vAddr;
     int ban;
     int64_t doneAfter;
+    int64_t lastReceive;
     CAddress you;
 
-    int GetTimeout() { return you.IsTor() ? 120 : 30; }
+    int GetTimeout() const { return you.IsTor() ? 120 : 30; }
 
     void BeginMessage(const char *pszCommand);
 
@@ -66,21 +67,51 @@ private:
 
     void EndMessage();
 
-    void Send();
-
     void PushVersion();
 
     bool ProcessMessages();
 
+    bool Receive();
+
 protected:
     PeerMessagingState ProcessMessage(std::string strCommand,
                                       CDataStream &recv);
 
 public:
     CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn);
+    ~CSeederNode();
 
     bool Run();
 
+    /**
+     * Nonblocking interface, used by CSeederCrawler to drive many nodes from a
+     * single thread. Connect() starts connecting and OnConnected() must be
+     * called once the socket is writable. OnReadable() and Send() return
+     * false when the connection is lost. Peers behind a proxy are not
+     * supported, use Run() for them.
+     */
+    bool Connect();
+    bool OnConnected();
+    bool OnReadable();
+    bool Send();
+    bool HasDataToSend() const { return !vSend.empty(); }
+    SOCKET GetSocket() const { return sock; }
+    void Disconnect();
+
+    /**
+     * The exchange with the peer is over, either because it misbehaved or
+     * because we got what we wanted from it.
+     */
+    bool IsDone(int64_t now) const {
+        return ban != 0 || (doneAfter != 0 && doneAfter <= now);
+    }
+
+    /**
+     * Time after which a peer which is not done yet is considered
+     * unresponsive.
+     */
+    int64_t GetTimeoutTime() const { return lastReceive + GetTimeout(); }
+
     int GetBan() { return ban; }
 
     int GetClientVersion() { return nVersion; }
@@ -0,0 +1,276 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/crawler.h>
+
+#include <netbase.h>
+#include <tinyformat.h>
+#include <util/time.h>
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <ios>
+#include <stdexcept>
+
+/** How often the connections are scanned for timeouts, in milliseconds. */
+static constexpr int64_t TIMEOUT_CHECK_INTERVAL = 250;
+
+CSeederCrawler::CSeederCrawler(size_t maxConnectionsIn)
+    : maxConnections(maxConnectionsIn) {
+#ifdef HAVE_SYS_EPOLL_H
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd < 0) {
+        throw std::runtime_error(
+            strprintf("epoll_create1 failed: %s", NetworkErrorString(errno)));
+    }
+#endif
+}
+
+CSeederCrawler::~CSeederCrawler() {
+    // The nodes close their socket on destruction.
+    connections.clear();
+#ifdef HAVE_SYS_EPOLL_H
+    close(epollfd);
+#endif
+}
+
+bool CSeederCrawler::Register(Connection &conn) {
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.fd = conn.sock;
+    return epoll_ctl(epollfd, EPOLL_CTL_ADD, conn.sock, &event) == 0;
+#else
+    return true;
+#endif
+}
+
+void CSeederCrawler::UpdateInterest(Connection &conn) {
+    // While connecting we wait for the socket to become writable. After that
+    // we always read, and only ask for write readiness when the kernel send
+    // buffer was full so we don't spin on an always writable socket.
+    const bool wantWrite = conn.connecting || conn.node->HasDataToSend();
+    if (wantWrite == conn.wantWrite) {
+        return;
+    }
+    conn.wantWrite = wantWrite;
+
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event event = {};
+    event.events = wantWrite ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = conn.sock;
+    epoll_ctl(epollfd, EPOLL_CTL_MOD, conn.sock, &event);
+#endif
+}
+
+void CSeederCrawler::Add(const CServiceResult &ip, bool getaddr) {
+    auto conn = std::make_unique<Connection>();
+    conn->result = ip;
+    conn->result.nBanTime = 0;
+    conn->result.nClientV = 0;
+    conn->result.nHeight = 0;
+    conn->result.strClientV = "";
+    conn->result.fGood = false;
+    conn->node = std::make_unique<CSeederNode>(
+        ip.service, getaddr ? &conn->addrs : nullptr);
+    conn->connecting = true;
+    conn->wantWrite = true;
+    conn->connectDeadline = GetTimeMillis() + nConnectTimeout;
+
+    if (!conn->node->Connect()) {
+        results.push_back(conn->result);
+        return;
+    }
+
+    conn->sock = conn->node->GetSocket();
+    if (!Register(*conn)) {
+        results.push_back(conn->result);
+        return;
+    }
+
+    connections.emplace(conn->sock, std::move(conn));
+}
+
+void CSeederCrawler::Finish(SOCKET sock, bool good) {
+    auto it = connections.find(sock);
+    assert(it != connections.end());
+    Connection &conn = *it->second;
+
+#ifdef HAVE_SYS_EPOLL_H
+    // The node may already have closed the socket after an error, in which
+    // case the kernel removed it from the epoll set already.
+    if (conn.node->GetSocket() != INVALID_SOCKET) {
+        epoll_ctl(epollfd, EPOLL_CTL_DEL, sock, nullptr);
+    }
+#endif
+    conn.node->Disconnect();
+
+    CServiceResult &res = conn.result;
+    res.fGood = good;
+    res.nBanTime = good ? 0 : conn.node->GetBan();
+    res.nClientV = conn.node->GetClientVersion();
+    res.strClientV = conn.node->GetClientSubVersion();
+    res.nHeight = conn.node->GetStartingHeight();
+    results.push_back(std::move(res));
+    addrs.insert(addrs.end(), conn.addrs.begin(), conn.addrs.end());
+
+    connections.erase(it);
+}
+
+void CSeederCrawler::HandleEvent(Connection &conn, bool readable,
+                                 bool writable, bool error) {
+    CSeederNode &node = *conn.node;
+
+    if (conn.connecting) {
+        if (!writable && !error) {
+            return;
+        }
+
+        conn.connecting = false;
+        if (!node.OnConnected()) {
+            Finish(conn.sock, false);
+            return;
+        }
+    } else {
+        bool ok;
+        try {
+            ok = !(readable || error) || node.OnReadable();
+        } catch (std::ios_base::failure &e) {
+            // The peer sent us a message we could not parse.
+            ok = false;
+        }
+
+        if (!ok) {
+            Finish(conn.sock, false);
+            return;
+        }
+
+        if (writable && !node.Send()) {
+            Finish(conn.sock, false);
+            return;
+        }
+    }
+
+    if (node.IsDone(GetTime())) {
+        Finish(conn.sock, node.GetBan() == 0);
+        return;
+    }
+
+    UpdateInterest(conn);
+}
+
+void CSeederCrawler::CheckTimeouts() {
+    const int64_t nowMillis = GetTimeMillis();
+    if (nowMillis < nextTimeoutCheck) {
+        return;
+    }
+    nextTimeoutCheck = nowMillis + TIMEOUT_CHECK_INTERVAL;
+
+    const int64_t now = GetTime();
+    std::vector<std::pair<SOCKET, bool>> expired;
+    for (const auto &p : connections) {
+        const Connection &conn = *p.second;
+        if (conn.connecting) {
+            if (conn.connectDeadline <= nowMillis) {
+                expired.emplace_back(p.first, false);
+            }
+            continue;
+        }
+
+        // Peers which are done are good unless they misbehaved, peers which
+        // stopped talking to us before that are not.
+        if (conn.node->IsDone(now)) {
+            expired.emplace_back(p.first, conn.node->GetBan() == 0);
+        } else if (conn.node->GetTimeoutTime() <= now) {
+            expired.emplace_back(p.first, false);
+        }
+    }
+
+    for (const auto &p : expired) {
+        Finish(p.first, p.second);
+    }
+}
+
+void CSeederCrawler::Poll(std::chrono::milliseconds timeout) {
+    // Don't sleep past the next timeout check when we have work to do.
+    int64_t waitMillis = timeout.count();
+    if (!connections.empty()) {
+        waitMillis = std::min(
+            waitMillis,
+            std::max<int64_t>(0, nextTimeoutCheck - GetTimeMillis()));
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    std::vector<struct epoll_event> events(
+        std::max<size_t>(1, std::min(connections.size(), maxConnections)));
+    int n = epoll_wait(epollfd, events.data(), events.size(), waitMillis);
+    for (int i = 0; i < n; i++) {
+        auto it = connections.find(events[i].data.fd);
+        if (it == connections.end()) {
+            continue;
+        }
+
+        const uint32_t ev = events[i].events;
+        HandleEvent(*it->second, ev & EPOLLIN, ev & EPOLLOUT,
+                    ev & (EPOLLERR | EPOLLHUP));
+    }
+#else
+    std::vector<struct pollfd> fds;
+    fds.reserve(connections.size());
+    for (const auto &p : connections) {
+        struct pollfd pfd = {};
+        pfd.fd = p.first;
+        pfd.events = POLLIN | (p.second->wantWrite ? POLLOUT : 0);
+        fds.push_back(pfd);
+    }
+
+    if (fds.empty()) {
+        UninterruptibleSleep(std::chrono::milliseconds{waitMillis});
+    } else if (poll(fds.data(), fds.size(), waitMillis) > 0) {
+        for (const struct pollfd &pfd : fds) {
+            if (pfd.revents == 0) {
+                continue;
+            }
+
+            auto it = connections.find(pfd.fd);
+            if (it == connections.end()) {
+                continue;
+            }
+
+            HandleEvent(*it->second, pfd.revents & POLLIN,
+                        pfd.revents & POLLOUT,
+                        pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+        }
+    }
+#endif
+
+    CheckTimeouts();
+}
+
+void CSeederCrawler::TakeResults(std::vector<CServiceResult> &resultsOut,
+                                 std::vector<CAddress> &addrsOut) {
+    resultsOut = std::move(results);
+    addrsOut = std::move(addrs);
+    results.clear();
+    addrs.clear();
+}
@@ -0,0 +1,105 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_CRAWLER_H
+#define BITCOIN_SEEDER_CRAWLER_H
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <compat.h>
+#include <protocol.h>
+#include <seeder/bitcoin.h>
+#include <seeder/db.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Crawl many peers at once from a single thread.
+ *
+ * The sockets are nonblocking and are multiplexed with epoll where it is
+ * available, poll otherwise, so the number of peers crawled at the same time
+ * is bounded by maxConnections rather than by the number of threads.
+ *
+ * Connecting through a SOCKS5 proxy is blocking, so peers which need a proxy
+ * are not handled here and must be crawled with CSeederNode::Run().
+ */
+class CSeederCrawler {
+    struct Connection {
+        CServiceResult result;
+        std::vector<CAddress> addrs;
+        std::unique_ptr<CSeederNode> node;
+        SOCKET sock;
+        bool connecting;
+        bool wantWrite;
+        int64_t connectDeadline;
+    };
+
+    const size_t maxConnections;
+    std::unordered_map<SOCKET, std::unique_ptr<Connection>> connections;
+
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+
+    int64_t nextTimeoutCheck = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+    int epollfd;
+#endif
+
+    bool Register(Connection &conn);
+    void UpdateInterest(Connection &conn);
+    void HandleEvent(Connection &conn, bool readable, bool writable,
+                     bool error);
+    void CheckTimeouts();
+    void Finish(SOCKET sock, bool good);
+
+public:
+    explicit CSeederCrawler(size_t maxConnectionsIn);
+    ~CSeederCrawler();
+
+    CSeederCrawler(const CSeederCrawler &) = delete;
+    CSeederCrawler &operator=(const CSeederCrawler &) = delete;
+
+    size_t GetConnectionCount() const { return connections.size(); }
+    bool IsFull() const { return connections.size() >= maxConnections; }
+
+    /**
+     * Start crawling a peer. Its result is available from TakeResults() once
+     * it is done.
+     */
+    void Add(const CServiceResult &ip, bool getaddr);
+
+    /**
+     * Wait up to timeout for socket events and advance all the connections
+     * accordingly.
+     */
+    void Poll(std::chrono::milliseconds timeout);
+
+    /**
+     * Move out the results of the crawled peers and the addresses they sent
+     * us.
+     */
+    void TakeResults(std::vector<CServiceResult> &resultsOut,
+                     std::vector<CAddress> &addrsOut);
+};
+
+#endif // BITCOIN_SEEDER_CRAWLER_H
@@ -65,10 +65,8 @@ bool CAddrDb::Get_(CServiceResult &ip, int &wait) {
         size_t rnd = rand() % tot;
         int ret;
         if (rnd < unkId.size()) {
-            std::set<int>::iterator it = unkId.end();
-            it--;
-            ret = *it;
-            unkId.erase(it);
+            ret = unkId.back();
+            unkId.erase(ret);
         } else {
             ret = ourId.front();
             if (GetTime() - idToInfo[ret].ourLastTry < MIN_RETRY) {
@@ -92,12 +90,35 @@ bool CAddrDb::Get_(CServiceResult &ip, int &wait) {
 }
 
 int CAddrDb::Lookup_(const CService &ip) {
-    if (ipToId.count(ip)) {
-        return ipToId[ip];
+    auto it = ipToId.find(ip);
+    if (it != ipToId.end()) {
+        return it->second;
     }
     return -1;
 }
 
+int CAddrDb::Insert_(const SeederAddrInfo &info) {
+    int id;
+    if (freeId.empty()) {
+        id = idToInfo.size();
+        idToInfo.push_back(info);
+    } else {
+        id = freeId.back();
+        freeId.pop_back();
+        idToInfo[id] = info;
+    }
+    ipToId[info.ip] = id;
+    return id;
+}
+
+void CAddrDb::Remove_(int id) {
+    ipToId.erase(idToInfo[id].ip);
+    unkId.erase(id);
+    goodId.erase(id);
+    idToInfo[id] = SeederAddrInfo();
+    freeId.push_back(id);
+}
+
 void CAddrDb::Good_(const CService &addr, int clientV, std::string clientSV,
                     int blocks) {
     int id = Lookup_(addr);
@@ -140,9 +161,7 @@ void CAddrDb::Bad_(const CService &addr, int ban) {
         //    tfm::format(std::cout, "%s: ban for %i seconds\n",
         //    ToString(addr), ban);
         banned[info.ip] = ban + now;
-        ipToId.erase(info.ip);
-        goodId.erase(id);
-        idToInfo.erase(id);
+        Remove_(id);
     } else {
         if (/*!info.IsReliable() && */ goodId.count(id) == 1) {
             goodId.erase(id);
@@ -167,8 +186,9 @@ void CAddrDb::Add_(const CAddress &addr, bool force) {
             return;
         }
     }
-    if (ipToId.count(ipp)) {
-        SeederAddrInfo &ai = idToInfo[ipToId[ipp]];
+    int existing = Lookup_(ipp);
+    if (existing != -1) {
+        SeederAddrInfo &ai = idToInfo[existing];
         if (addr.nTime > ai.lastTry || ai.services != addr.nServices) {
             ai.lastTry = addr.nTime;
             ai.services |= addr.nServices;
@@ -188,9 +208,7 @@ void CAddrDb::Add_(const CAddress &addr, bool force) {
     ai.ourLastTry = 0;
     ai.total = 0;
     ai.success = 0;
-    int id = nId++;
-    idToInfo[id] = ai;
-    ipToId[ipp] = id;
+    int id = Insert_(ai);
     //  tfm::format(std::cout, "%s: added\n", ToString(ipp),
     //  ipToId[ipp]);
     unkId.insert(id);
@@ -205,9 +223,9 @@ void CAddrDb::GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags,
             if (unkId.size() == 0) {
                 return;
             }
-            id = *unkId.begin();
+            id = unkId[0];
         } else {
-            id = *ourId.begin();
+            id = ourId.front();
         }
 
         if (id >= 0 &&
@@ -218,7 +236,8 @@ void CAddrDb::GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags,
     }
 
     std::vector<int> goodIdFiltered;
-    for (auto &id : goodId) {
+    goodIdFiltered.reserve(goodId.size());
+    for (int id : goodId) {
         if ((idToInfo[id].services & requestedFlags) == requestedFlags) {
             goodIdFiltered.push_back(id);
         }
@@ -18,8 +18,10 @@
 #define BITCOIN_SEEDER_DB_H
 
 #include <chainparams.h>
+#include <crypto/siphash.h>
 #include <netbase.h>
 #include <protocol.h>
+#include <random.h>
 #include <seeder/bitcoin.h>
 #include <seeder/util.h>
 #include <sync.h>
@@ -29,8 +31,10 @@
 #include <cmath>
 #include <cstdint>
 #include <deque>
+#include <limits>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #define MIN_RETRY 1000
@@ -263,6 +267,75 @@ struct CServiceResult {
     int64_t ourLastSuccess;
 };
 
+class SaltedServiceHasher {
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedServiceHasher()
+        : k0(GetRand(std::numeric_limits<uint64_t>::max())),
+          k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    size_t operator()(const CService &ip) const noexcept {
+        std::vector<uint8_t> key = ip.GetKey();
+        return CSipHasher(k0, k1).Write(key.data(), key.size()).Finalize();
+    }
+};
+
+/**
+ * A set of address ids with constant time insertion, removal and access by
+ * index, so picking random elements does not require walking a tree.
+ * Removal swaps the last element in place, so the order is not preserved.
+ */
+class CAddrIdSet {
+private:
+    std::vector<int> ids;
+    // position of each id in ids, or -1, indexed by id
+    std::vector<int> positions;
+
+public:
+    bool insert(int id) {
+        if (size_t(id) >= positions.size()) {
+            positions.resize(id + 1, -1);
+        }
+        if (positions[id] >= 0) {
+            return false;
+        }
+        positions[id] = ids.size();
+        ids.push_back(id);
+        return true;
+    }
+
+    bool erase(int id) {
+        if (!count(id)) {
+            return false;
+        }
+        int pos = positions[id];
+        ids[pos] = ids.back();
+        positions[ids[pos]] = pos;
+        ids.pop_back();
+        positions[id] = -1;
+        return true;
+    }
+
+    bool count(int id) const {
+        return size_t(id) < positions.size() && positions[id] >= 0;
+    }
+
+    void reserve(size_t n) {
+        ids.reserve(n);
+        positions.reserve(n);
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    int operator[](size_t i) const { return ids[i]; }
+    int back() const { return ids.back(); }
+    std::vector<int>::const_iterator begin() const { return ids.begin(); }
+    std::vector<int>::const_iterator end() const { return ids.end(); }
+};
+
 /**
  *             seen nodes
  *            /          \
@@ -275,22 +348,26 @@ struct CServiceResult {
 class CAddrDb {
 private:
     mutable RecursiveMutex cs;
-    // number of address id's
-    int nId;
-    // map address id to address info (b,c,d,e)
-    std::map<int, SeederAddrInfo> idToInfo;
+    // address info indexed by address id (b,c,d,e). The slots of the removed
+    // addresses are kept in freeId and reused.
+    std::vector<SeederAddrInfo> idToInfo;
+    std::vector<int> freeId;
     // map ip to id (b,c,d,e)
-    std::map<CService, int> ipToId;
+    std::unordered_map<CService, int, SaltedServiceHasher> ipToId;
     // sequence of tried nodes, in order we have tried connecting to them (c,d)
     std::deque<int> ourId;
     // set of nodes not yet tried (b)
-    std::set<int> unkId;
+    CAddrIdSet unkId;
     // set of good nodes  (d, good e)
-    std::set<int> goodId;
-    int nDirty;
+    CAddrIdSet goodId;
+    int nDirty = 0;
 
 protected:
     // internal routines that assume proper locks are acquired
+    // store a new address and return its id
+    int Insert_(const SeederAddrInfo &info);
+    // forget an address and free its id
+    void Remove_(int id);
     // add an address
     void Add_(const CAddress &addr, bool force);
     // get an IP to test (must call Good_ or Bad_ on result afterwards)
@@ -314,21 +391,20 @@ public:
     void GetStats(CAddrDbStats &stats) const {
         LOCK(cs);
         stats.nBanned = banned.size();
-        stats.nAvail = idToInfo.size();
+        stats.nAvail = idToInfo.size() - freeId.size();
         stats.nTracked = ourId.size();
         stats.nGood = goodId.size();
         stats.nNew = unkId.size();
         if (ourId.size() > 0) {
-            stats.nAge = GetTime() - idToInfo.at(ourId.at(0)).ourLastTry;
+            stats.nAge = GetTime() - idToInfo[ourId.front()].ourLastTry;
         } else {
             stats.nAge = 0;
         }
     }
 
     void ResetIgnores() {
-        for (std::map<int, SeederAddrInfo>::iterator it = idToInfo.begin();
-             it != idToInfo.end(); it++) {
-            (*it).second.ignoreTill = 0;
+        for (SeederAddrInfo &info : idToInfo) {
+            info.ignoreTill = 0;
         }
     }
 
@@ -351,59 +427,56 @@ public:
     //   n (number of ips in (b,c,d))
     //   SeederAddrInfo[n]
     //   banned
-    // acquires a shared lock (this does not suffice for read mode, but we
-    // assume that only happens at startup, single-threaded) this way, dumping
-    // does not interfere with GetIPs_, which is called from the DNS thread
+    // The lock is held for the whole serialization, so serialize to memory
+    // and write that to disk afterwards to not block the crawler and the DNS
+    // cache while the disk is busy.
     template <typename Stream> void Serialize(Stream &s) const {
         LOCK(cs);
 
         int nVersion = 0;
         s << nVersion;
 
-        CAddrDb *db = const_cast<CAddrDb *>(this);
         int n = ourId.size() + unkId.size();
         s << n;
-        for (std::deque<int>::const_iterator it = ourId.begin();
-             it != ourId.end(); it++) {
-            std::map<int, SeederAddrInfo>::iterator ci = db->idToInfo.find(*it);
-            s << (*ci).second;
+        for (int id : ourId) {
+            s << idToInfo[id];
         }
-        for (std::set<int>::const_iterator it = unkId.begin();
-             it != unkId.end(); it++) {
-            std::map<int, SeederAddrInfo>::iterator ci = db->idToInfo.find(*it);
-            s << (*ci).second;
+        for (int id : unkId) {
+            s << idToInfo[id];
         }
         s << banned;
     }
 
+    // Expects an empty database, which is only the case at startup.
     template <typename Stream> void Unserialize(Stream &s) {
         LOCK(cs);
 
         int nVersion;
         s >> nVersion;
 
-        CAddrDb *db = const_cast<CAddrDb *>(this);
-        db->nId = 0;
         int n;
         s >> n;
+        if (n > 0) {
+            idToInfo.reserve(n);
+            ipToId.reserve(n);
+            unkId.reserve(n);
+        }
         for (int i = 0; i < n; i++) {
             SeederAddrInfo info;
             s >> info;
             if (!info.GetBanTime()) {
-                int id = db->nId++;
-                db->idToInfo[id] = info;
-                db->ipToId[info.ip] = id;
+                int id = Insert_(info);
                 if (info.ourLastTry) {
-                    db->ourId.push_back(id);
+                    ourId.push_back(id);
                     if (info.IsReliable()) {
-                        db->goodId.insert(id);
+                        goodId.insert(id);
                     }
                 } else {
-                    db->unkId.insert(id);
+                    unkId.insert(id);
                 }
             }
         }
-        db->nDirty++;
+        nDirty++;
 
         s >> banned;
     }
@@ -272,6 +272,20 @@ error:
     return error;
 }
 
+int write_record_addr(uint8_t **outpos, const uint8_t *outend, int ttl,
+                      const addr_t *ip) {
+    // The question always comes right after the 12 bytes header.
+    const int offset = 12;
+    if (ip->v == 4) {
+        return write_record_a(outpos, outend, "", offset, CLASS_IN, ttl, ip);
+    }
+    if (ip->v == 6) {
+        return write_record_aaaa(outpos, outend, "", offset, CLASS_IN, ttl,
+                                 ip);
+    }
+    return -6;
+}
+
 static int write_record_ns(uint8_t **outpos, const uint8_t *outend,
                            const char *name, int offset, dns_class cls, int ttl,
                            const char *ns) {
@@ -532,32 +546,11 @@ static ssize_t dnshandle(dns_opt_t *opt, const uint8_t *inbuf, size_t insize,
         // A/AAAA records
         if ((typ == TYPE_A || typ == TYPE_AAAA || typ == QTYPE_ANY) &&
             (cls == CLASS_IN || cls == QCLASS_ANY)) {
-            addr_t addr[32];
-            int naddr = opt->cb((void *)opt, name, addr, 32,
-                                typ == TYPE_A || typ == QTYPE_ANY,
-                                typ == TYPE_AAAA || typ == QTYPE_ANY);
-            int n = 0;
-            while (n < naddr) {
-                int mustbreak = 1;
-                if (addr[n].v == 4) {
-                    mustbreak = write_record_a(&outpos, outend - max_auth_size,
-                                               "", offset, CLASS_IN,
-                                               opt->datattl, &addr[n]);
-                } else if (addr[n].v == 6) {
-                    mustbreak = write_record_aaaa(
-                        &outpos, outend - max_auth_size, "", offset, CLASS_IN,
-                        opt->datattl, &addr[n]);
-                }
-
-                //      tfm::format(std::cout, "wrote A record: %i\n",
-                //      mustbreak);
-                if (mustbreak) {
-                    break;
-                }
-
-                n++;
-                outbuf[7]++;
-            }
+            // The answers are encoded in advance, see write_record_addr().
+            outbuf[7] += opt->cb((void *)opt, name, &outpos,
+                                 outend - max_auth_size, 32,
+                                 typ == TYPE_A || typ == QTYPE_ANY,
+                                 typ == TYPE_AAAA || typ == QTYPE_ANY);
         }
 
         // Authority section
@@ -40,8 +40,11 @@ struct dns_opt_t {
     const char *host;
     const char *ns;
     const char *mbox;
-    uint32_t (*cb)(void *opt, char *requested_hostname, addr_t *addr,
-                   uint32_t max, uint32_t ipv4, uint32_t ipv6);
+    // Write up to max A/AAAA answers for requested_hostname, as encoded by
+    // write_record_addr(), and return how many were written.
+    uint32_t (*cb)(void *opt, char *requested_hostname, uint8_t **outpos,
+                   const uint8_t *outend, uint32_t max, uint32_t ipv4,
+                   uint32_t ipv6);
     // stats
     uint64_t nRequests;
 };
@@ -65,6 +68,17 @@ ParseNameStatus parse_name(const uint8_t **inpos, const uint8_t *inend,
 int write_name(uint8_t **outpos, const uint8_t *outend, const char *name,
                int offset);
 
+// Size of the A and AAAA answers written by write_record_addr().
+constexpr size_t DNS_A_RECORD_SIZE = 16;
+constexpr size_t DNS_AAAA_RECORD_SIZE = 28;
+
+// Write an A or AAAA answer for ip, which name is a pointer to the question.
+// The answer does not depend on the query, so it can be encoded in advance.
+//  0: ok
+// <0: error, nothing was written
+int write_record_addr(uint8_t **outpos, const uint8_t *outend, int ttl,
+                      const addr_t *ip);
+
 int dnsserver(dns_opt_t *opt);
 
 #endif // BITCOIN_SEEDER_DNS_H
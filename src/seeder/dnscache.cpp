@@ -0,0 +1,150 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/dnscache.h>
+
+#include <random.h>
+#include <seeder/dns.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+size_t DnsAnswerSet::GetIPv4Count() const {
+    return ipv4Records.size() / DNS_A_RECORD_SIZE;
+}
+
+size_t DnsAnswerSet::GetIPv6Count() const {
+    return ipv6Records.size() / DNS_AAAA_RECORD_SIZE;
+}
+
+std::shared_ptr<const DnsAnswerSet>
+DnsAnswerSet::Build(const std::set<CNetAddr> &ips, int ttl,
+                    FastRandomContext &rng) {
+    std::vector<addr_t> addrs;
+    addrs.reserve(ips.size());
+    for (const CNetAddr &ip : ips) {
+        struct in_addr addr;
+        struct in6_addr addr6;
+        addr_t a;
+        if (ip.GetInAddr(&addr)) {
+            a.v = 4;
+            memcpy(&a.data.v4, &addr, 4);
+        } else if (ip.GetIn6Addr(&addr6)) {
+            a.v = 6;
+            memcpy(&a.data.v6, &addr6, 16);
+        } else {
+            continue;
+        }
+        addrs.push_back(a);
+    }
+
+    Shuffle(addrs.begin(), addrs.end(), rng);
+
+    auto set = std::make_shared<DnsAnswerSet>();
+    for (const addr_t &a : addrs) {
+        std::vector<uint8_t> &records =
+            a.v == 4 ? set->ipv4Records : set->ipv6Records;
+        const size_t recordSize =
+            a.v == 4 ? DNS_A_RECORD_SIZE : DNS_AAAA_RECORD_SIZE;
+
+        const size_t pos = records.size();
+        records.resize(pos + recordSize);
+        uint8_t *outpos = records.data() + pos;
+        if (write_record_addr(&outpos, records.data() + records.size(), ttl,
+                              &a) != 0 ||
+            outpos != records.data() + records.size()) {
+            records.resize(pos);
+        }
+    }
+
+    return set;
+}
+
+DnsAnswerCache::DnsAnswerCache() : snapshot(std::make_shared<Snapshot>()) {}
+
+void DnsAnswerCache::Publish(Snapshot newSnapshot) {
+    std::atomic_store(&snapshot, std::shared_ptr<const Snapshot>(
+                                     std::make_shared<const Snapshot>(
+                                         std::move(newSnapshot))));
+}
+
+std::shared_ptr<const DnsAnswerSet>
+DnsAnswerCache::Get(uint64_t requestedFlags) const {
+    std::shared_ptr<const Snapshot> current = std::atomic_load(&snapshot);
+    auto it = current->find(requestedFlags);
+    if (it == current->end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+/**
+ * Copy up to max records from a window of the records starting at a random
+ * index. The records are shuffled when the set is built, and a new set is
+ * built every few seconds, so this gives a random sample without touching the
+ * shared data.
+ */
+static uint32_t CopyRecords(const std::vector<uint8_t> &records,
+                            size_t recordSize, uint8_t **outpos,
+                            const uint8_t *outend, uint32_t max,
+                            FastRandomContext &rng) {
+    const size_t count = records.size() / recordSize;
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t room = (outend - *outpos) / recordSize;
+    const size_t n = std::min({size_t(max), count, room});
+    const size_t start = rng.randrange(count);
+
+    // Copy the window in at most two chunks since it can wrap around.
+    const size_t first = std::min(n, count - start);
+    memcpy(*outpos, records.data() + start * recordSize, first * recordSize);
+    *outpos += first * recordSize;
+    memcpy(*outpos, records.data(), (n - first) * recordSize);
+    *outpos += (n - first) * recordSize;
+    return n;
+}
+
+uint32_t DnsAnswerCache::WriteAnswers(uint64_t requestedFlags,
+                                      uint8_t **outpos, const uint8_t *outend,
+                                      uint32_t max, bool ipv4, bool ipv6,
+                                      FastRandomContext &rng) const {
+    std::shared_ptr<const DnsAnswerSet> set = Get(requestedFlags);
+    if (!set) {
+        return 0;
+    }
+
+    // When both families are requested, share the answer between them in
+    // proportion of the addresses we know of.
+    uint32_t maxIPv4 = ipv4 ? max : 0;
+    if (ipv4 && ipv6) {
+        const size_t total = set->GetIPv4Count() + set->GetIPv6Count();
+        maxIPv4 = total == 0 ? 0 : max * set->GetIPv4Count() / total;
+    }
+
+    uint32_t n = 0;
+    if (ipv4) {
+        n += CopyRecords(set->ipv4Records, DNS_A_RECORD_SIZE, outpos, outend,
+                         maxIPv4, rng);
+    }
+    if (ipv6) {
+        n += CopyRecords(set->ipv6Records, DNS_AAAA_RECORD_SIZE, outpos,
+                         outend, max - n, rng);
+    }
+    return n;
+}
@@ -0,0 +1,78 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_DNSCACHE_H
+#define BITCOIN_SEEDER_DNSCACHE_H
+
+#include <netaddress.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class FastRandomContext;
+
+/**
+ * The A and AAAA answers for one service flags filter, already encoded in DNS
+ * wire format. Every record has a fixed size since its name is a pointer to
+ * the question, so serving a query is just copying bytes.
+ *
+ * The records are shuffled when the set is built and never modified after,
+ * so a set can be shared by all the DNS threads.
+ */
+struct DnsAnswerSet {
+    std::vector<uint8_t> ipv4Records;
+    std::vector<uint8_t> ipv6Records;
+
+    size_t GetIPv4Count() const;
+    size_t GetIPv6Count() const;
+
+    static std::shared_ptr<const DnsAnswerSet>
+    Build(const std::set<CNetAddr> &ips, int ttl, FastRandomContext &rng);
+};
+
+/**
+ * The answers served by the DNS threads, published as a whole by the thread
+ * which queries the address database. Readers only take a reference to the
+ * current snapshot, so answering a query never waits on the database.
+ */
+class DnsAnswerCache {
+public:
+    using Snapshot = std::map<uint64_t, std::shared_ptr<const DnsAnswerSet>>;
+
+private:
+    std::shared_ptr<const Snapshot> snapshot;
+
+public:
+    DnsAnswerCache();
+
+    void Publish(Snapshot newSnapshot);
+
+    std::shared_ptr<const DnsAnswerSet> Get(uint64_t requestedFlags) const;
+
+    /**
+     * Copy up to max answers for the filter to outpos, starting from a random
+     * record. Returns the number of records written.
+     */
+    uint32_t WriteAnswers(uint64_t requestedFlags, uint8_t **outpos,
+                          const uint8_t *outend, uint32_t max, bool ipv4,
+                          bool ipv6, FastRandomContext &rng) const;
+};
+
+#endif // BITCOIN_SEEDER_DNSCACHE_H
@@ -19,11 +19,16 @@
 #include <dnsseeds.h>
 #include <fs.h>
 #include <logging.h>
+#include <netbase.h>
 #include <protocol.h>
+#include <random.h>
 #include <seeder/bitcoin.h>
+#include <seeder/crawler.h>
 #include <seeder/db.h>
 #include <seeder/dns.h>
+#include <seeder/dnscache.h>
 #include <streams.h>
+#include <sync.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <util/time.h>
@@ -32,8 +37,10 @@
 #include <algorithm>
 #include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <csignal>
 #include <cstdlib>
+#include <deque>
 #include <functional>
 #include <pthread.h>
 
@@ -42,8 +49,10 @@ const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
 static const int CONTINUE_EXECUTION = -1;
 
 static const int DEFAULT_NUM_THREADS = 96;
+static const int DEFAULT_MAX_CONNECTIONS = 1000;
 static const int DEFAULT_PORT = 53;
 static const int DEFAULT_NUM_DNS_THREADS = 4;
+static const int DNS_DATA_TTL = 3600;
 static const bool DEFAULT_WIPE_BAN = false;
 static const bool DEFAULT_WIPE_IGNORE = false;
 static const std::string DEFAULT_EMAIL = "";
@@ -56,6 +65,7 @@ static const std::string DEFAULT_IPV6_PROXY = "";
 class CDnsSeedOpts {
 public:
     int nThreads;
+    int nMaxConnections;
     int nPort;
     int nDnsThreads;
     bool fWipeBan;
@@ -69,7 +79,8 @@ public:
     std::set<uint64_t> filter_whitelist;
 
     CDnsSeedOpts()
-        : nThreads(DEFAULT_NUM_THREADS), nPort(DEFAULT_PORT),
+        : nThreads(DEFAULT_NUM_THREADS),
+          nMaxConnections(DEFAULT_MAX_CONNECTIONS), nPort(DEFAULT_PORT),
           nDnsThreads(DEFAULT_NUM_DNS_THREADS), fWipeBan(DEFAULT_WIPE_BAN),
           fWipeIgnore(DEFAULT_WIPE_IGNORE), mbox(DEFAULT_EMAIL),
           ns(DEFAULT_NAMESERVER), host(DEFAULT_HOST), tor(DEFAULT_TOR_PROXY),
@@ -98,6 +109,8 @@ public:
         }
 
         nThreads = gArgs.GetArg("-threads", DEFAULT_NUM_THREADS);
+        nMaxConnections =
+            gArgs.GetArg("-maxconnections", DEFAULT_MAX_CONNECTIONS);
         nPort = gArgs.GetArg("-port", DEFAULT_PORT);
         nDnsThreads = gArgs.GetArg("-dnsthreads", DEFAULT_NUM_DNS_THREADS);
         fWipeBan = gArgs.GetBoolArg("-wipeban", DEFAULT_WIPE_BAN);
@@ -150,8 +163,13 @@ private:
         argsman.AddArg("-mbox=<mbox>", "E-Mail address reported in SOA records",
                        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
         argsman.AddArg("-threads=<threads>",
-                       "Number of crawlers to run in parallel (default 96)",
+                       "Number of crawler threads for the peers reached "
+                       "through a proxy (default 96)",
                        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        argsman.AddArg("-maxconnections=<n>",
+                       "Maximum number of peers to crawl at the same time "
+                       "(default 1000)",
+                       ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
         argsman.AddArg("-dnsthreads=<threads>",
                        "Number of DNS server threads (default 4)",
                        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -183,136 +201,163 @@ extern "C" {
 
 CAddrDb db;
 
-extern "C" void *ThreadCrawler(void *data) {
-    int *nThreads = (int *)data;
+/**
+ * Peers which can only be reached through a proxy, waiting for a proxy
+ * crawler thread.
+ */
+static Mutex cs_proxyQueue;
+static std::condition_variable proxyQueueCond;
+static std::deque<CServiceResult> proxyQueue GUARDED_BY(cs_proxyQueue);
+
+static bool NeedsGetAddr(const CServiceResult &res, int64_t now) {
+    return res.ourLastSuccess + 86400 < now;
+}
+
+/**
+ * Crawl the peers which need a proxy. Connecting through SOCKS5 is blocking,
+ * so these use one thread per connection.
+ */
+extern "C" void *ThreadProxyCrawler(void *) {
     do {
-        std::vector<CServiceResult> ips;
-        int wait = 5;
-        db.GetMany(ips, 16, wait);
-        int64_t now = GetTime();
-        if (ips.empty()) {
-            wait *= 1000;
-            wait += rand() % (500 * *nThreads);
-            Sleep(wait);
-            continue;
+        CServiceResult res;
+        {
+            WAIT_LOCK(cs_proxyQueue, lock);
+            proxyQueueCond.wait(lock, [] {
+                AssertLockHeld(cs_proxyQueue);
+                return !proxyQueue.empty();
+            });
+            res = std::move(proxyQueue.front());
+            proxyQueue.pop_front();
         }
 
         std::vector<CAddress> addr;
-        for (size_t i = 0; i < ips.size(); i++) {
-            CServiceResult &res = ips[i];
-            res.nBanTime = 0;
-            res.nClientV = 0;
-            res.nHeight = 0;
-            res.strClientV = "";
-            bool getaddr = res.ourLastSuccess + 86400 < now;
-            try {
-                CSeederNode node(res.service, getaddr ? &addr : nullptr);
-                bool ret = node.Run();
-                if (!ret) {
-                    res.nBanTime = node.GetBan();
-                } else {
-                    res.nBanTime = 0;
-                }
-                res.nClientV = node.GetClientVersion();
-                res.strClientV = node.GetClientSubVersion();
-                res.nHeight = node.GetStartingHeight();
-                // tfm::format(std::cout, "%s: %s!!!\n", cip.ToString(),
-                // ret ? "GOOD" : "BAD");
-                res.fGood = ret;
-            } catch (std::ios_base::failure &e) {
+        res.nBanTime = 0;
+        res.nClientV = 0;
+        res.nHeight = 0;
+        res.strClientV = "";
+        bool getaddr = NeedsGetAddr(res, GetTime());
+        try {
+            CSeederNode node(res.service, getaddr ? &addr : nullptr);
+            bool ret = node.Run();
+            if (!ret) {
+                res.nBanTime = node.GetBan();
+            } else {
                 res.nBanTime = 0;
-                res.fGood = false;
             }
+            res.nClientV = node.GetClientVersion();
+            res.strClientV = node.GetClientSubVersion();
+            res.nHeight = node.GetStartingHeight();
+            res.fGood = ret;
+        } catch (std::ios_base::failure &e) {
+            res.nBanTime = 0;
+            res.fGood = false;
         }
 
-        db.ResultMany(ips);
+        db.ResultMany({res});
         db.Add(addr);
     } while (1);
     return nullptr;
 }
 
+/**
+ * Crawl all the peers which don't need a proxy from a single event loop, with
+ * up to nMaxConnections connections in flight.
+ */
+extern "C" void *ThreadCrawler(void *data) {
+    const size_t nMaxConnections = *(int *)data;
+    CSeederCrawler crawler(nMaxConnections);
+    do {
+        size_t nQueued = WITH_LOCK(cs_proxyQueue, return proxyQueue.size());
+        size_t nInFlight = crawler.GetConnectionCount() + nQueued;
+        if (nInFlight < nMaxConnections) {
+            std::vector<CServiceResult> ips;
+            int wait = 5;
+            db.GetMany(ips, nMaxConnections - nInFlight, wait);
+
+            int64_t now = GetTime();
+            for (const CServiceResult &res : ips) {
+                proxyType proxy;
+                if (GetProxy(res.service.GetNetwork(), proxy)) {
+                    LOCK(cs_proxyQueue);
+                    proxyQueue.push_back(res);
+                    proxyQueueCond.notify_one();
+                    continue;
+                }
+
+                crawler.Add(res, NeedsGetAddr(res, now));
+            }
+        }
+
+        // Nothing is in flight when the database has no peer to test yet, in
+        // which case this is just a short sleep.
+        crawler.Poll(std::chrono::milliseconds{
+            crawler.GetConnectionCount() > 0 ? 100 : 1000});
+
+        std::vector<CServiceResult> results;
+        std::vector<CAddress> addr;
+        crawler.TakeResults(results, addr);
+        if (!results.empty()) {
+            db.ResultMany(results);
+            db.Add(addr);
+        }
+    } while (1);
+    return nullptr;
+}
+
 extern "C" uint32_t GetIPList(void *thread, char *requestedHostname,
-                              addr_t *addr, uint32_t max, uint32_t ipv4,
-                              uint32_t ipv6);
+                              uint8_t **outpos, const uint8_t *outend,
+                              uint32_t max, uint32_t ipv4, uint32_t ipv6);
+
+/** How often the DNS answers are rebuilt from the database, in seconds. */
+static const int DNS_CACHE_REFRESH_INTERVAL = 5;
+
+/**
+ * The answers served by all the DNS threads. They only read from it, so they
+ * never contend with the crawler for the database lock.
+ */
+static DnsAnswerCache dnsCache;
+static std::atomic<uint64_t> dnsDbQueries{0};
+
+static void RefreshDnsCache(const std::set<uint64_t> &filters, int ttl,
+                            FastRandomContext &rng) {
+    bool nets[NET_MAX] = {};
+    nets[NET_IPV4] = true;
+    nets[NET_IPV6] = true;
+
+    DnsAnswerCache::Snapshot snapshot;
+    for (uint64_t requestedFlags : filters) {
+        std::set<CNetAddr> ips;
+        db.GetIPs(ips, requestedFlags, 1000, nets);
+        dnsDbQueries++;
+        snapshot.emplace(requestedFlags, DnsAnswerSet::Build(ips, ttl, rng));
+    }
+    dnsCache.Publish(std::move(snapshot));
+}
 
 class CDnsThread {
 public:
-    struct FlagSpecificData {
-        int nIPv4, nIPv6;
-        std::vector<addr_t> cache;
-        time_t cacheTime;
-        unsigned int cacheHits;
-        FlagSpecificData() : nIPv4(0), nIPv6(0), cacheTime(0), cacheHits(0) {}
-    };
-
     dns_opt_t dns_opt; // must be first
     const int id;
-    std::map<uint64_t, FlagSpecificData> perflag;
-    std::atomic<uint64_t> dbQueries;
     std::set<uint64_t> filterWhitelist;
-
-    void cacheHit(uint64_t requestedFlags, bool force = false) {
-        static bool nets[NET_MAX] = {};
-        if (!nets[NET_IPV4]) {
-            nets[NET_IPV4] = true;
-            nets[NET_IPV6] = true;
-        }
-        int64_t now = GetTime();
-        FlagSpecificData &thisflag = perflag[requestedFlags];
-        thisflag.cacheHits++;
-        if (force ||
-            thisflag.cacheHits * 400 >
-                (thisflag.cache.size() * thisflag.cache.size()) ||
-            (thisflag.cacheHits * thisflag.cacheHits * 20 >
-                 thisflag.cache.size() &&
-             (now - thisflag.cacheTime > 5))) {
-            std::set<CNetAddr> ips;
-            db.GetIPs(ips, requestedFlags, 1000, nets);
-            dbQueries++;
-            thisflag.cache.clear();
-            thisflag.nIPv4 = 0;
-            thisflag.nIPv6 = 0;
-            thisflag.cache.reserve(ips.size());
-            for (auto &ip : ips) {
-                struct in_addr addr;
-                struct in6_addr addr6;
-                if (ip.GetInAddr(&addr)) {
-                    addr_t a;
-                    a.v = 4;
-                    memcpy(&a.data.v4, &addr, 4);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv4++;
-                } else if (ip.GetIn6Addr(&addr6)) {
-                    addr_t a;
-                    a.v = 6;
-                    memcpy(&a.data.v6, &addr6, 16);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv6++;
-                }
-            }
-            thisflag.cacheHits = 0;
-            thisflag.cacheTime = now;
-        }
-    }
+    FastRandomContext rng;
 
     CDnsThread(CDnsSeedOpts *opts, int idIn) : id(idIn) {
         dns_opt.host = opts->host.c_str();
         dns_opt.ns = opts->ns.c_str();
         dns_opt.mbox = opts->mbox.c_str();
-        dns_opt.datattl = 3600;
+        dns_opt.datattl = DNS_DATA_TTL;
         dns_opt.nsttl = 40000;
         dns_opt.cb = GetIPList;
         dns_opt.port = opts->nPort;
         dns_opt.nRequests = 0;
-        dbQueries = 0;
-        perflag.clear();
         filterWhitelist = opts->filter_whitelist;
     }
 
     void run() { dnsserver(&dns_opt); }
 };
 
-extern "C" uint32_t GetIPList(void *data, char *requestedHostname, addr_t *addr,
+extern "C" uint32_t GetIPList(void *data, char *requestedHostname,
+                              uint8_t **outpos, const uint8_t *outend,
                               uint32_t max, uint32_t ipv4, uint32_t ipv6) {
     CDnsThread *thread = (CDnsThread *)data;
 
@@ -333,40 +378,31 @@ extern "C" uint32_t GetIPList(void *data, char *requestedHostname, addr_t *addr,
     } else if (strcasecmp(requestedHostname, thread->dns_opt.host)) {
         return 0;
     }
-    thread->cacheHit(requestedFlags);
-    auto &thisflag = thread->perflag[requestedFlags];
-    uint32_t size = thisflag.cache.size();
-    uint32_t maxmax = (ipv4 ? thisflag.nIPv4 : 0) + (ipv6 ? thisflag.nIPv6 : 0);
-    if (max > size) {
-        max = size;
-    }
-    if (max > maxmax) {
-        max = maxmax;
-    }
-    uint32_t i = 0;
-    while (i < max) {
-        uint32_t j = i + (rand() % (size - i));
-        do {
-            bool ok = (ipv4 && thisflag.cache[j].v == 4) ||
-                      (ipv6 && thisflag.cache[j].v == 6);
-            if (ok) {
-                break;
-            }
-            j++;
-            if (j == size) {
-                j = i;
-            }
-        } while (1);
-        addr[i] = thisflag.cache[j];
-        thisflag.cache[j] = thisflag.cache[i];
-        thisflag.cache[i] = addr[i];
-        i++;
-    }
-    return max;
+
+    return dnsCache.WriteAnswers(requestedFlags, outpos, outend, max, ipv4,
+                                 ipv6, thread->rng);
 }
 
 std::vector<CDnsThread *> dnsThread;
 
+static std::set<uint64_t> GetDnsFilters(const CDnsSeedOpts &opts) {
+    // Queries without a filter are answered with the default flags.
+    std::set<uint64_t> filters = opts.filter_whitelist;
+    filters.insert(0);
+    return filters;
+}
+
+extern "C" void *ThreadDnsCache(void *data) {
+    const std::set<uint64_t> filters =
+        GetDnsFilters(*(const CDnsSeedOpts *)data);
+    FastRandomContext rng;
+    do {
+        Sleep(DNS_CACHE_REFRESH_INTERVAL * 1000);
+        RefreshDnsCache(filters, DNS_DATA_TTL, rng);
+    } while (1);
+    return nullptr;
+}
+
 extern "C" void *ThreadDNS(void *arg) {
     CDnsThread *thread = (CDnsThread *)arg;
     thread->run();
@@ -395,16 +431,21 @@ extern "C" void *ThreadDumper(void *) {
         }
 
         {
+            // Only hold the database lock while copying it to memory.
+            CDataStream ss(SER_DISK, CLIENT_VERSION);
+            ss << db;
             std::vector<CAddrReport> v = db.GetAll();
-            sort(v.begin(), v.end(), StatCompare);
+
             FILE *f = fsbridge::fopen("dnsseed.dat.new", "w+");
             if (f) {
                 {
                     CAutoFile cf(f, SER_DISK, CLIENT_VERSION);
-                    cf << db;
+                    cf.write(ss.data(), ss.size());
                 }
                 rename("dnsseed.dat.new", "dnsseed.dat");
             }
+
+            sort(v.begin(), v.end(), StatCompare);
             fsbridge::ofstream d{"dnsseed.dump"};
             tfm::format(
                 d, "# address                                        good  "
@@ -453,10 +494,9 @@ extern "C" void *ThreadStats(void *) {
         }
         tfm::format(std::cout, "\x1b[s");
         uint64_t requests = 0;
-        uint64_t queries = 0;
+        uint64_t queries = dnsDbQueries;
         for (unsigned int i = 0; i < dnsThread.size(); i++) {
             requests += dnsThread[i]->dns_opt.nRequests;
-            queries += dnsThread[i]->dbQueries;
         }
         tfm::format(
             std::cout,
@@ -562,8 +602,13 @@ int main(int argc, char **argv) {
         }
         tfm::format(std::cout, "done\n");
     }
-    pthread_t threadDns, threadSeed, threadDump, threadStats;
+    pthread_t threadDns, threadDnsCache, threadSeed, threadDump, threadStats;
     if (fDNS) {
+        // Have answers ready before the first query comes in.
+        FastRandomContext rng;
+        RefreshDnsCache(GetDnsFilters(opts), DNS_DATA_TTL, rng);
+        pthread_create(&threadDnsCache, nullptr, ThreadDnsCache, &opts);
+
         tfm::format(std::cout,
                     "Starting %i DNS threads for %s on %s (port %i)...",
                     opts.nDnsThreads, opts.host, opts.ns, opts.nPort);
@@ -579,16 +624,34 @@ int main(int argc, char **argv) {
     tfm::format(std::cout, "Starting seeder...");
     pthread_create(&threadSeed, nullptr, ThreadSeeder, nullptr);
     tfm::format(std::cout, "done\n");
-    tfm::format(std::cout, "Starting %i crawler threads...", opts.nThreads);
-    pthread_attr_t attr_crawler;
-    pthread_attr_init(&attr_crawler);
-    pthread_attr_setstacksize(&attr_crawler, 0x20000);
-    for (int i = 0; i < opts.nThreads; i++) {
-        pthread_t thread;
-        pthread_create(&thread, &attr_crawler, ThreadCrawler, &opts.nThreads);
-    }
-    pthread_attr_destroy(&attr_crawler);
+    // Keep some file descriptors for the DNS server, the database dumps and
+    // the proxied connections.
+    const int nReservedFD = 64 + opts.nDnsThreads + opts.nThreads;
+    const int nFD =
+        RaiseFileDescriptorLimit(opts.nMaxConnections + nReservedFD);
+    opts.nMaxConnections = std::max(
+        1, std::min(opts.nMaxConnections, nFD - nReservedFD));
+    tfm::format(std::cout, "Starting crawler with up to %i connections...",
+                opts.nMaxConnections);
+    pthread_t threadCrawler;
+    pthread_create(&threadCrawler, nullptr, ThreadCrawler,
+                   &opts.nMaxConnections);
     tfm::format(std::cout, "done\n");
+    if (!opts.tor.empty() || !opts.ipv4_proxy.empty() ||
+        !opts.ipv6_proxy.empty()) {
+        tfm::format(std::cout, "Starting %i proxy crawler threads...",
+                    opts.nThreads);
+        pthread_attr_t attr_crawler;
+        pthread_attr_init(&attr_crawler);
+        pthread_attr_setstacksize(&attr_crawler, 0x20000);
+        for (int i = 0; i < opts.nThreads; i++) {
+            pthread_t thread;
+            pthread_create(&thread, &attr_crawler, ThreadProxyCrawler,
+                           nullptr);
+        }
+        pthread_attr_destroy(&attr_crawler);
+        tfm::format(std::cout, "done\n");
+    }
     pthread_create(&threadStats, nullptr, ThreadStats, nullptr);
     pthread_create(&threadDump, nullptr, ThreadDumper, nullptr);
     void *res;
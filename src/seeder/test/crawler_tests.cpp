@@ -0,0 +1,213 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/crawler.h>
+
+#include <chainparams.h>
+#include <compat.h>
+#include <netbase.h>
+#include <protocol.h>
+#include <seeder/bitcoin.h>
+#include <seeder/db.h>
+#include <seeder/messagewriter.h>
+#include <streams.h>
+#include <util/time.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+struct CrawlerTestingSetup {
+    SOCKET listenSock = INVALID_SOCKET;
+    CService listenAddr;
+
+    CrawlerTestingSetup() {
+        SelectParams(CBaseChainParams::REGTEST);
+
+        // Listen on an ephemeral port on the loopback interface.
+        listenSock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        BOOST_REQUIRE(listenSock != INVALID_SOCKET);
+
+        struct sockaddr_in sin = {};
+        sin.sin_family = AF_INET;
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        BOOST_REQUIRE(bind(listenSock, (struct sockaddr *)&sin, sizeof(sin)) !=
+                      SOCKET_ERROR);
+        BOOST_REQUIRE(listen(listenSock, 128) != SOCKET_ERROR);
+        BOOST_REQUIRE(SetSocketNonBlocking(listenSock, true));
+
+        socklen_t len = sizeof(sin);
+        BOOST_REQUIRE(getsockname(listenSock, (struct sockaddr *)&sin, &len) !=
+                      SOCKET_ERROR);
+        BOOST_REQUIRE(listenAddr.SetSockAddr((struct sockaddr *)&sin));
+    }
+
+    ~CrawlerTestingSetup() { CloseSocket(listenSock); }
+
+    CServiceResult MakeResult(const CService &service) {
+        CServiceResult res = {};
+        res.service = service;
+        return res;
+    }
+
+    /** Poll the crawler until it is done with all its connections. */
+    void Crawl(CSeederCrawler &crawler, std::vector<CServiceResult> &results,
+               std::vector<CAddress> &addrs) {
+        const int64_t deadline = GetTime() + 10;
+        while (crawler.GetConnectionCount() > 0 && GetTime() < deadline) {
+            crawler.Poll(std::chrono::milliseconds{100});
+        }
+        BOOST_CHECK_EQUAL(crawler.GetConnectionCount(), 0);
+        crawler.TakeResults(results, addrs);
+    }
+
+    /** Accept the crawler connection and read what it sent first. */
+    SOCKET Accept(CSeederCrawler &crawler, std::string &firstCommand) {
+        SOCKET sock = INVALID_SOCKET;
+        const int64_t deadline = GetTime() + 10;
+        while (sock == INVALID_SOCKET && GetTime() < deadline) {
+            crawler.Poll(std::chrono::milliseconds{10});
+            sock = accept(listenSock, nullptr, nullptr);
+        }
+        BOOST_REQUIRE(sock != INVALID_SOCKET);
+
+        // Let the crawler send its version message.
+        CDataStream recvBuf(SER_NETWORK, INIT_PROTO_VERSION);
+        const CMessageHeader::MessageMagic netMagic = Params().NetMagic();
+        const size_t headerSize =
+            GetSerializeSize(CMessageHeader(netMagic), INIT_PROTO_VERSION);
+        while (recvBuf.size() < headerSize && GetTime() < deadline) {
+            crawler.Poll(std::chrono::milliseconds{10});
+            char buf[0x1000];
+            int n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) {
+                recvBuf.write(buf, n);
+            }
+        }
+
+        CMessageHeader header(netMagic);
+        recvBuf >> header;
+        BOOST_CHECK(header.IsValidWithoutConfig(netMagic));
+        firstCommand = header.GetCommand();
+        return sock;
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(crawler_tests, CrawlerTestingSetup)
+
+BOOST_AUTO_TEST_CASE(connection_refused) {
+    // Grab a port which nobody listens on.
+    CService closedAddr = listenAddr;
+    CloseSocket(listenSock);
+
+    CSeederCrawler crawler(16);
+    crawler.Add(MakeResult(closedAddr), false);
+
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    Crawl(crawler, results, addrs);
+    BOOST_REQUIRE_EQUAL(results.size(), 1);
+    BOOST_CHECK(results[0].service == closedAddr);
+    BOOST_CHECK(!results[0].fGood);
+    BOOST_CHECK(addrs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(peer_disconnects) {
+    CSeederCrawler crawler(16);
+    crawler.Add(MakeResult(listenAddr), true);
+    BOOST_CHECK_EQUAL(crawler.GetConnectionCount(), 1);
+
+    std::string command;
+    SOCKET sock = Accept(crawler, command);
+    BOOST_CHECK_EQUAL(command, NetMsgType::VERSION);
+    CloseSocket(sock);
+
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    Crawl(crawler, results, addrs);
+    BOOST_REQUIRE_EQUAL(results.size(), 1);
+    BOOST_CHECK(!results[0].fGood);
+}
+
+BOOST_AUTO_TEST_CASE(good_peer) {
+    CSeederCrawler crawler(16);
+    crawler.Add(MakeResult(listenAddr), false);
+
+    std::string command;
+    SOCKET sock = Accept(crawler, command);
+    BOOST_CHECK_EQUAL(command, NetMsgType::VERSION);
+
+    // Complete the handshake. Without getaddr, the crawler is done with the
+    // peer shortly after the verack.
+    const int startingHeight = GetRequireHeight();
+    CDataStream sendBuf(SER_NETWORK, INIT_PROTO_VERSION);
+    CAddress addrFrom{CService(), ServiceFlags(NODE_NETWORK)};
+    MessageWriter::WriteMessage(sendBuf, NetMsgType::VERSION, PROTOCOL_VERSION,
+                                uint64_t(NODE_NETWORK), GetTime(),
+                                CAddress(listenAddr, NODE_NONE), addrFrom,
+                                uint64_t(0), std::string("/test:1.0/"),
+                                startingHeight);
+    MessageWriter::WriteMessage(sendBuf, NetMsgType::VERACK);
+    BOOST_CHECK_EQUAL(send(sock, sendBuf.data(), sendBuf.size(), 0),
+                      sendBuf.size());
+
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    Crawl(crawler, results, addrs);
+    CloseSocket(sock);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 1);
+    BOOST_CHECK(results[0].fGood);
+    BOOST_CHECK_EQUAL(results[0].nBanTime, 0);
+    BOOST_CHECK_EQUAL(results[0].nClientV, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(results[0].strClientV, "/test:1.0/");
+    BOOST_CHECK_EQUAL(results[0].nHeight, startingHeight);
+}
+
+BOOST_AUTO_TEST_CASE(many_connections) {
+    // All the connections are driven concurrently from the same thread.
+    constexpr size_t NUM_PEERS = 64;
+    CSeederCrawler crawler(NUM_PEERS);
+    for (size_t i = 0; i < NUM_PEERS; i++) {
+        crawler.Add(MakeResult(listenAddr), false);
+    }
+    BOOST_CHECK(crawler.IsFull());
+
+    // Accept and drop everything.
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    const int64_t deadline = GetTime() + 10;
+    while (crawler.GetConnectionCount() > 0 && GetTime() < deadline) {
+        crawler.Poll(std::chrono::milliseconds{10});
+        SOCKET sock;
+        while ((sock = accept(listenSock, nullptr, nullptr)) !=
+               INVALID_SOCKET) {
+            CloseSocket(sock);
+        }
+    }
+    crawler.TakeResults(results, addrs);
+    BOOST_CHECK_EQUAL(results.size(), NUM_PEERS);
+    for (const CServiceResult &res : results) {
+        BOOST_CHECK(!res.fGood);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/db.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <netaddress.h>
+#include <protocol.h>
+#include <streams.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <vector>
+
+static CAddress MakeAddress(uint32_t i) {
+    struct in_addr s;
+    // 1.0.0.0/8 is routable.
+    s.s_addr = htonl(0x01000000 | i);
+    return CAddress(CService(CNetAddr(s), GetDefaultPort()),
+                    ServiceFlags(NODE_NETWORK));
+}
+
+static void CheckStats(const CAddrDb &db, int avail, int tracked, int good,
+                       int fresh, int banned) {
+    CAddrDbStats stats;
+    db.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.nAvail, avail);
+    BOOST_CHECK_EQUAL(stats.nTracked, tracked);
+    BOOST_CHECK_EQUAL(stats.nGood, good);
+    BOOST_CHECK_EQUAL(stats.nNew, fresh);
+    BOOST_CHECK_EQUAL(stats.nBanned, banned);
+}
+
+struct SeederDbSetup {
+    SeederDbSetup() { SelectParams(CBaseChainParams::REGTEST); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(db_tests, SeederDbSetup)
+
+BOOST_AUTO_TEST_CASE(id_set) {
+    CAddrIdSet set;
+    BOOST_CHECK(set.empty());
+    BOOST_CHECK(!set.count(3));
+    BOOST_CHECK(!set.erase(3));
+
+    for (int id : {3, 0, 7, 5}) {
+        BOOST_CHECK(set.insert(id));
+    }
+    BOOST_CHECK(!set.insert(7));
+    BOOST_CHECK_EQUAL(set.size(), 4);
+    BOOST_CHECK_EQUAL(set.back(), 5);
+
+    BOOST_CHECK(set.erase(0));
+    BOOST_CHECK(!set.erase(0));
+    BOOST_CHECK(!set.count(0));
+    BOOST_CHECK_EQUAL(set.size(), 3);
+
+    const std::set<int> ids(set.begin(), set.end());
+    const std::set<int> expected{3, 5, 7};
+    BOOST_CHECK(ids == expected);
+    for (size_t i = 0; i < set.size(); i++) {
+        BOOST_CHECK(set.count(set[i]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(add_and_crawl) {
+    constexpr uint32_t NUM_ADDRS = 100;
+    CAddrDb db;
+
+    std::vector<CAddress> addrs;
+    for (uint32_t i = 0; i < NUM_ADDRS; i++) {
+        addrs.push_back(MakeAddress(i));
+    }
+    db.Add(addrs);
+    // Adding the same addresses again is a no-op.
+    db.Add(addrs);
+    CheckStats(db, NUM_ADDRS, 0, 0, NUM_ADDRS, 0);
+
+    std::vector<CServiceResult> ips;
+    int wait = 0;
+    db.GetMany(ips, NUM_ADDRS, wait);
+    BOOST_CHECK_EQUAL(ips.size(), NUM_ADDRS);
+
+    // Half of the nodes are good, a quarter is bad and the last quarter gets
+    // banned.
+    for (size_t i = 0; i < ips.size(); i++) {
+        ips[i].fGood = i % 2 == 0;
+        ips[i].nBanTime = i % 4 == 3 ? 3600 : 0;
+    }
+    db.ResultMany(ips);
+    CheckStats(db, 3 * NUM_ADDRS / 4, 3 * NUM_ADDRS / 4, NUM_ADDRS / 2, 0,
+               NUM_ADDRS / 4);
+
+    bool nets[NET_MAX] = {};
+    nets[NET_IPV4] = true;
+    std::set<CNetAddr> good;
+    db.GetIPs(good, NODE_NETWORK, 1000, nets);
+    BOOST_CHECK_EQUAL(good.size(), NUM_ADDRS / 4);
+    for (const CNetAddr &ip : good) {
+        bool found = false;
+        for (size_t i = 0; i < ips.size(); i += 2) {
+            found |= ips[i].service == ip;
+        }
+        BOOST_CHECK(found);
+    }
+
+    // Banned addresses are not added back, and their slots are reused for new
+    // ones.
+    db.Add(addrs);
+    std::vector<CAddress> newAddrs;
+    for (uint32_t i = NUM_ADDRS; i < NUM_ADDRS + 10; i++) {
+        newAddrs.push_back(MakeAddress(i));
+    }
+    db.Add(newAddrs);
+    CheckStats(db, 3 * NUM_ADDRS / 4 + 10, 3 * NUM_ADDRS / 4, NUM_ADDRS / 2,
+               10, NUM_ADDRS / 4);
+}
+
+BOOST_AUTO_TEST_CASE(serialization) {
+    constexpr uint32_t NUM_ADDRS = 40;
+    CAddrDb db;
+
+    std::vector<CAddress> addrs;
+    for (uint32_t i = 0; i < NUM_ADDRS; i++) {
+        addrs.push_back(MakeAddress(i));
+    }
+    db.Add(addrs);
+
+    std::vector<CServiceResult> ips;
+    int wait = 0;
+    db.GetMany(ips, NUM_ADDRS / 2, wait);
+    for (size_t i = 0; i < ips.size(); i++) {
+        ips[i].fGood = i % 2 == 0;
+        ips[i].nBanTime = 0;
+    }
+    db.ResultMany(ips);
+
+    CAddrDbStats before;
+    db.GetStats(before);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << db;
+    CAddrDb loaded;
+    ss >> loaded;
+    BOOST_CHECK(ss.empty());
+
+    CheckStats(loaded, before.nAvail, before.nTracked, before.nGood,
+               before.nNew, before.nBanned);
+    BOOST_CHECK_EQUAL(loaded.GetAll().size(), db.GetAll().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/dnscache.h>
+
+#include <netaddress.h>
+#include <random.h>
+#include <seeder/dns.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+static CNetAddr IPv4(uint32_t i) {
+    struct in_addr s;
+    s.s_addr = htonl(0x0a000000 | i);
+    return CNetAddr(s);
+}
+
+static CNetAddr IPv6(uint32_t i) {
+    struct in6_addr s = {};
+    s.s6_addr[0] = 0x20;
+    s.s6_addr[1] = 0x01;
+    s.s6_addr[12] = i >> 24;
+    s.s6_addr[13] = i >> 16;
+    s.s6_addr[14] = i >> 8;
+    s.s6_addr[15] = i;
+    return CNetAddr(s);
+}
+
+BOOST_AUTO_TEST_SUITE(dnscache_tests)
+
+BOOST_AUTO_TEST_CASE(build_answer_set) {
+    FastRandomContext rng(true);
+    std::set<CNetAddr> ips;
+    for (uint32_t i = 0; i < 10; i++) {
+        ips.insert(IPv4(i));
+    }
+    for (uint32_t i = 0; i < 5; i++) {
+        ips.insert(IPv6(i));
+    }
+
+    auto set = DnsAnswerSet::Build(ips, 3600, rng);
+    BOOST_CHECK_EQUAL(set->GetIPv4Count(), 10);
+    BOOST_CHECK_EQUAL(set->GetIPv6Count(), 5);
+
+    // The records are the ones the DNS server would write for the address.
+    std::set<std::vector<uint8_t>> expected;
+    for (uint32_t i = 0; i < 10; i++) {
+        addr_t a;
+        a.v = 4;
+        struct in_addr addr;
+        BOOST_CHECK(IPv4(i).GetInAddr(&addr));
+        memcpy(&a.data.v4, &addr, 4);
+
+        std::vector<uint8_t> record(DNS_A_RECORD_SIZE);
+        uint8_t *outpos = record.data();
+        BOOST_CHECK_EQUAL(write_record_addr(&outpos,
+                                            record.data() + record.size(),
+                                            3600, &a),
+                          0);
+        BOOST_CHECK(outpos == record.data() + record.size());
+        expected.insert(record);
+    }
+
+    std::set<std::vector<uint8_t>> records;
+    for (size_t i = 0; i < set->GetIPv4Count(); i++) {
+        auto begin = set->ipv4Records.begin() + i * DNS_A_RECORD_SIZE;
+        records.emplace(begin, begin + DNS_A_RECORD_SIZE);
+    }
+    BOOST_CHECK(records == expected);
+
+    // Name pointer to the question, type AAAA, class IN, TTL and length.
+    const uint8_t aaaaHeader[] = {0xc0, 0x0c, 0x00, 0x1c, 0x00, 0x01,
+                                  0x00, 0x00, 0x0e, 0x10, 0x00, 0x10};
+    for (size_t i = 0; i < set->GetIPv6Count(); i++) {
+        BOOST_CHECK(memcmp(set->ipv6Records.data() + i * DNS_AAAA_RECORD_SIZE,
+                           aaaaHeader, sizeof(aaaaHeader)) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write_answers) {
+    FastRandomContext rng(true);
+    std::set<CNetAddr> ips;
+    for (uint32_t i = 0; i < 40; i++) {
+        ips.insert(IPv4(i));
+    }
+    for (uint32_t i = 0; i < 20; i++) {
+        ips.insert(IPv6(i));
+    }
+
+    DnsAnswerCache cache;
+    DnsAnswerCache::Snapshot snapshot;
+    snapshot.emplace(0, DnsAnswerSet::Build(ips, 3600, rng));
+    snapshot.emplace(1, DnsAnswerSet::Build({}, 3600, rng));
+
+    std::vector<uint8_t> buf(1000);
+    uint8_t *outpos = buf.data();
+    const uint8_t *outend = buf.data() + buf.size();
+
+    // Nothing is published yet.
+    BOOST_CHECK(!cache.Get(0));
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(0, &outpos, outend, 32, true, true, rng), 0);
+    BOOST_CHECK(outpos == buf.data());
+
+    cache.Publish(snapshot);
+    BOOST_CHECK(cache.Get(0) == snapshot[0]);
+    BOOST_CHECK(!cache.Get(2));
+
+    // A only.
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(0, &outpos, outend, 32, true, false, rng), 32);
+    BOOST_CHECK(outpos == buf.data() + 32 * DNS_A_RECORD_SIZE);
+
+    // AAAA only, there are not enough addresses to fill the answer.
+    outpos = buf.data();
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(0, &outpos, outend, 32, false, true, rng), 20);
+    BOOST_CHECK(outpos == buf.data() + 20 * DNS_AAAA_RECORD_SIZE);
+
+    // Both, shared in proportion of the known addresses.
+    outpos = buf.data();
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(0, &outpos, outend, 30, true, true, rng), 30);
+    BOOST_CHECK(outpos == buf.data() + 20 * DNS_A_RECORD_SIZE +
+                              10 * DNS_AAAA_RECORD_SIZE);
+
+    // The answer is truncated to what fits in the buffer.
+    outpos = buf.data();
+    BOOST_CHECK_EQUAL(cache.WriteAnswers(0, &outpos,
+                                         buf.data() + 5 * DNS_A_RECORD_SIZE + 1,
+                                         32, true, false, rng),
+                      5);
+
+    // Unknown and empty filters get no answer.
+    outpos = buf.data();
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(1, &outpos, outend, 32, true, true, rng), 0);
+    BOOST_CHECK_EQUAL(
+        cache.WriteAnswers(2, &outpos, outend, 32, true, true, rng), 0);
+    BOOST_CHECK(outpos == buf.data());
+
+    // Readers keep the snapshot they got alive after a new one is published.
+    auto previous = cache.Get(0);
+    cache.Publish({});
+    BOOST_CHECK(!cache.Get(0));
+    BOOST_CHECK_EQUAL(previous->GetIPv4Count(), 40);
+}
+
+BOOST_AUTO_TEST_CASE(random_answers) {
+    FastRandomContext rng(true);
+    std::set<CNetAddr> ips;
+    for (uint32_t i = 0; i < 100; i++) {
+        ips.insert(IPv4(i));
+    }
+
+    DnsAnswerCache cache;
+    cache.Publish({{0, DnsAnswerSet::Build(ips, 3600, rng)}});
+
+    // Successive queries don't always get the same answer, and all the
+    // addresses get served.
+    std::set<std::vector<uint8_t>> served;
+    std::vector<uint8_t> buf(10 * DNS_A_RECORD_SIZE);
+    for (int i = 0; i < 100; i++) {
+        uint8_t *outpos = buf.data();
+        BOOST_CHECK_EQUAL(cache.WriteAnswers(0, &outpos,
+                                             buf.data() + buf.size(), 10, true,
+                                             false, rng),
+                          10);
+        for (size_t j = 0; j < 10; j++) {
+            auto begin = buf.begin() + j * DNS_A_RECORD_SIZE;
+            served.emplace(begin, begin + DNS_A_RECORD_SIZE);
+        }
+    }
+    BOOST_CHECK_EQUAL(served.size(), 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
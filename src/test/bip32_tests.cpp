@@ -154,4 +154,27 @@ BOOST_AUTO_TEST_CASE(bip32_test3) {
     RunTest(test3);
 }
 
+BOOST_AUTO_TEST_CASE(bip32_derive_batch) {
+    std::vector<uint8_t> seed = ParseHex(test1.strHexMaster);
+    CExtKey key;
+    key.SetSeed(seed.data(), seed.size());
+    const CExtPubKey pubkey = key.Neuter();
+
+    // Cover the non-hardened range up to its edge, with counts that do not
+    // line up with the number of children hashed at a time.
+    for (const unsigned int first : {0x0u, 0x5u, 0x7fffffb9u}) {
+        for (const size_t count : {0, 1, 7, 33, 71}) {
+            std::vector<CExtPubKey> pubkeys;
+            BOOST_CHECK(pubkey.DeriveBatch(pubkeys, first, count));
+            BOOST_CHECK_EQUAL(pubkeys.size(), count);
+
+            for (size_t i = 0; i < count; ++i) {
+                CExtKey expected;
+                BOOST_CHECK(key.Derive(expected, first + i));
+                BOOST_CHECK(pubkeys[i] == expected.Neuter());
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
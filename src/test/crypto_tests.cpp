@@ -1083,6 +1083,43 @@ BOOST_AUTO_TEST_CASE(sha256d64) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha512_batch) {
+    // Cover prefixes and messages that fit in a single block together and
+    // ones that do not.
+    for (const size_t prefix_len : {0, 5, 74, 128, 200}) {
+        for (const size_t len : {0, 1, 37, 64, 111, 112, 200}) {
+            for (size_t count = 0; count <= 20; ++count) {
+                // Never empty, so data() is a valid pointer.
+                std::vector<uint8_t> prefix(prefix_len + 1);
+                std::vector<uint8_t> in(len * count + 1);
+                for (uint8_t &c : prefix) {
+                    c = InsecureRandBits(8);
+                }
+                for (uint8_t &c : in) {
+                    c = InsecureRandBits(8);
+                }
+
+                CSHA512 sha;
+                sha.Write(prefix.data(), prefix_len);
+                CHMAC_SHA512 hmac(prefix.data(), prefix_len);
+                std::vector<uint8_t> sha1(64 * count), sha2(64 * count);
+                std::vector<uint8_t> hmac1(64 * count), hmac2(64 * count);
+                for (size_t i = 0; i < count; ++i) {
+                    const uint8_t *msg = in.data() + len * i;
+                    CSHA512(sha).Write(msg, len).Finalize(sha1.data() + 64 * i);
+                    CHMAC_SHA512(hmac).Write(msg, len).Finalize(hmac1.data() +
+                                                                64 * i);
+                }
+
+                sha.FinalizeBatch(sha2.data(), in.data(), len, count);
+                hmac.FinalizeBatch(hmac2.data(), in.data(), len, count);
+                BOOST_CHECK(sha1 == sha2);
+                BOOST_CHECK(hmac1 == hmac2);
+            }
+        }
+    }
+}
+
 static void TestSHA3_256(const std::string &input, const std::string &output) {
     const auto in_bytes = ParseHex(input);
     const auto out_bytes = ParseHex(output);
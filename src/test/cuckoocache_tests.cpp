@@ -24,6 +24,9 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
+#include <algorithm>
+#include <vector>
+
 /**
  * Test Suite for CuckooCache
  *
@@ -535,4 +538,36 @@ BOOST_AUTO_TEST_CASE(cuckoocache_map) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(cuckoocache_for_each) {
+    SeedInsecureRand(SeedRand::ZEROS);
+
+    // 1MB cache, large enough that nothing gets evicted.
+    CuckooCacheMap cm{};
+    cm.setup_bytes(1 << 20);
+
+    std::vector<TestMapElement> elements;
+    for (int x = 0; x < 1000; ++x) {
+        elements.emplace_back(InsecureRand256());
+        cm.insert(elements.back());
+    }
+
+    // Erase every other element, they must not be visited anymore.
+    for (size_t i = 0; i < elements.size(); i += 2) {
+        BOOST_CHECK(cm.contains(elements[i].getKey(), true));
+    }
+
+    size_t visited = 0;
+    cm.for_each([&](const TestMapElement &e) {
+        ++visited;
+        auto it = std::find_if(elements.begin(), elements.end(),
+                               [&](const TestMapElement &x) {
+                                   return x.getKey() == e.getKey();
+                               });
+        BOOST_CHECK(it != elements.end());
+        BOOST_CHECK((it - elements.begin()) % 2 == 1);
+        BOOST_CHECK_EQUAL(it->getValue(), e.getValue());
+    });
+    BOOST_CHECK_EQUAL(visited, elements.size() / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -927,4 +927,52 @@ BOOST_AUTO_TEST_CASE(descriptor_test) {
     CheckUnparsable("", "raw(Ü)#00000000", "Invalid characters in payload");
 }
 
+BOOST_AUTO_TEST_CASE(descriptor_cache_derived_range) {
+    // A ranged key next to a fixed one, both cached as parent xpubs.
+    FlatSigningProvider keys;
+    std::string error;
+    const auto desc = Parse(
+        "sh(multi(1,"
+        "xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4ko"
+        "xb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/1/*,"
+        "xpub68NZiKmJWnxxS6aaHmn81bvJeTESw724CRDs6HbuccFQN9Ku14VQrADWgqbhhTHBao"
+        "hPX4CjNLf9fq9MYo6oDaPPLPxSb7gwQN3ih19Zm4Y/0))",
+        keys, error);
+    BOOST_REQUIRE(desc);
+
+    DescriptorCache cache;
+    std::vector<CScript> scripts;
+    FlatSigningProvider out;
+    BOOST_REQUIRE(desc->Expand(0, keys, scripts, out, &cache));
+
+    DescriptorCache range_cache;
+    for (const auto &parent : cache.GetCachedParentExtPubKeys()) {
+        range_cache.CacheParentExtPubKey(parent.first, parent.second);
+    }
+    desc->CacheDerivedExtPubKeys(1, 70, range_cache);
+    const auto derived = range_cache.GetCachedDerivedExtPubKeys();
+    BOOST_CHECK_EQUAL(derived.size(), 1);
+    BOOST_CHECK_EQUAL(derived.at(0).size(), 70);
+
+    for (int pos = 1; pos <= 70; ++pos) {
+        std::vector<CScript> expected, cached;
+        FlatSigningProvider expected_out, cached_out;
+        BOOST_CHECK(desc->Expand(pos, keys, expected, expected_out));
+        BOOST_CHECK(
+            desc->ExpandFromCache(pos, range_cache, cached, cached_out));
+        BOOST_CHECK(cached == expected);
+        BOOST_CHECK(cached_out.pubkeys == expected_out.pubkeys);
+    }
+
+    // Hardened children can't be derived from a public parent.
+    const auto hardened = Parse(
+        "pkh("
+        "xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4ko"
+        "xb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/*')",
+        keys, error);
+    BOOST_REQUIRE(hardened);
+    hardened->CacheDerivedExtPubKeys(0, 10, range_cache);
+    BOOST_CHECK_EQUAL(range_cache.GetCachedDerivedExtPubKeys().size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hash.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+
+#include <cassert>
+#include <numeric>
+#include <vector>
+
+/**
+ * Signature checker whose result depends on every byte it is given, so that
+ * a difference in the scriptCode passed by the fast path is detected.
+ */
+class FuzzedSignatureChecker : public BaseSignatureChecker {
+    static uint32_t Sum(const std::vector<uint8_t> &v, uint32_t init) {
+        return std::accumulate(v.begin(), v.end(), init);
+    }
+
+public:
+    bool CheckSig(const std::vector<uint8_t> &vchSigIn,
+                  const std::vector<uint8_t> &vchPubKey,
+                  const CScript &scriptCode, uint32_t flags) const override {
+        const std::vector<uint8_t> code(scriptCode.begin(), scriptCode.end());
+        return (Sum(code, Sum(vchPubKey, Sum(vchSigIn, flags))) & 1) != 0;
+    }
+};
+
+static bool CastToBool(const std::vector<uint8_t> &vch) {
+    for (size_t i = 0; i < vch.size(); i++) {
+        if (vch[i] != 0) {
+            return i != vch.size() - 1 || vch[i] != 0x80;
+        }
+    }
+    return false;
+}
+
+/**
+ * Mirror of VerifyScript for non P2SH outputs, always going through the
+ * generic interpreter.
+ */
+static bool GenericVerifyScript(const CScript &scriptSig,
+                                const CScript &scriptPubKey, uint32_t flags,
+                                const BaseSignatureChecker &checker,
+                                ScriptExecutionMetrics &metricsOut,
+                                ScriptError &serror) {
+    if (flags & SCRIPT_ENABLE_SIGHASH_FORKID) {
+        flags |= SCRIPT_VERIFY_STRICTENC;
+    }
+    if ((flags & SCRIPT_VERIFY_SIGPUSHONLY) && !scriptSig.IsPushOnly()) {
+        serror = ScriptError::SIG_PUSHONLY;
+        return false;
+    }
+
+    ScriptExecutionMetrics metrics = {};
+    std::vector<std::vector<uint8_t>> stack;
+    if (!EvalScript(stack, scriptSig, flags, checker, metrics, &serror) ||
+        !EvalScript(stack, scriptPubKey, flags, checker, metrics, &serror)) {
+        return false;
+    }
+    if (stack.empty() || !CastToBool(stack.back())) {
+        serror = ScriptError::EVAL_FALSE;
+        return false;
+    }
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) && stack.size() != 1) {
+        serror = ScriptError::CLEANSTACK;
+        return false;
+    }
+    if ((flags & SCRIPT_VERIFY_INPUT_SIGCHECKS) &&
+        int(scriptSig.size()) < metrics.nSigChecks * 43 - 60) {
+        serror = ScriptError::INPUT_SIGCHECKS;
+        return false;
+    }
+
+    metricsOut = metrics;
+    serror = ScriptError::OK;
+    return true;
+}
+
+void initialize() {
+    static const ECCVerifyHandle verify_handle;
+}
+
+void test_one_input(const std::vector<uint8_t> &buffer) {
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+
+    uint32_t flags = fuzzed_data_provider.ConsumeIntegral<uint32_t>();
+    if (flags & SCRIPT_VERIFY_CLEANSTACK) {
+        // CLEANSTACK without P2SH is forbidden by an assert.
+        flags |= SCRIPT_VERIFY_P2SH;
+    }
+
+    const std::vector<uint8_t> sig =
+        fuzzed_data_provider.ConsumeBytes<uint8_t>(
+            fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 80));
+    const std::vector<uint8_t> pubkey =
+        fuzzed_data_provider.ConsumeBytes<uint8_t>(
+            fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 80));
+
+    // Most of the time, commit to the pubkey actually provided so the
+    // signature check is reached.
+    uint160 pubKeyHash = Hash160(pubkey);
+    if (fuzzed_data_provider.ConsumeBool()) {
+        const std::vector<uint8_t> hash =
+            fuzzed_data_provider.ConsumeBytes<uint8_t>(20);
+        std::copy(hash.begin(), hash.end(), pubKeyHash.begin());
+    }
+
+    CScript scriptSig;
+    scriptSig << sig << pubkey;
+    if (fuzzed_data_provider.ConsumeBool()) {
+        // Arbitrary trailing data, including opcodes, to exercise the
+        // template matching.
+        const std::vector<uint8_t> extra =
+            fuzzed_data_provider.ConsumeRemainingBytes<uint8_t>();
+        scriptSig.insert(scriptSig.end(), extra.begin(), extra.end());
+    }
+    const CScript scriptPubKey = CScript() << OP_DUP << OP_HASH160
+                                           << ToByteVector(pubKeyHash)
+                                           << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    const FuzzedSignatureChecker checker;
+
+    ScriptExecutionMetrics metrics = {}, genericMetrics = {};
+    ScriptError serror, genericError;
+    const bool ret = VerifyScript(scriptSig, scriptPubKey, flags, checker,
+                                  metrics, &serror);
+    const bool genericRet = GenericVerifyScript(
+        scriptSig, scriptPubKey, flags, checker, genericMetrics, genericError);
+
+    assert(ret == genericRet);
+    assert(serror == genericError);
+    assert(metrics.nSigChecks == genericMetrics.nSigChecks);
+}
@@ -17,9 +17,11 @@
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <index/blockfilterindex.h>
 #include <interfaces/chain.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
+#include <util/time.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -190,4 +192,50 @@ BOOST_AUTO_TEST_CASE(hasBlocks) {
     BOOST_CHECK(!chain->hasBlocks(active.Tip()->GetBlockHash(), 6, 50));
 }
 
+BOOST_AUTO_TEST_CASE(blockFilterMatchesAny) {
+    auto chain = interfaces::MakeChain(m_node, Params());
+    auto &active = ChainActive();
+    const BlockHash hash = active[50]->GetBlockHash();
+
+    const CScript coinbase_script = CScript()
+                                    << ToByteVector(coinbaseKey.GetPubKey())
+                                    << OP_CHECKSIG;
+    const CScript other_script = CScript() << OP_TRUE;
+    const GCSFilter::ElementSet ours{
+        {coinbase_script.begin(), coinbase_script.end()}};
+    const GCSFilter::ElementSet theirs{
+        {other_script.begin(), other_script.end()}};
+
+    // No answer without an index.
+    BOOST_CHECK(!chain->hasBlockFilterIndex(BlockFilterType::BASIC));
+    BOOST_CHECK(!chain->blockFilterMatchesAny(BlockFilterType::BASIC, hash,
+                                              ours));
+
+    BOOST_REQUIRE(
+        InitBlockFilterIndex(BlockFilterType::BASIC, 1 << 20, true, false));
+    BlockFilterIndex &filter_index =
+        *GetBlockFilterIndex(BlockFilterType::BASIC);
+    BOOST_CHECK(chain->hasBlockFilterIndex(BlockFilterType::BASIC));
+
+    filter_index.Start();
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    // All the blocks pay to the coinbase key.
+    BOOST_CHECK(chain->blockFilterMatchesAny(BlockFilterType::BASIC, hash,
+                                             ours) == std::optional{true});
+    BOOST_CHECK(chain->blockFilterMatchesAny(BlockFilterType::BASIC, hash,
+                                             theirs) == std::optional{false});
+
+    // Unknown blocks have no filter.
+    BOOST_CHECK(!chain->blockFilterMatchesAny(BlockFilterType::BASIC,
+                                              BlockHash(), ours));
+
+    DestroyAllBlockFilterIndexes();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,16 +18,23 @@
 
 #include <script/sigcache.h>
 
+#include <clientversion.h>
+#include <crypto/sha256.h>
+#include <fs.h>
 #include <key.h>
 #include <key_io.h>
+#include <script/scriptcache.h>
 #include <streams.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
+#include <util/system.h>
+#include <validation.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -58,6 +65,11 @@ public:
                          const CPubKey &pubkey, const uint256 &sighash) {
         return pchecker->IsCached(vchSig, pubkey, sighash);
     }
+
+    inline uint256 GetSignatureHash(const CScript &scriptCode,
+                                    SigHashType sigHashType, uint32_t flags) {
+        return pchecker->GetSignatureHash(scriptCode, sigHashType, flags);
+    }
 };
 
 BOOST_FIXTURE_TEST_SUITE(sigcache_tests, BasicTestingSetup)
@@ -127,4 +139,192 @@ BOOST_AUTO_TEST_CASE(sig_pubkey_hash_variations) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(sighash_memo) {
+    CDataStream stream(
+        ParseHex(
+            "010000000122739e70fbee987a8be1788395a2f2e6ad18ccb7ff611cd798071539"
+            "dde3c38e000000000151ffffffff010000000000000000016a00000000"),
+        SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction dummyTx(deserialize, stream);
+    PrecomputedTransactionData txdata(dummyTx);
+    CachingTransactionSignatureChecker checker(&dummyTx, 0, 1 * SATOSHI, true,
+                                               txdata);
+    TestCachingTransactionSignatureChecker testChecker(checker);
+
+    // More combinations than the memo holds, each requested several times in
+    // a row and interleaved, must give the same hashes as SignatureHash.
+    const std::vector<CScript> scriptCodes{CScript(), CScript() << OP_1,
+                                           CScript() << OP_2 << OP_CHECKSIG};
+    const std::vector<SigHashType> sigHashTypes{
+        SigHashType().withForkId(),
+        SigHashType().withForkId().withAnyoneCanPay(),
+        SigHashType(SIGHASH_SINGLE).withForkId(), SigHashType()};
+    const std::vector<uint32_t> flagsList{
+        SCRIPT_ENABLE_SIGHASH_FORKID,
+        SCRIPT_ENABLE_SIGHASH_FORKID | SCRIPT_ENABLE_REPLAY_PROTECTION,
+        SCRIPT_ENABLE_SIGHASH_FORKID | SCRIPT_VERIFY_P2SH};
+    for (int round = 0; round < 3; ++round) {
+        for (const CScript &scriptCode : scriptCodes) {
+            for (const SigHashType &sigHashType : sigHashTypes) {
+                for (const uint32_t flags : flagsList) {
+                    const uint256 expected =
+                        SignatureHash(scriptCode, dummyTx, 0, sigHashType,
+                                      1 * SATOSHI, nullptr, flags);
+                    BOOST_CHECK(testChecker.GetSignatureHash(
+                                    scriptCode, sigHashType, flags) ==
+                                expected);
+                    BOOST_CHECK(testChecker.GetSignatureHash(
+                                    scriptCode, sigHashType, flags) ==
+                                expected);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(schnorr_sig_cache) {
+    CDataStream stream(
+        ParseHex(
+            "010000000122739e70fbee987a8be1788395a2f2e6ad18ccb7ff611cd798071539"
+            "dde3c38e000000000151ffffffff010000000000000000016a00000000"),
+        SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction dummyTx(deserialize, stream);
+    PrecomputedTransactionData txdata(dummyTx);
+    CachingTransactionSignatureChecker checker(&dummyTx, 0, 0 * SATOSHI, true,
+                                               txdata);
+    TestCachingTransactionSignatureChecker testChecker(checker);
+
+    CKey key = DecodeSecret(strSecret1C);
+    CPubKey pubkey = key.GetPubKey();
+
+    for (int n = 0; n < 16; n++) {
+        const uint256 hash = Hash(strprintf("Sigcache schnorr %i", n));
+        const uint256 hash2 = Hash(strprintf("Sigcache schnorr %i bis", n));
+
+        SchnorrSig sig;
+        BOOST_CHECK(key.SignSchnorr(hash, sig));
+        const std::vector<uint8_t> vchSig(sig.begin(), sig.end());
+
+        // Signatures are only cached when the caller adds them.
+        BOOST_CHECK(!IsSchnorrSignatureCached(pubkey, hash, sig));
+        AddSchnorrSignatureToCache(pubkey, hash, sig);
+        BOOST_CHECK(IsSchnorrSignatureCached(pubkey, hash, sig));
+        BOOST_CHECK(!IsSchnorrSignatureCached(pubkey, hash2, sig));
+
+        // They are kept apart from the script signatures.
+        BOOST_CHECK(!testChecker.IsCached(vchSig, pubkey, hash));
+
+        // A modified signature is not found.
+        sig[0] ^= 1;
+        BOOST_CHECK(!IsSchnorrSignatureCached(pubkey, hash, sig));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sig_cache_persistence) {
+    CDataStream stream(
+        ParseHex(
+            "010000000122739e70fbee987a8be1788395a2f2e6ad18ccb7ff611cd798071539"
+            "dde3c38e000000000151ffffffff010000000000000000016a00000000"),
+        SER_NETWORK, PROTOCOL_VERSION);
+    CTransaction dummyTx(deserialize, stream);
+    PrecomputedTransactionData txdata(dummyTx);
+    CachingTransactionSignatureChecker checker(&dummyTx, 0, 0 * SATOSHI, true,
+                                               txdata);
+    TestCachingTransactionSignatureChecker testChecker(checker);
+
+    CKey key = DecodeSecret(strSecret1C);
+    CPubKey pubkey = key.GetPubKey();
+
+    const uint256 hash = Hash(std::string("Sigcache persistence"));
+    const uint256 hash2 = Hash(std::string("Sigcache persistence bis"));
+    std::vector<uint8_t> sig, sig2;
+    BOOST_CHECK(key.SignECDSA(hash, sig));
+    BOOST_CHECK(key.SignECDSA(hash2, sig2));
+
+    BOOST_CHECK(testChecker.VerifyAndStore(sig, pubkey, hash));
+    BOOST_CHECK(DumpSignatureCache());
+
+    // The file holds the nonce and the salted entries.
+    const fs::path path = GetDataDir() / "sigcache.dat";
+    uint256 nonce;
+    std::vector<uint256> entries;
+    {
+        CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        uint64_t version;
+        file >> version >> nonce >> entries;
+        BOOST_CHECK_EQUAL(version, 1);
+    }
+
+    auto computeEntry = [](const uint256 &n, const uint256 &h,
+                           const CPubKey &pk, const std::vector<uint8_t> &vch) {
+        uint256 entry;
+        CSHA256()
+            .Write(n.begin(), 32)
+            .Write(n.begin(), 32)
+            .Write(h.begin(), 32)
+            .Write(pk.data(), pk.size())
+            .Write(vch.data(), vch.size())
+            .Finalize(entry.begin());
+        return entry;
+    };
+    BOOST_CHECK(std::count(entries.begin(), entries.end(),
+                           computeEntry(nonce, hash, pubkey, sig)) == 1);
+
+    // Loading a cache saved under another nonce makes its entries visible and
+    // the ones computed under the previous nonce unreachable.
+    const uint256 otherNonce = InsecureRand256();
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        file << uint64_t(1) << otherNonce
+             << std::vector<uint256>{
+                    computeEntry(otherNonce, hash2, pubkey, sig2)};
+    }
+    BOOST_CHECK(LoadSignatureCache());
+    BOOST_CHECK(testChecker.IsCached(sig2, pubkey, hash2));
+    BOOST_CHECK(!testChecker.IsCached(sig, pubkey, hash));
+
+    // An unknown version is ignored.
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        file << uint64_t(2) << nonce << entries;
+    }
+    BOOST_CHECK(!LoadSignatureCache());
+    BOOST_CHECK(!testChecker.IsCached(sig, pubkey, hash));
+
+    // Reloading the original dump restores the original entries.
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        file << uint64_t(1) << nonce << entries;
+    }
+    BOOST_CHECK(LoadSignatureCache());
+    BOOST_CHECK(testChecker.IsCached(sig, pubkey, hash));
+}
+
+BOOST_AUTO_TEST_CASE(script_cache_persistence) {
+    LOCK(cs_main);
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vout.resize(1);
+    const CTransaction tx(mtx);
+    const uint32_t flags = SCRIPT_VERIFY_P2SH | SCRIPT_ENABLE_SIGHASH_FORKID;
+
+    int nSigChecks = 0;
+    AddKeyInScriptCache(ScriptCacheKey(tx, flags), 42);
+    BOOST_CHECK(DumpScriptExecutionCache());
+
+    // Start over with a fresh cache and nonce, the entry is gone.
+    InitScriptExecutionCache();
+    BOOST_CHECK(
+        !IsKeyInScriptCache(ScriptCacheKey(tx, flags), false, nSigChecks));
+
+    // It is back once the dump is loaded, with its nonce and value.
+    BOOST_CHECK(LoadScriptExecutionCache());
+    BOOST_CHECK(
+        IsKeyInScriptCache(ScriptCacheKey(tx, flags), false, nSigChecks));
+    BOOST_CHECK_EQUAL(nSigChecks, 42);
+    BOOST_CHECK(!IsKeyInScriptCache(ScriptCacheKey(tx, SCRIPT_VERIFY_P2SH),
+                                    false, nSigChecks));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -199,6 +199,19 @@ BOOST_AUTO_TEST_CASE(sighash_test) {
                           sigHashType.withForkValue(0xff1342), Amount::zero());
         BOOST_CHECK(shrepabcdef == manualshrepabcdef);
 
+        // Precomputed transaction data must not change the result.
+        const CTransaction tx(txTo);
+        const PrecomputedTransactionData txdata(tx);
+        // The shared midstate is only worth computing for several inputs.
+        BOOST_CHECK_EQUAL(txdata.sighashPrefixReady, tx.vin.size() > 1);
+        BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, sigHashType,
+                                  Amount::zero(), &txdata) == shreg);
+        BOOST_CHECK(SignatureHash(scriptCode, tx, nIn, sigHashType,
+                                  Amount::zero(), &txdata,
+                                  SCRIPT_ENABLE_SIGHASH_FORKID |
+                                      SCRIPT_ENABLE_REPLAY_PROTECTION) ==
+                    shrep);
+
 #if defined(PRINT_SIGHASH_JSON)
         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
         ss << txTo;
@@ -0,0 +1,455 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txreconciliation.h>
+
+#include <protocol.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
+
+namespace {
+
+constexpr NodeId INITIATOR_PEER = 0;
+constexpr NodeId RESPONDER_PEER = 1;
+/** Size of an inv entry on the wire: 4 bytes type and 32 bytes hash. */
+constexpr size_t INV_ENTRY_SIZE = 36;
+
+std::vector<TxId> RandomTxIds(size_t count) {
+    std::vector<TxId> txids;
+    for (size_t i = 0; i < count; ++i) {
+        txids.emplace_back(InsecureRand256());
+    }
+    return txids;
+}
+
+/**
+ * Connect two trackers as the initiator and the responder of a reconciliation
+ * session, as seen from each side.
+ */
+void RegisterPair(TxReconciliationTracker &initiator,
+                  TxReconciliationTracker &responder) {
+    const uint64_t initiator_salt = initiator.PreRegisterPeer(RESPONDER_PEER);
+    const uint64_t responder_salt = responder.PreRegisterPeer(INITIATOR_PEER);
+    BOOST_CHECK(initiator.RegisterPeer(RESPONDER_PEER, true,
+                                       TXRECONCILIATION_VERSION,
+                                       responder_salt));
+    BOOST_CHECK(responder.RegisterPeer(INITIATOR_PEER, false,
+                                       TXRECONCILIATION_VERSION,
+                                       initiator_salt));
+}
+
+struct RoundResult {
+    bool success{false};
+    std::set<TxId> announced_by_initiator;
+    std::set<TxId> announced_by_responder;
+    size_t bytes{0};
+};
+
+/** Run a full reconciliation round through serialized messages. */
+RoundResult RunRound(TxReconciliationTracker &initiator,
+                     TxReconciliationTracker &responder,
+                     const std::function<void()> &after_request = {}) {
+    RoundResult result;
+
+    auto request = initiator.MaybeRequestReconciliation(
+        RESPONDER_PEER, GetTime<std::chrono::microseconds>());
+    BOOST_REQUIRE(request);
+    CDataStream reqrecon(SER_NETWORK, PROTOCOL_VERSION);
+    reqrecon << request->set_size << request->round;
+    result.bytes += reqrecon.size();
+    if (after_request) {
+        after_request();
+    }
+
+    uint16_t peer_set_size;
+    uint32_t round;
+    reqrecon >> peer_set_size >> round;
+    ReconciliationSketch sketch;
+    std::vector<TxId> to_announce;
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(
+        INITIATOR_PEER, peer_set_size, sketch, to_announce));
+    BOOST_CHECK(to_announce.empty());
+    CDataStream sketch_msg(SER_NETWORK, PROTOCOL_VERSION);
+    sketch_msg << round << sketch;
+    result.bytes += sketch_msg.size();
+
+    uint32_t received_round;
+    ReconciliationSketch received;
+    sketch_msg >> received_round >> received;
+    std::vector<uint32_t> to_request;
+    BOOST_REQUIRE(initiator.HandleSketch(RESPONDER_PEER, received_round,
+                                         received, result.success,
+                                         to_announce, to_request));
+    result.announced_by_initiator.insert(to_announce.begin(),
+                                         to_announce.end());
+    CDataStream diff_msg(SER_NETWORK, PROTOCOL_VERSION);
+    diff_msg << result.success << to_request;
+    result.bytes += diff_msg.size();
+
+    bool success;
+    std::vector<uint32_t> requested;
+    diff_msg >> success >> requested;
+    BOOST_REQUIRE(responder.HandleReconciliationDifference(
+        INITIATOR_PEER, success, requested, to_announce));
+    result.announced_by_responder.insert(to_announce.begin(),
+                                         to_announce.end());
+
+    result.bytes += INV_ENTRY_SIZE * (result.announced_by_initiator.size() +
+                                      result.announced_by_responder.size());
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(sketch_decode) {
+    SeedInsecureRand(SeedRand::ZEROS);
+    for (const size_t diff : {0, 1, 5, 20, 100, 500}) {
+        int successes = 0;
+        for (int round = 0; round < 50; ++round) {
+            ReconciliationSketch ours(
+                ReconciliationSketch::CellsForCapacity(diff));
+            ReconciliationSketch theirs(ours.GetCells());
+
+            // Common elements cancel out.
+            for (int i = 0; i < 200; ++i) {
+                const uint32_t shortid = InsecureRand32();
+                ours.Add(shortid);
+                theirs.Add(shortid);
+            }
+
+            std::set<uint32_t> expected_ours, expected_theirs;
+            for (size_t i = 0; i < diff; ++i) {
+                const uint32_t shortid = InsecureRand32();
+                if (InsecureRandBool()) {
+                    ours.Add(shortid);
+                    expected_ours.insert(shortid);
+                } else {
+                    theirs.Add(shortid);
+                    expected_theirs.insert(shortid);
+                }
+            }
+
+            BOOST_CHECK(ours.Subtract(theirs));
+            std::vector<uint32_t> decoded_ours, decoded_theirs;
+            if (!ours.Decode(decoded_ours, decoded_theirs)) {
+                continue;
+            }
+
+            ++successes;
+            BOOST_CHECK(std::set<uint32_t>(decoded_ours.begin(),
+                                           decoded_ours.end()) ==
+                        expected_ours);
+            BOOST_CHECK(std::set<uint32_t>(decoded_theirs.begin(),
+                                           decoded_theirs.end()) ==
+                        expected_theirs);
+        }
+        // The decoding is probabilistic, but fails in about 1% of the cases
+        // at the nominal capacity.
+        BOOST_CHECK_GE(successes, 48);
+    }
+
+    // Sketches of different sizes can't be combined.
+    ReconciliationSketch small(ReconciliationSketch::CellsForCapacity(1));
+    ReconciliationSketch large(ReconciliationSketch::CellsForCapacity(100));
+    BOOST_CHECK(!small.Subtract(large));
+
+    // Decoding garbage fails without looping forever.
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    WriteCompactSize(ss, 300);
+    for (int i = 0; i < 300; ++i) {
+        ss << int32_t(InsecureRandRange(3)) - 1 << InsecureRand32()
+           << InsecureRand32();
+    }
+    ReconciliationSketch garbage;
+    ss >> garbage;
+    BOOST_CHECK(garbage.IsValid());
+    std::vector<uint32_t> decoded_ours, decoded_theirs;
+    BOOST_CHECK(!garbage.Decode(decoded_ours, decoded_theirs));
+
+    // Extreme counts wrap around when subtracted instead of overflowing.
+    ss.clear();
+    WriteCompactSize(ss, 300);
+    for (int i = 0; i < 300; ++i) {
+        ss << (i % 2 ? std::numeric_limits<int32_t>::min()
+                     : std::numeric_limits<int32_t>::max())
+           << InsecureRand32() << InsecureRand32();
+    }
+    ss >> garbage;
+    BOOST_CHECK(garbage.IsValid());
+    ReconciliationSketch difference(garbage.GetCells());
+    difference.Add(InsecureRand32());
+    BOOST_CHECK(difference.Subtract(garbage));
+    BOOST_CHECK(!difference.Decode(decoded_ours, decoded_theirs));
+
+    // Oversized or misshapen sketches are rejected.
+    BOOST_CHECK(!ReconciliationSketch(MAX_SKETCH_CELLS + 3).IsValid());
+    ss.clear();
+    WriteCompactSize(ss, 2);
+    ss << int32_t(0) << uint32_t(0) << uint32_t(0) << int32_t(0)
+       << uint32_t(0) << uint32_t(0);
+    ss >> garbage;
+    BOOST_CHECK(!garbage.IsValid());
+    BOOST_CHECK(!ReconciliationSketch().IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(register_peer) {
+    TxReconciliationTracker tracker;
+
+    // Registration requires our own salt to have been sent first.
+    BOOST_CHECK(!tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION, 1));
+    BOOST_CHECK(!tracker.IsPeerRegistered(0));
+
+    tracker.PreRegisterPeer(0);
+    BOOST_CHECK(!tracker.RegisterPeer(0, true, 0, 1));
+    BOOST_CHECK(!tracker.IsPeerRegistered(0));
+    tracker.PreRegisterPeer(0);
+    BOOST_CHECK(tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION, 1));
+    BOOST_CHECK(tracker.IsPeerRegistered(0));
+    BOOST_CHECK(!tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION, 1));
+
+    const TxId txid{InsecureRand256()};
+    BOOST_CHECK(!tracker.AddToSet(1, txid));
+    BOOST_CHECK(tracker.AddToSet(0, txid));
+    BOOST_CHECK_EQUAL(tracker.GetSetSize(0), 1);
+    tracker.TryRemovingFromSet(0, txid);
+    BOOST_CHECK_EQUAL(tracker.GetSetSize(0), 0);
+
+    // The set is bounded, the overflow is meant to be flooded.
+    for (const TxId &id : RandomTxIds(MAX_RECON_SET_SIZE)) {
+        BOOST_CHECK(tracker.AddToSet(0, id));
+    }
+    BOOST_CHECK(!tracker.AddToSet(0, TxId{InsecureRand256()}));
+
+    tracker.ForgetPeer(0);
+    BOOST_CHECK(!tracker.IsPeerRegistered(0));
+    BOOST_CHECK_EQUAL(tracker.GetSetSize(0), 0);
+}
+
+BOOST_AUTO_TEST_CASE(fanout) {
+    const auto txids = RandomTxIds(10000);
+
+    TxReconciliationTracker never(0);
+    TxReconciliationTracker always(100);
+    TxReconciliationTracker some(10);
+    size_t flooded = 0;
+    for (const TxId &txid : txids) {
+        BOOST_CHECK(!never.ShouldFloodTo(txid, 0));
+        BOOST_CHECK(always.ShouldFloodTo(txid, 0));
+        flooded += some.ShouldFloodTo(txid, 0);
+        // The decision is stable.
+        BOOST_CHECK_EQUAL(some.ShouldFloodTo(txid, 1),
+                          some.ShouldFloodTo(txid, 1));
+    }
+    BOOST_CHECK_GT(flooded, 800);
+    BOOST_CHECK_LT(flooded, 1200);
+}
+
+BOOST_AUTO_TEST_CASE(reconciliation_round) {
+    TxReconciliationTracker initiator;
+    TxReconciliationTracker responder;
+    RegisterPair(initiator, responder);
+
+    // Both sides have most transactions in common, as they would have
+    // received them from other peers.
+    const auto common = RandomTxIds(300);
+    const auto initiator_only = RandomTxIds(10);
+    const auto responder_only = RandomTxIds(15);
+    for (const TxId &txid : common) {
+        BOOST_CHECK(initiator.AddToSet(RESPONDER_PEER, txid));
+        BOOST_CHECK(responder.AddToSet(INITIATOR_PEER, txid));
+    }
+    for (const TxId &txid : initiator_only) {
+        BOOST_CHECK(initiator.AddToSet(RESPONDER_PEER, txid));
+    }
+    for (const TxId &txid : responder_only) {
+        BOOST_CHECK(responder.AddToSet(INITIATOR_PEER, txid));
+    }
+
+    // Only the initiator requests reconciliations, and one at a time.
+    BOOST_CHECK(!responder.MaybeRequestReconciliation(
+        INITIATOR_PEER, GetTime<std::chrono::microseconds>()));
+
+    RoundResult result = RunRound(initiator, responder);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(result.announced_by_initiator ==
+                std::set<TxId>(initiator_only.begin(), initiator_only.end()));
+    BOOST_CHECK(result.announced_by_responder ==
+                std::set<TxId>(responder_only.begin(), responder_only.end()));
+    BOOST_CHECK_EQUAL(initiator.GetSetSize(RESPONDER_PEER), 0);
+    BOOST_CHECK_EQUAL(responder.GetSetSize(INITIATOR_PEER), 0);
+
+    // Flooding would have announced every transaction in both directions.
+    const size_t flooding_bytes =
+        INV_ENTRY_SIZE * (2 * common.size() + initiator_only.size() +
+                          responder_only.size());
+    BOOST_CHECK_LT(result.bytes * 5, flooding_bytes);
+
+    // The next round has to wait.
+    BOOST_CHECK(!initiator.MaybeRequestReconciliation(
+        RESPONDER_PEER, GetTime<std::chrono::microseconds>()));
+
+    // Unexpected messages are rejected.
+    ReconciliationSketch sketch;
+    bool success;
+    std::vector<TxId> txids;
+    std::vector<uint32_t> shortids;
+    BOOST_CHECK(!initiator.HandleSketch(RESPONDER_PEER, 1, sketch, success,
+                                        txids, shortids));
+    BOOST_CHECK(!initiator.HandleReconciliationRequest(RESPONDER_PEER, 0,
+                                                       sketch, txids));
+    BOOST_CHECK(!responder.HandleReconciliationDifference(INITIATOR_PEER, true,
+                                                          shortids, txids));
+}
+
+BOOST_AUTO_TEST_CASE(reconciliation_failure) {
+    TxReconciliationTracker initiator;
+    TxReconciliationTracker responder;
+    RegisterPair(initiator, responder);
+
+    const auto initiator_txs = RandomTxIds(500);
+    const auto responder_txs = RandomTxIds(500);
+    for (const TxId &txid : responder_txs) {
+        BOOST_CHECK(responder.AddToSet(INITIATOR_PEER, txid));
+    }
+
+    // The initiator set grows after the request, so the sketch is too small
+    // and both sides fall back to announcing everything.
+    RoundResult result = RunRound(initiator, responder, [&] {
+        for (const TxId &txid : initiator_txs) {
+            BOOST_CHECK(initiator.AddToSet(RESPONDER_PEER, txid));
+        }
+    });
+    BOOST_CHECK(!result.success);
+    BOOST_CHECK(result.announced_by_initiator ==
+                std::set<TxId>(initiator_txs.begin(), initiator_txs.end()));
+    BOOST_CHECK(result.announced_by_responder ==
+                std::set<TxId>(responder_txs.begin(), responder_txs.end()));
+    BOOST_CHECK_EQUAL(initiator.GetSetSize(RESPONDER_PEER), 0);
+    BOOST_CHECK_EQUAL(responder.GetSetSize(INITIATOR_PEER), 0);
+}
+
+BOOST_AUTO_TEST_CASE(reconciliation_timeout) {
+    TxReconciliationTracker initiator;
+    TxReconciliationTracker responder;
+    RegisterPair(initiator, responder);
+
+    const auto initiator_txs = RandomTxIds(20);
+    const auto responder_txs = RandomTxIds(30);
+    for (const TxId &txid : initiator_txs) {
+        BOOST_CHECK(initiator.AddToSet(RESPONDER_PEER, txid));
+    }
+    for (const TxId &txid : responder_txs) {
+        BOOST_CHECK(responder.AddToSet(INITIATOR_PEER, txid));
+    }
+
+    auto now = GetTime<std::chrono::microseconds>();
+    std::vector<TxId> to_announce;
+    BOOST_CHECK(!initiator.ExpireReconciliationRequest(RESPONDER_PEER, now,
+                                                       to_announce));
+
+    // An invalid sketch fails the reconciliation, the set is flooded.
+    auto request = initiator.MaybeRequestReconciliation(RESPONDER_PEER, now);
+    BOOST_REQUIRE(request);
+    ReconciliationSketch sketch;
+    bool success;
+    std::vector<uint32_t> to_request;
+    BOOST_CHECK(initiator.HandleSketch(RESPONDER_PEER, request->round, sketch,
+                                       success, to_announce, to_request));
+    BOOST_CHECK(!success);
+    BOOST_CHECK(to_request.empty());
+    BOOST_CHECK(std::set<TxId>(to_announce.begin(), to_announce.end()) ==
+                std::set<TxId>(initiator_txs.begin(), initiator_txs.end()));
+    BOOST_CHECK_EQUAL(initiator.GetSetSize(RESPONDER_PEER), 0);
+
+    for (const TxId &txid : initiator_txs) {
+        BOOST_CHECK(initiator.AddToSet(RESPONDER_PEER, txid));
+    }
+    now += RECON_REQUEST_INTERVAL;
+    request = initiator.MaybeRequestReconciliation(RESPONDER_PEER, now);
+    BOOST_REQUIRE(request);
+    const uint32_t late_round = request->round;
+    BOOST_CHECK(responder.HandleReconciliationRequest(
+        INITIATOR_PEER, request->set_size, sketch, to_announce));
+    BOOST_CHECK(to_announce.empty());
+
+    // The sketch doesn't arrive in time: the set is flooded once the request
+    // expires.
+    const auto expiry = now + RECON_RESPONSE_TIMEOUT;
+    BOOST_CHECK(!initiator.ExpireReconciliationRequest(
+        RESPONDER_PEER, expiry - std::chrono::microseconds{1}, to_announce));
+    BOOST_CHECK(initiator.ExpireReconciliationRequest(
+        RESPONDER_PEER, expiry, to_announce));
+    BOOST_CHECK(std::set<TxId>(to_announce.begin(), to_announce.end()) ==
+                std::set<TxId>(initiator_txs.begin(), initiator_txs.end()));
+    BOOST_CHECK_EQUAL(initiator.GetSetSize(RESPONDER_PEER), 0);
+    BOOST_CHECK(!initiator.ExpireReconciliationRequest(
+        RESPONDER_PEER, expiry, to_announce));
+
+    // The next round starts right away, and the late sketch is dropped
+    // instead of being taken as the answer to the new request.
+    request = initiator.MaybeRequestReconciliation(RESPONDER_PEER, expiry);
+    BOOST_REQUIRE(request);
+    BOOST_CHECK(request->round != late_round);
+    BOOST_CHECK(!initiator.HandleSketch(RESPONDER_PEER, late_round, sketch,
+                                        success, to_announce, to_request));
+
+    // The responder never got a "reconcildiff" for its last sketch, so it
+    // floods that snapshot when the new request arrives.
+    const auto new_txs = RandomTxIds(5);
+    for (const TxId &txid : new_txs) {
+        BOOST_CHECK(responder.AddToSet(INITIATOR_PEER, txid));
+    }
+    BOOST_CHECK(responder.HandleReconciliationRequest(
+        INITIATOR_PEER, request->set_size, sketch, to_announce));
+    BOOST_CHECK(std::set<TxId>(to_announce.begin(), to_announce.end()) ==
+                std::set<TxId>(responder_txs.begin(), responder_txs.end()));
+
+    // The new round completes normally, and answering it twice doesn't
+    // count for the next one.
+    BOOST_CHECK(initiator.HandleSketch(RESPONDER_PEER, request->round, sketch,
+                                       success, to_announce, to_request));
+    BOOST_CHECK(to_announce.empty());
+    BOOST_CHECK(responder.HandleReconciliationDifference(
+        INITIATOR_PEER, success, to_request, to_announce));
+    BOOST_CHECK(std::set<TxId>(to_announce.begin(), to_announce.end()) ==
+                std::set<TxId>(new_txs.begin(), new_txs.end()));
+    BOOST_CHECK_EQUAL(responder.GetSetSize(INITIATOR_PEER), 0);
+
+    std::vector<TxId> duplicate_announce;
+    BOOST_CHECK(!initiator.HandleSketch(RESPONDER_PEER, request->round, sketch,
+                                        success, duplicate_announce,
+                                        to_request));
+    request = initiator.MaybeRequestReconciliation(
+        RESPONDER_PEER, expiry + RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(request);
+    BOOST_CHECK(initiator.HandleSketch(RESPONDER_PEER, request->round, sketch,
+                                       success, duplicate_announce,
+                                       to_request));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
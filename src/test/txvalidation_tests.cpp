@@ -14,17 +14,30 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chainparams.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <core_io.h>
+#include <fs.h>
+#include <key.h>
 #include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <script/script.h>
+#include <script/sighashtype.h>
 #include <txmempool.h>
+#include <util/moneystr.h>
+#include <util/ref.h>
+#include <util/system.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <univalue.h>
+
+extern UniValue CallRPC(const std::string &args, const util::Ref &context);
+
 BOOST_AUTO_TEST_SUITE(txvalidation_tests)
 
 /**
@@ -65,4 +78,305 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup) {
     BOOST_CHECK(state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
 
+/**
+ * Create a transaction spending the output `n` of `prevTx` to `nOutputs`
+ * P2PK outputs of the coinbase key.
+ */
+static CTransactionRef CreateSpend(const CKey &key,
+                                   const CTransactionRef &prevTx, uint32_t n,
+                                   size_t nOutputs, bool validSig = true) {
+    const CScript scriptPubKey = CScript() << ToByteVector(key.GetPubKey())
+                                           << OP_CHECKSIG;
+    const Amount fee = 10000 * SATOSHI;
+
+    CMutableTransaction mtx;
+    mtx.nVersion = 1;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(prevTx->GetId(), n);
+    mtx.vout.resize(nOutputs);
+    for (CTxOut &out : mtx.vout) {
+        out.nValue = (prevTx->vout[n].nValue - fee) / int64_t(nOutputs);
+        out.scriptPubKey = scriptPubKey;
+    }
+
+    // Sign with replay protection if the next block enforces it.
+    uint32_t flags = SCRIPT_ENABLE_SIGHASH_FORKID;
+    const Consensus::Params &params =
+        GetConfig().GetChainParams().GetConsensus();
+    {
+        LOCK(cs_main);
+        if (::ChainActive().Tip()->GetMedianTimePast() >=
+            params.selectronActivationTime) {
+            flags |= SCRIPT_ENABLE_REPLAY_PROTECTION;
+        }
+    }
+
+    std::vector<uint8_t> vchSig;
+    const uint256 hash = SignatureHash(
+        prevTx->vout[n].scriptPubKey, CTransaction(mtx), 0,
+        SigHashType().withForkId(), prevTx->vout[n].nValue, nullptr, flags);
+    BOOST_CHECK(key.SignECDSA(hash, vchSig));
+    if (!validSig) {
+        vchSig[10] ^= 0x01;
+    }
+    vchSig.push_back(uint8_t(SIGHASH_ALL | SIGHASH_FORKID));
+    mtx.vin[0].scriptSig << vchSig;
+
+    return MakeTransactionRef(std::move(mtx));
+}
+
+BOOST_FIXTURE_TEST_CASE(check_package, TestChain100Setup) {
+    const CTransactionRef parent =
+        CreateSpend(coinbaseKey, m_coinbase_txns[0], 0, 2);
+    const CTransactionRef child1 = CreateSpend(coinbaseKey, parent, 0, 1);
+    const CTransactionRef child2 = CreateSpend(coinbaseKey, parent, 1, 1);
+    const CTransactionRef doubleSpend =
+        CreateSpend(coinbaseKey, parent, 0, 2);
+
+    auto checkPackageRejected = [](const Package &package,
+                                   const std::string &reason) {
+        TxValidationState state;
+        BOOST_CHECK(!CheckPackage(package, state));
+        BOOST_CHECK(state.IsInvalid());
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), reason);
+    };
+
+    TxValidationState state;
+    BOOST_CHECK(CheckPackage({parent}, state));
+    BOOST_CHECK(CheckPackage({parent, child1, child2}, state));
+    BOOST_CHECK(CheckPackage({parent, child2, child1}, state));
+    BOOST_CHECK(state.IsValid());
+
+    checkPackageRejected({}, "package-empty");
+    checkPackageRejected({parent, child1, parent},
+                         "package-contains-duplicates");
+    checkPackageRejected({child1, parent}, "package-not-sorted");
+    checkPackageRejected({parent, child2, child1, doubleSpend},
+                         "package-conflicting-inputs");
+
+    Package tooLarge;
+    CTransactionRef tx = parent;
+    for (size_t i = 0; i <= MAX_PACKAGE_COUNT; i++) {
+        tooLarge.push_back(tx);
+        tx = CreateSpend(coinbaseKey, tx, 0, 1);
+    }
+    checkPackageRejected(tooLarge, "package-too-many-transactions");
+    tooLarge.pop_back();
+    BOOST_CHECK(CheckPackage(tooLarge, state));
+}
+
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_package, TestChain100Setup) {
+    const Config &config = GetConfig();
+    CTxMemPool &mempool = *m_node.mempool;
+
+    // Only the first coinbase is mature, so split it to fund all the packages
+    // below. A chain of transactions is accepted in one go.
+    const CTransactionRef funding =
+        CreateSpend(coinbaseKey, m_coinbase_txns[0], 0, 3);
+    Package chain{funding};
+    CTransactionRef tx = funding;
+    for (size_t i = 1; i < 10; i++) {
+        tx = CreateSpend(coinbaseKey, tx, 0, 1);
+        chain.push_back(tx);
+    }
+
+    LOCK(cs_main);
+
+    TxValidationState packageState;
+    std::vector<TxValidationState> txStates;
+    BOOST_CHECK(AcceptPackageToMemoryPool(
+        config, mempool, chain, packageState, txStates,
+        false /* bypass_limits */, CFeeRate(Amount::zero())));
+    BOOST_CHECK(packageState.IsValid());
+    BOOST_CHECK_EQUAL(txStates.size(), chain.size());
+    BOOST_CHECK_EQUAL(mempool.size(), chain.size());
+    for (const CTransactionRef &ptx : chain) {
+        BOOST_CHECK(mempool.exists(ptx->GetId()));
+    }
+
+    // Submitting the package again is a no-op.
+    BOOST_CHECK(AcceptPackageToMemoryPool(
+        config, mempool, chain, packageState, txStates,
+        false /* bypass_limits */, CFeeRate(Amount::zero())));
+    BOOST_CHECK_EQUAL(mempool.size(), chain.size());
+
+    // An unsorted package is rejected as a whole.
+    const CTransactionRef parent =
+        CreateSpend(coinbaseKey, funding, 1, 2);
+    const CTransactionRef invalid =
+        CreateSpend(coinbaseKey, parent, 0, 1, false /* validSig */);
+    const CTransactionRef orphan = CreateSpend(coinbaseKey, invalid, 0, 1);
+    const CTransactionRef sibling = CreateSpend(coinbaseKey, parent, 1, 1);
+    BOOST_CHECK(!AcceptPackageToMemoryPool(
+        config, mempool, {sibling, parent}, packageState, txStates,
+        false /* bypass_limits */, CFeeRate(Amount::zero())));
+    BOOST_CHECK_EQUAL(packageState.GetRejectReason(), "package-not-sorted");
+    BOOST_CHECK_EQUAL(mempool.size(), chain.size());
+
+    // An invalid transaction doesn't prevent the rest of the package from
+    // being accepted, but its descendants are rejected.
+    packageState = TxValidationState();
+    BOOST_CHECK(!AcceptPackageToMemoryPool(
+        config, mempool, {parent, invalid, orphan, sibling}, packageState,
+        txStates, false /* bypass_limits */, CFeeRate(Amount::zero())));
+    BOOST_CHECK(packageState.IsValid());
+    BOOST_CHECK_EQUAL(txStates.size(), 4U);
+    BOOST_CHECK(txStates[0].IsValid());
+    BOOST_CHECK(txStates[1].IsInvalid());
+    BOOST_CHECK(txStates[2].GetResult() ==
+                TxValidationResult::TX_MISSING_INPUTS);
+    BOOST_CHECK(txStates[3].IsValid());
+    BOOST_CHECK(mempool.exists(parent->GetId()));
+    BOOST_CHECK(!mempool.exists(invalid->GetId()));
+    BOOST_CHECK(!mempool.exists(orphan->GetId()));
+    BOOST_CHECK(mempool.exists(sibling->GetId()));
+    BOOST_CHECK_EQUAL(mempool.size(), chain.size() + 2);
+
+    // The fee rate limit applies to each transaction.
+    const CTransactionRef highFee =
+        CreateSpend(coinbaseKey, funding, 2, 1);
+    BOOST_CHECK(!AcceptPackageToMemoryPool(
+        config, mempool, {highFee}, packageState, txStates,
+        false /* bypass_limits */, CFeeRate(SATOSHI)));
+    BOOST_CHECK_EQUAL(txStates[0].GetRejectReason(), "absurdly-high-fee");
+    BOOST_CHECK(!mempool.exists(highFee->GetId()));
+}
+
+BOOST_FIXTURE_TEST_CASE(rpc_submitpackage, TestChain100Setup) {
+    const util::Ref context{m_node};
+    const CTxMemPool &mempool = *m_node.mempool;
+
+    auto toJSON = [](const Package &package) {
+        std::string json = "[";
+        for (const CTransactionRef &ptx : package) {
+            json += json.size() > 1 ? "," : "";
+            json += "\"" + EncodeHexTx(*ptx) + "\"";
+        }
+        return json + "]";
+    };
+
+    const CTransactionRef parent =
+        CreateSpend(coinbaseKey, m_coinbase_txns[0], 0, 3);
+    const CTransactionRef invalid =
+        CreateSpend(coinbaseKey, parent, 0, 1, false /* validSig */);
+    const CTransactionRef orphan = CreateSpend(coinbaseKey, invalid, 0, 1);
+    const CTransactionRef sibling = CreateSpend(coinbaseKey, parent, 1, 1);
+
+    // Argument parsing
+    BOOST_CHECK_THROW(CallRPC("submitpackage", context), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("submitpackage {}", context),
+                      std::runtime_error);
+    BOOST_CHECK_EXCEPTION(
+        CallRPC("submitpackage []", context), std::runtime_error,
+        HasReason("Array must contain between 1 and"));
+    Package tooLarge(MAX_PACKAGE_COUNT + 1, parent);
+    BOOST_CHECK_EXCEPTION(
+        CallRPC("submitpackage " + toJSON(tooLarge), context),
+        std::runtime_error, HasReason("Array must contain between 1 and"));
+    BOOST_CHECK_EXCEPTION(
+        CallRPC("submitpackage [\"" + EncodeHexTx(*parent) + "\",\"00\"]",
+                context),
+        std::runtime_error, HasReason("TX decode failed for transaction 1"));
+    BOOST_CHECK_THROW(
+        CallRPC("submitpackage " + toJSON({parent}) + " not_amount", context),
+        std::runtime_error);
+    BOOST_CHECK_EQUAL(mempool.size(), 0U);
+
+    // An unsorted package is rejected as a whole.
+    BOOST_CHECK_EXCEPTION(
+        CallRPC("submitpackage " + toJSON({sibling, parent}), context),
+        std::runtime_error, HasReason("package-not-sorted"));
+    BOOST_CHECK_EQUAL(mempool.size(), 0U);
+
+    // Result format: one entry per transaction, in the package order.
+    const Package package{parent, invalid, orphan, sibling};
+    UniValue result =
+        CallRPC("submitpackage " + toJSON(package), context);
+    BOOST_CHECK(result.isArray());
+    BOOST_CHECK_EQUAL(result.size(), package.size());
+    for (size_t i = 0; i < package.size(); i++) {
+        BOOST_CHECK_EQUAL(find_value(result[i], "txid").get_str(),
+                          package[i]->GetId().GetHex());
+    }
+    BOOST_CHECK(find_value(result[0], "allowed").get_bool());
+    BOOST_CHECK(find_value(result[0], "reject-reason").isNull());
+    BOOST_CHECK(!find_value(result[1], "allowed").get_bool());
+    BOOST_CHECK(!find_value(result[1], "reject-reason").get_str().empty());
+    BOOST_CHECK(!find_value(result[2], "allowed").get_bool());
+    BOOST_CHECK_EQUAL(find_value(result[2], "reject-reason").get_str(),
+                      "missing-inputs");
+    BOOST_CHECK(find_value(result[3], "allowed").get_bool());
+    BOOST_CHECK(find_value(result[3], "reject-reason").isNull());
+    BOOST_CHECK(mempool.exists(parent->GetId()));
+    BOOST_CHECK(mempool.exists(sibling->GetId()));
+    BOOST_CHECK_EQUAL(mempool.size(), 2U);
+
+    // The fee rate limit is passed through.
+    const CTransactionRef highFee = CreateSpend(coinbaseKey, parent, 2, 1);
+    result = CallRPC("submitpackage " + toJSON({highFee}) + " " +
+                         FormatMoney(1000 * SATOSHI),
+                     context);
+    BOOST_CHECK_EQUAL(result.size(), 1U);
+    BOOST_CHECK(!find_value(result[0], "allowed").get_bool());
+    BOOST_CHECK_EQUAL(find_value(result[0], "reject-reason").get_str(),
+                      "absurdly-high-fee");
+    BOOST_CHECK(!mempool.exists(highFee->GetId()));
+}
+
+BOOST_FIXTURE_TEST_CASE(mempool_dump_load, TestChain100Setup) {
+    const Config &config = GetConfig();
+    CTxMemPool &mempool = *m_node.mempool;
+
+    // Confirm a transaction with many outputs, and build a short chain of
+    // transactions on top of each of them. There are enough transactions to
+    // span several load batches, with descendants in the same batch as their
+    // ancestors and in the following ones.
+    const CTransactionRef funding =
+        CreateSpend(coinbaseKey, m_coinbase_txns[0], 0, 60);
+    CreateAndProcessBlock({CMutableTransaction(*funding)},
+                          CScript() << ToByteVector(coinbaseKey.GetPubKey())
+                                    << OP_CHECKSIG);
+
+    std::vector<CTransactionRef> txs;
+    for (uint32_t n = 0; n < funding->vout.size(); n++) {
+        CTransactionRef tx = CreateSpend(coinbaseKey, funding, n, 1);
+        txs.push_back(tx);
+        for (size_t i = 1; i < 25; i++) {
+            tx = CreateSpend(coinbaseKey, tx, 0, 1);
+            txs.push_back(tx);
+        }
+    }
+
+    {
+        LOCK(cs_main);
+        for (const CTransactionRef &tx : txs) {
+            TxValidationState state;
+            BOOST_CHECK(AcceptToMemoryPool(config, mempool, state, tx,
+                                           false /* bypass_limits */,
+                                           Amount::zero() /* nAbsurdFee */));
+        }
+    }
+    BOOST_CHECK_EQUAL(mempool.size(), txs.size());
+
+    BOOST_CHECK(DumpMempool(mempool));
+    mempool.clear();
+
+    BOOST_CHECK(LoadMempool(config, mempool));
+    BOOST_CHECK_EQUAL(mempool.size(), txs.size());
+    for (const CTransactionRef &tx : txs) {
+        BOOST_CHECK(mempool.exists(tx->GetId()));
+    }
+
+    // When the file is truncated, the transactions read before the error are
+    // still loaded, including those of the batch that could not be completed.
+    BOOST_CHECK(DumpMempool(mempool));
+    mempool.clear();
+    const fs::path path = GetDataDir() / "mempool.dat";
+    fs::resize_file(path, fs::file_size(path) / 3);
+
+    BOOST_CHECK(!LoadMempool(config, mempool));
+    BOOST_CHECK(mempool.size() > 0);
+    BOOST_CHECK(mempool.size() < txs.size() / 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <crypto/sha512.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <logging.h>
@@ -135,6 +136,7 @@ BasicTestingSetup::BasicTestingSetup(
     AppInitParameterInteraction(config, *m_node.args);
     LogInstance().StartLogging();
     SHA256AutoDetect();
+    SHA512AutoDetect();
     ECC_Start();
     SetupEnvironment();
     SetupNetworking();
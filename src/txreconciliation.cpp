@@ -0,0 +1,531 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txreconciliation.h>
+
+#include <crypto/siphash.h>
+#include <hash.h>
+#include <logging.h>
+#include <random.h>
+#include <salteduint256hasher.h>
+#include <sync.h>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+/** Integer mixing function spreading short ids over the cells. */
+uint32_t Mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+uint32_t Checksum(uint32_t shortid) {
+    return Mix(shortid ^ 0x5bd1e995);
+}
+
+} // namespace
+
+ReconciliationSketch::ReconciliationSketch(size_t cells)
+    : m_cells((cells + NUM_HASHES - 1) / NUM_HASHES * NUM_HASHES) {}
+
+size_t ReconciliationSketch::CellsForCapacity(size_t capacity) {
+    // Peeling with 3 hashes succeeds with high probability above ~1.23 cells
+    // per element for large differences. Small ones mostly fail when two
+    // elements share their cells in every subtable, which is likely with
+    // small subtables, so give them some more slack.
+    const size_t cells = capacity + capacity / 2 + 4 * NUM_HASHES +
+                         NUM_HASHES * std::min<size_t>(capacity, 32);
+    return std::min(cells, MAX_SKETCH_CELLS) / NUM_HASHES * NUM_HASHES;
+}
+
+size_t ReconciliationSketch::GetCellIndex(uint32_t shortid,
+                                          size_t hash) const {
+    const uint64_t subtable = m_cells.size() / NUM_HASHES;
+    const uint32_t h = Mix(shortid + uint32_t(hash) * 0x9e3779b9);
+    return hash * subtable + ((uint64_t(h) * subtable) >> 32);
+}
+
+void ReconciliationSketch::Toggle(uint32_t shortid, int32_t count) {
+    const uint32_t checksum = Checksum(shortid);
+    for (size_t i = 0; i < NUM_HASHES; ++i) {
+        Cell &cell = m_cells[GetCellIndex(shortid, i)];
+        cell.count += uint32_t(count);
+        cell.keysum ^= shortid;
+        cell.checksum ^= checksum;
+    }
+}
+
+void ReconciliationSketch::Add(uint32_t shortid) {
+    if (!m_cells.empty()) {
+        Toggle(shortid, 1);
+    }
+}
+
+bool ReconciliationSketch::Subtract(const ReconciliationSketch &other) {
+    if (other.m_cells.size() != m_cells.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        m_cells[i].count -= other.m_cells[i].count;
+        m_cells[i].keysum ^= other.m_cells[i].keysum;
+        m_cells[i].checksum ^= other.m_cells[i].checksum;
+    }
+    return true;
+}
+
+bool ReconciliationSketch::Decode(std::vector<uint32_t> &ours,
+                                  std::vector<uint32_t> &theirs) const {
+    ours.clear();
+    theirs.clear();
+
+    ReconciliationSketch work(*this);
+    auto isPure = [](const Cell &cell) {
+        return (cell.count == 1 || cell.count == uint32_t(-1)) &&
+               cell.checksum == Checksum(cell.keysum);
+    };
+
+    std::vector<size_t> queue;
+    queue.reserve(m_cells.size());
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        if (isPure(m_cells[i])) {
+            queue.push_back(i);
+        }
+    }
+
+    while (!queue.empty()) {
+        const Cell &cell = work.m_cells[queue.back()];
+        queue.pop_back();
+        if (!isPure(cell)) {
+            // Already peeled through another cell.
+            continue;
+        }
+
+        // A difference can't have more elements than cells. This also bounds
+        // the work done on an adversarial sketch.
+        if (ours.size() + theirs.size() >= m_cells.size()) {
+            return false;
+        }
+
+        const uint32_t shortid = cell.keysum;
+        const int32_t count = cell.count == 1 ? 1 : -1;
+        (count > 0 ? ours : theirs).push_back(shortid);
+        work.Toggle(shortid, -count);
+        for (size_t i = 0; i < NUM_HASHES; ++i) {
+            const size_t index = work.GetCellIndex(shortid, i);
+            if (isPure(work.m_cells[index])) {
+                queue.push_back(index);
+            }
+        }
+    }
+
+    return std::all_of(work.m_cells.begin(), work.m_cells.end(),
+                       [](const Cell &cell) {
+                           return cell.count == 0 && cell.keysum == 0 &&
+                                  cell.checksum == 0;
+                       });
+}
+
+namespace {
+
+/** Static component of the salt used to compute short ids. */
+const std::string RECON_STATIC_SALT = "Tx Relay Salting";
+
+struct ReconciliationState {
+    /** Whether we send the "reqrecon", i.e. we opened the connection. */
+    const bool m_we_initiate;
+    /** SipHash keys for the short ids, derived from both salts. */
+    const uint64_t m_k0;
+    const uint64_t m_k1;
+
+    /** Transactions to be reconciled with the peer. */
+    std::unordered_set<TxId, SaltedUint256Hasher> m_local_set;
+
+    /** Initiator: whether we are waiting for a sketch. */
+    bool m_request_pending{false};
+    /** Initiator: round of the last request, see ReconciliationRequest. */
+    uint32_t m_request_round{0};
+    std::chrono::microseconds m_request_expiry{0};
+    std::chrono::microseconds m_next_request{0};
+
+    /** Responder: the set our last sketch was built from, by short id. */
+    std::unordered_map<uint32_t, TxId> m_snapshot;
+    bool m_snapshot_pending{false};
+
+    ReconciliationState(bool we_initiate, uint64_t k0, uint64_t k1)
+        : m_we_initiate(we_initiate), m_k0(k0), m_k1(k1) {}
+
+    uint32_t ComputeShortId(const TxId &txid) const {
+        return SipHashUint256(m_k0, m_k1, txid) & 0xffffffff;
+    }
+
+    ReconciliationSketch ComputeSketch(size_t cells) const {
+        ReconciliationSketch sketch(cells);
+        for (const TxId &txid : m_local_set) {
+            sketch.Add(ComputeShortId(txid));
+        }
+        return sketch;
+    }
+};
+
+} // namespace
+
+class TxReconciliationTracker::Impl {
+    const int m_fanout_percent;
+    const uint64_t m_fanout_k0;
+    const uint64_t m_fanout_k1;
+
+    mutable Mutex m_mutex;
+    /** Our salt for the peers we sent "sendrecon" to. */
+    std::unordered_map<NodeId, uint64_t> m_pre_registered GUARDED_BY(m_mutex);
+    std::unordered_map<NodeId, ReconciliationState>
+        m_states GUARDED_BY(m_mutex);
+
+    ReconciliationState *GetState(NodeId peer)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        auto it = m_states.find(peer);
+        return it == m_states.end() ? nullptr : &it->second;
+    }
+
+public:
+    explicit Impl(int fanout_percent)
+        : m_fanout_percent(fanout_percent),
+          m_fanout_k0(GetRand(std::numeric_limits<uint64_t>::max())),
+          m_fanout_k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    uint64_t PreRegisterPeer(NodeId peer) {
+        const uint64_t salt = GetRand(std::numeric_limits<uint64_t>::max());
+        LOCK(m_mutex);
+        m_pre_registered[peer] = salt;
+        return salt;
+    }
+
+    bool RegisterPeer(NodeId peer, bool we_initiate, uint32_t peer_version,
+                      uint64_t peer_salt) {
+        LOCK(m_mutex);
+        auto it = m_pre_registered.find(peer);
+        if (it == m_pre_registered.end() || m_states.count(peer) ||
+            peer_version < TXRECONCILIATION_VERSION) {
+            return false;
+        }
+
+        // Both sides must derive the same keys, so combine the salts in a
+        // canonical order.
+        const uint64_t salt1 = std::min(it->second, peer_salt);
+        const uint64_t salt2 = std::max(it->second, peer_salt);
+        const uint256 h =
+            (CHashWriter(SER_GETHASH, 0) << RECON_STATIC_SALT << salt1 << salt2)
+                .GetHash();
+        m_pre_registered.erase(it);
+        m_states.emplace(std::piecewise_construct, std::forward_as_tuple(peer),
+                         std::forward_as_tuple(we_initiate, h.GetUint64(0),
+                                               h.GetUint64(1)));
+        return true;
+    }
+
+    void ForgetPeer(NodeId peer) {
+        LOCK(m_mutex);
+        m_pre_registered.erase(peer);
+        m_states.erase(peer);
+    }
+
+    bool IsPeerRegistered(NodeId peer) const {
+        LOCK(m_mutex);
+        return m_states.count(peer);
+    }
+
+    bool ShouldFloodTo(const TxId &txid, NodeId peer) const {
+        const uint64_t h = CSipHasher(m_fanout_k0, m_fanout_k1)
+                               .Write(txid.begin(), txid.size())
+                               .Write(uint64_t(peer))
+                               .Finalize();
+        return int(h % 100) < m_fanout_percent;
+    }
+
+    bool AddToSet(NodeId peer, const TxId &txid) {
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || state->m_local_set.size() >= MAX_RECON_SET_SIZE) {
+            return false;
+        }
+        state->m_local_set.insert(txid);
+        return true;
+    }
+
+    void TryRemovingFromSet(NodeId peer, const TxId &txid) {
+        LOCK(m_mutex);
+        if (ReconciliationState *state = GetState(peer)) {
+            state->m_local_set.erase(txid);
+        }
+    }
+
+    size_t GetSetSize(NodeId peer) const {
+        LOCK(m_mutex);
+        auto it = m_states.find(peer);
+        return it == m_states.end() ? 0 : it->second.m_local_set.size();
+    }
+
+    std::optional<ReconciliationRequest>
+    MaybeRequestReconciliation(NodeId peer, std::chrono::microseconds now) {
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || !state->m_we_initiate || state->m_request_pending ||
+            now < state->m_next_request) {
+            return std::nullopt;
+        }
+
+        state->m_request_pending = true;
+        state->m_request_expiry = now + RECON_RESPONSE_TIMEOUT;
+        state->m_next_request = now + RECON_REQUEST_INTERVAL;
+        return ReconciliationRequest{
+            ++state->m_request_round,
+            uint16_t(std::min<size_t>(state->m_local_set.size(),
+                                      std::numeric_limits<uint16_t>::max()))};
+    }
+
+    bool ExpireReconciliationRequest(NodeId peer,
+                                     std::chrono::microseconds now,
+                                     std::vector<TxId> &txs_to_announce) {
+        txs_to_announce.clear();
+
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || !state->m_request_pending ||
+            now < state->m_request_expiry) {
+            return false;
+        }
+        state->m_request_pending = false;
+
+        txs_to_announce.assign(state->m_local_set.begin(),
+                               state->m_local_set.end());
+        state->m_local_set.clear();
+        LogPrint(BCLog::NET,
+                 "Reconciliation request timed out, flooding %u transactions "
+                 "to peer=%d\n",
+                 txs_to_announce.size(), peer);
+        return true;
+    }
+
+    bool HandleReconciliationRequest(NodeId peer, uint16_t peer_set_size,
+                                     ReconciliationSketch &sketch,
+                                     std::vector<TxId> &txs_to_announce) {
+        txs_to_announce.clear();
+
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || state->m_we_initiate) {
+            return false;
+        }
+
+        if (state->m_snapshot_pending) {
+            // The peer only sends a new request once the previous one was
+            // answered or timed out, so it gave up on our last sketch and
+            // won't tell us what it is missing.
+            for (const auto &entry : state->m_snapshot) {
+                txs_to_announce.push_back(entry.second);
+            }
+            LogPrint(BCLog::NET,
+                     "Reconciliation request superseded, flooding %u "
+                     "transactions to peer=%d\n",
+                     txs_to_announce.size(), peer);
+        }
+
+        // The difference is at least the difference of the set sizes. Most
+        // of the transactions should be in both sets, but allow for a
+        // fraction of the smallest one to differ.
+        const size_t local_size = state->m_local_set.size();
+        const size_t capacity =
+            std::max<size_t>(local_size, peer_set_size) -
+            std::min<size_t>(local_size, peer_set_size) +
+            std::min<size_t>(local_size, peer_set_size) / 4 + 1;
+        sketch = state->ComputeSketch(
+            ReconciliationSketch::CellsForCapacity(capacity));
+
+        state->m_snapshot.clear();
+        for (const TxId &txid : state->m_local_set) {
+            state->m_snapshot.emplace(state->ComputeShortId(txid), txid);
+        }
+        state->m_local_set.clear();
+        state->m_snapshot_pending = true;
+        return true;
+    }
+
+    bool HandleSketch(NodeId peer, uint32_t round,
+                      const ReconciliationSketch &sketch, bool &success,
+                      std::vector<TxId> &txs_to_announce,
+                      std::vector<uint32_t> &shortids_to_request) {
+        txs_to_announce.clear();
+        shortids_to_request.clear();
+
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || !state->m_we_initiate) {
+            return false;
+        }
+        if (!state->m_request_pending || round != state->m_request_round) {
+            // Unsolicited, or answers a request which timed out and whose set
+            // was flooded already.
+            return false;
+        }
+        state->m_request_pending = false;
+
+        std::vector<uint32_t> ours;
+        success = false;
+        if (sketch.IsValid()) {
+            ReconciliationSketch difference =
+                state->ComputeSketch(sketch.GetCells());
+            success = difference.Subtract(sketch) &&
+                      difference.Decode(ours, shortids_to_request);
+        }
+
+        if (success) {
+            std::unordered_map<uint32_t, TxId> by_shortid;
+            by_shortid.reserve(state->m_local_set.size());
+            for (const TxId &txid : state->m_local_set) {
+                by_shortid.emplace(state->ComputeShortId(txid), txid);
+            }
+            for (const uint32_t shortid : ours) {
+                auto it = by_shortid.find(shortid);
+                if (it != by_shortid.end()) {
+                    txs_to_announce.push_back(it->second);
+                }
+            }
+        } else {
+            // Fall back to announcing everything.
+            shortids_to_request.clear();
+            txs_to_announce.assign(state->m_local_set.begin(),
+                                   state->m_local_set.end());
+            LogPrint(BCLog::NET,
+                     "Failed to reconcile %u transactions with peer=%d\n",
+                     txs_to_announce.size(), peer);
+        }
+
+        state->m_local_set.clear();
+        return true;
+    }
+
+    bool HandleReconciliationDifference(NodeId peer, bool success,
+                                        const std::vector<uint32_t> &shortids,
+                                        std::vector<TxId> &txs_to_announce) {
+        txs_to_announce.clear();
+
+        LOCK(m_mutex);
+        ReconciliationState *state = GetState(peer);
+        if (!state || state->m_we_initiate || !state->m_snapshot_pending) {
+            return false;
+        }
+        state->m_snapshot_pending = false;
+
+        if (success) {
+            for (const uint32_t shortid : shortids) {
+                auto it = state->m_snapshot.find(shortid);
+                if (it != state->m_snapshot.end()) {
+                    txs_to_announce.push_back(it->second);
+                }
+            }
+        } else {
+            for (const auto &entry : state->m_snapshot) {
+                txs_to_announce.push_back(entry.second);
+            }
+        }
+
+        state->m_snapshot.clear();
+        return true;
+    }
+};
+
+TxReconciliationTracker::TxReconciliationTracker(int fanout_percent)
+    : m_impl{std::make_unique<Impl>(fanout_percent)} {}
+
+TxReconciliationTracker::~TxReconciliationTracker() = default;
+
+uint64_t TxReconciliationTracker::PreRegisterPeer(NodeId peer) {
+    return m_impl->PreRegisterPeer(peer);
+}
+
+bool TxReconciliationTracker::RegisterPeer(NodeId peer, bool we_initiate,
+                                           uint32_t peer_version,
+                                           uint64_t peer_salt) {
+    return m_impl->RegisterPeer(peer, we_initiate, peer_version, peer_salt);
+}
+
+void TxReconciliationTracker::ForgetPeer(NodeId peer) {
+    m_impl->ForgetPeer(peer);
+}
+
+bool TxReconciliationTracker::IsPeerRegistered(NodeId peer) const {
+    return m_impl->IsPeerRegistered(peer);
+}
+
+bool TxReconciliationTracker::ShouldFloodTo(const TxId &txid,
+                                            NodeId peer) const {
+    return m_impl->ShouldFloodTo(txid, peer);
+}
+
+bool TxReconciliationTracker::AddToSet(NodeId peer, const TxId &txid) {
+    return m_impl->AddToSet(peer, txid);
+}
+
+void TxReconciliationTracker::TryRemovingFromSet(NodeId peer,
+                                                 const TxId &txid) {
+    m_impl->TryRemovingFromSet(peer, txid);
+}
+
+size_t TxReconciliationTracker::GetSetSize(NodeId peer) const {
+    return m_impl->GetSetSize(peer);
+}
+
+std::optional<ReconciliationRequest>
+TxReconciliationTracker::MaybeRequestReconciliation(
+    NodeId peer, std::chrono::microseconds now) {
+    return m_impl->MaybeRequestReconciliation(peer, now);
+}
+
+bool TxReconciliationTracker::ExpireReconciliationRequest(
+    NodeId peer, std::chrono::microseconds now,
+    std::vector<TxId> &txs_to_announce) {
+    return m_impl->ExpireReconciliationRequest(peer, now, txs_to_announce);
+}
+
+bool TxReconciliationTracker::HandleReconciliationRequest(
+    NodeId peer, uint16_t peer_set_size, ReconciliationSketch &sketch,
+    std::vector<TxId> &txs_to_announce) {
+    return m_impl->HandleReconciliationRequest(peer, peer_set_size, sketch,
+                                               txs_to_announce);
+}
+
+bool TxReconciliationTracker::HandleSketch(
+    NodeId peer, uint32_t round, const ReconciliationSketch &sketch,
+    bool &success, std::vector<TxId> &txs_to_announce,
+    std::vector<uint32_t> &shortids_to_request) {
+    return m_impl->HandleSketch(peer, round, sketch, success, txs_to_announce,
+                                shortids_to_request);
+}
+
+bool TxReconciliationTracker::HandleReconciliationDifference(
+    NodeId peer, bool success, const std::vector<uint32_t> &shortids,
+    std::vector<TxId> &txs_to_announce) {
+    return m_impl->HandleReconciliationDifference(peer, success, shortids,
+                                                  txs_to_announce);
+}
@@ -0,0 +1,240 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXRECONCILIATION_H
+#define BITCOIN_TXRECONCILIATION_H
+
+#include <net.h> // For NodeId
+#include <primitives/txid.h>
+#include <serialize.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/** Whether transaction reconciliation is enabled by default. */
+static constexpr bool DEFAULT_TXRECONCILIATION_ENABLE{false};
+/**
+ * Default percentage of the reconciling peers to which a transaction is still
+ * flooded. Flooding to a few peers keeps the propagation latency low, while
+ * reconciliation catches up the others at a fraction of the bandwidth.
+ */
+static constexpr int DEFAULT_TXRECONCILIATION_FANOUT{10};
+/** Version of the reconciliation protocol, announced in "sendrecon". */
+static constexpr uint32_t TXRECONCILIATION_VERSION{1};
+/** Delay between two reconciliations initiated with the same peer. */
+static constexpr std::chrono::seconds RECON_REQUEST_INTERVAL{8};
+/** How long to wait for the sketch before flooding the set instead. */
+static constexpr std::chrono::seconds RECON_RESPONSE_TIMEOUT{30};
+/**
+ * Maximum number of transactions waiting for reconciliation with a peer.
+ * Transactions beyond that are flooded, which bounds both the memory use and
+ * the sketch size.
+ */
+static constexpr size_t MAX_RECON_SET_SIZE{3000};
+/** Maximum number of cells in a sketch we produce or accept. */
+static constexpr size_t MAX_SKETCH_CELLS{4 * MAX_RECON_SET_SIZE};
+
+/**
+ * Invertible Bloom lookup table over 32 bits short transaction ids.
+ *
+ * Each element is added to one cell in each of NUM_HASHES equally sized
+ * subtables. Subtracting the sketch of a set from the sketch of another one
+ * built with the same number of cells leaves a sketch of their symmetric
+ * difference, which can be decoded by peeling cells containing a single
+ * element as long as the difference is small enough compared to the number of
+ * cells.
+ */
+class ReconciliationSketch {
+public:
+    static constexpr size_t NUM_HASHES{3};
+
+    struct Cell {
+        /**
+         * Number of elements added minus the number of elements removed.
+         * The cells of a sketch received from the network can hold anything,
+         * so this wraps around rather than overflowing, and only 1 and -1
+         * (UINT32_MAX) are meaningful when decoding.
+         */
+        uint32_t count{0};
+        uint32_t keysum{0};
+        uint32_t checksum{0};
+
+        SERIALIZE_METHODS(Cell, obj) {
+            READWRITE(obj.count, obj.keysum, obj.checksum);
+        }
+    };
+
+    ReconciliationSketch() = default;
+    /** Build an empty sketch, the cell count is rounded up to fit the
+     * subtables. */
+    explicit ReconciliationSketch(size_t cells);
+
+    /** Number of cells needed to decode a difference of `capacity` elements
+     * with high probability. */
+    static size_t CellsForCapacity(size_t capacity);
+
+    void Add(uint32_t shortid);
+    /**
+     * Subtract another sketch from this one, elementwise. Returns false if
+     * the sketches do not have the same geometry.
+     */
+    bool Subtract(const ReconciliationSketch &other);
+    /**
+     * Decode a difference sketch. Elements added to this sketch only are
+     * returned in `ours`, the ones of the subtracted sketch in `theirs`.
+     * Returns false if the difference could not be fully decoded.
+     */
+    bool Decode(std::vector<uint32_t> &ours,
+                std::vector<uint32_t> &theirs) const;
+
+    size_t GetCells() const { return m_cells.size(); }
+    /**
+     * A sketch received from the network must pass this before use. The
+     * responder always sizes its sketch for at least one difference, so an
+     * empty sketch is invalid too.
+     */
+    bool IsValid() const {
+        return !m_cells.empty() && m_cells.size() % NUM_HASHES == 0 &&
+               m_cells.size() <= MAX_SKETCH_CELLS;
+    }
+
+    SERIALIZE_METHODS(ReconciliationSketch, obj) { READWRITE(obj.m_cells); }
+
+private:
+    std::vector<Cell> m_cells;
+
+    size_t GetCellIndex(uint32_t shortid, size_t hash) const;
+    void Toggle(uint32_t shortid, int32_t count);
+};
+
+/** A reconciliation request, as sent in "reqrecon". */
+struct ReconciliationRequest {
+    /**
+     * Identifies the request. The responder echoes it in its "sketch", so a
+     * sketch answering a request which timed out can't be mistaken for the
+     * answer to a later one.
+     */
+    uint32_t round;
+    uint16_t set_size;
+};
+
+/**
+ * Track the transaction reconciliation state with each peer (Erlay).
+ *
+ * Instead of announcing every transaction to every peer, peers which both
+ * opted in with "sendrecon" only flood a transaction to a fraction of them
+ * (the fanout). The remaining ones are accumulated in a per peer set, and the
+ * sets are periodically reconciled: the side which opened the connection
+ * (the initiator) sends its set size in "reqrecon", the responder replies
+ * with a sketch of its set in "sketch", the initiator subtracts its own
+ * sketch, decodes the difference, announces the transactions the responder
+ * is missing and requests the ones it is missing with "reconcildiff", which
+ * the responder answers with a regular inv. All the announcements then go
+ * through the usual InvRequestTracker download logic. If the difference
+ * cannot be decoded, both sides fall back to announcing their whole set.
+ *
+ * This class is thread-safe.
+ */
+class TxReconciliationTracker {
+    class Impl;
+    const std::unique_ptr<Impl> m_impl;
+
+public:
+    explicit TxReconciliationTracker(
+        int fanout_percent = DEFAULT_TXRECONCILIATION_FANOUT);
+    ~TxReconciliationTracker();
+
+    /**
+     * Prepare to reconcile with a peer, and return the salt to announce in
+     * our "sendrecon" message.
+     */
+    uint64_t PreRegisterPeer(NodeId peer);
+    /**
+     * Complete the registration once the peer's "sendrecon" is received.
+     * Returns false if the peer was not pre-registered, is already registered
+     * or speaks an incompatible version.
+     */
+    bool RegisterPeer(NodeId peer, bool we_initiate, uint32_t peer_version,
+                      uint64_t peer_salt);
+    void ForgetPeer(NodeId peer);
+    bool IsPeerRegistered(NodeId peer) const;
+
+    /**
+     * Whether a transaction should be flooded to a registered peer rather
+     * than reconciled. This is a deterministic function of the transaction
+     * and the peer so that the decision is stable.
+     */
+    bool ShouldFloodTo(const TxId &txid, NodeId peer) const;
+    /**
+     * Queue a transaction for reconciliation with a registered peer. Returns
+     * false if it could not be added, in which case it should be flooded.
+     */
+    bool AddToSet(NodeId peer, const TxId &txid);
+    /** The peer already knows the transaction, don't reconcile it. */
+    void TryRemovingFromSet(NodeId peer, const TxId &txid);
+    size_t GetSetSize(NodeId peer) const;
+
+    /**
+     * Initiator side: if it is time to reconcile with the peer, mark the
+     * request as in flight and return it for the "reqrecon" message.
+     */
+    std::optional<ReconciliationRequest>
+    MaybeRequestReconciliation(NodeId peer, std::chrono::microseconds now);
+    /**
+     * Initiator side: give up on a request the peer did not answer within
+     * RECON_RESPONSE_TIMEOUT. Returns true and fills the transactions to
+     * flood to the peer if the request expired. The late sketch is dropped
+     * when it arrives, as its round no longer matches.
+     */
+    bool ExpireReconciliationRequest(NodeId peer,
+                                     std::chrono::microseconds now,
+                                     std::vector<TxId> &txs_to_announce);
+    /**
+     * Responder side: snapshot our set and build the sketch answering a
+     * "reqrecon". If the previous sketch was not followed by a
+     * "reconcildiff", the peer gave up on it, and the transactions of its
+     * snapshot are returned to be flooded. Returns false if the request was
+     * unexpected.
+     */
+    bool HandleReconciliationRequest(NodeId peer, uint16_t peer_set_size,
+                                     ReconciliationSketch &sketch,
+                                     std::vector<TxId> &txs_to_announce);
+    /**
+     * Initiator side: process the responder's sketch for the given round.
+     * Fills the transactions to announce to the peer and the short ids to
+     * request in "reconcildiff", an invalid sketch fails the reconciliation.
+     * Returns false if the sketch does not answer the pending request, e.g.
+     * because it arrived after the request timed out, in which case it is
+     * dropped.
+     */
+    bool HandleSketch(NodeId peer, uint32_t round,
+                      const ReconciliationSketch &sketch,
+                      bool &success, std::vector<TxId> &txs_to_announce,
+                      std::vector<uint32_t> &shortids_to_request);
+    /**
+     * Responder side: process the "reconcildiff" and return the
+     * transactions to announce to the peer. Returns false if it was
+     * unexpected.
+     */
+    bool HandleReconciliationDifference(
+        NodeId peer, bool success, const std::vector<uint32_t> &shortids,
+        std::vector<TxId> &txs_to_announce);
+};
+
+#endif // BITCOIN_TXRECONCILIATION_H
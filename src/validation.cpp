@@ -70,6 +70,7 @@
 #include <optional>
 #include <string>
 #include <thread>
+#include <unordered_set>
 
 #define MICRO 0.000001
 #define MILLI 0.001
@@ -395,6 +396,17 @@ public:
     bool AcceptSingleTransaction(const CTransactionRef &ptx, ATMPArgs &args)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    // Package acceptance. The transactions are processed in order and each
+    // accepted transaction is added to the pool before the next one is
+    // checked, so children can spend the outputs of their parents. The pool
+    // is only trimmed once the whole package has been processed.
+    bool AcceptPackage(const Config &config, const Package &package,
+                       std::vector<TxValidationState> &states,
+                       int64_t accept_time, bool bypass_limits,
+                       const CFeeRate &max_fee_rate,
+                       std::vector<COutPoint> &coins_to_uncache)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -439,6 +451,15 @@ private:
     bool Finalize(ATMPArgs &args, Workspace &ws)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Fetch all the coins spent by the package which are not created by the
+    // package itself into m_view, so they are looked up in a single pass.
+    void PrefetchPackageCoins(const Package &package,
+                              std::vector<COutPoint> &coins_to_uncache)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
+    // Trim the pool to its maximum size and expire old transactions.
+    void LimitMempoolSize() EXCLUSIVE_LOCKS_REQUIRED(m_pool.cs);
+
 private:
     CTxMemPool &m_pool;
     CCoinsViewCache m_view;
@@ -710,10 +731,7 @@ bool MemPoolAccept::Finalize(ATMPArgs &args, Workspace &ws) {
 
     // Trim mempool and check if tx was trimmed.
     if (!bypass_limits) {
-        m_pool.LimitSize(
-            gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000,
-            std::chrono::hours{
-                gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
+        LimitMempoolSize();
         if (!m_pool.exists(txid)) {
             return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY,
                                  "mempool full");
@@ -722,6 +740,40 @@ bool MemPoolAccept::Finalize(ATMPArgs &args, Workspace &ws) {
     return true;
 }
 
+void MemPoolAccept::PrefetchPackageCoins(
+    const Package &package, std::vector<COutPoint> &coins_to_uncache) {
+    CCoinsViewCache &coins_cache = ::ChainstateActive().CoinsTip();
+    std::unordered_set<TxId, SaltedTxIdHasher> package_txids;
+
+    m_view.SetBackend(m_viewmempool);
+    for (const CTransactionRef &ptx : package) {
+        for (const CTxIn &txin : ptx->vin) {
+            if (package_txids.count(txin.prevout.GetTxId())) {
+                // This coin will be created by the package, it will be found
+                // in the mempool once its parent is accepted.
+                continue;
+            }
+
+            if (!coins_cache.HaveCoinInCache(txin.prevout)) {
+                coins_to_uncache.push_back(txin.prevout);
+            }
+
+            // Missing coins are not cached, they will be reported by
+            // PreChecks.
+            m_view.HaveCoin(txin.prevout);
+        }
+        package_txids.insert(ptx->GetId());
+    }
+    m_view.SetBackend(m_dummy);
+}
+
+void MemPoolAccept::LimitMempoolSize() {
+    m_pool.LimitSize(
+        gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000,
+        std::chrono::hours{
+            gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
+}
+
 bool MemPoolAccept::AcceptSingleTransaction(const CTransactionRef &ptx,
                                             ATMPArgs &args) {
     AssertLockHeld(cs_main);
@@ -760,6 +812,82 @@ bool MemPoolAccept::AcceptSingleTransaction(const CTransactionRef &ptx,
     return true;
 }
 
+bool MemPoolAccept::AcceptPackage(const Config &config, const Package &package,
+                                  std::vector<TxValidationState> &states,
+                                  int64_t accept_time, bool bypass_limits,
+                                  const CFeeRate &max_fee_rate,
+                                  std::vector<COutPoint> &coins_to_uncache) {
+    AssertLockHeld(cs_main);
+    // mempool "read lock" (held through
+    // GetMainSignals().TransactionAddedToMempool())
+    LOCK(m_pool.cs);
+
+    // The whole package is validated against the same tip.
+    const uint32_t next_block_script_verify_flags = GetNextBlockScriptFlags(
+        config.GetChainParams().GetConsensus(), ::ChainActive().Tip());
+
+    PrefetchPackageCoins(package, coins_to_uncache);
+
+    states.assign(package.size(), TxValidationState());
+    std::vector<bool> added(package.size(), false);
+
+    for (size_t i = 0; i < package.size(); i++) {
+        const CTransactionRef &ptx = package[i];
+        if (m_pool.exists(ptx->GetId())) {
+            // Nothing to do, this is not an error.
+            continue;
+        }
+
+        const Amount absurd_fee =
+            max_fee_rate.GetFee(GetVirtualTransactionSize(*ptx));
+        ATMPArgs args{config,        states[i],  accept_time,
+                      bypass_limits, absurd_fee, coins_to_uncache,
+                      /* m_test_accept */ false};
+        Workspace workspace(ptx, next_block_script_verify_flags);
+
+        if (!PreChecks(args, workspace)) {
+            continue;
+        }
+
+        PrecomputedTransactionData txdata(*ptx);
+        if (!ConsensusScriptChecks(args, workspace, txdata)) {
+            continue;
+        }
+
+        // Store the transaction in memory so its descendants in the package
+        // can find it. Trimming is deferred until the end of the package.
+        m_pool.addUnchecked(*workspace.m_entry, workspace.m_ancestors);
+        added[i] = true;
+    }
+
+    if (!bypass_limits) {
+        LimitMempoolSize();
+    }
+
+    bool all_accepted = true;
+    for (size_t i = 0; i < package.size(); i++) {
+        const CTransactionRef &ptx = package[i];
+        if (m_pool.exists(ptx->GetId())) {
+            if (added[i]) {
+                GetMainSignals().TransactionAddedToMempool(ptx);
+            }
+            continue;
+        }
+
+        all_accepted = false;
+        if (added[i]) {
+            states[i].Invalid(TxValidationResult::TX_MEMPOOL_POLICY,
+                              "mempool full");
+        } else if (states[i].IsValid()) {
+            // The checks failed without a reason, which can only happen in
+            // case of a bug (see ConsensusScriptChecks).
+            states[i].Error("mempool-error");
+        }
+    }
+
+    return all_accepted;
+}
+
 } // namespace
 
 /**
@@ -805,6 +933,82 @@ bool AcceptToMemoryPool(const Config &config, CTxMemPool &pool,
                                       bypass_limits, nAbsurdFee, test_accept);
 }
 
+bool CheckPackage(const Package &package, TxValidationState &state) {
+    if (package.empty()) {
+        return state.Invalid(TxValidationResult::TX_CONSENSUS,
+                             "package-empty");
+    }
+
+    if (package.size() > MAX_PACKAGE_COUNT) {
+        return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY,
+                             "package-too-many-transactions");
+    }
+
+    std::unordered_set<TxId, SaltedTxIdHasher> later_txids;
+    for (const CTransactionRef &ptx : package) {
+        later_txids.insert(ptx->GetId());
+    }
+
+    if (later_txids.size() != package.size()) {
+        return state.Invalid(TxValidationResult::TX_CONSENSUS,
+                             "package-contains-duplicates");
+    }
+
+    // A transaction must not spend the output of a transaction that comes
+    // later in the package. Walk the package in order and remove each
+    // transaction from the set once it has been visited.
+    std::unordered_set<COutPoint, SaltedOutpointHasher> spent_outpoints;
+    for (const CTransactionRef &ptx : package) {
+        for (const CTxIn &txin : ptx->vin) {
+            if (later_txids.count(txin.prevout.GetTxId())) {
+                return state.Invalid(TxValidationResult::TX_CONSENSUS,
+                                     "package-not-sorted");
+            }
+
+            if (!spent_outpoints.insert(txin.prevout).second) {
+                return state.Invalid(TxValidationResult::TX_CONSENSUS,
+                                     "package-conflicting-inputs");
+            }
+        }
+        later_txids.erase(ptx->GetId());
+    }
+
+    return true;
+}
+
+bool AcceptPackageToMemoryPool(const Config &config, CTxMemPool &pool,
+                               const Package &package,
+                               TxValidationState &package_state,
+                               std::vector<TxValidationState> &tx_states,
+                               bool bypass_limits,
+                               const CFeeRate &max_fee_rate) {
+    AssertLockHeld(cs_main);
+    if (!CheckPackage(package, package_state)) {
+        return false;
+    }
+
+    std::vector<COutPoint> coins_to_uncache;
+    const bool res = MemPoolAccept(pool).AcceptPackage(
+        config, package, tx_states, GetTime(), bypass_limits, max_fee_rate,
+        coins_to_uncache);
+
+    // Remove the coins that were not present in the coins cache before the
+    // package was processed, unless they are spent by an accepted transaction.
+    CCoinsViewCache &coins_cache = ::ChainstateActive().CoinsTip();
+    for (const COutPoint &outpoint : coins_to_uncache) {
+        if (!pool.isSpent(outpoint)) {
+            coins_cache.Uncache(outpoint);
+        }
+    }
+
+    // After we've (potentially) uncached entries, ensure our coins cache is
+    // still within its size limits
+    BlockValidationState stateDummy;
+    ::ChainstateActive().FlushStateToDisk(config.GetChainParams(), stateDummy,
+                                          FlushStateMode::PERIODIC);
+    return res;
+}
+
 /**
  * Return transaction in txOut, and if it was found inside a block, its hash is
  * placed in hashBlock. If blockIndex is provided, the transaction is fetched
@@ -5847,6 +6051,58 @@ int VersionBitsTipStateSinceHeight(const Consensus::Params &params,
 
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
 
+/**
+ * Number of transactions from mempool.dat whose scripts are checked in
+ * parallel before they are added to the mempool.
+ */
+static const size_t MEMPOOL_LOAD_BATCH_SIZE = 1000;
+
+/**
+ * Run the script checks of a batch of transactions loaded from mempool.dat on
+ * the script check threads, so their signatures are in the signature cache by
+ * the time the transactions are accepted to the mempool one by one.
+ *
+ * The file is not trusted: all the checks are run again by
+ * AcceptToMemoryPool. A failure here only means part of the batch is not
+ * cached.
+ */
+static void WarmSignatureCache(
+    const Config &config, const CTxMemPool &pool,
+    const std::vector<std::pair<CTransactionRef, int64_t>> &batch) {
+    std::vector<CScriptCheck> checks;
+    {
+        LOCK2(cs_main, pool.cs);
+        const uint32_t flags =
+            STANDARD_SCRIPT_VERIFY_FLAGS |
+            GetNextBlockScriptFlags(config.GetChainParams().GetConsensus(),
+                                    ::ChainActive().Tip());
+
+        CCoinsViewMemPool viewmempool(&::ChainstateActive().CoinsTip(), pool);
+        CCoinsViewCache view(&viewmempool);
+        for (const auto &entry : batch) {
+            const CTransaction &tx = *entry.first;
+            if (tx.IsCoinBase() || !view.HaveInputs(tx)) {
+                continue;
+            }
+
+            const PrecomputedTransactionData txdata(tx);
+            for (size_t i = 0; i < tx.vin.size(); i++) {
+                const Coin &coin = view.AccessCoin(tx.vin[i].prevout);
+                checks.emplace_back(coin.GetTxOut(), tx, i, flags,
+                                    /* cacheStore = */ true, txdata);
+            }
+
+            // The mempool is dumped in topological order, so this makes the
+            // outputs available to the descendants in the same batch.
+            AddCoins(view, tx, MEMPOOL_HEIGHT);
+        }
+    }
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(checks);
+    control.Wait();
+}
+
 bool LoadMempool(const Config &config, CTxMemPool &pool) {
     int64_t nExpiryTimeout =
         gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY) * 60 * 60;
@@ -5874,24 +6130,22 @@ bool LoadMempool(const Config &config, CTxMemPool &pool) {
 
         uint64_t num;
         file >> num;
-        while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            Amount amountdelta = nFeeDelta * SATOSHI;
-            if (amountdelta != Amount::zero()) {
-                pool.PrioritiseTransaction(tx->GetId(), amountdelta);
-            }
-            TxValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(
-                    config, pool, state, tx, nTime, false /* bypass_limits */,
-                    Amount::zero() /* nAbsurdFee */, false /* test_accept */);
+        std::vector<std::pair<CTransactionRef, int64_t>> batch;
+        // Accept the transactions read so far, return false on shutdown.
+        const auto accept_batch = [&]() {
+            WarmSignatureCache(config, pool, batch);
+
+            for (const auto &entry : batch) {
+                const CTransactionRef &tx = entry.first;
+                TxValidationState state;
+                {
+                    LOCK(cs_main);
+                    AcceptToMemoryPoolWithTime(
+                        config, pool, state, tx, entry.second,
+                        false /* bypass_limits */,
+                        Amount::zero() /* nAbsurdFee */,
+                        false /* test_accept */);
+                }
                 if (state.IsValid()) {
                     ++count;
                 } else {
@@ -5905,11 +6159,46 @@ bool LoadMempool(const Config &config, CTxMemPool &pool) {
                         ++failed;
                     }
                 }
-            } else {
-                ++expired;
+
+                if (ShutdownRequested()) {
+                    return false;
+                }
             }
+            batch.clear();
+            return true;
+        };
 
-            if (ShutdownRequested()) {
+        while (num) {
+            try {
+                while (num && batch.size() < MEMPOOL_LOAD_BATCH_SIZE) {
+                    --num;
+                    CTransactionRef tx;
+                    int64_t nTime;
+                    int64_t nFeeDelta;
+                    file >> tx;
+                    file >> nTime;
+                    file >> nFeeDelta;
+
+                    Amount amountdelta = nFeeDelta * SATOSHI;
+                    if (amountdelta != Amount::zero()) {
+                        pool.PrioritiseTransaction(tx->GetId(), amountdelta);
+                    }
+                    if (nTime + nExpiryTimeout > nNow) {
+                        batch.emplace_back(std::move(tx), nTime);
+                    } else {
+                        ++expired;
+                    }
+                }
+            } catch (const std::exception &) {
+                // Still accept the transactions that were read before the
+                // error, like when they were accepted one at a time.
+                if (!accept_batch()) {
+                    return false;
+                }
+                throw;
+            }
+
+            if (!accept_batch()) {
                 return false;
             }
         }
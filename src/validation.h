@@ -291,6 +291,47 @@ bool AcceptToMemoryPool(const Config &config, CTxMemPool &pool,
                         bool test_accept = false)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * A package is an ordered list of transactions. Each transaction can only
+ * spend outputs from the UTXO set, from the mempool or from the transactions
+ * that appear before it in the package.
+ */
+using Package = std::vector<CTransactionRef>;
+
+/** Maximum number of transactions in a package. */
+static const unsigned int MAX_PACKAGE_COUNT = 50;
+
+/**
+ * Context-free checks on a package: it must not be empty nor contain more than
+ * MAX_PACKAGE_COUNT transactions, it must be topologically sorted and it must
+ * not contain duplicated transactions or transactions spending the same
+ * output.
+ */
+bool CheckPackage(const Package &package, TxValidationState &state);
+
+/**
+ * (try to) add a package of transactions to the memory pool.
+ *
+ * The package is validated in a single pass under a single mempool lock: the
+ * script flags are computed once, the coins spent by the package are fetched
+ * up front and the mempool is only trimmed after the whole package has been
+ * processed. A rejected transaction does not stop the processing of the
+ * package, but its descendants will fail with missing inputs.
+ *
+ * @param[out] package_state Reason for which the whole package was rejected
+ * @param[out] tx_states Validation state of each transaction, in the package
+ *                       order. Only filled if the package passed CheckPackage.
+ * @param[in]  max_fee_rate Reject transactions paying more than this fee rate
+ *                          (if 0, accept any fee).
+ * @return true if all the transactions of the package are in the mempool.
+ */
+bool AcceptPackageToMemoryPool(const Config &config, CTxMemPool &pool,
+                               const Package &package,
+                               TxValidationState &package_state,
+                               std::vector<TxValidationState> &tx_states,
+                               bool bypass_limits, const CFeeRate &max_fee_rate)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /**
  * Simple class for regulating resource usage during CheckInputScripts (and
  * CScriptCheck), atomic so as to be compatible with parallel validation.
@@ -348,7 +348,7 @@ void BerkeleyEnvironment::CheckpointLSN(const std::string &strFile) {
 
 BerkeleyBatch::BerkeleyBatch(BerkeleyDatabase &database, const char *pszMode,
                              bool fFlushOnCloseIn)
-    : pdb(nullptr), activeTxn(nullptr) {
+    : pdb(nullptr), activeTxn(nullptr), m_cursor(nullptr) {
     fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
     fFlushOnClose = fFlushOnCloseIn;
     env = database.env.get();
@@ -473,6 +473,7 @@ void BerkeleyBatch::Close() {
     }
     activeTxn = nullptr;
     pdb = nullptr;
+    CloseCursor();
 
     if (fFlushOnClose) {
         Flush();
@@ -561,19 +562,18 @@ bool BerkeleyDatabase::Rewrite(const char *pszSkip) {
                         fSuccess = false;
                     }
 
-                    Dbc *pcursor = db.GetCursor();
-                    if (pcursor) {
+                    if (db.StartCursor()) {
                         while (fSuccess) {
                             CDataStream ssKey(SER_DISK, CLIENT_VERSION);
                             CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-                            int ret1 = db.ReadAtCursor(pcursor, ssKey, ssValue);
-                            if (ret1 == DB_NOTFOUND) {
-                                pcursor->close();
+                            bool complete;
+                            bool ret1 =
+                                db.ReadAtCursor(ssKey, ssValue, complete);
+                            if (!ret1) {
+                                fSuccess = false;
                                 break;
                             }
-                            if (ret1 != 0) {
-                                pcursor->close();
-                                fSuccess = false;
+                            if (complete) {
                                 break;
                             }
                             if (pszSkip &&
@@ -596,6 +596,7 @@ bool BerkeleyDatabase::Rewrite(const char *pszSkip) {
                             }
                         }
                     }
+                    db.CloseCursor();
                     if (fSuccess) {
                         db.Close();
                         env->CloseDb(strFile);
@@ -793,28 +794,33 @@ void BerkeleyDatabase::ReloadDbEnv() {
     }
 }
 
-Dbc *BerkeleyBatch::GetCursor() {
+bool BerkeleyBatch::StartCursor() {
+    CloseCursor();
     if (!pdb) {
-        return nullptr;
-    }
-    Dbc *pcursor = nullptr;
-    int ret = pdb->cursor(nullptr, &pcursor, 0);
-    if (ret != 0) {
-        return nullptr;
+        return false;
     }
-    return pcursor;
+    int ret = pdb->cursor(nullptr, &m_cursor, 0);
+    return ret == 0;
 }
 
-int BerkeleyBatch::ReadAtCursor(Dbc *pcursor, CDataStream &ssKey,
-                                CDataStream &ssValue) {
+bool BerkeleyBatch::ReadAtCursor(CDataStream &ssKey, CDataStream &ssValue,
+                                 bool &complete) {
+    complete = false;
+    if (m_cursor == nullptr) {
+        return false;
+    }
     // Read at cursor
     SafeDbt datKey;
     SafeDbt datValue;
-    int ret = pcursor->get(datKey, datValue, DB_NEXT);
+    int ret = m_cursor->get(datKey, datValue, DB_NEXT);
+    if (ret == DB_NOTFOUND) {
+        complete = true;
+        return true;
+    }
     if (ret != 0) {
-        return ret;
+        return false;
     } else if (datKey.get_data() == nullptr || datValue.get_data() == nullptr) {
-        return 99999;
+        return false;
     }
 
     // Convert to streams
@@ -824,7 +830,15 @@ int BerkeleyBatch::ReadAtCursor(Dbc *pcursor, CDataStream &ssKey,
     ssValue.SetType(SER_DISK);
     ssValue.clear();
     ssValue.write((char *)datValue.get_data(), datValue.get_size());
-    return 0;
+    return true;
+}
+
+void BerkeleyBatch::CloseCursor() {
+    if (!m_cursor) {
+        return;
+    }
+    m_cursor->close();
+    m_cursor = nullptr;
 }
 
 bool BerkeleyBatch::TxnBegin() {
@@ -925,3 +939,8 @@ bool BerkeleyBatch::HasKey(CDataStream &key) {
     int ret = pdb->exists(activeTxn, datKey, 0);
     return ret == 0;
 }
+
+std::unique_ptr<DatabaseBatch>
+BerkeleyDatabase::MakeBatch(const char *mode, bool flush_on_close) {
+    return std::make_unique<BerkeleyBatch>(*this, mode, flush_on_close);
+}
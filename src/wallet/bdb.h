@@ -106,27 +106,24 @@ bool IsBDBWalletLoaded(const fs::path &wallet_path);
  * An instance of this class represents one database.
  * For BerkeleyDB this is just a (env, strFile) tuple.
  */
-class BerkeleyDatabase {
+class BerkeleyDatabase : public WalletDatabase {
     friend class BerkeleyBatch;
 
 public:
     /** Create dummy DB handle */
-    BerkeleyDatabase()
-        : nUpdateCounter(0), nLastSeen(0), nLastFlushed(0),
-          nLastWalletUpdate(0), env(nullptr) {}
+    BerkeleyDatabase() : WalletDatabase(), env(nullptr) {}
 
     /** Create DB handle to real database */
     BerkeleyDatabase(std::shared_ptr<BerkeleyEnvironment> envIn,
                      std::string filename)
-        : nUpdateCounter(0), nLastSeen(0), nLastFlushed(0),
-          nLastWalletUpdate(0), env(std::move(envIn)),
+        : WalletDatabase(), env(std::move(envIn)),
           strFile(std::move(filename)) {
         auto inserted =
             this->env->m_databases.emplace(strFile, std::ref(*this));
         assert(inserted.second);
     }
 
-    ~BerkeleyDatabase() {
+    ~BerkeleyDatabase() override {
         if (env) {
             size_t erased = env->m_databases.erase(strFile);
             assert(erased == 1);
@@ -137,35 +134,34 @@ public:
      * Rewrite the entire database on disk, with the exception of key pszSkip if
      * non-zero
      */
-    bool Rewrite(const char *pszSkip = nullptr);
+    bool Rewrite(const char *pszSkip = nullptr) override;
 
     /**
      * Back up the entire database to a file.
      */
-    bool Backup(const std::string &strDest) const;
+    bool Backup(const std::string &strDest) const override;
 
     /**
      * Make sure all changes are flushed to disk.
      */
-    void Flush(bool shutdown);
+    void Flush(bool shutdown) override;
 
     /*
      * flush the wallet passively (TRY_LOCK)
      * ideal to be called periodically
      */
-    bool PeriodicFlush();
+    bool PeriodicFlush() override;
 
-    void IncrementUpdateCounter();
+    void IncrementUpdateCounter() override;
 
-    void ReloadDbEnv();
-
-    std::atomic<unsigned int> nUpdateCounter;
-    unsigned int nLastSeen;
-    unsigned int nLastFlushed;
-    int64_t nLastWalletUpdate;
+    void ReloadDbEnv() override;
 
     /** Verifies the environment and database file */
-    bool Verify(bilingual_str &error);
+    bool Verify(bilingual_str &error) override;
+
+    /** Make a BerkeleyBatch connected to this database */
+    std::unique_ptr<DatabaseBatch>
+    MakeBatch(const char *mode = "r+", bool flush_on_close = true) override;
 
     /**
      * Pointer to shared database environment.
@@ -196,7 +192,7 @@ private:
 };
 
 /** RAII class that provides access to a Berkeley database */
-class BerkeleyBatch {
+class BerkeleyBatch : public DatabaseBatch {
     /** RAII class that automatically cleanses its data on destruction */
     class SafeDbt final {
         Dbt m_dbt;
@@ -217,15 +213,17 @@ class BerkeleyBatch {
     };
 
 private:
-    bool ReadKey(CDataStream &key, CDataStream &value);
-    bool WriteKey(CDataStream &key, CDataStream &value, bool overwrite = true);
-    bool EraseKey(CDataStream &key);
-    bool HasKey(CDataStream &key);
+    bool ReadKey(CDataStream &key, CDataStream &value) override;
+    bool WriteKey(CDataStream &key, CDataStream &value,
+                  bool overwrite = true) override;
+    bool EraseKey(CDataStream &key) override;
+    bool HasKey(CDataStream &key) override;
 
 protected:
     Db *pdb;
     std::string strFile;
     DbTxn *activeTxn;
+    Dbc *m_cursor;
     bool fReadOnly;
     bool fFlushOnClose;
     BerkeleyEnvironment *env;
@@ -234,76 +232,21 @@ public:
     explicit BerkeleyBatch(BerkeleyDatabase &database,
                            const char *pszMode = "r+",
                            bool fFlushOnCloseIn = true);
-    ~BerkeleyBatch() { Close(); }
+    ~BerkeleyBatch() override { Close(); }
 
     BerkeleyBatch(const BerkeleyBatch &) = delete;
     BerkeleyBatch &operator=(const BerkeleyBatch &) = delete;
 
-    void Flush();
-    void Close();
-
-    template <typename K, typename T> bool Read(const K &key, T &value) {
-        // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(1000);
-        ssKey << key;
-
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-        bool success = false;
-        bool ret = ReadKey(ssKey, ssValue);
-        if (ret) {
-            // Unserialize value
-            try {
-                ssValue >> value;
-                success = true;
-            } catch (const std::exception &) {
-                // In this case success remains 'false'
-            }
-        }
-        return ret && success;
-    }
-
-    template <typename K, typename T>
-    bool Write(const K &key, const T &value, bool fOverwrite = true) {
-        // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(1000);
-        ssKey << key;
-
-        // Value
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-        ssValue.reserve(10000);
-        ssValue << value;
-
-        // Write
-        return WriteKey(ssKey, ssValue, fOverwrite);
-    }
-
-    template <typename K> bool Erase(const K &key) {
-        // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(1000);
-        ssKey << key;
-
-        // Erase
-        return EraseKey(ssKey);
-    }
-
-    template <typename K> bool Exists(const K &key) {
-        // Key
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey.reserve(1000);
-        ssKey << key;
-
-        // Exists
-        return HasKey(ssKey);
-    }
+    void Flush() override;
+    void Close() override;
 
-    Dbc *GetCursor();
-    int ReadAtCursor(Dbc *pcursor, CDataStream &ssKey, CDataStream &ssValue);
-    bool TxnBegin();
-    bool TxnCommit();
-    bool TxnAbort();
+    bool StartCursor() override;
+    bool ReadAtCursor(CDataStream &ssKey, CDataStream &ssValue,
+                      bool &complete) override;
+    void CloseCursor() override;
+    bool TxnBegin() override;
+    bool TxnCommit() override;
+    bool TxnAbort() override;
 };
 
 #endif // BITCOIN_WALLET_BDB_H
@@ -19,6 +19,7 @@
 #include <util/moneystr.h>
 #include <util/system.h>
 
+#include <algorithm>
 #include <optional>
 
 // Descending order comparator
@@ -80,6 +81,13 @@ struct {
 
 static const size_t TOTAL_TRIES = 100000;
 
+/**
+ * Maximum number of groups the stochastic approximation of the knapsack solver
+ * works on. Each of its iterations goes through all of them, so with huge UTXO
+ * pools only the largest ones are considered.
+ */
+static const size_t KNAPSACK_MAX_CANDIDATES = 5000;
+
 bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
                     const Amount &target_value, const Amount &cost_of_change,
                     std::set<CInputCoin> &out_set, Amount &value_ret,
@@ -92,6 +100,27 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
     curr_selection.reserve(utxo_pool.size());
     Amount actual_target = not_input_fees + target_value;
 
+    // Sort the utxo_pool
+    std::sort(utxo_pool.begin(), utxo_pool.end(), descending);
+
+    // Whether including more UTXOs makes the waste increase. Every group is
+    // charged at the same fee rates, so the first one tells.
+    const bool waste_increases_with_inputs =
+        !utxo_pool.empty() &&
+        (utxo_pool.front().fee - utxo_pool.front().long_term_fee) >
+            Amount::zero();
+
+    // A UTXO worth more than the upper bound of the range exceeds it on its
+    // own, so it cannot be part of any solution. Leave those out of the search
+    // instead of spending tries on them, which matters for large pools.
+    utxo_pool.erase(utxo_pool.begin(),
+                    std::partition_point(utxo_pool.begin(), utxo_pool.end(),
+                                         [&](const OutputGroup &utxo) {
+                                             return utxo.effective_value >
+                                                    actual_target +
+                                                        cost_of_change;
+                                         }));
+
     // Calculate curr_available_value
     Amount curr_available_value = Amount::zero();
     for (const OutputGroup &utxo : utxo_pool) {
@@ -104,9 +133,6 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
         return false;
     }
 
-    // Sort the utxo_pool
-    std::sort(utxo_pool.begin(), utxo_pool.end(), descending);
-
     Amount curr_waste = Amount::zero();
     std::vector<bool> best_selection;
     Amount best_waste = MAX_MONEY;
@@ -122,9 +148,7 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
                 actual_target +
                     cost_of_change || // Selected value is out of range, go back
                                       // and try other branch
-            (curr_waste > best_waste &&
-             (utxo_pool.at(0).fee - utxo_pool.at(0).long_term_fee) >
-                 Amount::zero())) {
+            (curr_waste > best_waste && waste_increases_with_inputs)) {
             // Don't select things which we know will be more wasteful if the
             // waste is increasing
             backtrack = true;
@@ -307,6 +331,21 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
 
     // Solve subset sum by stochastic approximation
     std::sort(applicable_groups.begin(), applicable_groups.end(), descending);
+
+    // Bound the work on huge pools: keep the largest groups, but at least
+    // enough of them to reach the target with change.
+    if (applicable_groups.size() > KNAPSACK_MAX_CANDIDATES) {
+        Amount nTotalWindow = Amount::zero();
+        size_t nWindow = 0;
+        while (nWindow < applicable_groups.size() &&
+               (nWindow < KNAPSACK_MAX_CANDIDATES ||
+                nTotalWindow < nTargetValue + MIN_CHANGE)) {
+            nTotalWindow += applicable_groups[nWindow++].m_value;
+        }
+        applicable_groups.resize(nWindow);
+        nTotalLower = nTotalWindow;
+    }
+
     std::vector<char> vfBest;
     Amount nBest;
 
@@ -18,10 +18,16 @@
 #ifndef BITCOIN_WALLET_DB_H
 #define BITCOIN_WALLET_DB_H
 
+#include <clientversion.h>
 #include <fs.h>
+#include <streams.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
 
+struct bilingual_str;
+
 /**
  * Given a wallet directory path or legacy file path, return path to main data
  * file in the wallet database. */
@@ -29,4 +35,159 @@ fs::path WalletDataFilePath(const fs::path &wallet_path);
 void SplitWalletPath(const fs::path &wallet_path, fs::path &env_directory,
                      std::string &database_filename);
 
+/** RAII class that provides access to a WalletDatabase */
+class DatabaseBatch {
+private:
+    virtual bool ReadKey(CDataStream &key, CDataStream &value) = 0;
+    virtual bool WriteKey(CDataStream &key, CDataStream &value,
+                          bool overwrite = true) = 0;
+    virtual bool EraseKey(CDataStream &key) = 0;
+    virtual bool HasKey(CDataStream &key) = 0;
+
+public:
+    explicit DatabaseBatch() {}
+    virtual ~DatabaseBatch() {}
+
+    DatabaseBatch(const DatabaseBatch &) = delete;
+    DatabaseBatch &operator=(const DatabaseBatch &) = delete;
+
+    virtual void Flush() = 0;
+    virtual void Close() = 0;
+
+    template <typename K, typename T> bool Read(const K &key, T &value) {
+        // Key
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(1000);
+        ssKey << key;
+
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        bool success = false;
+        bool ret = ReadKey(ssKey, ssValue);
+        if (ret) {
+            // Unserialize value
+            try {
+                ssValue >> value;
+                success = true;
+            } catch (const std::exception &) {
+                // In this case success remains 'false'
+            }
+        }
+        return ret && success;
+    }
+
+    template <typename K, typename T>
+    bool Write(const K &key, const T &value, bool fOverwrite = true) {
+        // Key
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(1000);
+        ssKey << key;
+
+        // Value
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        ssValue.reserve(10000);
+        ssValue << value;
+
+        // Write
+        return WriteKey(ssKey, ssValue, fOverwrite);
+    }
+
+    template <typename K> bool Erase(const K &key) {
+        // Key
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(1000);
+        ssKey << key;
+
+        // Erase
+        return EraseKey(ssKey);
+    }
+
+    template <typename K> bool Exists(const K &key) {
+        // Key
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        ssKey.reserve(1000);
+        ssKey << key;
+
+        // Exists
+        return HasKey(ssKey);
+    }
+
+    /** Start iterating over all the records, closing any previous cursor. */
+    virtual bool StartCursor() = 0;
+    /**
+     * Read the next record. Sets complete and returns true once all the
+     * records have been read, returns false on error.
+     */
+    virtual bool ReadAtCursor(CDataStream &ssKey, CDataStream &ssValue,
+                              bool &complete) = 0;
+    virtual void CloseCursor() = 0;
+    /**
+     * Start a transaction, committed by TxnCommit() or undone by TxnAbort().
+     * What it covers depends on the backend. A SQLite transaction spans the
+     * whole database connection, so it covers the writes of all the batches
+     * of this thread, while the writes of the other threads wait for it to
+     * end. Only one can be open at a time. A Berkeley DB transaction only
+     * covers the writes of this batch, the other batches keep committing
+     * theirs on their own.
+     */
+    virtual bool TxnBegin() = 0;
+    virtual bool TxnCommit() = 0;
+    virtual bool TxnAbort() = 0;
+};
+
+/**
+ * An instance of this class represents one database.
+ */
+class WalletDatabase {
+public:
+    /** Create dummy DB handle */
+    WalletDatabase()
+        : nUpdateCounter(0), nLastSeen(0), nLastFlushed(0),
+          nLastWalletUpdate(0) {}
+    virtual ~WalletDatabase() {}
+
+    /**
+     * Rewrite the entire database on disk, with the exception of key pszSkip if
+     * non-zero
+     */
+    virtual bool Rewrite(const char *pszSkip = nullptr) = 0;
+
+    /**
+     * Back up the entire database to a file.
+     */
+    virtual bool Backup(const std::string &strDest) const = 0;
+
+    /**
+     * Make sure all changes are flushed to disk.
+     */
+    virtual void Flush(bool shutdown) = 0;
+
+    /*
+     * flush the wallet passively (TRY_LOCK)
+     * ideal to be called periodically
+     */
+    virtual bool PeriodicFlush() = 0;
+
+    virtual void IncrementUpdateCounter() = 0;
+
+    virtual void ReloadDbEnv() = 0;
+
+    /** Verifies the environment and database file */
+    virtual bool Verify(bilingual_str &error) = 0;
+
+    std::atomic<unsigned int> nUpdateCounter;
+    unsigned int nLastSeen;
+    unsigned int nLastFlushed;
+    int64_t nLastWalletUpdate;
+
+    /** Make a DatabaseBatch connected to this database */
+    virtual std::unique_ptr<DatabaseBatch>
+    MakeBatch(const char *mode = "r+", bool flush_on_close = true) = 0;
+};
+
+/** The storage formats a wallet database can use. */
+enum class DatabaseFormat {
+    BERKELEY,
+    SQLITE,
+};
+
 #endif // BITCOIN_WALLET_DB_H
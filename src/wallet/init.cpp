@@ -62,10 +62,16 @@ void WalletInit::AddWalletOptions(ArgsManager &argsman) const {
                   DEFAULT_AVOIDPARTIALSPENDS),
         ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
 
+    const auto &ticker = Currency::get().ticker;
+    argsman.AddArg("-consolidatefeerate=<amt>",
+                   strprintf("Fee rate (in %s/kB) below which coin selection "
+                             "spends more inputs to consolidate the wallet's "
+                             "outputs. 0 to disable (default: %s)",
+                             ticker, FormatMoney(DEFAULT_CONSOLIDATE_FEERATE)),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-disablewallet",
                    "Do not load the wallet and disable wallet RPC calls",
                    ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
-    const auto &ticker = Currency::get().ticker;
     argsman.AddArg("-fallbackfee=<amt>",
                    strprintf("A fee rate (in %s/kB) that will be used when fee "
                              "estimation has insufficient data. 0 to entirely "
@@ -1828,6 +1828,10 @@ UniValue importmulti(const Config &config, const JSONRPCRequest &mainRequest) {
 
         const int64_t minimumTimestamp = 1;
 
+        // Commit the imported records at once rather than one by one. With
+        // SQLite this spans the writes of the key managers.
+        WalletBatch batch(pwallet->GetDatabase(), "r+", false);
+        const bool txn = batch.TxnBegin();
         for (const UniValue &data : requests.getValues()) {
             const int64_t timestamp =
                 std::max(GetImportTimestamp(data, now), minimumTimestamp);
@@ -1848,6 +1852,11 @@ UniValue importmulti(const Config &config, const JSONRPCRequest &mainRequest) {
                 nLowestTimestamp = timestamp;
             }
         }
+        if (txn && !batch.TxnCommit()) {
+            throw JSONRPCError(RPC_WALLET_ERROR,
+                               "Error: Unable to write the imported data to "
+                               "the wallet database");
+        }
     }
     if (fRescan && fRunScan && requests.size()) {
         int64_t scannedTime = pwallet->RescanFromTime(
@@ -2236,6 +2245,9 @@ UniValue importdescriptors(const Config &config,
             pwallet->GetLastBlockHash(),
             FoundBlock().time(lowest_timestamp).mtpTime(now)));
 
+        // Commit the imported records at once rather than one by one
+        WalletBatch batch(pwallet->GetDatabase(), "r+", false);
+        const bool txn = batch.TxnBegin();
         // Get all timestamps and extract the lowest timestamp
         for (const UniValue &request : requests.getValues()) {
             // This throws an error if "timestamp" doesn't exist
@@ -2255,6 +2267,11 @@ UniValue importdescriptors(const Config &config,
                 rescan = true;
             }
         }
+        if (txn && !batch.TxnCommit()) {
+            throw JSONRPCError(RPC_WALLET_ERROR,
+                               "Error: Unable to write the imported data to "
+                               "the wallet database");
+        }
         pwallet->ConnectScriptPubKeyManNotifiers();
     }
 
@@ -731,7 +731,12 @@ bool LegacyScriptPubKeyMan::LoadCScript(const CScript &redeemScript) {
         return true;
     }
 
-    return FillableSigningProvider::AddCScript(redeemScript);
+    if (!FillableSigningProvider::AddCScript(redeemScript)) {
+        return false;
+    }
+    m_storage.AddOwnedScriptPubKey(
+        GetScriptForDestination(ScriptHash(redeemScript)));
+    return true;
 }
 
 void LegacyScriptPubKeyMan::LoadKeyMetadata(const CKeyID &keyID,
@@ -752,7 +757,11 @@ bool LegacyScriptPubKeyMan::AddKeyPubKeyInner(const CKey &key,
                                               const CPubKey &pubkey) {
     LOCK(cs_KeyStore);
     if (!m_storage.HasEncryptionKeys()) {
-        return FillableSigningProvider::AddKeyPubKey(key, pubkey);
+        if (!FillableSigningProvider::AddKeyPubKey(key, pubkey)) {
+            return false;
+        }
+        AddKeyScriptPubKeys(pubkey);
+        return true;
     }
 
     if (m_storage.IsLocked()) {
@@ -789,9 +798,17 @@ bool LegacyScriptPubKeyMan::AddCryptedKeyInner(
     assert(mapKeys.empty());
 
     mapCryptedKeys[vchPubKey.GetID()] = make_pair(vchPubKey, vchCryptedSecret);
+    AddKeyScriptPubKeys(vchPubKey);
     return true;
 }
 
+void LegacyScriptPubKeyMan::AddKeyScriptPubKeys(const CPubKey &pubkey) {
+    // These are the only scripts IsMine considers ours because of a key:
+    // bare multisig is not, and P2SH goes through AddCScript.
+    m_storage.AddOwnedScriptPubKey(GetScriptForRawPubKey(pubkey));
+    m_storage.AddOwnedScriptPubKey(GetScriptForDestination(PKHash(pubkey)));
+}
+
 bool LegacyScriptPubKeyMan::AddCryptedKey(
     const CPubKey &vchPubKey, const std::vector<uint8_t> &vchCryptedSecret) {
     if (!AddCryptedKeyInner(vchPubKey, vchCryptedSecret)) {
@@ -849,6 +866,7 @@ bool LegacyScriptPubKeyMan::LoadWatchOnly(const CScript &dest) {
 bool LegacyScriptPubKeyMan::AddWatchOnlyInMem(const CScript &dest) {
     LOCK(cs_KeyStore);
     setWatchOnly.insert(dest);
+    m_storage.AddOwnedScriptPubKey(dest);
     CPubKey pubKey;
     if (ExtractPubKey(dest, pubKey)) {
         mapWatchKeys[pubKey.GetID()] = pubKey;
@@ -1500,6 +1518,8 @@ bool LegacyScriptPubKeyMan::AddCScriptWithDB(WalletBatch &batch,
     if (!FillableSigningProvider::AddCScript(redeemScript)) {
         return false;
     }
+    m_storage.AddOwnedScriptPubKey(
+        GetScriptForDestination(ScriptHash(redeemScript)));
     if (batch.WriteCScript(Hash160(redeemScript), redeemScript)) {
         m_storage.UnsetBlankWalletFlag(batch);
         return true;
@@ -1828,12 +1848,30 @@ bool DescriptorScriptPubKeyMan::TopUp(unsigned int size) {
 
     WalletBatch batch(m_storage.GetDatabase());
     uint256 id = GetID();
+    // Keys of the range derived at once from the cached parent xpubs. The
+    // cache is empty until the first position is expanded.
+    DescriptorCache range_cache;
+    bool range_cached = !m_wallet_descriptor.descriptor->IsRange();
     for (int32_t i = m_max_cached_index + 1; i < new_range_end; ++i) {
+        if (!range_cached) {
+            for (const auto &parent :
+                 m_wallet_descriptor.cache.GetCachedParentExtPubKeys()) {
+                range_cache.CacheParentExtPubKey(parent.first, parent.second);
+                range_cached = true;
+            }
+            if (range_cached) {
+                m_wallet_descriptor.descriptor->CacheDerivedExtPubKeys(
+                    i, new_range_end - i, range_cache);
+            }
+        }
+
         FlatSigningProvider out_keys;
         std::vector<CScript> scripts_temp;
         DescriptorCache temp_cache;
         // Maybe we have a cached xpub and we can expand from the cache first
         if (!m_wallet_descriptor.descriptor->ExpandFromCache(
+                i, range_cache, scripts_temp, out_keys) &&
+            !m_wallet_descriptor.descriptor->ExpandFromCache(
                 i, m_wallet_descriptor.cache, scripts_temp, out_keys)) {
             if (!m_wallet_descriptor.descriptor->Expand(
                     i, provider, scripts_temp, out_keys, &temp_cache)) {
@@ -1843,6 +1881,7 @@ bool DescriptorScriptPubKeyMan::TopUp(unsigned int size) {
         // Add all of the scriptPubKeys to the scriptPubKey set
         for (const CScript &script : scripts_temp) {
             m_map_script_pub_keys[script] = i;
+            m_storage.AddOwnedScriptPubKey(script);
         }
         for (const auto &pk_pair : out_keys.pubkeys) {
             const CPubKey &pubkey = pk_pair.second;
@@ -2299,6 +2338,7 @@ void DescriptorScriptPubKeyMan::SetCache(const DescriptorCache &cache) {
                               i, m_map_script_pub_keys[script]));
             }
             m_map_script_pub_keys[script] = i;
+            m_storage.AddOwnedScriptPubKey(script);
         }
         for (const auto &pk_pair : out_keys.pubkeys) {
             const CPubKey &pubkey = pk_pair.second;
@@ -2355,13 +2395,16 @@ const WalletDescriptor DescriptorScriptPubKeyMan::GetWalletDescriptor() const {
     return m_wallet_descriptor;
 }
 
-const std::vector<CScript> DescriptorScriptPubKeyMan::GetScriptPubKeys() const {
+const std::vector<CScript>
+DescriptorScriptPubKeyMan::GetScriptPubKeys(int32_t minimum_index) const {
     LOCK(cs_desc_man);
     std::vector<CScript> script_pub_keys;
     script_pub_keys.reserve(m_map_script_pub_keys.size());
 
     for (auto const &script_pub_key : m_map_script_pub_keys) {
-        script_pub_keys.push_back(script_pub_key.first);
+        if (script_pub_key.second >= minimum_index) {
+            script_pub_keys.push_back(script_pub_key.first);
+        }
     }
     return script_pub_keys;
 }
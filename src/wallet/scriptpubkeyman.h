@@ -57,6 +57,9 @@ public:
     virtual const CKeyingMaterial &GetEncryptionKey() const = 0;
     virtual bool HasEncryptionKeys() const = 0;
     virtual bool IsLocked() const = 0;
+    //! Called with every scriptPubKey that a ScriptPubKeyMan may consider as
+    //! its own, from then on. Used to answer IsMine quickly for other scripts.
+    virtual void AddOwnedScriptPubKey(const CScript &script) = 0;
 };
 
 //! Default for -keypool
@@ -350,6 +353,8 @@ private:
     int64_t nTimeFirstKey GUARDED_BY(cs_KeyStore) = 0;
 
     bool AddKeyPubKeyInner(const CKey &key, const CPubKey &pubkey);
+    //! Report the scriptPubKeys paying to the key to the wallet
+    void AddKeyScriptPubKeys(const CPubKey &pubkey);
     bool AddCryptedKeyInner(const CPubKey &vchPubKey,
                             const std::vector<uint8_t> &vchCryptedSecret);
 
@@ -794,7 +799,9 @@ public:
 
     const WalletDescriptor GetWalletDescriptor() const
         EXCLUSIVE_LOCKS_REQUIRED(cs_desc_man);
-    const std::vector<CScript> GetScriptPubKeys() const;
+    //! The scriptPubKeys at descriptor range index minimum_index and above.
+    const std::vector<CScript>
+    GetScriptPubKeys(int32_t minimum_index = 0) const;
 };
 
 #endif // BITCOIN_WALLET_SCRIPTPUBKEYMAN_H
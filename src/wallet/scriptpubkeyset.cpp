@@ -0,0 +1,83 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/scriptpubkeyset.h>
+
+#include <crypto/siphash.h>
+#include <random.h>
+#include <script/script.h>
+
+#include <limits>
+
+/** The 4 bits set in a filter word for a hash, picked by its low 24 bits. */
+static uint64_t FilterMask(uint64_t hash) {
+    return (uint64_t(1) << (hash & 63)) |
+           (uint64_t(1) << ((hash >> 6) & 63)) |
+           (uint64_t(1) << ((hash >> 12) & 63)) |
+           (uint64_t(1) << ((hash >> 18) & 63));
+}
+
+/** The filter word for a hash, picked by its high 32 bits. */
+static size_t FilterIndex(uint64_t hash, size_t filter_size) {
+    return (hash >> 32) & (filter_size - 1);
+}
+
+ScriptPubKeySet::ScriptPubKeySet()
+    : m_k0(GetRand(std::numeric_limits<uint64_t>::max())),
+      m_k1(GetRand(std::numeric_limits<uint64_t>::max())),
+      m_filter(INITIAL_FILTER_SIZE) {}
+
+uint64_t ScriptPubKeySet::Hash(const CScript &script) const {
+    return CSipHasher(m_k0, m_k1)
+        .Write(script.data(), script.size())
+        .Finalize();
+}
+
+void ScriptPubKeySet::Insert(const CScript &script) {
+    const uint64_t hash = Hash(script);
+
+    LOCK(m_mutex);
+    if (!m_hashes.insert(hash).second) {
+        return;
+    }
+
+    if (m_hashes.size() <= m_filter.size() * SCRIPTS_PER_WORD) {
+        m_filter[FilterIndex(hash, m_filter.size())] |= FilterMask(hash);
+        return;
+    }
+
+    // Double the filter size so it stays selective, and fill it again.
+    m_filter.assign(m_filter.size() * 2, 0);
+    for (const uint64_t h : m_hashes) {
+        m_filter[FilterIndex(h, m_filter.size())] |= FilterMask(h);
+    }
+}
+
+bool ScriptPubKeySet::MayContain(const CScript &script) const {
+    const uint64_t hash = Hash(script);
+    const uint64_t mask = FilterMask(hash);
+
+    LOCK(m_mutex);
+    if ((m_filter[FilterIndex(hash, m_filter.size())] & mask) != mask) {
+        return false;
+    }
+    return m_hashes.count(hash) > 0;
+}
+
+size_t ScriptPubKeySet::Size() const {
+    LOCK(m_mutex);
+    return m_hashes.size();
+}
@@ -0,0 +1,69 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_SCRIPTPUBKEYSET_H
+#define BITCOIN_WALLET_SCRIPTPUBKEYSET_H
+
+#include <sync.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+class CScript;
+
+/**
+ * The scriptPubKeys that may belong to a wallet, as reported by its
+ * ScriptPubKeyMans.
+ *
+ * Almost all the scripts a wallet is asked about belong to someone else. They
+ * are rejected by a blocked bloom filter, which costs a single memory access,
+ * or else by a set of salted 64 bits hashes of the scripts, which the filter is
+ * rebuilt from when it grows. A script that passes both still has to be
+ * checked by the ScriptPubKeyMans: scripts are never removed, and some of them
+ * may not actually be solvable by the wallet.
+ */
+class ScriptPubKeySet {
+public:
+    ScriptPubKeySet();
+
+    void Insert(const CScript &script);
+
+    /**
+     * Whether the script may have been inserted. There are no false negatives.
+     */
+    bool MayContain(const CScript &script) const;
+
+    size_t Size() const;
+
+private:
+    //! Scripts per 64 bits word of the filter, it is grown beyond that
+    static constexpr size_t SCRIPTS_PER_WORD = 4;
+    //! Initial number of 64 bits words of the filter, a power of two
+    static constexpr size_t INITIAL_FILTER_SIZE = 256;
+
+    const uint64_t m_k0;
+    const uint64_t m_k1;
+
+    mutable Mutex m_mutex;
+    std::unordered_set<uint64_t> m_hashes GUARDED_BY(m_mutex);
+    std::vector<uint64_t> m_filter GUARDED_BY(m_mutex);
+
+    uint64_t Hash(const CScript &script) const;
+};
+
+#endif // BITCOIN_WALLET_SCRIPTPUBKEYSET_H
@@ -0,0 +1,829 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/sqlite.h>
+
+#include <chainparams.h>
+#include <crypto/common.h>
+#include <logging.h>
+#include <sync.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <util/translation.h>
+#include <wallet/db.h>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+
+static constexpr int32_t WALLET_SCHEMA_VERSION = 0;
+
+static Mutex g_sqlite_mutex;
+static int g_sqlite_count GUARDED_BY(g_sqlite_mutex) = 0;
+//! Paths of the database files currently in use, see IsSQLiteWalletLoaded
+static std::multiset<std::string> g_sqlite_files GUARDED_BY(g_sqlite_mutex);
+
+static void ErrorLogCallback(void *arg, int code, const char *msg) {
+    // From sqlite3_config() documentation for the SQLITE_CONFIG_LOG option:
+    // "The void pointer that is the second argument to SQLITE_CONFIG_LOG is
+    // passed through as the first parameter to the application-defined logger
+    // function whenever that function is invoked."
+    // Assert that this is the case:
+    assert(arg == nullptr);
+    LogPrintf("SQLite Error. Code: %d. Message: %s\n", code, msg);
+}
+
+static uint32_t GetApplicationId() {
+    return ReadBE32(Params().DiskMagic().data());
+}
+
+static bool ReadPragmaInteger(sqlite3 *db, const std::string &key,
+                              int &value) {
+    const std::string stmt_text = strprintf("PRAGMA %s", key);
+    sqlite3_stmt *pragma_read_stmt{nullptr};
+    int ret = sqlite3_prepare_v2(db, stmt_text.c_str(), -1, &pragma_read_stmt,
+                                 nullptr);
+    if (ret != SQLITE_OK) {
+        return false;
+    }
+    ret = sqlite3_step(pragma_read_stmt);
+    const bool success = ret == SQLITE_ROW;
+    if (success) {
+        // Leftmost column in result is index 0
+        value = sqlite3_column_int(pragma_read_stmt, 0);
+    }
+    sqlite3_finalize(pragma_read_stmt);
+    return success;
+}
+
+static void ExecStatement(sqlite3 *db, const std::string &statement,
+                          const std::string &description) {
+    int ret = sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
+    if (ret != SQLITE_OK) {
+        throw std::runtime_error(strprintf("SQLiteDatabase: %s: %s\n",
+                                           description, sqlite3_errstr(ret)));
+    }
+}
+
+static bool BindBlob(sqlite3_stmt *stmt, int index, const CDataStream &blob,
+                     const std::string &description) {
+    int res = sqlite3_bind_blob(stmt, index, blob.data(), blob.size(),
+                                SQLITE_STATIC);
+    if (res != SQLITE_OK) {
+        LogPrintf("Unable to bind %s to statement: %s\n", description,
+                  sqlite3_errstr(res));
+        sqlite3_clear_bindings(stmt);
+        sqlite3_reset(stmt);
+        return false;
+    }
+    return true;
+}
+
+static void ResetStatement(sqlite3_stmt *stmt) {
+    sqlite3_clear_bindings(stmt);
+    sqlite3_reset(stmt);
+}
+
+SQLiteDatabase::SQLiteDatabase(const fs::path &dir_path,
+                               const fs::path &file_path, bool mock)
+    : WalletDatabase(), m_mock(mock), m_dir_path(dir_path.string()),
+      m_file_path(file_path.string()) {
+    LOCK(g_sqlite_mutex);
+    LogPrintf("Using SQLite Version %s\n", SQLiteDatabaseVersion());
+    LogPrintf("Using wallet %s\n", m_file_path);
+
+    if (++g_sqlite_count == 1) {
+        // Setup logging
+        int ret = sqlite3_config(SQLITE_CONFIG_LOG, ErrorLogCallback, nullptr);
+        if (ret != SQLITE_OK) {
+            throw std::runtime_error(
+                strprintf("SQLiteDatabase: Failed to setup error log: %s\n",
+                          sqlite3_errstr(ret)));
+        }
+        // Batches from several threads share the connection
+        ret = sqlite3_config(SQLITE_CONFIG_SERIALIZED);
+        if (ret != SQLITE_OK) {
+            throw std::runtime_error(strprintf(
+                "SQLiteDatabase: Failed to configure serialized threading "
+                "mode: %s\n",
+                sqlite3_errstr(ret)));
+        }
+    }
+    // This is a no-op if sqlite3 is already initialized
+    int ret = sqlite3_initialize();
+    if (ret != SQLITE_OK) {
+        throw std::runtime_error(
+            strprintf("SQLiteDatabase: Failed to initialize SQLite: %s\n",
+                      sqlite3_errstr(ret)));
+    }
+
+    if (!m_mock) {
+        g_sqlite_files.insert(m_file_path);
+    }
+}
+
+SQLiteDatabase::~SQLiteDatabase() {
+    {
+        LOCK(m_mutex);
+        Close();
+    }
+
+    LOCK(g_sqlite_mutex);
+    if (!m_mock) {
+        g_sqlite_files.erase(g_sqlite_files.find(m_file_path));
+    }
+    if (--g_sqlite_count == 0) {
+        int ret = sqlite3_shutdown();
+        if (ret != SQLITE_OK) {
+            LogPrintf("SQLiteDatabase: Failed to shutdown SQLite: %s\n",
+                      sqlite3_errstr(ret));
+        }
+    }
+}
+
+void SQLiteDatabase::Open() const {
+    if (m_db) {
+        return;
+    }
+
+    int flags =
+        SQLITE_OPEN_FULLMUTEX | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    if (m_mock) {
+        // In memory database for mock db
+        flags |= SQLITE_OPEN_MEMORY;
+    } else {
+        TryCreateDirectories(m_dir_path);
+    }
+
+    sqlite3 *db{nullptr};
+    int ret = sqlite3_open_v2(m_file_path.c_str(), &db, flags, nullptr);
+    if (ret != SQLITE_OK) {
+        sqlite3_close(db);
+        throw std::runtime_error(
+            strprintf("SQLiteDatabase: Failed to open database: %s\n",
+                      sqlite3_errstr(ret)));
+    }
+
+    try {
+        if (sqlite3_db_readonly(db, "main") != 0) {
+            throw std::runtime_error("SQLiteDatabase: Database opened in "
+                                     "readonly mode but read-write permissions "
+                                     "are needed");
+        }
+
+        // Acquire an exclusive lock on the database, which is held until the
+        // connection is closed. This also lets the write-ahead log work
+        // without a shared memory index.
+        ExecStatement(db, "PRAGMA locking_mode = exclusive",
+                      "Unable to change database locking mode to exclusive");
+        // Take the lock now, rather than on the first write
+        int lock_ret = sqlite3_exec(db, "BEGIN EXCLUSIVE TRANSACTION", nullptr,
+                                    nullptr, nullptr);
+        if (lock_ret != SQLITE_OK) {
+            throw std::runtime_error(
+                "SQLiteDatabase: Unable to obtain an exclusive lock on the "
+                "database, is it being used by another instance?\n");
+        }
+        ExecStatement(db, "COMMIT",
+                      "Unable to end exclusive lock transaction");
+
+        // Commits append to the write-ahead log, which is synced at every
+        // commit so that a power failure can't lose committed records. The
+        // log is checkpointed into the database by the periodic wallet flush.
+        ExecStatement(db, "PRAGMA journal_mode = WAL",
+                      "Unable to enable the write-ahead log");
+        ExecStatement(db, "PRAGMA synchronous = FULL",
+                      "Unable to set the synchronous mode");
+        // Enable fullfsync for the platforms that use it
+        ExecStatement(db, "PRAGMA fullfsync = true",
+                      "Failed to enable fullfsync");
+
+        // Make the table for our key-value pairs
+        // First check that the main table exists
+        sqlite3_stmt *check_main_stmt{nullptr};
+        ret = sqlite3_prepare_v2(db,
+                                 "SELECT name FROM sqlite_master WHERE "
+                                 "type='table' AND name='main'",
+                                 -1, &check_main_stmt, nullptr);
+        if (ret != SQLITE_OK) {
+            throw std::runtime_error(strprintf(
+                "SQLiteDatabase: Failed to prepare statement to check table "
+                "existence: %s\n",
+                sqlite3_errstr(ret)));
+        }
+        ret = sqlite3_step(check_main_stmt);
+        sqlite3_finalize(check_main_stmt);
+        bool table_exists;
+        if (ret == SQLITE_DONE) {
+            table_exists = false;
+        } else if (ret == SQLITE_ROW) {
+            table_exists = true;
+        } else {
+            throw std::runtime_error(strprintf(
+                "SQLiteDatabase: Failed to execute statement to check table "
+                "existence: %s\n",
+                sqlite3_errstr(ret)));
+        }
+
+        // Do the db setup things because the table doesn't exist only when we
+        // are creating a new wallet
+        if (!table_exists) {
+            ExecStatement(db,
+                          "CREATE TABLE main(key BLOB PRIMARY KEY NOT NULL, "
+                          "value BLOB NOT NULL)",
+                          "Failed to create new database");
+
+            // Set the application id
+            ExecStatement(db,
+                          strprintf("PRAGMA application_id = %d",
+                                    static_cast<int32_t>(GetApplicationId())),
+                          "Failed to set the application id");
+
+            // Set the user version
+            ExecStatement(db,
+                          strprintf("PRAGMA user_version = %d",
+                                    WALLET_SCHEMA_VERSION),
+                          "Failed to set the wallet schema version");
+        }
+    } catch (const std::runtime_error &) {
+        sqlite3_close(db);
+        throw;
+    }
+
+    m_db = db;
+}
+
+void SQLiteDatabase::Close() {
+    if (!m_db) {
+        return;
+    }
+
+    // Closing the last connection checkpoints the write-ahead log and removes
+    // it.
+    int res = sqlite3_close(m_db);
+    if (res != SQLITE_OK) {
+        LogPrintf("SQLiteDatabase: Failed to close database %s: %s\n",
+                  m_file_path, sqlite3_errstr(res));
+        return;
+    }
+    m_db = nullptr;
+}
+
+sqlite3 *SQLiteDatabase::GetConnection() const {
+    LOCK(m_mutex);
+    Open();
+    return m_db;
+}
+
+bool SQLiteDatabase::Checkpoint(int mode) {
+    LOCK(m_txn_mutex);
+    if (m_txn_thread) {
+        // The log can't be checkpointed past an open transaction, retry later
+        return false;
+    }
+    LOCK(m_mutex);
+    if (!m_db) {
+        return true;
+    }
+    int ret = sqlite3_wal_checkpoint_v2(m_db, nullptr, mode, nullptr, nullptr);
+    if (ret != SQLITE_OK) {
+        LogPrint(BCLog::WALLETDB, "Failed to checkpoint %s: %s\n", m_file_path,
+                 sqlite3_errstr(ret));
+        return false;
+    }
+    return true;
+}
+
+bool SQLiteDatabase::Verify(bilingual_str &error) {
+    sqlite3 *db;
+    try {
+        db = GetConnection();
+    } catch (const std::runtime_error &e) {
+        error = Untranslated(e.what());
+        return false;
+    }
+
+    const uint32_t app_id = GetApplicationId();
+    int read_app_id = 0;
+    if (!ReadPragmaInteger(db, "application_id", read_app_id)) {
+        error = _("SQLiteDatabase: Failed to fetch the application id");
+        return false;
+    }
+    if (static_cast<uint32_t>(read_app_id) != app_id) {
+        error = strprintf(
+            _("SQLiteDatabase: Unexpected application id. Expected %u, got %u"),
+            app_id, static_cast<uint32_t>(read_app_id));
+        return false;
+    }
+
+    int user_ver = 0;
+    if (!ReadPragmaInteger(db, "user_version", user_ver)) {
+        error = _("SQLiteDatabase: Failed to fetch the wallet schema version");
+        return false;
+    }
+    if (user_ver != WALLET_SCHEMA_VERSION) {
+        error = strprintf(_("SQLiteDatabase: Unknown SQLite wallet schema "
+                            "version %d. Only version %d is supported"),
+                          user_ver, WALLET_SCHEMA_VERSION);
+        return false;
+    }
+
+    sqlite3_stmt *stmt{nullptr};
+    int ret =
+        sqlite3_prepare_v2(db, "PRAGMA integrity_check", -1, &stmt, nullptr);
+    if (ret != SQLITE_OK) {
+        error = strprintf(_("SQLiteDatabase: Failed to prepare statement to "
+                            "verify database: %s"),
+                          sqlite3_errstr(ret));
+        return false;
+    }
+    std::string str_errors;
+    while (true) {
+        ret = sqlite3_step(stmt);
+        if (ret == SQLITE_DONE) {
+            break;
+        }
+        if (ret != SQLITE_ROW) {
+            error = strprintf(_("SQLiteDatabase: Failed to execute statement "
+                                "to verify database: %s"),
+                              sqlite3_errstr(ret));
+            break;
+        }
+        const char *msg = (const char *)sqlite3_column_text(stmt, 0);
+        if (!msg) {
+            error = strprintf(_("SQLiteDatabase: Failed to read database "
+                                "verification error: %s"),
+                              sqlite3_errstr(ret));
+            break;
+        }
+        std::string str_msg(msg);
+        if (str_msg == "ok") {
+            continue;
+        }
+        if (!str_errors.empty()) {
+            str_errors += "\n";
+        }
+        str_errors += str_msg;
+    }
+    sqlite3_finalize(stmt);
+    if (!str_errors.empty()) {
+        error = strprintf(_("%s corrupt. Try restoring a backup."),
+                          m_file_path);
+        LogPrintf("Verifying %s failed:\n%s\n", m_file_path, str_errors);
+        return false;
+    }
+    return error.empty();
+}
+
+bool SQLiteDatabase::Rewrite(const char *pszSkip) {
+    WAIT_LOCK(m_txn_mutex, lock);
+    WaitForTxn(lock);
+    sqlite3 *db = GetConnection();
+
+    if (pszSkip) {
+        // Drop the skipped records, VACUUM then rebuilds the file without them
+        sqlite3_stmt *stmt{nullptr};
+        int ret = sqlite3_prepare_v2(
+            db, "DELETE FROM main WHERE substr(key, 1, ?) = ?", -1, &stmt,
+            nullptr);
+        if (ret != SQLITE_OK) {
+            LogPrintf("%s: Failed to prepare statement: %s\n", __func__,
+                      sqlite3_errstr(ret));
+            return false;
+        }
+        const int skip_len = strlen(pszSkip);
+        sqlite3_bind_int(stmt, 1, skip_len);
+        sqlite3_bind_blob(stmt, 2, pszSkip, skip_len, SQLITE_STATIC);
+        ret = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (ret != SQLITE_DONE) {
+            LogPrintf("%s: Failed to erase records: %s\n", __func__,
+                      sqlite3_errstr(ret));
+            return false;
+        }
+    }
+
+    // Rewrite the database using the VACUUM command:
+    // https://sqlite.org/lang_vacuum.html
+    int ret = sqlite3_exec(db, "VACUUM", nullptr, nullptr, nullptr);
+    return ret == SQLITE_OK;
+}
+
+bool SQLiteDatabase::Backup(const std::string &dest) const {
+    if (m_mock) {
+        return false;
+    }
+
+    fs::path dest_path(dest);
+    if (fs::is_directory(dest_path)) {
+        dest_path /= fs::path(m_file_path).filename();
+    }
+
+    try {
+        if (fs::exists(dest_path) && fs::equivalent(m_file_path, dest_path)) {
+            LogPrintf("cannot backup to wallet source file %s\n",
+                      dest_path.string());
+            return false;
+        }
+    } catch (const fs::filesystem_error &e) {
+        LogPrintf("error copying %s to %s - %s\n", m_file_path,
+                  dest_path.string(),
+                  fsbridge::get_filesystem_error_message(e));
+        return false;
+    }
+
+    sqlite3 *db_copy{nullptr};
+    int res = sqlite3_open(dest_path.string().c_str(), &db_copy);
+    if (res != SQLITE_OK) {
+        sqlite3_close(db_copy);
+        return false;
+    }
+    sqlite3_backup *backup =
+        sqlite3_backup_init(db_copy, "main", GetConnection(), "main");
+    if (!backup) {
+        LogPrintf("%s: Unable to begin backup: %s\n", __func__,
+                  sqlite3_errmsg(db_copy));
+        sqlite3_close(db_copy);
+        return false;
+    }
+    // Specifying -1 will copy all of the pages
+    res = sqlite3_backup_step(backup, -1);
+    if (res != SQLITE_DONE) {
+        LogPrintf("%s: Unable to backup: %s\n", __func__, sqlite3_errstr(res));
+        sqlite3_backup_finish(backup);
+        sqlite3_close(db_copy);
+        return false;
+    }
+    res = sqlite3_backup_finish(backup);
+    sqlite3_close(db_copy);
+    if (res != SQLITE_OK) {
+        return false;
+    }
+    LogPrintf("copied %s to %s\n", m_file_path, dest_path.string());
+    return true;
+}
+
+void SQLiteDatabase::Flush(bool shutdown) {
+    Checkpoint(SQLITE_CHECKPOINT_TRUNCATE);
+    if (shutdown) {
+        LOCK(m_mutex);
+        Close();
+    }
+}
+
+bool SQLiteDatabase::PeriodicFlush() {
+    {
+        LOCK(m_mutex);
+        if (!m_db) {
+            return true;
+        }
+    }
+
+    LogPrint(BCLog::WALLETDB, "Flushing %s\n", m_file_path);
+    int64_t nStart = GetTimeMillis();
+
+    if (!Checkpoint(SQLITE_CHECKPOINT_TRUNCATE)) {
+        return false;
+    }
+
+    LogPrint(BCLog::WALLETDB, "Flushed %s %dms\n", m_file_path,
+             GetTimeMillis() - nStart);
+    return true;
+}
+
+std::unique_ptr<DatabaseBatch> SQLiteDatabase::MakeBatch(const char *mode,
+                                                         bool flush_on_close) {
+    return std::make_unique<SQLiteBatch>(*this);
+}
+
+SQLiteBatch::SQLiteBatch(SQLiteDatabase &database) : m_database(database) {
+    SetupSQLStatements();
+}
+
+void SQLiteBatch::SetupSQLStatements() {
+    sqlite3 *db = m_database.GetConnection();
+    const std::vector<std::pair<sqlite3_stmt **, const char *>> statements{
+        {&m_read_stmt, "SELECT value FROM main WHERE key = ?"},
+        {&m_insert_stmt, "INSERT INTO main VALUES(?, ?)"},
+        {&m_overwrite_stmt, "INSERT or REPLACE into main values(?, ?)"},
+        {&m_delete_stmt, "DELETE FROM main WHERE key = ?"},
+        {&m_cursor_stmt, "SELECT key, value FROM main"},
+    };
+
+    for (const auto &[stmt_prepared, stmt_text] : statements) {
+        if (*stmt_prepared == nullptr) {
+            int res = sqlite3_prepare_v2(db, stmt_text, -1, stmt_prepared,
+                                         nullptr);
+            if (res != SQLITE_OK) {
+                Close();
+                throw std::runtime_error(strprintf(
+                    "SQLiteDatabase: Failed to setup SQL statements: %s\n",
+                    sqlite3_errstr(res)));
+            }
+        }
+    }
+}
+
+void SQLiteBatch::Close() {
+    // If this batch started a transaction, abort it
+    if (m_txn) {
+        if (TxnAbort()) {
+            LogPrintf("SQLiteBatch: Batch closed unexpectedly without the "
+                      "transaction being explicitly committed or aborted\n");
+        } else {
+            LogPrintf("SQLiteBatch: Batch closed and failed to abort "
+                      "transaction\n");
+        }
+    }
+
+    // Free all of the prepared statements
+    const std::vector<std::pair<sqlite3_stmt **, const char *>> statements{
+        {&m_read_stmt, "read"},
+        {&m_insert_stmt, "insert"},
+        {&m_overwrite_stmt, "overwrite"},
+        {&m_delete_stmt, "delete"},
+        {&m_cursor_stmt, "cursor"},
+    };
+
+    for (const auto &[stmt_prepared, stmt_description] : statements) {
+        int res = sqlite3_finalize(*stmt_prepared);
+        if (res != SQLITE_OK) {
+            LogPrintf("SQLiteBatch: Batch closed but could not finalize "
+                      "%s statement: %s\n",
+                      stmt_description, sqlite3_errstr(res));
+        }
+        *stmt_prepared = nullptr;
+    }
+    m_cursor_init = false;
+}
+
+bool SQLiteBatch::ReadKey(CDataStream &key, CDataStream &value) {
+    if (!m_read_stmt) {
+        return false;
+    }
+
+    // Bind: leftmost parameter in statement is index 1
+    if (!BindBlob(m_read_stmt, 1, key, "key")) {
+        return false;
+    }
+    int res = sqlite3_step(m_read_stmt);
+    if (res != SQLITE_ROW) {
+        if (res != SQLITE_DONE) {
+            // SQLITE_DONE means "not found", don't log an error in that case.
+            LogPrintf("%s: Unable to execute statement: %s\n", __func__,
+                      sqlite3_errstr(res));
+        }
+        ResetStatement(m_read_stmt);
+        return false;
+    }
+    // Leftmost column in result is index 0
+    const char *data =
+        reinterpret_cast<const char *>(sqlite3_column_blob(m_read_stmt, 0));
+    int data_size = sqlite3_column_bytes(m_read_stmt, 0);
+    value.write(data, data_size);
+
+    ResetStatement(m_read_stmt);
+    return true;
+}
+
+bool SQLiteBatch::WriteKey(CDataStream &key, CDataStream &value,
+                           bool overwrite) {
+    sqlite3_stmt *stmt = overwrite ? m_overwrite_stmt : m_insert_stmt;
+    if (!stmt) {
+        return false;
+    }
+
+    // Bind: leftmost parameter in statement is index 1
+    // Insert index 1 is key, 2 is value
+    if (!BindBlob(stmt, 1, key, "key") || !BindBlob(stmt, 2, value, "value")) {
+        return false;
+    }
+
+    // Execute once the other threads' transactions have ended
+    int res;
+    {
+        WAIT_LOCK(m_database.m_txn_mutex, lock);
+        m_database.WaitForTxn(lock);
+        res = sqlite3_step(stmt);
+    }
+    ResetStatement(stmt);
+    if (res != SQLITE_DONE) {
+        LogPrintf("%s: Unable to execute statement: %s\n", __func__,
+                  sqlite3_errstr(res));
+    }
+    return res == SQLITE_DONE;
+}
+
+bool SQLiteBatch::EraseKey(CDataStream &key) {
+    if (!m_delete_stmt) {
+        return false;
+    }
+
+    // Bind: leftmost parameter in statement is index 1
+    if (!BindBlob(m_delete_stmt, 1, key, "key")) {
+        return false;
+    }
+
+    // Execute once the other threads' transactions have ended
+    int res;
+    {
+        WAIT_LOCK(m_database.m_txn_mutex, lock);
+        m_database.WaitForTxn(lock);
+        res = sqlite3_step(m_delete_stmt);
+    }
+    ResetStatement(m_delete_stmt);
+    if (res != SQLITE_DONE) {
+        LogPrintf("%s: Unable to execute statement: %s\n", __func__,
+                  sqlite3_errstr(res));
+    }
+    return res == SQLITE_DONE;
+}
+
+bool SQLiteBatch::HasKey(CDataStream &key) {
+    if (!m_read_stmt) {
+        return false;
+    }
+
+    // Bind: leftmost parameter in statement is index 1
+    if (!BindBlob(m_read_stmt, 1, key, "key")) {
+        return false;
+    }
+    int res = sqlite3_step(m_read_stmt);
+    ResetStatement(m_read_stmt);
+    return res == SQLITE_ROW;
+}
+
+bool SQLiteBatch::StartCursor() {
+    CloseCursor();
+    if (!m_cursor_stmt) {
+        return false;
+    }
+    m_cursor_init = true;
+    return true;
+}
+
+bool SQLiteBatch::ReadAtCursor(CDataStream &ssKey, CDataStream &ssValue,
+                               bool &complete) {
+    complete = false;
+
+    if (!m_cursor_init) {
+        return false;
+    }
+
+    int res = sqlite3_step(m_cursor_stmt);
+    if (res == SQLITE_DONE) {
+        complete = true;
+        return true;
+    }
+    if (res != SQLITE_ROW) {
+        LogPrintf("SQLiteBatch::ReadAtCursor: Unable to execute cursor step: "
+                  "%s\n",
+                  sqlite3_errstr(res));
+        return false;
+    }
+
+    // Leftmost column in result is index 0
+    const char *key_data =
+        reinterpret_cast<const char *>(sqlite3_column_blob(m_cursor_stmt, 0));
+    int key_data_size = sqlite3_column_bytes(m_cursor_stmt, 0);
+    ssKey.SetType(SER_DISK);
+    ssKey.clear();
+    ssKey.write(key_data, key_data_size);
+    const char *value_data =
+        reinterpret_cast<const char *>(sqlite3_column_blob(m_cursor_stmt, 1));
+    int value_data_size = sqlite3_column_bytes(m_cursor_stmt, 1);
+    ssValue.SetType(SER_DISK);
+    ssValue.clear();
+    ssValue.write(value_data, value_data_size);
+    return true;
+}
+
+void SQLiteBatch::CloseCursor() {
+    if (m_cursor_stmt) {
+        sqlite3_reset(m_cursor_stmt);
+    }
+    m_cursor_init = false;
+}
+
+void SQLiteBatch::EndTxn() {
+    // A failed commit can leave the transaction open, to be aborted
+    if (!sqlite3_get_autocommit(m_database.GetConnection())) {
+        return;
+    }
+    m_txn = false;
+    {
+        LOCK(m_database.m_txn_mutex);
+        m_database.m_txn_thread.reset();
+    }
+    m_database.m_txn_cv.notify_all();
+}
+
+bool SQLiteBatch::TxnBegin() {
+    if (m_txn) {
+        return false;
+    }
+    WAIT_LOCK(m_database.m_txn_mutex, lock);
+    m_database.WaitForTxn(lock);
+    // Fails if another batch of this thread already started a transaction
+    int res = sqlite3_exec(m_database.GetConnection(), "BEGIN TRANSACTION",
+                           nullptr, nullptr, nullptr);
+    if (res != SQLITE_OK) {
+        LogPrintf("SQLiteBatch: Failed to begin the transaction\n");
+        return false;
+    }
+    m_txn = true;
+    m_database.m_txn_thread = std::this_thread::get_id();
+    return true;
+}
+
+bool SQLiteBatch::TxnCommit() {
+    if (!m_txn) {
+        return false;
+    }
+    int res = sqlite3_exec(m_database.GetConnection(), "COMMIT TRANSACTION",
+                           nullptr, nullptr, nullptr);
+    EndTxn();
+    if (res != SQLITE_OK) {
+        LogPrintf("SQLiteBatch: Failed to commit the transaction\n");
+        return false;
+    }
+    return true;
+}
+
+bool SQLiteBatch::TxnAbort() {
+    if (!m_txn) {
+        return false;
+    }
+    int res = sqlite3_exec(m_database.GetConnection(), "ROLLBACK TRANSACTION",
+                           nullptr, nullptr, nullptr);
+    EndTxn();
+    if (res != SQLITE_OK) {
+        LogPrintf("SQLiteBatch: Failed to abort the transaction\n");
+        return false;
+    }
+    return true;
+}
+
+bool IsSQLiteFile(const fs::path &path) {
+    if (!fs::exists(path)) {
+        return false;
+    }
+
+    // A SQLite Database file is at least 512 bytes.
+    boost::system::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec) {
+        LogPrintf("%s: %s %s\n", __func__, ec.message(), path.string());
+    }
+    if (size < 512) {
+        return false;
+    }
+
+    fsbridge::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Magic is at beginning and is 16 bytes long
+    char magic[16];
+    file.read(magic, 16);
+
+    // Application id is at offset 68 and 4 bytes long
+    file.seekg(68, std::ios::beg);
+    uint8_t app_id[4];
+    file.read(reinterpret_cast<char *>(app_id), 4);
+
+    file.close();
+
+    // Check the magic, see https://sqlite.org/fileformat2.html
+    if (std::memcmp(magic, "SQLite format 3", 16) != 0) {
+        return false;
+    }
+
+    // Check the application id matches our network magic
+    return ReadBE32(app_id) == GetApplicationId();
+}
+
+bool IsSQLiteWalletLoaded(const fs::path &wallet_path) {
+    const std::string file_path = WalletDataFilePath(wallet_path).string();
+    LOCK(g_sqlite_mutex);
+    return g_sqlite_files.count(file_path) > 0;
+}
+
+std::string SQLiteDatabaseVersion() {
+    return std::string(sqlite3_libversion());
+}
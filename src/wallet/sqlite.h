@@ -0,0 +1,169 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_SQLITE_H
+#define BITCOIN_WALLET_SQLITE_H
+
+#include <sync.h>
+#include <wallet/db.h>
+
+#include <sqlite3.h>
+
+#include <condition_variable>
+#include <optional>
+#include <thread>
+
+struct bilingual_str;
+class SQLiteDatabase;
+
+/** RAII class that provides access to a SQLite database */
+class SQLiteBatch : public DatabaseBatch {
+private:
+    SQLiteDatabase &m_database;
+
+    bool m_cursor_init = false;
+    //! Whether this batch started the connection's current transaction
+    bool m_txn = false;
+
+    //! Release the connection's transaction once it has ended
+    void EndTxn();
+
+    sqlite3_stmt *m_read_stmt{nullptr};
+    sqlite3_stmt *m_insert_stmt{nullptr};
+    sqlite3_stmt *m_overwrite_stmt{nullptr};
+    sqlite3_stmt *m_delete_stmt{nullptr};
+    sqlite3_stmt *m_cursor_stmt{nullptr};
+
+    void SetupSQLStatements();
+
+    bool ReadKey(CDataStream &key, CDataStream &value) override;
+    bool WriteKey(CDataStream &key, CDataStream &value,
+                  bool overwrite = true) override;
+    bool EraseKey(CDataStream &key) override;
+    bool HasKey(CDataStream &key) override;
+
+public:
+    explicit SQLiteBatch(SQLiteDatabase &database);
+    ~SQLiteBatch() override { Close(); }
+
+    /**
+     * No-op. Every commit is synced to the write-ahead log, which is
+     * checkpointed automatically by SQLite and by
+     * SQLiteDatabase::PeriodicFlush.
+     */
+    void Flush() override {}
+    void Close() override;
+
+    bool StartCursor() override;
+    bool ReadAtCursor(CDataStream &ssKey, CDataStream &ssValue,
+                      bool &complete) override;
+    void CloseCursor() override;
+    bool TxnBegin() override;
+    bool TxnCommit() override;
+    bool TxnAbort() override;
+};
+
+/**
+ * An instance of this class represents one SQLite3 database.
+ *
+ * The database is opened on first use and kept open, with an exclusive lock,
+ * until this object is destroyed. It runs in WAL mode: commits append to the
+ * write-ahead log, which is synced at every commit (synchronous=FULL) and
+ * checkpointed into the database file by the periodic wallet flush.
+ *
+ * All the batches share one connection, so a transaction spans all of them.
+ * It belongs to the thread that started it: the writes of the other threads
+ * wait until it is committed or aborted, so that they are neither grouped nor
+ * undone with it.
+ */
+class SQLiteDatabase : public WalletDatabase {
+private:
+    const bool m_mock{false};
+
+    const std::string m_dir_path;
+
+    const std::string m_file_path;
+
+    /** Serializes opening and closing the connection */
+    mutable RecursiveMutex m_mutex;
+
+    mutable sqlite3 *m_db GUARDED_BY(m_mutex){nullptr};
+
+    void Open() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Close() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    bool Checkpoint(int mode);
+
+public:
+    SQLiteDatabase() = delete;
+
+    /** Create DB handle to real database */
+    SQLiteDatabase(const fs::path &dir_path, const fs::path &file_path,
+                   bool mock = false);
+
+    ~SQLiteDatabase() override;
+
+    /**
+     * Rewrite the entire database on disk, with the exception of the keys
+     * starting with pszSkip if non-zero
+     */
+    bool Rewrite(const char *pszSkip = nullptr) override;
+
+    /** Back up the entire database to a file. */
+    bool Backup(const std::string &dest) const override;
+
+    /** Make sure all changes are flushed to disk. */
+    void Flush(bool shutdown) override;
+
+    bool PeriodicFlush() override;
+
+    void IncrementUpdateCounter() override { ++nUpdateCounter; }
+
+    /** No environment to reload */
+    void ReloadDbEnv() override {}
+
+    /** Verifies the database file */
+    bool Verify(bilingual_str &error) override;
+
+    std::unique_ptr<DatabaseBatch>
+    MakeBatch(const char *mode = "r+", bool flush_on_close = true) override;
+
+    /** Return the underlying connection, opening the database if needed */
+    sqlite3 *GetConnection() const;
+
+    /** Guards the ownership of the connection's transaction */
+    Mutex m_txn_mutex;
+    std::condition_variable m_txn_cv;
+    //! Thread whose transaction is open on the connection, if any
+    std::optional<std::thread::id> m_txn_thread GUARDED_BY(m_txn_mutex);
+
+    /** Wait until no other thread has a transaction open */
+    void WaitForTxn(UniqueLock<Mutex> &lock)
+        EXCLUSIVE_LOCKS_REQUIRED(m_txn_mutex) {
+        m_txn_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_txn_mutex) {
+            return !m_txn_thread || *m_txn_thread == std::this_thread::get_id();
+        });
+    }
+};
+
+/** Return whether the file at path is a SQLite wallet database. */
+bool IsSQLiteFile(const fs::path &path);
+
+/** Return whether a SQLite wallet database is currently loaded. */
+bool IsSQLiteWalletLoaded(const fs::path &wallet_path);
+
+std::string SQLiteDatabaseVersion();
+
+#endif // BITCOIN_WALLET_SQLITE_H
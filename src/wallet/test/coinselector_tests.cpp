@@ -788,6 +788,122 @@ BOOST_AUTO_TEST_CASE(ApproximateBestSubset) {
     empty_wallet();
 }
 
+// UTXOs exceeding the target range on their own are left out of the BnB
+// search. This must not change its results.
+BOOST_AUTO_TEST_CASE(bnb_over_range_utxos) {
+    std::vector<CInputCoin> utxo_pool;
+    for (int i = 1; i <= 10; ++i) {
+        add_coin(i * CENT, i, utxo_pool);
+    }
+    std::vector<CInputCoin> utxo_pool_with_large = utxo_pool;
+    add_coin(60 * CENT, 11, utxo_pool_with_large);
+    add_coin(100 * CENT, 12, utxo_pool_with_large);
+    add_coin(1000 * CENT, 13, utxo_pool_with_large);
+
+    const Amount not_input_fees = Amount::zero();
+    for (int target = 1; target <= 60; ++target) {
+        CoinSet selection, selection_with_large;
+        Amount value_ret = Amount::zero();
+        Amount value_ret_with_large = Amount::zero();
+        const bool found =
+            SelectCoinsBnB(GroupCoins(utxo_pool), target * CENT, CENT / 2,
+                           selection, value_ret, not_input_fees);
+        const bool found_with_large = SelectCoinsBnB(
+            GroupCoins(utxo_pool_with_large), target * CENT, CENT / 2,
+            selection_with_large, value_ret_with_large, not_input_fees);
+        // Only the 60 cents UTXO is in range when targeting it, and it is
+        // selected on its own as the least wasteful solution.
+        if (target == 60) {
+            BOOST_CHECK(found_with_large);
+            BOOST_CHECK_EQUAL(selection_with_large.size(), 1U);
+            BOOST_CHECK_EQUAL(value_ret_with_large, 60 * CENT);
+            continue;
+        }
+        BOOST_CHECK_EQUAL(found, found_with_large);
+        BOOST_CHECK(equal_sets(selection, selection_with_large));
+        BOOST_CHECK_EQUAL(value_ret, value_ret_with_large);
+    }
+
+    // A UTXO right at the upper bound of the range is still a solution.
+    utxo_pool.clear();
+    add_coin(CENT + CENT / 2, 1, utxo_pool);
+    CoinSet selection;
+    Amount value_ret = Amount::zero();
+    BOOST_CHECK(SelectCoinsBnB(GroupCoins(utxo_pool), 1 * CENT, CENT / 2,
+                               selection, value_ret, not_input_fees));
+    BOOST_CHECK_EQUAL(value_ret, CENT + CENT / 2);
+}
+
+// The knapsack solver only works on the largest groups of huge pools, but
+// takes as many as needed to reach the target.
+BOOST_AUTO_TEST_CASE(knapsack_solver_large_pool) {
+    std::vector<CInputCoin> utxo_pool;
+    for (int i = 0; i < 6000; ++i) {
+        CMutableTransaction tx;
+        // so all transactions get different hashes
+        tx.nLockTime = i;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 1 * CENT;
+        utxo_pool.emplace_back(MakeTransactionRef(tx), 0);
+    }
+
+    CoinSet selection;
+    Amount value_ret = Amount::zero();
+    BOOST_CHECK(KnapsackSolver(5500 * CENT, GroupCoins(utxo_pool), selection,
+                               value_ret));
+    BOOST_CHECK_GE(value_ret, 5500 * CENT);
+    BOOST_CHECK_GT(selection.size(), 5000U);
+
+    // The whole pool is still spent when needed.
+    BOOST_CHECK(KnapsackSolver(6000 * CENT, GroupCoins(utxo_pool), selection,
+                               value_ret));
+    BOOST_CHECK_EQUAL(value_ret, 6000 * CENT);
+    BOOST_CHECK_EQUAL(selection.size(), 6000U);
+
+    BOOST_CHECK(!KnapsackSolver(6001 * CENT, GroupCoins(utxo_pool), selection,
+                                value_ret));
+}
+
+// Valuing the inputs at the consolidation feerate makes BnB prefer the
+// solutions spending more of them while the fees are lower.
+BOOST_AUTO_TEST_CASE(consolidate_feerate) {
+    LOCK(m_wallet.cs_wallet);
+    m_wallet.SetupLegacyScriptPubKeyMan();
+
+    // Spending an input costs 740 satoshis at the effective feerate, so both
+    // the first UTXO alone and the two others together exactly match the
+    // target.
+    empty_wallet();
+    add_coin(m_wallet, 3 * CENT - 740 * SATOSHI);
+    add_coin(m_wallet, 2 * CENT);
+    add_coin(m_wallet, 1 * CENT);
+    for (COutput &output : vCoins) {
+        output.nInputBytes = 148;
+    }
+    const Amount target = 3 * CENT - 1480 * SATOSHI;
+
+    CoinSelectionParams coin_selection_params_bnb(true, 34, 148,
+                                                  CFeeRate(5000 * SATOSHI), 0);
+    CoinSet setCoinsRet;
+    Amount nValueRet;
+    bool bnb_used;
+    BOOST_CHECK(m_wallet.SelectCoinsMinConf(
+        target, filter_standard, GroupCoins(vCoins), setCoinsRet, nValueRet,
+        coin_selection_params_bnb, bnb_used));
+    BOOST_CHECK(bnb_used);
+    BOOST_CHECK_EQUAL(setCoinsRet.size(), 1U);
+
+    m_wallet.m_consolidate_feerate = CFeeRate(10000 * SATOSHI);
+    BOOST_CHECK(m_wallet.SelectCoinsMinConf(
+        target, filter_standard, GroupCoins(vCoins), setCoinsRet, nValueRet,
+        coin_selection_params_bnb, bnb_used));
+    BOOST_CHECK(bnb_used);
+    BOOST_CHECK_EQUAL(setCoinsRet.size(), 2U);
+    BOOST_CHECK_EQUAL(nValueRet, 3 * CENT);
+
+    empty_wallet();
+}
+
 // Tests that with the ideal conditions, the coin selector will always be able
 // to find a solution that can pay the target value
 BOOST_AUTO_TEST_CASE(SelectCoins_test) {
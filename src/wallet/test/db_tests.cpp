@@ -15,14 +15,24 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <wallet/bdb.h>
+#ifdef USE_SQLITE
+#include <wallet/sqlite.h>
+#endif
+#include <wallet/walletdb.h>
 
 #include <fs.h>
 
 #include <test/util/setup_common.h>
+#include <util/time.h>
+#include <util/translation.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>
+#include <utility>
 
 BOOST_FIXTURE_TEST_SUITE(db_tests, BasicTestingSetup)
 
@@ -86,4 +96,143 @@ BOOST_AUTO_TEST_CASE(getwalletenv_g_dbenvs_free_instance) {
     BOOST_CHECK(env_2_a == env_2_b);
 }
 
+#ifdef USE_SQLITE
+BOOST_AUTO_TEST_CASE(sqlite_read_write) {
+    std::unique_ptr<WalletDatabase> database =
+        CreateMockWalletDatabase(DatabaseFormat::SQLITE);
+    std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+
+    int value = 0;
+    BOOST_CHECK(!batch->Read(std::string("a"), value));
+    BOOST_CHECK(batch->Write(std::string("a"), 1));
+    BOOST_CHECK(batch->Read(std::string("a"), value));
+    BOOST_CHECK_EQUAL(value, 1);
+
+    // Overwriting is only allowed when requested
+    BOOST_CHECK(!batch->Write(std::string("a"), 2, false));
+    BOOST_CHECK(batch->Write(std::string("a"), 3));
+    BOOST_CHECK(batch->Read(std::string("a"), value));
+    BOOST_CHECK_EQUAL(value, 3);
+
+    BOOST_CHECK(batch->Exists(std::string("a")));
+    BOOST_CHECK(batch->Erase(std::string("a")));
+    BOOST_CHECK(!batch->Exists(std::string("a")));
+    // Erasing a missing record succeeds, like with BDB
+    BOOST_CHECK(batch->Erase(std::string("a")));
+}
+
+BOOST_AUTO_TEST_CASE(sqlite_cursor_and_transactions) {
+    std::unique_ptr<WalletDatabase> database =
+        CreateMockWalletDatabase(DatabaseFormat::SQLITE);
+    std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+
+    BOOST_CHECK(batch->TxnBegin());
+    // The transaction spans the connection, only one can be started
+    std::unique_ptr<DatabaseBatch> other_batch = database->MakeBatch();
+    BOOST_CHECK(!other_batch->TxnBegin());
+    BOOST_CHECK(batch->Write(std::string("aborted"), 0));
+    BOOST_CHECK(batch->TxnAbort());
+    BOOST_CHECK(!batch->Exists(std::string("aborted")));
+
+    BOOST_CHECK(batch->TxnBegin());
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK(batch->Write(std::make_pair(std::string("key"), i), i));
+    }
+    BOOST_CHECK(batch->TxnCommit());
+
+    BOOST_CHECK(batch->StartCursor());
+    int records = 0;
+    while (true) {
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        bool complete;
+        BOOST_CHECK(batch->ReadAtCursor(ssKey, ssValue, complete));
+        if (complete) {
+            break;
+        }
+        std::string type;
+        int index, value;
+        ssKey >> type >> index;
+        ssValue >> value;
+        BOOST_CHECK_EQUAL(type, "key");
+        BOOST_CHECK_EQUAL(index, value);
+        ++records;
+    }
+    batch->CloseCursor();
+    BOOST_CHECK_EQUAL(records, 100);
+}
+
+BOOST_AUTO_TEST_CASE(sqlite_transaction_other_thread) {
+    std::unique_ptr<WalletDatabase> database =
+        CreateMockWalletDatabase(DatabaseFormat::SQLITE);
+    std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+
+    BOOST_CHECK(batch->TxnBegin());
+    BOOST_CHECK(batch->Write(std::string("aborted"), 0));
+
+    // The writes of another thread wait for the transaction to end, rather
+    // than joining it and being undone with it
+    std::atomic<bool> done{false};
+    bool written = false;
+    std::thread writer([&] {
+        std::unique_ptr<DatabaseBatch> other_batch = database->MakeBatch();
+        written = other_batch->Write(std::string("kept"), 1);
+        done = true;
+    });
+    UninterruptibleSleep(std::chrono::milliseconds{100});
+    BOOST_CHECK(!done);
+    BOOST_CHECK(batch->TxnAbort());
+    writer.join();
+    BOOST_CHECK(written);
+
+    BOOST_CHECK(!batch->Exists(std::string("aborted")));
+    BOOST_CHECK(batch->Exists(std::string("kept")));
+}
+
+BOOST_AUTO_TEST_CASE(sqlite_file) {
+    const fs::path wallet_path = GetDataDir() / "sqlite_wallet";
+    const fs::path file_path = wallet_path / "wallet.dat";
+    {
+        std::unique_ptr<WalletDatabase> database =
+            CreateWalletDatabase(wallet_path, DatabaseFormat::SQLITE);
+        bilingual_str error;
+        BOOST_CHECK(database->Verify(error));
+        BOOST_CHECK(IsWalletLoaded(wallet_path));
+
+        std::unique_ptr<DatabaseBatch> batch = database->MakeBatch();
+        for (int i = 0; i < 100; ++i) {
+            BOOST_CHECK(
+                batch->Write(std::make_pair(std::string("pool"), i), i));
+        }
+        BOOST_CHECK(batch->Write(std::string("kept"), 1));
+
+        // The database is locked while in use
+        SQLiteDatabase other_database(wallet_path, file_path);
+        BOOST_CHECK(!other_database.Verify(error));
+
+        const fs::path backup_path = GetDataDir() / "backup.dat";
+        BOOST_CHECK(database->Backup(backup_path.string()));
+        BOOST_CHECK(IsSQLiteFile(backup_path));
+
+        BOOST_CHECK(database->Rewrite("\x04pool"));
+        BOOST_CHECK(!batch->Exists(std::make_pair(std::string("pool"), 0)));
+        BOOST_CHECK(batch->Exists(std::string("kept")));
+
+        batch.reset();
+        database->Flush(true);
+    }
+    BOOST_CHECK(!IsWalletLoaded(wallet_path));
+    BOOST_CHECK(IsSQLiteFile(file_path));
+
+    // An existing database is opened with its own format
+    std::unique_ptr<WalletDatabase> database =
+        CreateWalletDatabase(wallet_path);
+    bilingual_str error;
+    BOOST_CHECK(database->Verify(error));
+    int value = 0;
+    BOOST_CHECK(database->MakeBatch()->Read(std::string("kept"), value));
+    BOOST_CHECK_EQUAL(value, 1);
+}
+#endif // USE_SQLITE
+
 BOOST_AUTO_TEST_SUITE_END()
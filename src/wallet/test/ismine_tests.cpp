@@ -16,11 +16,14 @@
 
 #include <chainparams.h>
 #include <key.h>
+#include <key_io.h>
 #include <node/context.h>
+#include <script/descriptor.h>
 #include <script/script.h>
 #include <script/script_error.h>
 #include <script/standard.h>
 #include <wallet/ismine.h>
+#include <wallet/scriptpubkeyset.h>
 #include <wallet/wallet.h>
 
 #include <test/util/setup_common.h>
@@ -262,4 +265,98 @@ BOOST_AUTO_TEST_CASE(ismine_standard) {
     }
 }
 
+static CScript RandomScript() {
+    const uint256 hash = InsecureRand256();
+    return GetScriptForDestination(
+        PKHash(uint160(std::vector<uint8_t>(hash.begin(), hash.begin() + 20))));
+}
+
+BOOST_AUTO_TEST_CASE(scriptpubkeyset) {
+    ScriptPubKeySet set;
+    std::vector<CScript> scripts;
+    // Enough scripts for the filter to grow a few times
+    for (int i = 0; i < 10000; ++i) {
+        scripts.push_back(RandomScript());
+        set.Insert(scripts.back());
+    }
+    set.Insert(scripts[0]);
+    BOOST_CHECK_EQUAL(set.Size(), scripts.size());
+
+    for (const CScript &script : scripts) {
+        BOOST_CHECK(set.MayContain(script));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        BOOST_CHECK(!set.MayContain(RandomScript()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ismine_wallet_scriptpubkeys) {
+    NodeContext node;
+    std::unique_ptr<interfaces::Chain> chain =
+        interfaces::MakeChain(node, Params());
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript p2pkh = GetScriptForDestination(PKHash(pubkey));
+    const CScript p2pk = GetScriptForRawPubKey(pubkey);
+    const CScript multisig = GetScriptForMultisig(1, {pubkey});
+    const CScript p2sh = GetScriptForDestination(ScriptHash(multisig));
+    const CScript other = RandomScript();
+
+    // The wallet learns about the scripts of a legacy ScriptPubKeyMan as keys
+    // and scripts are added
+    {
+        CWallet wallet(chain.get(), WalletLocation(),
+                       CreateMockWalletDatabase());
+        wallet.SetupLegacyScriptPubKeyMan();
+        LegacyScriptPubKeyMan *spk_man = wallet.GetLegacyScriptPubKeyMan();
+        LOCK(spk_man->cs_KeyStore);
+
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2pkh), ISMINE_NO);
+        BOOST_CHECK(spk_man->AddKey(key));
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2pkh), ISMINE_SPENDABLE);
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2pk), ISMINE_SPENDABLE);
+
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2sh), ISMINE_NO);
+        BOOST_CHECK(spk_man->AddCScript(multisig));
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2sh), ISMINE_SPENDABLE);
+        // Bare multisig is never ours
+        BOOST_CHECK_EQUAL(wallet.IsMine(multisig), ISMINE_NO);
+
+        BOOST_CHECK_EQUAL(wallet.IsMine(other), ISMINE_NO);
+        BOOST_CHECK(spk_man->AddWatchOnly(other, 0));
+        BOOST_CHECK_EQUAL(wallet.IsMine(other), ISMINE_WATCH_ONLY);
+        // The script is still in the wallet set, but no longer ours
+        BOOST_CHECK(spk_man->RemoveWatchOnly(other));
+        BOOST_CHECK_EQUAL(wallet.IsMine(other), ISMINE_NO);
+    }
+
+    // And about the scripts of a descriptor as it is expanded
+    {
+        CWallet wallet(chain.get(), WalletLocation(),
+                       CreateDummyWalletDatabase());
+        wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+
+        CExtKey master_key;
+        master_key.SetSeed(key.begin(), key.size());
+        FlatSigningProvider keys;
+        std::string error;
+        std::unique_ptr<Descriptor> desc =
+            Parse("pkh(" + EncodeExtKey(master_key) + "/0/*)", keys, error,
+                  /* require_checksum = */ false);
+        BOOST_REQUIRE(desc);
+        WalletDescriptor w_desc(std::move(desc), 0, 0, 1, 0);
+        BOOST_REQUIRE(wallet.AddWalletDescriptor(w_desc, keys, ""));
+
+        for (int i : {0, 10}) {
+            std::vector<CScript> scripts;
+            FlatSigningProvider out;
+            BOOST_REQUIRE(w_desc.descriptor->Expand(i, keys, scripts, out));
+            BOOST_CHECK_EQUAL(wallet.IsMine(scripts[0]), ISMINE_SPENDABLE);
+        }
+        BOOST_CHECK_EQUAL(wallet.IsMine(p2pkh), ISMINE_NO);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,11 +16,14 @@
 
 #include <chainparams.h>
 #include <key.h>
+#include <script/descriptor.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <wallet/scriptpubkeyman.h>
 #include <wallet/wallet.h>
 
+#include <algorithm>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(scriptpubkeyman_tests, BasicTestingSetup)
@@ -53,4 +56,39 @@ BOOST_AUTO_TEST_CASE(CanProvide) {
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// The keys of a topped up range are derived at once, check that they match
+// the ones derived one position at a time.
+BOOST_AUTO_TEST_CASE(DescriptorTopUp) {
+    NodeContext node;
+    std::unique_ptr<interfaces::Chain> chain =
+        interfaces::MakeChain(node, Params());
+    CWallet wallet(chain.get(), WalletLocation(), CreateDummyWalletDatabase());
+
+    FlatSigningProvider keys;
+    std::string error;
+    std::shared_ptr<Descriptor> desc = Parse(
+        "sh(multi(1,"
+        "xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4ko"
+        "xb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/1/*,"
+        "xpub68NZiKmJWnxxS6aaHmn81bvJeTESw724CRDs6HbuccFQN9Ku14VQrADWgqbhhTHBao"
+        "hPX4CjNLf9fq9MYo6oDaPPLPxSb7gwQN3ih19Zm4Y/0))",
+        keys, error);
+    BOOST_REQUIRE(desc);
+    WalletDescriptor w_desc(desc, 0, 0, 0, 0);
+    DescriptorScriptPubKeyMan spk_man(wallet, w_desc);
+
+    BOOST_CHECK(spk_man.TopUp(50));
+    std::vector<CScript> expected;
+    for (int pos = 0; pos < 50; ++pos) {
+        std::vector<CScript> scripts;
+        FlatSigningProvider out;
+        BOOST_CHECK(desc->Expand(pos, keys, scripts, out));
+        expected.insert(expected.end(), scripts.begin(), scripts.end());
+    }
+    std::vector<CScript> scripts = spk_man.GetScriptPubKeys();
+    std::sort(scripts.begin(), scripts.end());
+    std::sort(expected.begin(), expected.end());
+    BOOST_CHECK(scripts == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
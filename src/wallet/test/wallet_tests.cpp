@@ -17,11 +17,16 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <config.h>
+#include <index/blockfilterindex.h>
 #include <interfaces/chain.h>
+#include <key_io.h>
 #include <node/context.h>
 #include <policy/policy.h>
 #include <rpc/server.h>
+#include <script/descriptor.h>
+#include <txmempool.h>
 #include <util/ref.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <wallet/coincontrol.h>
@@ -196,6 +201,91 @@ BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions, TestChain100Setup) {
     }
 }
 
+// With the block filter index, a descriptor wallet rescan does not read the
+// blocks which have nothing for the wallet.
+BOOST_FIXTURE_TEST_CASE(scan_skips_unmatched_blocks, TestChain100Setup) {
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node, Params());
+
+    CWallet wallet(chain.get(), WalletLocation(), CreateDummyWalletDatabase());
+    wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+    CKey seed;
+    seed.MakeNewKey(true);
+    CExtKey master_key;
+    master_key.SetSeed(seed.begin(), seed.size());
+    FlatSigningProvider keys;
+    std::string error;
+    std::unique_ptr<Descriptor> desc =
+        Parse("pkh(" + EncodeExtKey(master_key) + "/0/*)", keys, error,
+              /* require_checksum = */ false);
+    BOOST_REQUIRE(desc);
+    WalletDescriptor w_desc(std::move(desc), 0, 0, 1, 0);
+    BOOST_REQUIRE(wallet.AddWalletDescriptor(w_desc, keys, ""));
+    std::vector<CScript> scripts;
+    FlatSigningProvider out;
+    BOOST_REQUIRE(w_desc.descriptor->Expand(0, keys, scripts, out));
+
+    // Mine a block paying someone else, then one paying the wallet, each in
+    // its own block file.
+    CBlockIndex *oldTip = ::ChainActive().Tip();
+    GetBlockFileInfo(oldTip->GetBlockPos().nFile)->nSize = MAX_BLOCKFILE_SIZE;
+    CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    const CBlockIndex *unmatched = ::ChainActive().Tip();
+    GetBlockFileInfo(unmatched->GetBlockPos().nFile)->nSize =
+        MAX_BLOCKFILE_SIZE;
+    CreateAndProcessBlock({}, scripts[0]);
+    const CBlockIndex *matched = ::ChainActive().Tip();
+    BOOST_CHECK(unmatched->GetBlockPos().nFile !=
+                matched->GetBlockPos().nFile);
+
+    BOOST_REQUIRE(
+        InitBlockFilterIndex(BlockFilterType::BASIC, 1 << 20, true, false));
+    BlockFilterIndex &filter_index =
+        *GetBlockFilterIndex(BlockFilterType::BASIC);
+    filter_index.Start();
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    // Make the unmatched block unreadable.
+    {
+        LOCK(cs_main);
+        Assert(m_node.chainman)
+            ->PruneOneBlockFile(unmatched->GetBlockPos().nFile);
+    }
+    UnlinkPrunedFiles({unmatched->GetBlockPos().nFile});
+
+    {
+        LOCK(wallet.cs_wallet);
+        wallet.SetLastBlockProcessed(::ChainActive().Height(),
+                                     ::ChainActive().Tip()->GetBlockHash());
+    }
+    WalletRescanReserver reserver(wallet);
+    reserver.reserve();
+
+    // The unmatched block is skipped, so the scan does not fail on it.
+    CWallet::ScanResult result = wallet.ScanForWalletTransactions(
+        unmatched->GetBlockHash(), unmatched->nHeight, {} /* max_height */,
+        reserver, false /* update */);
+    BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+    BOOST_CHECK(result.last_failed_block.IsNull());
+    BOOST_CHECK_EQUAL(result.last_scanned_block, matched->GetBlockHash());
+    BOOST_CHECK_EQUAL(*result.last_scanned_height, matched->nHeight);
+    BOOST_CHECK_EQUAL(wallet.GetBalance().m_mine_immature, 50 * COIN);
+
+    // Without the filters it is read, and found missing.
+    DestroyAllBlockFilterIndexes();
+    result = wallet.ScanForWalletTransactions(
+        unmatched->GetBlockHash(), unmatched->nHeight, {} /* max_height */,
+        reserver, false /* update */);
+    BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::FAILURE);
+    BOOST_CHECK_EQUAL(result.last_failed_block, unmatched->GetBlockHash());
+    BOOST_CHECK_EQUAL(result.last_scanned_block, matched->GetBlockHash());
+}
+
 BOOST_FIXTURE_TEST_CASE(importmulti_rescan, TestChain100Setup) {
     // Cap last block file size, and mine new block in a new block file.
     CBlockIndex *oldTip = ::ChainActive().Tip();
@@ -670,6 +760,67 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup) {
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(txs_with_unspent_outputs, ListCoinsTestingSetup) {
+    auto hasUnspentOutputs = [&](const TxId &txid) {
+        LOCK(wallet->cs_wallet);
+        for (const CWalletTx *wtx : wallet->GetTxsWithUnspentOutputs()) {
+            if (wtx->GetId() == txid) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Only the first coinbase is mature, the immature ones are always
+    // returned.
+    const TxId coinbaseTxId = m_coinbase_txns[0]->GetId();
+    const TxId immatureTxId = m_coinbase_txns[1]->GetId();
+    BOOST_CHECK(hasUnspentOutputs(coinbaseTxId));
+    BOOST_CHECK(hasUnspentOutputs(immatureTxId));
+    BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), 50 * COIN);
+
+    // Spend the mature coinbase to a key which is not ours, with no change.
+    CKey key;
+    key.MakeNewKey(true);
+    CTransactionRef tx;
+    Amount fee;
+    int changePos = -1;
+    bilingual_str error;
+    CCoinControl dummy;
+    BOOST_CHECK(wallet->CreateTransaction(
+        {CRecipient{GetScriptForRawPubKey(key.GetPubKey()), 50 * COIN,
+                    true /* subtract fee */}},
+        tx, fee, changePos, error, dummy));
+    BOOST_CHECK_EQUAL(changePos, -1);
+    wallet->CommitTransaction(tx, {}, {});
+
+    // The coinbase is pruned once spent, and the spending transaction doesn't
+    // pay to us.
+    BOOST_CHECK(!hasUnspentOutputs(coinbaseTxId));
+    BOOST_CHECK(!hasUnspentOutputs(tx->GetId()));
+    BOOST_CHECK(hasUnspentOutputs(immatureTxId));
+    BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), Amount::zero());
+
+    // Abandoning the spending transaction makes the coinbase unspent again.
+    {
+        LOCK2(::cs_main, m_node.mempool->cs);
+        m_node.mempool->removeRecursive(*tx, MemPoolRemovalReason::CONFLICT);
+    }
+    wallet->transactionRemovedFromMempool(tx);
+    BOOST_CHECK(wallet->AbandonTransaction(tx->GetId()));
+    BOOST_CHECK(hasUnspentOutputs(coinbaseTxId));
+    BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), 50 * COIN);
+
+    // Once the key is imported the spending transaction pays to us. It was
+    // pruned, so it is only back after MarkDirty, as done by the imports.
+    AddKey(*wallet, key);
+    BOOST_CHECK(!hasUnspentOutputs(tx->GetId()));
+    wallet->MarkDirty();
+    BOOST_CHECK(hasUnspentOutputs(tx->GetId()));
+    LOCK(wallet->cs_wallet);
+    BOOST_CHECK(wallet->HasUnspentOutputs(wallet->mapWallet.at(tx->GetId())));
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup) {
     NodeContext node;
     auto chain = interfaces::MakeChain(node, Params());
@@ -18,6 +18,7 @@
 
 #include <chainparams.h>
 #include <interfaces/chain.h>
+#include <key.h>
 #include <node/context.h>
 #include <wallet/wallet.h>
 
@@ -27,6 +28,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace {
 static std::unique_ptr<CWallet> LoadWallet(WalletBatch &batch) {
@@ -140,4 +142,47 @@ BOOST_AUTO_TEST_CASE(no_dest_fails) {
     BOOST_CHECK(!batch.WriteDestData(dst, "key", "value"));
 }
 
+BOOST_AUTO_TEST_CASE(load_keys) {
+    WalletBatch batch(m_wallet.GetDBHandle(), "cr+");
+    std::unique_ptr<DatabaseBatch> raw_batch =
+        m_wallet.GetDBHandle().MakeBatch();
+
+    // Enough keys to be decoded in several batches, some of them in the old
+    // format without the pubkey/privkey hash.
+    std::vector<CPubKey> pubkeys;
+    for (int i = 0; i < 5000; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        CPubKey pubkey = key.GetPubKey();
+        if (i % 10 == 0) {
+            BOOST_CHECK(raw_batch->Write(std::make_pair(DBKeys::KEY, pubkey),
+                                         key.GetPrivKey()));
+        } else {
+            BOOST_CHECK(
+                batch.WriteKey(pubkey, key.GetPrivKey(), CKeyMetadata()));
+        }
+        pubkeys.push_back(pubkey);
+    }
+
+    {
+        auto w = LoadWallet(batch);
+        LegacyScriptPubKeyMan *spk_man = w->GetLegacyScriptPubKeyMan();
+        BOOST_REQUIRE(spk_man);
+        for (const CPubKey &pubkey : pubkeys) {
+            BOOST_CHECK(spk_man->HaveKey(pubkey.GetID()));
+        }
+    }
+
+    // A private key that does not match its public key is detected
+    CKey other_key;
+    other_key.MakeNewKey(true);
+    BOOST_CHECK(raw_batch->Write(std::make_pair(DBKeys::KEY, pubkeys[0]),
+                                 other_key.GetPrivKey()));
+
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node, Params());
+    CWallet wallet(chain.get(), WalletLocation(), CreateDummyWalletDatabase());
+    BOOST_CHECK(batch.LoadWallet(&wallet) == DBErrors::CORRUPT);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
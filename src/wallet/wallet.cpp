@@ -17,6 +17,7 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <config.h>
@@ -46,6 +47,12 @@
 
 #include <boost/algorithm/string/replace.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <system_error>
+#include <thread>
+
 using interfaces::FoundBlock;
 
 const std::map<uint64_t, std::string> WALLET_FLAG_CAVEATS{
@@ -804,6 +811,8 @@ void CWallet::MarkDirty() {
     LOCK(cs_wallet);
     for (std::pair<const TxId, CWalletTx> &item : mapWallet) {
         item.second.MarkDirty();
+        // Outputs may have become ours, e.g. after an import.
+        m_txs_with_unspent_outputs.insert(item.first);
     }
 }
 
@@ -888,6 +897,7 @@ CWalletTx *CWallet::AddToWallet(CTransactionRef tx,
     CWalletTx &wtx = (*ret.first).second;
     bool fInsertedNew = ret.second;
     bool fUpdated = update_wtx && update_wtx(wtx, fInsertedNew);
+    m_txs_with_unspent_outputs.insert(txid);
     if (fInsertedNew) {
         wtx.m_confirm = confirm;
         wtx.nTimeReceived = chain().getAdjustedTime();
@@ -986,6 +996,7 @@ bool CWallet::LoadToWallet(const TxId &txid, const UpdateWalletTxFn &fill_wtx) {
         wtx.m_it_wtxOrdered =
             wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
+    m_txs_with_unspent_outputs.insert(txid);
     AddToSpends(txid);
     for (const CTxIn &txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.GetTxId());
@@ -1068,6 +1079,9 @@ void CWallet::MarkInputsDirty(const CTransactionRef &tx) {
         auto it = mapWallet.find(txin.prevout.GetTxId());
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            // The spending transaction may no longer count, e.g. because it
+            // was abandoned or conflicted.
+            m_txs_with_unspent_outputs.insert(it->first);
         }
     }
 }
@@ -1310,6 +1324,11 @@ isminetype CWallet::IsMine(const CTxDestination &dest) const {
 }
 
 isminetype CWallet::IsMine(const CScript &script) const {
+    // Most scripts are not ours, don't ask each ScriptPubKeyMan about them.
+    if (!m_owned_spks.MayContain(script)) {
+        return ISMINE_NO;
+    }
+
     isminetype result = ISMINE_NO;
     for (const auto &spk_man_pair : m_spk_managers) {
         result = std::max(result, spk_man_pair.second->IsMine(script));
@@ -1763,6 +1782,298 @@ int64_t CWallet::RescanFromTime(int64_t startTime,
     return startTime;
 }
 
+namespace {
+/**
+ * Number of blocks a rescan reads ahead of the one the wallet is processing.
+ */
+constexpr size_t RESCAN_READ_AHEAD_BLOCKS = 16;
+/**
+ * Number of threads reading the blocks ahead. Reading is mostly disk bound,
+ * more threads would only compete with the wallet for the disk.
+ */
+constexpr unsigned int RESCAN_READ_AHEAD_THREADS = 2;
+
+/**
+ * Matches blocks against the wallet's scriptPubKeys using the BIP158 basic
+ * block filters. These cover both the outputs of a block and the scripts spent
+ * by its inputs, so a rescan can skip the blocks which do not match without
+ * reading them.
+ *
+ * Only descriptor wallets are supported: the scripts a legacy wallet
+ * considers as its own cannot be enumerated.
+ */
+class FastWalletRescanFilter {
+public:
+    explicit FastWalletRescanFilter(const CWallet &wallet)
+        : m_wallet(wallet),
+          m_filter_set(std::make_shared<GCSFilter::ElementSet>()) {
+        assert(wallet.IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS));
+        UpdateIfNeeded();
+    }
+
+    /**
+     * Add the scriptPubKeys the descriptors were topped up with since the last
+     * call, which happens when the rescan finds one of the last addresses in
+     * their range. Return whether the filter set changed.
+     */
+    bool UpdateIfNeeded() {
+        std::shared_ptr<GCSFilter::ElementSet> filter_set;
+        for (ScriptPubKeyMan *spkm : m_wallet.GetAllScriptPubKeyMans()) {
+            auto desc_spkm = dynamic_cast<DescriptorScriptPubKeyMan *>(spkm);
+            assert(desc_spkm != nullptr);
+
+            const int32_t range_end =
+                WITH_LOCK(desc_spkm->cs_desc_man,
+                          return desc_spkm->GetWalletDescriptor().range_end);
+            auto it = m_last_range_ends.find(desc_spkm);
+            if (it != m_last_range_ends.end() && it->second >= range_end) {
+                continue;
+            }
+
+            // The set is shared with the blocks being read ahead, copy it
+            // before adding to it.
+            if (!filter_set) {
+                filter_set =
+                    std::make_shared<GCSFilter::ElementSet>(*m_filter_set);
+            }
+            const int32_t minimum_index =
+                it == m_last_range_ends.end() ? 0 : it->second;
+            for (const CScript &script :
+                 desc_spkm->GetScriptPubKeys(minimum_index)) {
+                filter_set->emplace(script.begin(), script.end());
+            }
+            m_last_range_ends[desc_spkm] = range_end;
+        }
+
+        if (!filter_set) {
+            return false;
+        }
+        m_filter_set = std::move(filter_set);
+        return true;
+    }
+
+    std::shared_ptr<const GCSFilter::ElementSet> GetFilterSet() const {
+        return m_filter_set;
+    }
+
+private:
+    const CWallet &m_wallet;
+    std::shared_ptr<const GCSFilter::ElementSet> m_filter_set;
+    //! The range end of each descriptor the last time it was added to the set.
+    std::map<const DescriptorScriptPubKeyMan *, int32_t> m_last_range_ends;
+};
+
+/**
+ * Reads the blocks of a rescan ahead of the one the wallet is processing, on a
+ * few worker threads, so reading and deserializing them overlaps with the
+ * wallet syncing the previous ones. The blocks are still handed to the wallet
+ * one at a time and in order. The workers are joined when the object goes out
+ * of scope.
+ */
+class RescanReadAhead {
+public:
+    struct Block {
+        //! The block filter shows there is nothing for the wallet in the
+        //! block, so it was not read.
+        bool skipped{false};
+        //! The block was read from disk.
+        bool found{false};
+        CBlock block;
+    };
+
+    RescanReadAhead(interfaces::Chain &chain, size_t depth,
+                    unsigned int num_threads)
+        : m_chain(chain), m_depth(depth) {
+        try {
+            for (unsigned int i = 0; i < num_threads; i++) {
+                m_threads.emplace_back(&TraceThread<std::function<void()>>,
+                                       "rescanread",
+                                       std::function<void()>(
+                                           [this] { ThreadReadAhead(); }));
+            }
+        } catch (const std::system_error &e) {
+            // Read ahead with the threads that could be started, or only read
+            // the blocks when they are needed if there are none.
+            LogPrintf("Unable to start a rescan read ahead thread: %s\n",
+                      e.what());
+        }
+    }
+
+    ~RescanReadAhead() {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cond_worker.notify_all();
+        for (std::thread &t : m_threads) {
+            t.join();
+        }
+    }
+
+    /**
+     * Use filter_set to skip blocks from now on. The blocks already read
+     * ahead with the previous set are dropped. This does not wait for the
+     * blocks being read, the workers discard them when they are done.
+     */
+    void SetFilterSet(std::shared_ptr<const GCSFilter::ElementSet> filter_set) {
+        LOCK(m_mutex);
+        m_pending.clear();
+        m_filter_set = std::move(filter_set);
+    }
+
+    /**
+     * Get the block block_hash at block_height, and queue the blocks
+     * following it, up to end_hash, for the workers to read.
+     */
+    Block Get(const BlockHash &block_hash, int block_height,
+              const BlockHash &end_hash) {
+        std::shared_ptr<Request> current;
+        std::shared_ptr<const GCSFilter::ElementSet> filter_set;
+        int next_height;
+        size_t missing;
+        {
+            LOCK(m_mutex);
+            while (!m_pending.empty() &&
+                   m_pending.front()->height < block_height) {
+                m_pending.pop_front();
+            }
+            // What was read ahead belongs to another chain after a reorg.
+            if (!m_pending.empty() && m_pending.front()->hash != block_hash) {
+                m_pending.clear();
+            }
+            if (!m_pending.empty()) {
+                current = std::move(m_pending.front());
+                m_pending.pop_front();
+            }
+            filter_set = m_filter_set;
+            next_height = m_pending.empty() ? block_height + 1
+                                            : m_pending.back()->height + 1;
+            missing = m_depth - m_pending.size();
+        }
+
+        // Look the blocks up without holding the lock, the workers need it.
+        std::vector<std::shared_ptr<Request>> requests;
+        for (; requests.size() < missing; ++next_height) {
+            BlockHash next_hash;
+            if (!m_chain.findAncestorByHeight(
+                    end_hash, next_height,
+                    interfaces::FoundBlock().hash(next_hash))) {
+                break;
+            }
+            requests.push_back(
+                std::make_shared<Request>(next_height, next_hash, filter_set));
+        }
+        if (!requests.empty()) {
+            {
+                LOCK(m_mutex);
+                m_pending.insert(m_pending.end(), requests.begin(),
+                                 requests.end());
+            }
+            m_cond_worker.notify_all();
+        }
+
+        if (!current) {
+            return Fetch(m_chain, block_hash, filter_set);
+        }
+        {
+            WAIT_LOCK(m_mutex, lock);
+            if (current->started) {
+                m_cond_done.wait(lock,
+                                 [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                                     return current->done;
+                                 });
+                return std::move(current->block);
+            }
+            // No worker got to it yet, read it here.
+            current->started = true;
+        }
+        return Fetch(m_chain, block_hash, current->filter_set);
+    }
+
+private:
+    /** A block to read ahead. started, done and block are guarded by m_mutex */
+    struct Request {
+        Request(int height_in, const BlockHash &hash_in,
+                std::shared_ptr<const GCSFilter::ElementSet> filter_set_in)
+            : height(height_in), hash(hash_in),
+              filter_set(std::move(filter_set_in)) {}
+
+        const int height;
+        const BlockHash hash;
+        const std::shared_ptr<const GCSFilter::ElementSet> filter_set;
+        bool started{false};
+        bool done{false};
+        Block block;
+    };
+
+    static Block
+    Fetch(interfaces::Chain &chain, const BlockHash &block_hash,
+          const std::shared_ptr<const GCSFilter::ElementSet> &filter_set) {
+        Block result;
+        if (filter_set) {
+            const std::optional<bool> matches = chain.blockFilterMatchesAny(
+                BlockFilterType::BASIC, block_hash, *filter_set);
+            if (matches && !*matches) {
+                result.skipped = true;
+                return result;
+            }
+        }
+        result.found = chain.findBlock(block_hash,
+                                       interfaces::FoundBlock().data(
+                                           result.block)) &&
+                       !result.block.IsNull();
+        return result;
+    }
+
+    void ThreadReadAhead() {
+        while (true) {
+            std::shared_ptr<Request> request;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cond_worker.wait(
+                    lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                        if (m_stop) {
+                            return true;
+                        }
+                        for (const std::shared_ptr<Request> &r : m_pending) {
+                            if (!r->started) {
+                                request = r;
+                                return true;
+                            }
+                        }
+                        return false;
+                    });
+                if (m_stop) {
+                    return;
+                }
+                request->started = true;
+            }
+
+            Block block = Fetch(m_chain, request->hash, request->filter_set);
+
+            {
+                LOCK(m_mutex);
+                request->block = std::move(block);
+                request->done = true;
+            }
+            m_cond_done.notify_all();
+        }
+    }
+
+    interfaces::Chain &m_chain;
+    const size_t m_depth;
+    Mutex m_mutex;
+    std::condition_variable m_cond_worker;
+    std::condition_variable m_cond_done;
+    std::shared_ptr<const GCSFilter::ElementSet>
+        m_filter_set GUARDED_BY(m_mutex);
+    //! The blocks following the one being processed, in chain order
+    std::deque<std::shared_ptr<Request>> m_pending GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions from or to
  * us. If fUpdate is true, found transactions that already exist in the wallet
@@ -1774,6 +2085,10 @@ int64_t CWallet::RescanFromTime(int64_t startTime,
  * @param[in] max_height  Optional max scanning height. If unset there is
  *                        no maximum and scanning can continue to the tip
  *
+ * The blocks are read ahead on a few worker threads. For descriptor wallets,
+ * and if the basic block filter index is enabled, the blocks which do not match
+ * the wallet's scriptPubKeys are skipped without being read.
+ *
  * @return ScanResult returning scan information and indicating success or
  *         failure. Return status will be set to SUCCESS if scan was
  *         successful. FAILURE if a complete rescan was not possible (due to
@@ -1796,8 +2111,20 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
     BlockHash block_hash = start_block;
     ScanResult result;
 
-    WalletLogPrintf("Rescan started from block %s...\n",
-                    start_block.ToString());
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS) &&
+        chain().hasBlockFilterIndex(BlockFilterType::BASIC)) {
+        fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(*this);
+    }
+    RescanReadAhead read_ahead(chain(), RESCAN_READ_AHEAD_BLOCKS,
+                               RESCAN_READ_AHEAD_THREADS);
+    if (fast_rescan_filter) {
+        read_ahead.SetFilterSet(fast_rescan_filter->GetFilterSet());
+    }
+
+    WalletLogPrintf("Rescan started from block %s...%s\n",
+                    start_block.ToString(),
+                    fast_rescan_filter ? " (using block filters)" : "");
 
     fAbortRescan = false;
     // Show rescan progress in GUI as dialog or on splashscreen, if -rescan on
@@ -1829,12 +2156,12 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                             block_height, progress_current);
         }
 
-        CBlock block;
+        const RescanReadAhead::Block fetched = read_ahead.Get(
+            block_hash, block_height, max_height ? end_hash : tip_hash);
         bool next_block;
         BlockHash next_block_hash;
         bool reorg = false;
-        if (chain().findBlock(block_hash, FoundBlock().data(block)) &&
-            !block.IsNull()) {
+        if (fetched.skipped || fetched.found) {
             LOCK(cs_wallet);
             next_block = chain().findNextBlock(
                 block_hash, block_height, FoundBlock().hash(next_block_hash),
@@ -1848,12 +2175,28 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                 result.status = ScanResult::FAILURE;
                 break;
             }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size();
+            const std::vector<CTransactionRef> &vtx = fetched.block.vtx;
+            // Commit the records of the block at once rather than one by one.
+            // With SQLite this spans the writes of the other batches of this
+            // thread, the other threads wait for it to end. Each Berkeley DB
+            // batch keeps its own transaction.
+            WalletBatch batch(*database, "r+", false);
+            const bool txn = !vtx.empty() && batch.TxnBegin();
+            for (size_t posInBlock = 0; posInBlock < vtx.size();
                  ++posInBlock) {
                 CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED,
                                                 block_height, block_hash,
                                                 posInBlock);
-                SyncTransaction(block.vtx[posInBlock], confirm, fUpdate);
+                SyncTransaction(vtx[posInBlock], confirm, fUpdate);
+            }
+            if (txn && !batch.TxnCommit()) {
+                batch.TxnAbort();
+                WalletLogPrintf("Rescan: Unable to write the transactions of "
+                                "block %s\n",
+                                block_hash.ToString());
+                result.last_failed_block = block_hash;
+                result.status = ScanResult::FAILURE;
+                break;
             }
             // scan succeeded, record block as most recent successfully
             // scanned
@@ -1868,6 +2211,12 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                 block_hash, block_height, FoundBlock().hash(next_block_hash),
                 &reorg);
         }
+        // Transactions found in this block may have topped up the
+        // descriptors, the blocks read ahead need to be matched again.
+        if (fast_rescan_filter && fetched.found &&
+            fast_rescan_filter->UpdateIfNeeded()) {
+            read_ahead.SetFilterSet(fast_rescan_filter->GetFilterSet());
+        }
         if (max_height && block_height >= *max_height) {
             break;
         }
@@ -2266,8 +2615,8 @@ CWallet::Balance CWallet::GetBalance(const int min_depth,
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
     LOCK(cs_wallet);
     std::set<TxId> trusted_parents;
-    for (const auto &entry : mapWallet) {
-        const CWalletTx &wtx = entry.second;
+    for (const CWalletTx *pwtx : GetTxsWithUnspentOutputs()) {
+        const CWalletTx &wtx = *pwtx;
         const bool is_trusted{wtx.IsTrusted(trusted_parents)};
         const int tx_depth{wtx.GetDepthInMainChain()};
         const Amount tx_credit_mine{wtx.GetAvailableCredit(
@@ -2288,6 +2637,42 @@ CWallet::Balance CWallet::GetBalance(const int min_depth,
     return ret;
 }
 
+bool CWallet::HasUnspentOutputs(const CWalletTx &wtx) const {
+    AssertLockHeld(cs_wallet);
+
+    // Immature coinbases are accounted for whether they are spent or not.
+    if (wtx.IsImmatureCoinBase()) {
+        return true;
+    }
+
+    const TxId &txid = wtx.GetId();
+    for (uint32_t i = 0; i < wtx.tx->vout.size(); i++) {
+        if (IsMine(wtx.tx->vout[i]) != ISMINE_NO &&
+            !IsSpent(COutPoint(txid, i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<const CWalletTx *> CWallet::GetTxsWithUnspentOutputs() const {
+    AssertLockHeld(cs_wallet);
+
+    std::vector<const CWalletTx *> result;
+    result.reserve(m_txs_with_unspent_outputs.size());
+    auto it = m_txs_with_unspent_outputs.begin();
+    while (it != m_txs_with_unspent_outputs.end()) {
+        auto wit = mapWallet.find(*it);
+        if (wit == mapWallet.end() || !HasUnspentOutputs(wit->second)) {
+            it = m_txs_with_unspent_outputs.erase(it);
+            continue;
+        }
+        result.push_back(&wit->second);
+        ++it;
+    }
+    return result;
+}
+
 Amount CWallet::GetAvailableBalance(const CCoinControl *coinControl) const {
     LOCK(cs_wallet);
 
@@ -2325,9 +2710,9 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe,
                                        : DEFAULT_MAX_DEPTH};
 
     std::set<TxId> trusted_parents;
-    for (const auto &entry : mapWallet) {
-        const TxId &wtxid = entry.first;
-        const CWalletTx &wtx = entry.second;
+    for (const CWalletTx *pwtx : GetTxsWithUnspentOutputs()) {
+        const TxId &wtxid = pwtx->GetId();
+        const CWalletTx &wtx = *pwtx;
 
         TxValidationState state;
         if (!chain().contextualCheckTransactionForCurrentBlock(*wtx.tx,
@@ -2384,7 +2769,7 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe,
         for (uint32_t i = 0; i < wtx.tx->vout.size(); i++) {
             // Only consider selected coins if add_inputs is false
             if (coinControl && !coinControl->m_add_inputs &&
-                !coinControl->IsSelected(COutPoint(entry.first, i))) {
+                !coinControl->IsSelected(COutPoint(wtxid, i))) {
                 continue;
             }
 
@@ -2532,7 +2917,10 @@ bool CWallet::SelectCoinsMinConf(
         // Get long term estimate
         CCoinControl temp;
         temp.m_confirm_target = 1008;
-        CFeeRate long_term_feerate = GetMinimumFeeRate(*this, temp);
+        // Never value the inputs below the consolidation feerate, so that
+        // selection favours spending more of them while fees are low.
+        CFeeRate long_term_feerate =
+            std::max(GetMinimumFeeRate(*this, temp), m_consolidate_feerate);
 
         // Calculate cost of change
         Amount cost_of_change = chain().relayDustFee().GetFee(
@@ -3498,6 +3886,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<TxId> &txIdsIn,
         const auto &it = mapWallet.find(txid);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
+        m_txs_with_unspent_outputs.erase(txid);
         NotifyTransactionChanged(this, txid, CT_DELETED);
     }
 
@@ -4298,6 +4687,22 @@ std::shared_ptr<CWallet> CWallet::CreateWalletFromFile(
         walletInstance->m_min_fee = CFeeRate(n);
     }
 
+    if (gArgs.IsArgSet("-consolidatefeerate")) {
+        Amount n = Amount::zero();
+        if (!ParseMoney(gArgs.GetArg("-consolidatefeerate", ""), n)) {
+            error = AmountErrMsg("consolidatefeerate",
+                                 gArgs.GetArg("-consolidatefeerate", ""));
+            return nullptr;
+        }
+        if (n > HIGH_TX_FEE_PER_KB) {
+            warnings.push_back(AmountHighWarn("-consolidatefeerate") +
+                               Untranslated(" ") +
+                               _("Coin selection will prefer spending more "
+                                 "inputs below this fee rate."));
+        }
+        walletInstance->m_consolidate_feerate = CFeeRate(n);
+    }
+
     if (gArgs.IsArgSet("-maxapsfee")) {
         Amount n = Amount::zero();
         if (gArgs.GetArg("-maxapsfee", "") == "-1") {
@@ -4875,6 +5280,10 @@ bool CWallet::HasEncryptionKeys() const {
     return !mapMasterKeys.empty();
 }
 
+void CWallet::AddOwnedScriptPubKey(const CScript &script) {
+    m_owned_spks.Insert(script);
+}
+
 void CWallet::ConnectScriptPubKeyManNotifiers() {
     for (const auto &spk_man : GetActiveScriptPubKeyMans()) {
         spk_man->NotifyWatchonlyChanged.connect(NotifyWatchonlyChanged);
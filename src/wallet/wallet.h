@@ -37,6 +37,7 @@
 #include <wallet/crypter.h>
 #include <wallet/rpcwallet.h>
 #include <wallet/scriptpubkeyman.h>
+#include <wallet/scriptpubkeyset.h>
 #include <wallet/walletdb.h>
 #include <wallet/walletutil.h>
 
@@ -90,6 +91,8 @@ WalletCreationStatus CreateWallet(const CChainParams &params,
 constexpr Amount DEFAULT_PAY_TX_FEE = Amount::zero();
 //! -fallbackfee default
 static const Amount DEFAULT_FALLBACK_FEE = Amount::zero();
+//! -consolidatefeerate default (disabled)
+static const Amount DEFAULT_CONSOLIDATE_FEERATE = Amount::zero();
 //! -mintxfee default
 static const Amount DEFAULT_TRANSACTION_MINFEE_PER_KB = 1000 * SATOSHI;
 /**
@@ -449,7 +452,20 @@ public:
     }
 
     template <typename Stream> void Unserialize(Stream &s) {
+        CTransactionRef txIn;
+        s >> txIn;
+        UnserializeWithTx(s, std::move(txIn));
+    }
+
+    /**
+     * Unserialize everything that follows the transaction in the stream. The
+     * transaction itself was already read by the caller, which allows the
+     * transactions to be decoded on several threads when loading the wallet.
+     */
+    template <typename Stream>
+    void UnserializeWithTx(Stream &s, CTransactionRef txIn) {
         Init();
+        tx = std::move(txIn);
 
         //! Used to be vMerkleBranch
         std::vector<uint256> dummy_vector1;
@@ -458,7 +474,7 @@ public:
         //! Used to be fSpent
         bool dummy_bool;
         int serializedIndex;
-        s >> tx >> m_confirm.hashBlock >> dummy_vector1 >> serializedIndex >>
+        s >> m_confirm.hashBlock >> dummy_vector1 >> serializedIndex >>
             dummy_vector2 >> mapValue >> vOrderForm >> fTimeReceivedIsTxTime >>
             nTimeReceived >> fFromMe >> dummy_bool;
 
@@ -763,6 +779,17 @@ private:
     void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>)
         EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Transactions which may still have unspent outputs of ours, so
+     * AvailableCoins and GetBalance do not need to go through the whole of
+     * mapWallet. This is a superset: transactions are added when they enter
+     * the wallet and whenever the outputs they pay to us may have become
+     * unspent again (a spending transaction got abandoned or conflicted, or
+     * IsMine changed). They are only removed by GetTxsWithUnspentOutputs,
+     * once all their outputs are found spent.
+     */
+    mutable std::set<TxId> m_txs_with_unspent_outputs GUARDED_BY(cs_wallet);
+
     /**
      * Used by
      * TransactionAddedToMemorypool/BlockConnected/Disconnected/ScanForWalletTransactions.
@@ -826,6 +853,10 @@ private:
     // structure
     std::map<uint256, std::unique_ptr<ScriptPubKeyMan>> m_spk_managers;
 
+    //! The scriptPubKeys reported by the ScriptPubKeyMans through
+    //! AddOwnedScriptPubKey. IsMine only asks them about these scripts.
+    ScriptPubKeySet m_owned_spks;
+
 public:
     /*
      * Main wallet lock.
@@ -920,6 +951,15 @@ public:
         return nWalletMaxVersion >= wf;
     }
 
+    //! Whether some of the outputs of wtx paying to us are not spent yet, or
+    //! it is an immature coinbase.
+    bool HasUnspentOutputs(const CWalletTx &wtx) const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    //! The transactions with unspent outputs of ours, ordered by txid.
+    std::vector<const CWalletTx *> GetTxsWithUnspentOutputs() const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * populate vCoins with vector of available COutputs.
      */
@@ -1091,9 +1131,9 @@ public:
         std::optional<int> last_scanned_height;
 
         //! Hash of the most recent block that could not be scanned due to
-        //! read errors or pruning. Will be set if status is FAILURE, unset if
-        //! status is SUCCESS, and may or may not be set if status is
-        //! USER_ABORT.
+        //! read errors or pruning, or whose transactions could not be
+        //! written. Will be set if status is FAILURE, unset if status is
+        //! SUCCESS, and may or may not be set if status is USER_ABORT.
         BlockHash last_failed_block;
     };
     ScanResult ScanForWalletTransactions(const BlockHash &start_block,
@@ -1221,6 +1261,12 @@ public:
     bool m_allow_fallback_fee{true};
     // Override with -mintxfee
     CFeeRate m_min_fee{DEFAULT_TRANSACTION_MINFEE_PER_KB};
+    /**
+     * Fee rate below which coin selection prefers spending more inputs, to
+     * consolidate the wallet's UTXOs while it is cheap. Override with
+     * -consolidatefeerate
+     */
+    CFeeRate m_consolidate_feerate{DEFAULT_CONSOLIDATE_FEERATE};
     /**
      * If fee estimation does not have enough data to provide estimates, use
      * this fee instead. Has no effect if not using fee estimation Override with
@@ -1516,6 +1562,7 @@ public:
 
     const CKeyingMaterial &GetEncryptionKey() const override;
     bool HasEncryptionKeys() const override;
+    void AddOwnedScriptPubKey(const CScript &script) override;
 
     /** Get last block processed height */
     int GetLastBlockHeight() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
@@ -27,9 +27,20 @@
 #include <util/bip32.h>
 #include <util/system.h>
 #include <util/time.h>
+#ifdef USE_SQLITE
+#include <wallet/sqlite.h>
+#endif
 #include <wallet/wallet.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 namespace DBKeys {
 const std::string ACENTRY{"acentry"};
@@ -150,7 +161,7 @@ bool WalletBatch::WriteCryptedKey(const CPubKey &vchPubKey,
     if (!WriteIC(key, std::make_pair(vchCryptedSecret, checksum), false)) {
         // It may already exist, so try writing just the checksum
         std::vector<uint8_t> val;
-        if (!m_batch.Read(key, val)) {
+        if (!m_batch->Read(key, val)) {
             return false;
         }
         if (!WriteIC(key, std::make_pair(val, checksum), true)) {
@@ -194,10 +205,10 @@ bool WalletBatch::WriteBestBlock(const CBlockLocator &locator) {
 }
 
 bool WalletBatch::ReadBestBlock(CBlockLocator &locator) {
-    if (m_batch.Read(DBKeys::BESTBLOCK, locator) && !locator.vHave.empty()) {
+    if (m_batch->Read(DBKeys::BESTBLOCK, locator) && !locator.vHave.empty()) {
         return true;
     }
-    return m_batch.Read(DBKeys::BESTBLOCK_NOMERKLE, locator);
+    return m_batch->Read(DBKeys::BESTBLOCK_NOMERKLE, locator);
 }
 
 bool WalletBatch::WriteOrderPosNext(int64_t nOrderPosNext) {
@@ -205,7 +216,7 @@ bool WalletBatch::WriteOrderPosNext(int64_t nOrderPosNext) {
 }
 
 bool WalletBatch::ReadPool(int64_t nPool, CKeyPool &keypool) {
-    return m_batch.Read(std::make_pair(DBKeys::POOL, nPool), keypool);
+    return m_batch->Read(std::make_pair(DBKeys::POOL, nPool), keypool);
 }
 
 bool WalletBatch::WritePool(int64_t nPool, const CKeyPool &keypool) {
@@ -304,15 +315,255 @@ public:
     CWalletScanState() {}
 };
 
-static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
-                         CDataStream &ssValue, CWalletScanState &wss,
-                         std::string &strType, std::string &strErr)
-    EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+/** Number of records read from the database before they are decoded. */
+static constexpr size_t LOAD_BATCH_SIZE = 4096;
+/** Maximum number of threads decoding the records when loading a wallet. */
+static constexpr unsigned int MAX_LOAD_THREADS = 8;
+/** Fewer threads are used when they would get fewer records than this. */
+static constexpr size_t MIN_RECORDS_PER_LOAD_THREAD = 256;
+
+/**
+ * A wallet record, along with the parts of it that can be decoded without
+ * accessing the wallet: the transaction of a transaction record, and the
+ * private key of a key record, checked against its public key.
+ */
+struct WalletRecord {
+    CDataStream ssKey{SER_DISK, CLIENT_VERSION};
+    CDataStream ssValue{SER_DISK, CLIENT_VERSION};
+
+    //! Set by DecodeRecord
+    std::string strType;
+    std::string strErr;
+    bool decoded{false};
+    CPubKey pubkey;
+    CKey key;
+    uint256 desc_id;
+    TxId txid;
+    CTransactionRef tx;
+};
+
+/**
+ * Decode the record type, and the costly parts of the records that do not
+ * need the wallet. This does not lock anything, so that several records can
+ * be decoded at the same time.
+ */
+static bool DecodeRecord(WalletRecord &record) {
+    CDataStream &ssKey = record.ssKey;
+    CDataStream &ssValue = record.ssValue;
+    std::string &strErr = record.strErr;
     try {
         // Unserialize
         // Taking advantage of the fact that pair serialization is just the two
         // items serialized one after the other.
-        ssKey >> strType;
+        ssKey >> record.strType;
+        if (record.strType == DBKeys::TX) {
+            ssKey >> record.txid;
+            ssValue >> record.tx;
+        } else if (record.strType == DBKeys::KEY) {
+            CPubKey &vchPubKey = record.pubkey;
+            ssKey >> vchPubKey;
+            if (!vchPubKey.IsValid()) {
+                strErr = "Error reading wallet database: CPubKey corrupt";
+                return false;
+            }
+            CPrivKey pkey;
+            uint256 hash;
+
+            ssValue >> pkey;
+
+            // Old wallets store keys as DBKeys::KEY [pubkey] => [privkey] ...
+            // which was slow for wallets with lots of keys, because the public
+            // key is re-derived from the private key using EC operations as a
+            // checksum. Newer wallets store keys as DBKeys::KEY [pubkey] =>
+            // [privkey][hash(pubkey,privkey)], which is much faster while
+            // remaining backwards-compatible.
+            try {
+                ssValue >> hash;
+            } catch (...) {
+            }
+
+            bool fSkipCheck = false;
+
+            if (!hash.IsNull()) {
+                // hash pubkey/privkey to accelerate wallet load
+                std::vector<uint8_t> vchKey;
+                vchKey.reserve(vchPubKey.size() + pkey.size());
+                vchKey.insert(vchKey.end(), vchPubKey.begin(), vchPubKey.end());
+                vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
+
+                if (Hash(vchKey) != hash) {
+                    strErr = "Error reading wallet database: CPubKey/CPrivKey "
+                             "corrupt";
+                    return false;
+                }
+
+                fSkipCheck = true;
+            }
+
+            if (!record.key.Load(pkey, vchPubKey, fSkipCheck)) {
+                strErr = "Error reading wallet database: CPrivKey corrupt";
+                return false;
+            }
+        } else if (record.strType == DBKeys::WALLETDESCRIPTORKEY) {
+            CPubKey &pubkey = record.pubkey;
+            ssKey >> record.desc_id;
+            ssKey >> pubkey;
+            if (!pubkey.IsValid()) {
+                strErr = "Error reading wallet database: CPubKey corrupt";
+                return false;
+            }
+            CPrivKey pkey;
+            uint256 hash;
+
+            ssValue >> pkey;
+            ssValue >> hash;
+
+            // hash pubkey/privkey to accelerate wallet load
+            std::vector<uint8_t> to_hash;
+            to_hash.reserve(pubkey.size() + pkey.size());
+            to_hash.insert(to_hash.end(), pubkey.begin(), pubkey.end());
+            to_hash.insert(to_hash.end(), pkey.begin(), pkey.end());
+
+            if (Hash(to_hash) != hash) {
+                strErr =
+                    "Error reading wallet database: CPubKey/CPrivKey corrupt";
+                return false;
+            }
+
+            if (!record.key.Load(pkey, pubkey, true)) {
+                strErr = "Error reading wallet database: CPrivKey corrupt";
+                return false;
+            }
+        }
+    } catch (const std::exception &e) {
+        if (strErr.empty()) {
+            strErr = e.what();
+        }
+        return false;
+    } catch (...) {
+        if (strErr.empty()) {
+            strErr = "Caught unknown exception in DecodeRecord";
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Decode batches of records on several threads. This is where most of the time
+ * goes when loading a large wallet, mostly hashing transactions and checking
+ * keys. The threads are started once for the whole load and are joined when the
+ * decoder goes out of scope, including when an exception is thrown.
+ */
+class RecordDecoder {
+public:
+    explicit RecordDecoder(unsigned int num_threads) {
+        try {
+            for (unsigned int i = 1; i < num_threads; i++) {
+                m_threads.emplace_back(
+                    &TraceThread<std::function<void()>>, "walletload",
+                    std::function<void()>([this] { ThreadDecode(); }));
+            }
+        } catch (const std::system_error &e) {
+            // Decode with the threads that could be started
+            LogPrintf("Unable to start a wallet loading thread: %s\n",
+                      e.what());
+        }
+    }
+
+    ~RecordDecoder() {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cond_worker.notify_all();
+        for (std::thread &t : m_threads) {
+            t.join();
+        }
+    }
+
+    void Decode(std::vector<WalletRecord> &records) {
+        {
+            LOCK(m_mutex);
+            m_records = &records;
+            m_next = 0;
+            m_working = m_threads.size();
+            ++m_generation;
+        }
+        m_cond_worker.notify_all();
+
+        DecodeNext(records);
+
+        WAIT_LOCK(m_mutex, lock);
+        m_cond_done.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_working == 0;
+        });
+        m_records = nullptr;
+    }
+
+private:
+    Mutex m_mutex;
+    std::condition_variable m_cond_worker;
+    std::condition_variable m_cond_done;
+    std::vector<WalletRecord> *m_records GUARDED_BY(m_mutex){nullptr};
+    //! Incremented for every batch, so that each thread works on it once
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+    //! The number of threads that are not done with the current batch
+    size_t m_working GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::atomic<size_t> m_next{0};
+    std::vector<std::thread> m_threads;
+
+    void DecodeNext(std::vector<WalletRecord> &records) {
+        for (size_t i = m_next++; i < records.size(); i = m_next++) {
+            records[i].decoded = DecodeRecord(records[i]);
+        }
+    }
+
+    void ThreadDecode() {
+        uint64_t generation = 0;
+        while (true) {
+            std::vector<WalletRecord> *records;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cond_worker.wait(
+                    lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                        return m_stop || m_generation != generation;
+                    });
+                if (m_stop) {
+                    return;
+                }
+                generation = m_generation;
+                records = m_records;
+            }
+
+            DecodeNext(*records);
+
+            LOCK(m_mutex);
+            if (--m_working == 0) {
+                m_cond_done.notify_one();
+            }
+        }
+    }
+};
+
+/**
+ * Load a record that went through DecodeRecord into the wallet. The record
+ * streams are positioned where DecodeRecord left them.
+ */
+static bool ReadKeyValue(CWallet *pwallet, WalletRecord &record,
+                         CWalletScanState &wss, std::string &strType,
+                         std::string &strErr)
+    EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+    strType = record.strType;
+    if (!record.decoded) {
+        strErr = record.strErr;
+        return false;
+    }
+
+    CDataStream &ssKey = record.ssKey;
+    CDataStream &ssValue = record.ssValue;
+    try {
         if (strType == DBKeys::NAME) {
             std::string strAddress;
             ssKey >> strAddress;
@@ -330,13 +581,12 @@ static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
                                strAddress, pwallet->GetChainParams())]
                            .purpose;
         } else if (strType == DBKeys::TX) {
-            TxId txid;
-            ssKey >> txid;
+            const TxId &txid = record.txid;
             // LoadToWallet call below creates a new CWalletTx that fill_wtx
             // callback fills with transaction metadata.
             auto fill_wtx = [&](CWalletTx &wtx, bool new_tx) {
                 assert(new_tx);
-                ssValue >> wtx;
+                wtx.UnserializeWithTx(ssValue, record.tx);
                 if (wtx.GetId() != txid) {
                     return false;
                 }
@@ -382,54 +632,9 @@ static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
                     script);
             }
         } else if (strType == DBKeys::KEY) {
-            CPubKey vchPubKey;
-            ssKey >> vchPubKey;
-            if (!vchPubKey.IsValid()) {
-                strErr = "Error reading wallet database: CPubKey corrupt";
-                return false;
-            }
-            CKey key;
-            CPrivKey pkey;
-            uint256 hash;
-
             wss.nKeys++;
-            ssValue >> pkey;
-
-            // Old wallets store keys as DBKeys::KEY [pubkey] => [privkey] ...
-            // which was slow for wallets with lots of keys, because the public
-            // key is re-derived from the private key using EC operations as a
-            // checksum. Newer wallets store keys as DBKeys::KEY [pubkey] =>
-            // [privkey][hash(pubkey,privkey)], which is much faster while
-            // remaining backwards-compatible.
-            try {
-                ssValue >> hash;
-            } catch (...) {
-            }
-
-            bool fSkipCheck = false;
-
-            if (!hash.IsNull()) {
-                // hash pubkey/privkey to accelerate wallet load
-                std::vector<uint8_t> vchKey;
-                vchKey.reserve(vchPubKey.size() + pkey.size());
-                vchKey.insert(vchKey.end(), vchPubKey.begin(), vchPubKey.end());
-                vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
-
-                if (Hash(vchKey) != hash) {
-                    strErr = "Error reading wallet database: CPubKey/CPrivKey "
-                             "corrupt";
-                    return false;
-                }
-
-                fSkipCheck = true;
-            }
-
-            if (!key.Load(pkey, vchPubKey, fSkipCheck)) {
-                strErr = "Error reading wallet database: CPrivKey corrupt";
-                return false;
-            }
             if (!pwallet->GetOrCreateLegacyScriptPubKeyMan()->LoadKey(
-                    key, vchPubKey)) {
+                    record.key, record.pubkey)) {
                 strErr = "Error reading wallet database: "
                          "LegacyScriptPubKeyMan::LoadKey failed";
                 return false;
@@ -687,40 +892,10 @@ static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
                     key_exp_index, der_index, xpub);
             }
         } else if (strType == DBKeys::WALLETDESCRIPTORKEY) {
-            uint256 desc_id;
-            CPubKey pubkey;
-            ssKey >> desc_id;
-            ssKey >> pubkey;
-            if (!pubkey.IsValid()) {
-                strErr = "Error reading wallet database: CPubKey corrupt";
-                return false;
-            }
-            CKey key;
-            CPrivKey pkey;
-            uint256 hash;
-
             wss.nKeys++;
-            ssValue >> pkey;
-            ssValue >> hash;
-
-            // hash pubkey/privkey to accelerate wallet load
-            std::vector<uint8_t> to_hash;
-            to_hash.reserve(pubkey.size() + pkey.size());
-            to_hash.insert(to_hash.end(), pubkey.begin(), pubkey.end());
-            to_hash.insert(to_hash.end(), pkey.begin(), pkey.end());
-
-            if (Hash(to_hash) != hash) {
-                strErr =
-                    "Error reading wallet database: CPubKey/CPrivKey corrupt";
-                return false;
-            }
-
-            if (!key.Load(pkey, pubkey, true)) {
-                strErr = "Error reading wallet database: CPrivKey corrupt";
-                return false;
-            }
-            wss.m_descriptor_keys.insert(
-                std::make_pair(std::make_pair(desc_id, pubkey.GetID()), key));
+            wss.m_descriptor_keys.insert(std::make_pair(
+                std::make_pair(record.desc_id, record.pubkey.GetID()),
+                record.key));
         } else if (strType == DBKeys::WALLETDESCRIPTORCKEY) {
             uint256 desc_id;
             CPubKey pubkey;
@@ -762,8 +937,12 @@ static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
 bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey, CDataStream &ssValue,
                   std::string &strType, std::string &strErr) {
     CWalletScanState dummy_wss;
+    WalletRecord record;
+    record.ssKey = ssKey;
+    record.ssValue = ssValue;
+    record.decoded = DecodeRecord(record);
     LOCK(pwallet->cs_wallet);
-    return ReadKeyValue(pwallet, ssKey, ssValue, dummy_wss, strType, strErr);
+    return ReadKeyValue(pwallet, record, dummy_wss, strType, strErr);
 }
 
 bool WalletBatch::IsKeyType(const std::string &strType) {
@@ -779,7 +958,7 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
     LOCK(pwallet->cs_wallet);
     try {
         int nMinVersion = 0;
-        if (m_batch.Read(DBKeys::MINVERSION, nMinVersion)) {
+        if (m_batch->Read(DBKeys::MINVERSION, nMinVersion)) {
             if (nMinVersion > FEATURE_LATEST) {
                 return DBErrors::TOO_NEW;
             }
@@ -787,54 +966,75 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
         }
 
         // Get cursor
-        Dbc *pcursor = m_batch.GetCursor();
-        if (!pcursor) {
+        if (!m_batch->StartCursor()) {
             pwallet->WalletLogPrintf("Error getting wallet database cursor\n");
             return DBErrors::CORRUPT;
         }
 
-        while (true) {
-            // Read next record
-            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            int ret = m_batch.ReadAtCursor(pcursor, ssKey, ssValue);
-            if (ret == DB_NOTFOUND) {
-                break;
-            }
+        // Read the records in batches, decode each batch on several threads,
+        // then load the records into the wallet in database order.
+        std::optional<RecordDecoder> decoder;
+        std::vector<WalletRecord> records;
+        bool complete = false;
+        while (!complete) {
+            records.clear();
+            while (records.size() < LOAD_BATCH_SIZE) {
+                WalletRecord record;
+                bool ret = m_batch->ReadAtCursor(record.ssKey, record.ssValue,
+                                                 complete);
+                if (complete) {
+                    break;
+                }
 
-            if (ret != 0) {
-                pwallet->WalletLogPrintf(
-                    "Error reading next record from wallet database\n");
-                return DBErrors::CORRUPT;
+                if (!ret) {
+                    m_batch->CloseCursor();
+                    pwallet->WalletLogPrintf(
+                        "Error reading next record from wallet database\n");
+                    return DBErrors::CORRUPT;
+                }
+                records.push_back(std::move(record));
             }
 
-            // Try to be tolerant of single corrupt records:
-            std::string strType, strErr;
-            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr)) {
-                // losing keys is considered a catastrophic error, anything else
-                // we assume the user can live with:
-                if (IsKeyType(strType) || strType == DBKeys::DEFAULTKEY) {
-                    result = DBErrors::CORRUPT;
-                } else if (strType == DBKeys::FLAGS) {
-                    // Reading the wallet flags can only fail if unknown flags
-                    // are present.
-                    result = DBErrors::TOO_NEW;
-                } else {
-                    // Leave other errors alone, if we try to fix them we might
-                    // make things worse. But do warn the user there is
-                    // something wrong.
-                    fNoncriticalErrors = true;
-                    if (strType == DBKeys::TX) {
-                        // Rescan if there is a bad transaction record:
-                        gArgs.SoftSetBoolArg("-rescan", true);
+            if (!decoder) {
+                // Small wallets are read in a single batch, there is no point
+                // in starting more threads than that batch needs.
+                decoder.emplace(std::min(
+                    {std::max(std::thread::hardware_concurrency(), 1u),
+                     MAX_LOAD_THREADS,
+                     unsigned(1 +
+                              records.size() / MIN_RECORDS_PER_LOAD_THREAD)}));
+            }
+            decoder->Decode(records);
+
+            for (WalletRecord &record : records) {
+                // Try to be tolerant of single corrupt records:
+                std::string strType, strErr;
+                if (!ReadKeyValue(pwallet, record, wss, strType, strErr)) {
+                    // losing keys is considered a catastrophic error, anything
+                    // else we assume the user can live with:
+                    if (IsKeyType(strType) || strType == DBKeys::DEFAULTKEY) {
+                        result = DBErrors::CORRUPT;
+                    } else if (strType == DBKeys::FLAGS) {
+                        // Reading the wallet flags can only fail if unknown
+                        // flags are present.
+                        result = DBErrors::TOO_NEW;
+                    } else {
+                        // Leave other errors alone, if we try to fix them we
+                        // might make things worse. But do warn the user there
+                        // is something wrong.
+                        fNoncriticalErrors = true;
+                        if (strType == DBKeys::TX) {
+                            // Rescan if there is a bad transaction record:
+                            gArgs.SoftSetBoolArg("-rescan", true);
+                        }
                     }
                 }
-            }
-            if (!strErr.empty()) {
-                pwallet->WalletLogPrintf("%s\n", strErr);
+                if (!strErr.empty()) {
+                    pwallet->WalletLogPrintf("%s\n", strErr);
+                }
             }
         }
-        pcursor->close();
+        m_batch->CloseCursor();
     } catch (...) {
         result = DBErrors::CORRUPT;
     }
@@ -884,7 +1084,7 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
     // Last client version to open this wallet, was previously the file version
     // number
     int last_client = CLIENT_VERSION;
-    m_batch.Read(DBKeys::VERSION, last_client);
+    m_batch->Read(DBKeys::VERSION, last_client);
 
     int wallet_version = pwallet->GetVersion();
     pwallet->WalletLogPrintf("Wallet File Version = %d\n",
@@ -916,7 +1116,7 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
 
     if (last_client < CLIENT_VERSION) {
         // Update
-        m_batch.Write(DBKeys::VERSION, CLIENT_VERSION);
+        m_batch->Write(DBKeys::VERSION, CLIENT_VERSION);
     }
 
     if (wss.fAnyUnordered) {
@@ -959,15 +1159,14 @@ DBErrors WalletBatch::FindWalletTx(std::vector<TxId> &txIds,
 
     try {
         int nMinVersion = 0;
-        if (m_batch.Read(DBKeys::MINVERSION, nMinVersion)) {
+        if (m_batch->Read(DBKeys::MINVERSION, nMinVersion)) {
             if (nMinVersion > FEATURE_LATEST) {
                 return DBErrors::TOO_NEW;
             }
         }
 
         // Get cursor
-        Dbc *pcursor = m_batch.GetCursor();
-        if (!pcursor) {
+        if (!m_batch->StartCursor()) {
             LogPrintf("Error getting wallet database cursor\n");
             return DBErrors::CORRUPT;
         }
@@ -976,12 +1175,14 @@ DBErrors WalletBatch::FindWalletTx(std::vector<TxId> &txIds,
             // Read next record
             CDataStream ssKey(SER_DISK, CLIENT_VERSION);
             CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            int ret = m_batch.ReadAtCursor(pcursor, ssKey, ssValue);
-            if (ret == DB_NOTFOUND) {
+            bool complete;
+            bool ret = m_batch->ReadAtCursor(ssKey, ssValue, complete);
+            if (complete) {
                 break;
             }
 
-            if (ret != 0) {
+            if (!ret) {
+                m_batch->CloseCursor();
                 LogPrintf("Error reading next record from wallet database\n");
                 return DBErrors::CORRUPT;
             }
@@ -996,7 +1197,7 @@ DBErrors WalletBatch::FindWalletTx(std::vector<TxId> &txIds,
                 ssValue >> vWtx.back();
             }
         }
-        pcursor->close();
+        m_batch->CloseCursor();
     } catch (...) {
         result = DBErrors::CORRUPT;
     }
@@ -1123,23 +1324,46 @@ bool WalletBatch::WriteWalletFlags(const uint64_t flags) {
 }
 
 bool WalletBatch::TxnBegin() {
-    return m_batch.TxnBegin();
+    return m_batch->TxnBegin();
 }
 
 bool WalletBatch::TxnCommit() {
-    return m_batch.TxnCommit();
+    return m_batch->TxnCommit();
 }
 
 bool WalletBatch::TxnAbort() {
-    return m_batch.TxnAbort();
+    return m_batch->TxnAbort();
 }
 
 bool IsWalletLoaded(const fs::path &wallet_path) {
+#ifdef USE_SQLITE
+    if (IsSQLiteWalletLoaded(wallet_path)) {
+        return true;
+    }
+#endif
     return IsBDBWalletLoaded(wallet_path);
 }
 
 /** Return object for accessing database at specified path. */
-std::unique_ptr<BerkeleyDatabase> CreateWalletDatabase(const fs::path &path) {
+std::unique_ptr<WalletDatabase> CreateWalletDatabase(const fs::path &path,
+                                                     DatabaseFormat format) {
+#ifdef USE_SQLITE
+    const fs::path file_path = WalletDataFilePath(path);
+    if (IsSQLiteFile(file_path)) {
+        format = DatabaseFormat::SQLITE;
+    } else if (fs::exists(file_path)) {
+        format = DatabaseFormat::BERKELEY;
+    }
+
+    if (format == DatabaseFormat::SQLITE) {
+        return std::make_unique<SQLiteDatabase>(file_path.parent_path(),
+                                                file_path);
+    }
+#else
+    // Without SQLite support every wallet is a Berkeley DB wallet.
+    assert(format == DatabaseFormat::BERKELEY);
+#endif
+
     std::string filename;
     return std::make_unique<BerkeleyDatabase>(GetWalletEnv(path, filename),
                                               std::move(filename));
@@ -1148,12 +1372,20 @@ std::unique_ptr<BerkeleyDatabase> CreateWalletDatabase(const fs::path &path) {
 /**
  * Return object for accessing dummy database with no read/write capabilities.
  */
-std::unique_ptr<BerkeleyDatabase> CreateDummyWalletDatabase() {
+std::unique_ptr<WalletDatabase> CreateDummyWalletDatabase() {
     return std::make_unique<BerkeleyDatabase>();
 }
 
 /** Return object for accessing temporary in-memory database. */
-std::unique_ptr<BerkeleyDatabase> CreateMockWalletDatabase() {
+std::unique_ptr<WalletDatabase>
+CreateMockWalletDatabase(DatabaseFormat format) {
+#ifdef USE_SQLITE
+    if (format == DatabaseFormat::SQLITE) {
+        return std::make_unique<SQLiteDatabase>("", "", true /* mock */);
+    }
+#else
+    assert(format == DatabaseFormat::BERKELEY);
+#endif
     return std::make_unique<BerkeleyDatabase>(
         std::make_shared<BerkeleyEnvironment>(), "");
 }
@@ -37,10 +37,11 @@
  * encapsulates a database batch update as well as methods to act on the
  * database. It should be agnostic to the database implementation.
  *
- * The following classes are implementation specific:
- * - BerkeleyEnvironment is an environment in which the database exists.
- * - BerkeleyDatabase represents a wallet database.
- * - BerkeleyBatch is a low-level database batch update.
+ * - WalletDatabase represents a wallet database, and DatabaseBatch is a
+ * low-level database batch update. They are implemented by:
+ *   - BerkeleyDatabase and BerkeleyBatch, on top of a BerkeleyEnvironment in
+ *     which the database exists.
+ *   - SQLiteDatabase and SQLiteBatch.
  */
 
 static const bool DEFAULT_FLUSHWALLET = true;
@@ -54,9 +55,6 @@ class CWalletTx;
 class uint160;
 class uint256;
 
-/** Backend-agnostic database type. */
-using WalletDatabase = BerkeleyDatabase;
-
 /** Error statuses for the wallet database */
 enum class DBErrors {
     LOAD_OK,
@@ -184,31 +182,33 @@ public:
  * Opens the database and provides read and write access to it. Each read and
  * write is its own transaction. Multiple operation transactions can be started
  * using TxnBegin() and committed using TxnCommit() Otherwise the transaction
- * will be committed when the object goes out of scope. Optionally (on by
- * default) it will flush to disk on close. Every 1000 writes will automatically
- * trigger a flush to disk.
+ * will be committed when the object goes out of scope. With SQLite such a
+ * transaction also covers the writes of the other batches of the same thread,
+ * not with Berkeley DB (see DatabaseBatch::TxnBegin). Optionally (on by
+ * default) it will flush to disk on close. Every 1000 writes will
+ * automatically trigger a flush to disk.
  */
 class WalletBatch {
 private:
     template <typename K, typename T>
     bool WriteIC(const K &key, const T &value, bool fOverwrite = true) {
-        if (!m_batch.Write(key, value, fOverwrite)) {
+        if (!m_batch->Write(key, value, fOverwrite)) {
             return false;
         }
         m_database.IncrementUpdateCounter();
         if (m_database.nUpdateCounter % 1000 == 0) {
-            m_batch.Flush();
+            m_batch->Flush();
         }
         return true;
     }
 
     template <typename K> bool EraseIC(const K &key) {
-        if (!m_batch.Erase(key)) {
+        if (!m_batch->Erase(key)) {
             return false;
         }
         m_database.IncrementUpdateCounter();
         if (m_database.nUpdateCounter % 1000 == 0) {
-            m_batch.Flush();
+            m_batch->Flush();
         }
         return true;
     }
@@ -216,7 +216,8 @@ private:
 public:
     explicit WalletBatch(WalletDatabase &database, const char *pszMode = "r+",
                          bool _fFlushOnClose = true)
-        : m_batch(database, pszMode, _fFlushOnClose), m_database(database) {}
+        : m_batch(database.MakeBatch(pszMode, _fFlushOnClose)),
+          m_database(database) {}
     WalletBatch(const WalletBatch &) = delete;
     WalletBatch &operator=(const WalletBatch &) = delete;
 
@@ -300,12 +301,12 @@ public:
     bool TxnAbort();
 
 private:
-    BerkeleyBatch m_batch;
+    std::unique_ptr<DatabaseBatch> m_batch;
     WalletDatabase &m_database;
 };
 
-//! Compacts BDB state so that wallet.dat is self-contained (if there are
-//! changes)
+//! Compacts BDB state, or checkpoints the SQLite write-ahead log, so that
+//! wallet.dat is self-contained (if there are changes)
 void MaybeCompactWalletDB();
 
 //! Unserialize a given Key-Value pair and load it into the wallet
@@ -315,15 +316,21 @@ bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey, CDataStream &ssValue,
 /** Return whether a wallet database is currently loaded. */
 bool IsWalletLoaded(const fs::path &wallet_path);
 
-/** Return object for accessing database at specified path. */
-std::unique_ptr<BerkeleyDatabase> CreateWalletDatabase(const fs::path &path);
+/**
+ * Return object for accessing database at specified path. An existing database
+ * keeps its format, a new one is created with the given format.
+ */
+std::unique_ptr<WalletDatabase>
+CreateWalletDatabase(const fs::path &path,
+                     DatabaseFormat format = DatabaseFormat::BERKELEY);
 
 /**
  * Return object for accessing dummy database with no read/write capabilities.
  */
-std::unique_ptr<BerkeleyDatabase> CreateDummyWalletDatabase();
+std::unique_ptr<WalletDatabase> CreateDummyWalletDatabase();
 
 /** Return object for accessing temporary in-memory database. */
-std::unique_ptr<BerkeleyDatabase> CreateMockWalletDatabase();
+std::unique_ptr<WalletDatabase>
+CreateMockWalletDatabase(DatabaseFormat format = DatabaseFormat::BERKELEY);
 
 #endif // BITCOIN_WALLET_WALLETDB_H
@@ -18,7 +18,11 @@
 #include <fs.h>
 #include <util/system.h>
 #include <util/translation.h>
+#include <wallet/bdb.h>
 #include <wallet/salvage.h>
+#ifdef USE_SQLITE
+#include <wallet/sqlite.h>
+#endif
 #include <wallet/wallet.h>
 #include <wallet/walletutil.h>
 
@@ -36,7 +40,8 @@ static void WalletToolReleaseWallet(CWallet *wallet) {
 }
 
 static std::shared_ptr<CWallet> CreateWallet(const std::string &name,
-                                             const fs::path &path) {
+                                             const fs::path &path,
+                                             DatabaseFormat format) {
     if (fs::exists(path)) {
         tfm::format(std::cerr, "Error: File exists already\n");
         return nullptr;
@@ -44,7 +49,7 @@ static std::shared_ptr<CWallet> CreateWallet(const std::string &name,
     // dummy chain interface
     std::shared_ptr<CWallet> wallet_instance(
         new CWallet(nullptr /* chain */, WalletLocation(name),
-                    CreateWalletDatabase(path)),
+                    CreateWalletDatabase(path, format)),
         WalletToolReleaseWallet);
     LOCK(wallet_instance->cs_wallet);
     bool first_run = true;
@@ -136,17 +141,184 @@ static void WalletShowInfo(CWallet *wallet_instance) {
                 wallet_instance->m_address_book.size());
 }
 
+#ifdef USE_SQLITE
+/**
+ * Copy every record of the Berkeley DB file to a new SQLite file, in a single
+ * transaction.
+ */
+static bool CopyToSQLite(const fs::path &path, const fs::path &new_path,
+                         size_t &records) {
+    std::string filename;
+    std::shared_ptr<BerkeleyEnvironment> env = GetWalletEnv(path, filename);
+    BerkeleyDatabase bdb(env, filename);
+    bilingual_str error;
+    if (!bdb.Verify(error)) {
+        tfm::format(std::cerr, "%s\n", error.original);
+        return false;
+    }
+
+    SQLiteDatabase sqlite(new_path.parent_path(), new_path);
+    {
+        std::unique_ptr<DatabaseBatch> batch_in = bdb.MakeBatch("r", false);
+        std::unique_ptr<DatabaseBatch> batch_out = sqlite.MakeBatch();
+        if (!batch_in->StartCursor() || !batch_out->TxnBegin()) {
+            tfm::format(std::cerr, "Error: Unable to start the migration\n");
+            return false;
+        }
+
+        while (true) {
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+            bool complete;
+            if (!batch_in->ReadAtCursor(ssKey, ssValue, complete)) {
+                tfm::format(std::cerr,
+                            "Error reading next record from wallet database\n");
+                return false;
+            }
+            if (complete) {
+                break;
+            }
+            // The key and value are already serialized, copy them verbatim
+            if (!batch_out->Write(MakeUCharSpan(ssKey),
+                                  MakeUCharSpan(ssValue))) {
+                tfm::format(std::cerr, "Error writing record to %s\n",
+                            new_path.string());
+                return false;
+            }
+            ++records;
+        }
+        batch_in->CloseCursor();
+
+        if (!batch_out->TxnCommit()) {
+            tfm::format(std::cerr, "Error: Unable to commit the migration\n");
+            return false;
+        }
+    }
+
+    bdb.Flush(true);
+    sqlite.Flush(true);
+    return true;
+}
+
+/**
+ * Move a file, reporting the failure instead of throwing. The error message
+ * tells how to complete the operation manually.
+ */
+static bool RenameFile(const fs::path &from, const fs::path &to) {
+    try {
+        fs::rename(from, to);
+    } catch (const fs::filesystem_error &e) {
+        tfm::format(std::cerr, "Error: Unable to move %s to %s: %s\n",
+                    from.string(), to.string(),
+                    fsbridge::get_filesystem_error_message(e));
+        return false;
+    }
+    return true;
+}
+
+static bool MigrateToSQLite(const std::string &name, const fs::path &path) {
+    const fs::path file_path = WalletDataFilePath(path);
+    const fs::path new_path = file_path.string() + ".migrating";
+    const fs::path backup_path = file_path.string() + ".bdb.bak";
+
+    // The files are swapped with two renames, which cannot be done atomically.
+    // The migrated file is complete before the first one, so a migration
+    // interrupted in between is finished by moving it in place.
+    try {
+        if (!fs::exists(file_path) && fs::exists(backup_path) &&
+            IsSQLiteFile(new_path)) {
+            if (!RenameFile(new_path, file_path)) {
+                return false;
+            }
+            tfm::format(std::cout,
+                        "Completed the interrupted migration. The Berkeley DB "
+                        "file was kept as %s\n",
+                        backup_path.string());
+            return true;
+        }
+
+        if (IsSQLiteFile(file_path)) {
+            tfm::format(std::cerr, "Error: %s already uses SQLite\n", name);
+            return false;
+        }
+        if (fs::exists(backup_path)) {
+            tfm::format(std::cerr, "Error: %s exists already\n",
+                        backup_path.string());
+            return false;
+        }
+        // Left over by a migration interrupted while copying
+        fs::remove(new_path);
+    } catch (const fs::filesystem_error &e) {
+        tfm::format(std::cerr, "Error: Unable to prepare the migration: %s\n",
+                    fsbridge::get_filesystem_error_message(e));
+        return false;
+    }
+
+    size_t records = 0;
+    bool copied = false;
+    try {
+        copied = CopyToSQLite(path, new_path, records);
+    } catch (const std::exception &e) {
+        tfm::format(std::cerr, "Error: %s\n", e.what());
+    }
+    if (!copied) {
+        // Removed on the next attempt otherwise
+        boost::system::error_code ec;
+        fs::remove(new_path, ec);
+        return false;
+    }
+
+    // Swap the files, keeping the original one as a backup
+    if (!RenameFile(file_path, backup_path)) {
+        return false;
+    }
+    if (!RenameFile(new_path, file_path)) {
+        tfm::format(std::cerr,
+                    "The migrated wallet is %s and the original one was kept "
+                    "as %s. Run the migrate command again to complete the "
+                    "migration.\n",
+                    new_path.string(), backup_path.string());
+        return false;
+    }
+
+    tfm::format(std::cout,
+                "Migrated %u records to SQLite. The Berkeley DB file was kept "
+                "as %s\n",
+                records, backup_path.string());
+    return true;
+}
+#endif // USE_SQLITE
+
 bool ExecuteWalletToolFunc(const std::string &command,
                            const std::string &name) {
     fs::path path = fs::absolute(name, GetWalletDir());
 
     if (command == "create") {
-        std::shared_ptr<CWallet> wallet_instance = CreateWallet(name, path);
+        DatabaseFormat format;
+        const std::string format_str = gArgs.GetArg("-format", "bdb");
+        if (format_str == "bdb") {
+            format = DatabaseFormat::BERKELEY;
+        } else if (format_str == "sqlite") {
+#ifdef USE_SQLITE
+            format = DatabaseFormat::SQLITE;
+#else
+            tfm::format(std::cerr,
+                        "Error: This build does not support SQLite wallets\n");
+            return false;
+#endif
+        } else {
+            tfm::format(std::cerr, "Invalid database format: %s\n",
+                        format_str);
+            return false;
+        }
+        std::shared_ptr<CWallet> wallet_instance =
+            CreateWallet(name, path, format);
         if (wallet_instance) {
             WalletShowInfo(wallet_instance.get());
             wallet_instance->Flush(true);
         }
-    } else if (command == "info" || command == "salvage") {
+    } else if (command == "info" || command == "salvage" ||
+               command == "migrate") {
         if (!fs::exists(path)) {
             tfm::format(std::cerr, "Error: no wallet file at %s\n", name);
             return false;
@@ -160,6 +332,14 @@ bool ExecuteWalletToolFunc(const std::string &command,
             WalletShowInfo(wallet_instance.get());
             wallet_instance->Flush(true);
         } else if (command == "salvage") {
+#ifdef USE_SQLITE
+            if (IsSQLiteFile(WalletDataFilePath(path))) {
+                tfm::format(std::cerr,
+                            "Error: salvage is only supported for Berkeley DB "
+                            "wallets\n");
+                return false;
+            }
+#endif
             bilingual_str error;
             std::vector<bilingual_str> warnings;
             bool ret = RecoverDatabaseFile(path, error, warnings);
@@ -172,6 +352,14 @@ bool ExecuteWalletToolFunc(const std::string &command,
                 }
             }
             return ret;
+        } else if (command == "migrate") {
+#ifdef USE_SQLITE
+            return MigrateToSQLite(name, path);
+#else
+            tfm::format(std::cerr,
+                        "Error: This build does not support SQLite wallets\n");
+            return false;
+#endif
         }
     } else {
         tfm::format(std::cerr, "Invalid command: %s\n", command);
@@ -18,6 +18,9 @@
 
 #include <logging.h>
 #include <util/system.h>
+#ifdef USE_SQLITE
+#include <wallet/sqlite.h>
+#endif
 
 fs::path GetWalletDir() {
     fs::path path;
@@ -75,6 +78,16 @@ static bool IsBerkeleyBtree(const fs::path &path) {
     return data == 0x00053162 || data == 0x62310500;
 }
 
+/** Whether path is a wallet file in one of the supported formats. */
+static bool IsWalletFile(const fs::path &path) {
+#ifdef USE_SQLITE
+    if (IsSQLiteFile(path)) {
+        return true;
+    }
+#endif
+    return IsBerkeleyBtree(path);
+}
+
 std::vector<fs::path> ListWalletDir() {
     const fs::path wallet_dir = GetWalletDir();
     const size_t offset = wallet_dir.string().size() + 1;
@@ -95,13 +108,13 @@ std::vector<fs::path> ListWalletDir() {
         const fs::path path = it->path().string().substr(offset);
 
         if (it->status().type() == fs::directory_file &&
-            IsBerkeleyBtree(it->path() / "wallet.dat")) {
+            IsWalletFile(it->path() / "wallet.dat")) {
             // Found a directory which contains wallet.dat btree file, add it as
             // a wallet.
             paths.emplace_back(path);
         } else if (it.level() == 0 &&
                    it->symlink_status().type() == fs::regular_file &&
-                   IsBerkeleyBtree(it->path())) {
+                   IsWalletFile(it->path())) {
             if (it->path().filename() == "wallet.dat") {
                 // Found top-level wallet.dat btree file, add top level
                 // directory "" as a wallet.
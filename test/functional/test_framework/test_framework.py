@@ -788,6 +788,11 @@ class BitcoinTestFramework(metaclass=BitcoinTestMetaClass):
         """Checks whether bitcoin-wallet was compiled."""
         return self.config["components"].getboolean("ENABLE_WALLET_TOOL")
 
+    def is_sqlite_compiled(self):
+        """Checks whether the wallet was compiled with SQLite support."""
+        return self.is_wallet_compiled() and self.config["components"].getboolean(
+            "USE_SQLITE")
+
     def is_zmq_compiled(self):
         """Checks whether the zmq module was compiled."""
         return self.config["components"].getboolean("ENABLE_ZMQ")
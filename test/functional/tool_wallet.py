@@ -253,6 +253,96 @@ class ToolWalletTest(BitcoinTestFramework):
 
         self.assert_tool_output('', '-wallet=salvage', 'salvage')
 
+    def wallet_file_magic(self, name):
+        path = os.path.join(
+            self.nodes[0].datadir, self.chain, 'wallets', name, 'wallet.dat')
+        with open(path, 'rb') as f:
+            return f.read(16)
+
+    def test_format(self):
+        self.log.info('Check the create command -format option')
+        self.assert_raises_tool_error(
+            'Invalid database format: foo', '-wallet=badformat', '-format=foo',
+            'create')
+
+        if not self.is_sqlite_compiled():
+            self.assert_raises_tool_error(
+                'Error: This build does not support SQLite wallets',
+                '-wallet=sqlite', '-format=sqlite', 'create')
+            return
+
+        out = textwrap.dedent('''\
+            Topping up keypool...
+            Wallet info
+            ===========
+            Encrypted: no
+            HD (hd seed available): yes
+            Keypool Size: 2000
+            Transactions: 0
+            Address Book: 0
+        ''')
+        self.assert_tool_output(out, '-wallet=sqlite', '-format=sqlite',
+                                'create')
+        assert_equal(self.wallet_file_magic('sqlite'), b'SQLite format 3\x00')
+        # The format is detected when the wallet is opened again
+        self.assert_tool_output(out.replace('Topping up keypool...\n', ''),
+                                '-wallet=sqlite', 'info')
+
+        self.log.info('Check that the node loads a SQLite wallet')
+        self.start_node(0, ['-wallet=sqlite'])
+        address = self.nodes[0].getnewaddress()
+        assert self.nodes[0].getaddressinfo(address)['ismine']
+        self.stop_node(0)
+
+    def test_migrate(self):
+        self.log.info('Check migrate')
+        if not self.is_sqlite_compiled():
+            self.assert_raises_tool_error(
+                'Error: This build does not support SQLite wallets',
+                '-wallet=wallet.dat', 'migrate')
+            return
+
+        self.start_node(0, ['-wallet=migrate'])
+        address = self.nodes[0].getnewaddress()
+        self.stop_node(0)
+
+        wallet_dir = os.path.join(
+            self.nodes[0].datadir, self.chain, 'wallets', 'migrate')
+        wallet_path = os.path.join(wallet_dir, 'wallet.dat')
+        backup_path = wallet_path + '.bdb.bak'
+        p = self.bitcoin_wallet_process('-wallet=migrate', 'info')
+        info_before, _ = p.communicate()
+        assert_equal(p.poll(), 0)
+        with open(wallet_path, 'rb') as f:
+            bdb_contents = f.read()
+
+        p = self.bitcoin_wallet_process('-wallet=migrate', 'migrate')
+        stdout, stderr = p.communicate()
+        assert_equal(stderr, '')
+        assert_equal(p.poll(), 0)
+        assert stdout.startswith('Migrated ')
+        assert stdout.endswith(
+            'The Berkeley DB file was kept as {}\n'.format(backup_path))
+        assert_equal(self.wallet_file_magic('migrate'), b'SQLite format 3\x00')
+        with open(backup_path, 'rb') as f:
+            assert f.read() == bdb_contents
+        self.assert_tool_output(info_before, '-wallet=migrate', 'info')
+
+        self.assert_raises_tool_error(
+            'Error: migrate already uses SQLite', '-wallet=migrate', 'migrate')
+
+        self.log.info('Check that migrate completes an interrupted swap')
+        os.rename(wallet_path, wallet_path + '.migrating')
+        self.assert_tool_output(
+            'Completed the interrupted migration. The Berkeley DB file was '
+            'kept as {}\n'.format(backup_path), '-wallet=migrate', 'migrate')
+        assert_equal(self.wallet_file_magic('migrate'), b'SQLite format 3\x00')
+
+        self.log.info('Check that the node loads the migrated wallet')
+        self.start_node(0, ['-wallet=migrate'])
+        assert self.nodes[0].getaddressinfo(address)['ismine']
+        self.stop_node(0)
+
     def run_test(self):
         self.wallet_path = os.path.join(
             self.nodes[0].datadir, self.chain, 'wallets', 'wallet.dat')
@@ -263,6 +353,8 @@ class ToolWalletTest(BitcoinTestFramework):
         self.test_tool_wallet_create_on_existing_wallet()
         self.test_getwalletinfo_on_different_wallet()
         self.test_salvage()
+        self.test_format()
+        self.test_migrate()
 
 
 if __name__ == '__main__':